@@ -3,8 +3,104 @@
 
 #undef main
 
-int main() {
+int main(int argc, char* argv[]) {
+	profiler::setThreadName("main");
+
 	try {
+		if ((argc == 4 || argc == 5) && std::string(argv[1]) == "--pack") {
+			jobs::init();
+			filesystem::writePack(argv[2], argv[3], argc == 5 ? compression::parseCodec(argv[4]) : compression::codec::none);
+			jobs::shutdown();
+
+			return EXIT_SUCCESS;
+		}
+
+		// headless asset import, only sources that changed since the last run are rebuilt
+		if ((argc == 3 || argc == 4) && std::string(argv[1]) == "--import") {
+			jobs::init();
+			filesystem::init();
+			assets::import(argv[2], argc == 4 ? compression::parseCodec(argv[3]) : compression::codec::lz4);
+			jobs::shutdown();
+
+			return EXIT_SUCCESS;
+		}
+
+		if (argc == 3 && std::string(argv[1]) == "--benchmark-io") {
+			jobs::init();
+			benchmark::runIO(argv[2]);
+			jobs::shutdown();
+
+			return EXIT_SUCCESS;
+		}
+
+		// generated obj files, the engine's parser against tinyobjloader
+		if (argc == 3 && std::string(argv[1]) == "--benchmark-obj") {
+			jobs::init();
+
+			std::vector<benchmark::objResult> results = benchmark::runObj(argv[2]);
+
+			jobs::shutdown();
+
+			bool matches = std::all_of(results.begin(), results.end(), [](const benchmark::objResult& result) { return result.matches; });
+
+			return matches ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+
+		// synthetic scenes, cpu side for the whole suite or a single scene
+		if ((argc == 3 || argc == 4) && std::string(argv[1]) == "--benchmark") {
+			jobs::init();
+			filesystem::init();
+			assets::init();
+
+			std::vector<benchmark::sceneConfig> configs = argc == 4 ? std::vector<benchmark::sceneConfig>{ benchmark::findConfig(argv[3]) } : benchmark::defaultSuite();
+			std::vector<benchmark::sceneResult> results = benchmark::runSuite(configs);
+			benchmark::writeResults(argv[2], results);
+
+			jobs::shutdown();
+
+			bool budgetExceeded = std::any_of(results.begin(), results.end(), [](const benchmark::sceneResult& result) { return result.budgetExceeded; });
+
+			return budgetExceeded ? EXIT_FAILURE : EXIT_SUCCESS;
+		}
+
+		// a generated city through the software occlusion rasterizer, cpu only
+		if (argc == 3 && std::string(argv[1]) == "--benchmark-occlusion") {
+			jobs::init();
+			benchmark::writeOcclusionResults(argv[2], benchmark::runOcclusion(16, 1));
+			jobs::shutdown();
+
+			return EXIT_SUCCESS;
+		}
+
+		// renders one synthetic scene headless, extra arguments go to headless::parseArguments
+		if (argc >= 4 && std::string(argv[1]) == "--benchmark-render") {
+			headless::parseArguments(argc, argv, 4);
+
+			benchmark::writeResults(argv[2], { benchmark::renderScene(benchmark::findConfig(argv[3])) });
+
+			return headless::failed ? EXIT_FAILURE : EXIT_SUCCESS;
+		}
+
+		// interactive run with a cpu trace written on exit
+		if (argc == 3 && std::string(argv[1]) == "--profile") {
+			profiler::start(argv[2]);
+		}
+
+		// interactive run with per subsystem memory and device heaps logged on exit
+		if (argc == 2 && std::string(argv[1]) == "--memory-report") {
+			memory::reportOnExit = true;
+		}
+
+		// interactive run with the buffers in a compact vertex format, full or compact
+		if (argc == 3 && std::string(argv[1]) == "--vertex-format") {
+			renderer::requestedVertexFormat = renderer::parseVertexFormat(argv[2]);
+		}
+
+		// offscreen rendering on any vulkan device (lavapipe in ci), see headless::parseArguments for the options
+		if (argc >= 2 && std::string(argv[1]) == "--headless") {
+			headless::parseArguments(argc, argv, 2);
+		}
+
 		logger::log(std::string("Starting ") + engine::name + std::string("..."), 4);
 
 		engine::init();
@@ -14,5 +110,5 @@ int main() {
 		return EXIT_FAILURE;
 	}
 
-	return EXIT_SUCCESS;
+	return headless::failed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
\ No newline at end of file
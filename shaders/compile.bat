@@ -1,3 +1,8 @@
 C:/VulkanSDK/1.3.283.0/Bin/glslc.exe shader.vert -o vert.spv
+C:/VulkanSDK/1.3.283.0/Bin/glslc.exe -DCOMPACT_VERTEX shader.vert -o vert_compact.spv
+C:/VulkanSDK/1.3.283.0/Bin/glslc.exe -DCOMPACT_VERTEX -DVERTEX_COLOR shader.vert -o vert_compact_color.spv
 C:/VulkanSDK/1.3.283.0/Bin/glslc.exe shader.frag -o frag.spv
+C:/VulkanSDK/1.3.283.0/Bin/glslc.exe cluster.comp -o cluster.spv
+C:/VulkanSDK/1.3.283.0/Bin/glslc.exe cull.comp -o cull.spv
+C:/VulkanSDK/1.3.283.0/Bin/glslc.exe hiz.comp -o hiz.spv
 pause
\ No newline at end of file
@@ -1,20 +1,62 @@
 #version 450
 
+// variants: COMPACT_VERTEX reads renderer::compactVertex, with VERTEX_COLOR renderer::compactColorVertex (see compile.bat)
+
 layout(binding = 0) uniform uniformBufferObject {
 	mat4 model;
 	mat4 view;
 	mat4 proj;
 } ubo;
 
+// the compact variants get the mesh's dequantization folded into the transform
+layout(push_constant) uniform objectConstants {
+	mat4 transform;
+	// indirect draws of gpu culling, firstInstance is the object and its transform is in the instance buffer
+	uint instanced;
+} object;
+
+// occlusion::instance, only the transform is read here
+struct instance {
+	mat4 transform;
+	vec4 sphere;
+	uint mesh;
+	uint lod;
+	float scale;
+	uint padding;
+};
+
+layout(std430, binding = 2) readonly buffer instanceBuffer {
+	instance instances[];
+};
+
+#ifdef COMPACT_VERTEX
+layout(location = 0) in vec4 inPosition;
+#ifdef VERTEX_COLOR
+layout(location = 1) in vec4 inColor;
+#endif
+layout(location = 2) in vec2 inTexCoord;
+// octahedral, see quantize::octahedralEncode, kept in the buffer for shading that does not exist yet
+layout(location = 3) in vec2 inNormal;
+#else
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec2 inTexCoord;
+#endif
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
 
 void main() {
-	gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
-	fragColor = inColor;
+	mat4 transform = object.instanced != 0u ? instances[gl_InstanceIndex].transform : object.transform;
+
+	gl_Position = ubo.proj * ubo.view * ubo.model * transform * vec4(inPosition.xyz, 1.0);
 	fragTexCoord = inTexCoord;
+
+#ifdef VERTEX_COLOR
+	fragColor = inColor.rgb;
+#elif defined(COMPACT_VERTEX)
+	fragColor = vec3(1.0);
+#else
+	fragColor = inColor;
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "./arena.h"
+
+std::array<arena::linearArena, renderer::maxFramesInFlight> arena::frameArenas;
+
+VkBuffer arena::gpuBuffer = VK_NULL_HANDLE;
+VkDeviceMemory arena::gpuBufferMemory = VK_NULL_HANDLE;
+char* arena::gpuBufferMapped = nullptr;
+VkDeviceSize arena::gpuSliceStart = 0;
+VkDeviceSize arena::gpuOffset = 0;
+VkDeviceSize arena::gpuHighWater = 0;
+
+static size_t alignUp(size_t value, size_t alignment) {
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+arena::linearArena::~linearArena() {
+	arena::linearArena::release();
+}
+
+void arena::linearArena::init(size_t capacity, memory::tag owner) {
+	arena::linearArena::release();
+
+	this->owner = owner;
+
+	base = static_cast<char*>(memory::allocate(capacity, alignof(std::max_align_t), owner));
+	size = capacity;
+	offset.store(0, std::memory_order_relaxed);
+}
+
+void arena::linearArena::release() {
+	for (void* pointer : overflow) {
+		memory::deallocate(pointer);
+	}
+
+	overflow.clear();
+	overflowBytes = 0;
+
+	memory::deallocate(base);
+
+	base = nullptr;
+	size = 0;
+	offset.store(0, std::memory_order_relaxed);
+}
+
+void* arena::linearArena::allocate(size_t size, size_t alignment) {
+	size_t current = offset.load(std::memory_order_relaxed);
+
+	while (true) {
+		size_t aligned = alignUp(reinterpret_cast<uintptr_t>(base) + current, alignment) - reinterpret_cast<uintptr_t>(base);
+
+		if (aligned + size > this->size) {
+			break;
+		}
+
+		if (offset.compare_exchange_weak(current, aligned + size, std::memory_order_relaxed)) {
+			return base + aligned;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(overflowMutex);
+
+	void* pointer = memory::allocate(size, alignment, owner);
+
+	if (pointer == nullptr) {
+		throw std::bad_alloc();
+	}
+
+	overflow.push_back(pointer);
+	overflowBytes += size + alignment;
+
+	return pointer;
+}
+
+void arena::linearArena::reset() {
+	peak = std::max(peak, offset.load(std::memory_order_relaxed) + overflowBytes);
+
+	if (!overflow.empty()) {
+		size_t capacity = alignUp(peak + peak / 2, 4096);
+
+		logger::log("Frame arena exhausted, growing to " + std::to_string(capacity) + " bytes", 2);
+
+		arena::linearArena::init(capacity, owner);
+	}
+
+	offset.store(0, std::memory_order_relaxed);
+}
+
+void arena::init() {
+	for (auto& frameArena : arena::frameArenas) {
+		frameArena.init(arena::frameArenaSize, memory::tag::renderer);
+	}
+
+	renderer::createBuffer(arena::gpuArenaSize * renderer::maxFramesInFlight, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, arena::gpuBuffer, arena::gpuBufferMemory);
+
+	void* mapped;
+	vkMapMemory(renderer::device, arena::gpuBufferMemory, 0, VK_WHOLE_SIZE, 0, &mapped);
+
+	arena::gpuBufferMapped = static_cast<char*>(mapped);
+	arena::gpuSliceStart = renderer::currentFrame * arena::gpuArenaSize;
+	arena::gpuOffset = arena::gpuSliceStart;
+}
+
+void arena::cleanup() {
+	for (auto& frameArena : arena::frameArenas) {
+		frameArena.release();
+	}
+
+	if (arena::gpuBuffer != VK_NULL_HANDLE) {
+		vkUnmapMemory(renderer::device, arena::gpuBufferMemory);
+		vkDestroyBuffer(renderer::device, arena::gpuBuffer, nullptr);
+		memory::freeDevice(arena::gpuBufferMemory);
+
+		arena::gpuBuffer = VK_NULL_HANDLE;
+		arena::gpuBufferMemory = VK_NULL_HANDLE;
+		arena::gpuBufferMapped = nullptr;
+	}
+}
+
+void arena::beginFrame(uint32_t frame) {
+	arena::frameArenas[frame].reset();
+
+	arena::gpuHighWater = std::max(arena::gpuHighWater, arena::gpuOffset - arena::gpuSliceStart);
+
+	arena::gpuSliceStart = frame * arena::gpuArenaSize;
+	arena::gpuOffset = arena::gpuSliceStart;
+}
+
+arena::linearArena& arena::frame() {
+	return arena::frameArenas[renderer::currentFrame];
+}
+
+arena::gpuAllocation arena::allocateGpu(VkDeviceSize size, VkDeviceSize alignment) {
+	const VkPhysicalDeviceLimits& limits = renderer::physicalDeviceProperties.limits;
+
+	alignment = std::max({ alignment, limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment, static_cast<VkDeviceSize>(16) });
+
+	VkDeviceSize sliceEnd = arena::gpuSliceStart + arena::gpuArenaSize;
+	VkDeviceSize aligned = alignUp(arena::gpuOffset, alignment);
+
+	if (aligned + size > sliceEnd) {
+		throw std::runtime_error("Failed to allocate from GPU frame arena!");
+	}
+
+	arena::gpuOffset = aligned + size;
+
+	arena::gpuAllocation allocation{};
+	allocation.buffer = arena::gpuBuffer;
+	allocation.offset = aligned;
+	allocation.mapped = arena::gpuBufferMapped + aligned;
+
+	return allocation;
+}
\ No newline at end of file
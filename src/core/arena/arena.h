@@ -0,0 +1,122 @@
+#pragma once
+#ifndef arena_h
+#define arena_h
+
+#include "../src/engine.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace arena {
+	// sized for a few hundred thousand visible objects worth of indices and sort keys, grows once if a frame needs more
+	const size_t frameArenaSize = 4 * 1024 * 1024;
+
+	// per frame uniforms, dynamic vertex data and indirect commands, one slice of the buffer per frame in flight
+	const VkDeviceSize gpuArenaSize = 4 * 1024 * 1024;
+
+	class linearArena {
+		public:
+			linearArena() = default;
+			~linearArena();
+
+			linearArena(const linearArena&) = delete;
+			linearArena& operator=(const linearArena&) = delete;
+
+			void init(size_t capacity, memory::tag owner);
+			void release();
+
+			// lock free bump, only an exhausted arena takes the lock and falls back to the heap
+			void* allocate(size_t size, size_t alignment);
+
+			// frees the overflow and grows to the high-water mark, so the next frame fits without touching the heap
+			void reset();
+
+			size_t used() const { return offset.load(std::memory_order_relaxed) + overflowBytes; }
+			size_t capacity() const { return size; }
+			size_t highWater() const { return peak; }
+		private:
+			char* base = nullptr;
+			size_t size = 0;
+			std::atomic<size_t> offset = 0;
+			size_t peak = 0;
+			memory::tag owner = memory::tag::general;
+
+			std::vector<void*> overflow;
+			size_t overflowBytes = 0;
+			std::mutex overflowMutex;
+	};
+
+	// deallocate is a no-op, everything goes away when the frame's fence has been waited on
+	// assigning a makeVector takes its arena along, a default constructed allocator is only for globals that get one before their first use
+	template<typename type>
+	struct allocator {
+		using value_type = type;
+		using propagate_on_container_copy_assignment = std::true_type;
+		using propagate_on_container_move_assignment = std::true_type;
+		using propagate_on_container_swap = std::true_type;
+
+		linearArena* source = nullptr;
+
+		allocator() noexcept = default;
+		allocator(linearArena& source) noexcept : source(&source) {}
+
+		template<typename otherType>
+		allocator(const allocator<otherType>& other) noexcept : source(other.source) {}
+
+		type* allocate(size_t count) {
+			return static_cast<type*>(source->allocate(count * sizeof(type), alignof(type)));
+		}
+
+		void deallocate(type*, size_t) noexcept {}
+
+		template<typename otherType>
+		bool operator==(const allocator<otherType>& other) const noexcept { return source == other.source; }
+
+		template<typename otherType>
+		bool operator!=(const allocator<otherType>& other) const noexcept { return source != other.source; }
+	};
+
+	template<typename type>
+	using vector = std::vector<type, allocator<type>>;
+
+	struct gpuAllocation {
+		VkBuffer buffer;
+		VkDeviceSize offset;
+		void* mapped;
+	};
+
+	extern std::array<linearArena, renderer::maxFramesInFlight> frameArenas;
+
+	// one host visible, coherent buffer mapped for the lifetime of the device
+	extern VkBuffer gpuBuffer;
+	extern VkDeviceMemory gpuBufferMemory;
+	extern char* gpuBufferMapped;
+	extern VkDeviceSize gpuSliceStart;
+	extern VkDeviceSize gpuOffset;
+	extern VkDeviceSize gpuHighWater;
+
+	void init();
+	void cleanup();
+
+	// called once the frame's fence has been waited on, nothing the gpu still reads lives in this slot
+	void beginFrame(uint32_t frame);
+
+	linearArena& frame();
+
+	template<typename type>
+	arena::vector<type> makeVector(size_t reserve = 0) {
+		arena::vector<type> result{ arena::allocator<type>(arena::frame()) };
+		result.reserve(reserve);
+
+		return result;
+	}
+
+	// offsets are aligned for uniform, storage, vertex and indirect use, the allocation is only valid for the current frame
+	gpuAllocation allocateGpu(VkDeviceSize size, VkDeviceSize alignment = 0);
+}
+
+#endif
\ No newline at end of file
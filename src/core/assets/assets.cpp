@@ -0,0 +1,541 @@
+#include "./assets.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unordered_set>
+
+std::unordered_map<assets::assetId, assets::assetRecord> assets::records;
+
+static bool producesArtifact(assets::assetType type) {
+	return type == assets::assetType::model || type == assets::assetType::texture;
+}
+
+static std::string toHex(uint64_t value) {
+	char buffer[17];
+	snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(value));
+
+	return buffer;
+}
+
+static std::vector<std::string> split(const std::string& text, char separator) {
+	std::vector<std::string> parts;
+	std::string part;
+	std::istringstream stream(text);
+
+	while (std::getline(stream, part, separator)) {
+		parts.push_back(part);
+	}
+
+	return parts;
+}
+
+template<typename type>
+static uint64_t hashValue(const type& value, uint64_t seed) {
+	return assets::hashBytes(std::span<const char>(reinterpret_cast<const char*>(&value), sizeof(value)), seed);
+}
+
+assets::assetId assets::makeId(const std::string& path) {
+	std::string virtualPath = filesystem::normalizePath(path);
+
+	return assets::hashBytes(std::span<const char>(virtualPath.data(), virtualPath.size()));
+}
+
+// fnv-1a
+uint64_t assets::hashBytes(std::span<const char> bytes, uint64_t seed) {
+	uint64_t hash = seed;
+
+	for (char byte : bytes) {
+		hash ^= static_cast<unsigned char>(byte);
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+assets::assetType assets::typeOf(const std::string& path) {
+	std::string extension = std::filesystem::path(assets::sourcePath(path)).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char character) { return static_cast<char>(std::tolower(character)); });
+
+	if (extension == ".scene") {
+		return assets::assetType::scene;
+	}
+	else if (extension == ".obj" || extension == ".gltf" || extension == ".glb") {
+		return assets::assetType::model;
+	}
+	else if (extension == ".mtl") {
+		return assets::assetType::material;
+	}
+	else if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp") {
+		return assets::assetType::texture;
+	}
+
+	return assets::assetType::unknown;
+}
+
+std::string assets::sourcePath(const std::string& path) {
+	return path.substr(0, path.find_last_of('#'));
+}
+
+std::string assets::artifactPath(uint64_t artifactKey) {
+	return assets::artifactDirectory + "/" + toHex(artifactKey) + compression::blobExtension;
+}
+
+void assets::init() {
+	BRUTAL_PROFILE_FUNCTION();
+	BRUTAL_MEMORY_SCOPE(memory::tag::assets);
+
+	assets::loadDatabase(assets::databasePath);
+}
+
+void assets::loadDatabase(const std::string& path) {
+	assets::records.clear();
+
+	if (!filesystem::exists(path)) {
+		return;
+	}
+
+	filesystem::fileView file = filesystem::open(path);
+	filesystem::viewStream stream(file);
+
+	std::string line;
+
+	while (std::getline(stream, line)) {
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+
+		std::vector<std::string> fields = split(line, '\t');
+
+		if (fields.size() < 7) {
+			throw std::runtime_error("Invalid asset database: " + path);
+		}
+
+		assets::assetRecord record{};
+		record.id = std::stoull(fields[0], nullptr, 16);
+		record.type = static_cast<assets::assetType>(std::stoul(fields[1]));
+		record.sourceSize = std::stoull(fields[2]);
+		record.sourceTime = std::stoll(fields[3]);
+		record.sourceHash = std::stoull(fields[4], nullptr, 16);
+		record.artifactKey = std::stoull(fields[5], nullptr, 16);
+		record.path = fields[6];
+
+		if (fields.size() > 7) {
+			record.dependencies = split(fields[7], '|');
+		}
+
+		assets::records.emplace(record.id, std::move(record));
+	}
+
+	logger::log("Successfully loaded asset database: " + path + " (" + std::to_string(assets::records.size()) + " assets)", 1);
+}
+
+void assets::saveDatabase(const std::string& path) {
+	std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+
+	std::vector<const assets::assetRecord*> sorted;
+
+	for (const auto& [id, record] : assets::records) {
+		sorted.push_back(&record);
+	}
+
+	std::sort(sorted.begin(), sorted.end(), [](const assets::assetRecord* a, const assets::assetRecord* b) { return a->path < b->path; });
+
+	std::ofstream database(path, std::ios::trunc);
+
+	if (!database.is_open()) {
+		throw std::runtime_error("Failed to write asset database: " + path);
+	}
+
+	database << "# id\ttype\tsize\ttime\thash\tartifact\tpath\tdependencies\n";
+
+	for (const auto* record : sorted) {
+		database << toHex(record->id) << '\t' << static_cast<uint32_t>(record->type) << '\t' << record->sourceSize << '\t' << record->sourceTime << '\t' << toHex(record->sourceHash) << '\t' << toHex(record->artifactKey) << '\t' << record->path << '\t';
+
+		for (size_t i = 0; i < record->dependencies.size(); i++) {
+			database << (i > 0 ? "|" : "") << record->dependencies[i];
+		}
+
+		database << '\n';
+	}
+}
+
+const assets::assetRecord* assets::find(const std::string& path) {
+	auto record = assets::records.find(assets::makeId(path));
+
+	return record != assets::records.end() ? &record->second : nullptr;
+}
+
+std::vector<std::string> assets::scanDependencies(const std::string& path, assetType type) {
+	std::vector<std::string> dependencies;
+
+	if (type != assets::assetType::scene && type != assets::assetType::model && type != assets::assetType::material) {
+		return dependencies;
+	}
+
+	if (type == assets::assetType::model && gltf::isGltf(path)) {
+		return gltf::dependencies(path);
+	}
+
+	filesystem::fileView file = filesystem::open(path);
+	filesystem::viewStream stream(file);
+
+	std::string baseDirectory = path.substr(0, path.find_last_of("/\\") + 1);
+	std::string line;
+
+	while (std::getline(stream, line)) {
+		if (!line.empty() && line.back() == '\r') {
+			line.pop_back();
+		}
+
+		std::istringstream tokens(line);
+		std::string keyword;
+		tokens >> keyword;
+
+		if (keyword.empty() || keyword[0] == '#') {
+			continue;
+		}
+
+		// scenes list virtual paths, obj and mtl references are relative to the file
+		if (type == assets::assetType::scene) {
+			dependencies.push_back(filesystem::normalizePath(keyword));
+		}
+		else if (type == assets::assetType::model && keyword == "mtllib") {
+			std::string library;
+
+			while (tokens >> library) {
+				dependencies.push_back(filesystem::normalizePath(baseDirectory + library));
+			}
+		}
+		else if (type == assets::assetType::material && (keyword == "map_Kd" || keyword == "map_Ka" || keyword == "map_Ks" || keyword == "map_d" || keyword == "map_Bump" || keyword == "map_bump" || keyword == "bump" || keyword == "norm" || keyword == "disp")) {
+			// options come first, the texture name is the last token
+			std::string token;
+			std::string texture;
+
+			while (tokens >> token) {
+				texture = token;
+			}
+
+			if (!texture.empty()) {
+				dependencies.push_back(filesystem::normalizePath(baseDirectory + texture));
+			}
+		}
+	}
+
+	return dependencies;
+}
+
+std::vector<std::string> assets::dependenciesOf(const std::string& path, assetType type) {
+	std::vector<std::string> result;
+	std::unordered_set<std::string> visited;
+
+	std::function<void(const std::string&)> visit = [&](const std::string& current) {
+		if (!visited.insert(current).second) {
+			return;
+		}
+
+		if (current != path && assets::typeOf(current) == type) {
+			result.push_back(current);
+		}
+
+		const assets::assetRecord* record = assets::find(current);
+
+		if (record) {
+			for (const auto& dependency : record->dependencies) {
+				visit(dependency);
+			}
+		}
+		else if (filesystem::exists(current)) {
+			for (const auto& dependency : assets::scanDependencies(current, assets::typeOf(current))) {
+				visit(dependency);
+			}
+		}
+	};
+
+	visit(filesystem::normalizePath(path));
+
+	return result;
+}
+
+uint32_t assets::import(const std::string& directory, compression::codec codec) {
+	BRUTAL_PROFILE_FUNCTION();
+	BRUTAL_MEMORY_SCOPE(memory::tag::assets);
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	assets::loadDatabase(assets::databasePath);
+
+	std::vector<assets::assetRecord> current;
+
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(directory)) {
+		if (!entry.is_regular_file()) {
+			continue;
+		}
+
+		assets::assetRecord record{};
+		record.path = filesystem::normalizePath(std::filesystem::relative(entry.path()).generic_string());
+		record.type = assets::typeOf(record.path);
+
+		if (record.type == assets::assetType::unknown) {
+			continue;
+		}
+
+		record.id = assets::makeId(record.path);
+		record.sourceSize = entry.file_size();
+		record.sourceTime = static_cast<int64_t>(entry.last_write_time().time_since_epoch().count());
+
+		current.push_back(std::move(record));
+	}
+
+	std::sort(current.begin(), current.end(), [](const assets::assetRecord& a, const assets::assetRecord& b) { return a.path < b.path; });
+
+	// only sources whose size or write time changed are hashed and scanned again
+	std::atomic<uint32_t> hashed = 0;
+
+	jobs::parallelFor(current.size(), 8, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			auto previous = assets::records.find(current[i].id);
+
+			if (previous != assets::records.end() && previous->second.sourceSize == current[i].sourceSize && previous->second.sourceTime == current[i].sourceTime) {
+				current[i].sourceHash = previous->second.sourceHash;
+				current[i].dependencies = previous->second.dependencies;
+				continue;
+			}
+
+			filesystem::fileView file = filesystem::openImmediate(current[i].path);
+
+			current[i].sourceHash = assets::hashBytes(file.bytes);
+			current[i].dependencies = assets::scanDependencies(current[i].path, current[i].type);
+
+			hashed++;
+		}
+	});
+
+	// an artifact key covers the importer, the source and every dependency key, so edits propagate up obj -> mtl -> texture chains
+	std::unordered_map<std::string, size_t> indices;
+
+	for (size_t i = 0; i < current.size(); i++) {
+		indices.emplace(current[i].path, i);
+	}
+
+	std::vector<uint8_t> state(current.size(), 0);
+
+	std::function<uint64_t(size_t)> keyOf = [&](size_t index) -> uint64_t {
+		if (state[index] == 2) {
+			return current[index].artifactKey;
+		}
+
+		if (state[index] == 1) {
+			return current[index].sourceHash;
+		}
+
+		state[index] = 1;
+
+		uint64_t key = hashValue(assets::importerVersion, 14695981039346656037ull);
+		key = hashValue(current[index].type, key);
+		key = hashValue(current[index].sourceHash, key);
+
+		for (const auto& dependency : current[index].dependencies) {
+			auto dependencyIndex = indices.find(dependency);
+
+			key = hashValue(dependencyIndex != indices.end() ? keyOf(dependencyIndex->second) : assets::makeId(dependency), key);
+		}
+
+		current[index].artifactKey = key;
+		state[index] = 2;
+
+		return key;
+	};
+
+	std::vector<size_t> dirty;
+
+	for (size_t i = 0; i < current.size(); i++) {
+		keyOf(i);
+
+		if (producesArtifact(current[i].type) && !std::filesystem::exists(assets::artifactPath(current[i].artifactKey))) {
+			dirty.push_back(i);
+		}
+	}
+
+	std::filesystem::create_directories(assets::artifactDirectory);
+
+	jobs::parallelFor(dirty.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			assets::importAsset(current[dirty[i]], codec);
+		}
+	});
+
+	assets::records.clear();
+
+	for (auto& record : current) {
+		assets::records.emplace(record.id, std::move(record));
+	}
+
+	assets::saveDatabase(assets::databasePath);
+
+	double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	logger::log("Successfully imported " + std::to_string(dirty.size()) + " of " + std::to_string(assets::records.size()) + " assets (" + std::to_string(hashed) + " hashed, " + std::to_string(milliseconds) + " ms)", 1);
+
+	return static_cast<uint32_t>(dirty.size());
+}
+
+void assets::importAsset(const assetRecord& record, compression::codec codec) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	std::vector<char> artifact;
+
+	if (record.type == assets::assetType::model) {
+		engine::mesh mesh = engine::model::parseModel(record.path);
+
+		// baked meshes are welded and ordered for the post-transform cache, overdraw and fetch locality
+		optimize::result optimized = optimize::optimizeMesh(record.path, mesh.vertices(), mesh.indices());
+		mesh.release();
+
+		std::vector<renderer::meshLod> lods = lod::buildChain(record.path, optimized.vertices, optimized.indices);
+		std::vector<renderer::meshlet> meshlets = cluster::build(record.path, optimized.vertices, std::span<const uint32_t>(optimized.indices).first(lods[0].indexCount));
+
+		assets::meshHeader header{};
+		memcpy(header.magic, assets::meshMagic, sizeof(header.magic));
+		header.vertexCount = static_cast<uint32_t>(optimized.vertices.size());
+		header.indexCount = static_cast<uint32_t>(optimized.indices.size());
+		header.vertexSize = sizeof(renderer::vertex);
+		header.lodCount = static_cast<uint32_t>(lods.size());
+		header.meshletCount = static_cast<uint32_t>(meshlets.size());
+
+		size_t lodsSize = lods.size() * sizeof(renderer::meshLod);
+		size_t meshletsSize = meshlets.size() * sizeof(renderer::meshlet);
+		size_t verticesSize = optimized.vertices.size() * sizeof(renderer::vertex);
+		size_t indicesSize = optimized.indices.size() * sizeof(uint32_t);
+
+		artifact.resize(sizeof(header) + lodsSize + meshletsSize + verticesSize + indicesSize);
+		memcpy(artifact.data(), &header, sizeof(header));
+		memcpy(artifact.data() + sizeof(header), lods.data(), lodsSize);
+		memcpy(artifact.data() + sizeof(header) + lodsSize, meshlets.data(), meshletsSize);
+		memcpy(artifact.data() + sizeof(header) + lodsSize + meshletsSize, optimized.vertices.data(), verticesSize);
+		memcpy(artifact.data() + sizeof(header) + lodsSize + meshletsSize + verticesSize, optimized.indices.data(), indicesSize);
+	}
+	else if (record.type == assets::assetType::texture) {
+		filesystem::fileView file = filesystem::openImmediate(record.path);
+
+		assets::textureHeader header{};
+		memcpy(header.magic, assets::textureMagic, sizeof(header.magic));
+		header.channels = 4;
+
+		int width = 0;
+		int height = 0;
+		int channels = 0;
+
+		stbi_uc* pixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(file.data()), static_cast<int>(file.size()), &width, &height, &channels, STBI_rgb_alpha);
+
+		if (!pixels) {
+			throw std::runtime_error("Failed to import texture: " + record.path);
+		}
+
+		header.width = static_cast<uint32_t>(width);
+		header.height = static_cast<uint32_t>(height);
+
+		size_t pixelsSize = static_cast<size_t>(width) * height * 4;
+
+		artifact.resize(sizeof(header) + pixelsSize);
+		memcpy(artifact.data(), &header, sizeof(header));
+		memcpy(artifact.data() + sizeof(header), pixels, pixelsSize);
+
+		stbi_image_free(pixels);
+	}
+	else {
+		return;
+	}
+
+	// a blob even without a codec, the extension is what tells the filesystem to unpack it
+	artifact = compression::compressBlob(artifact, codec);
+
+	// write then rename, so an interrupted import never leaves a truncated artifact under a valid key
+	std::string path = assets::artifactPath(record.artifactKey);
+	std::string temporaryPath = path + ".tmp";
+
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+
+		if (!file.is_open()) {
+			throw std::runtime_error("Failed to write artifact: " + path);
+		}
+
+		file.write(artifact.data(), static_cast<std::streamsize>(artifact.size()));
+	}
+
+	std::filesystem::rename(temporaryPath, path);
+}
+
+std::string assets::artifactFor(const std::string& path) {
+	const assets::assetRecord* record = assets::find(path);
+
+	if (!record || !producesArtifact(record->type)) {
+		return "";
+	}
+
+	// loose sources edited since the last import fall back to loading the source
+	std::string loosePath = filesystem::resolveLoosePath(path);
+
+	if (!loosePath.empty()) {
+		std::error_code error;
+
+		uint64_t size = std::filesystem::file_size(loosePath, error);
+		int64_t time = static_cast<int64_t>(std::filesystem::last_write_time(loosePath, error).time_since_epoch().count());
+
+		if (error || size != record->sourceSize || time != record->sourceTime) {
+			logger::log("Asset changed since last import: " + record->path, 2);
+
+			return "";
+		}
+	}
+
+	std::string artifact = assets::artifactPath(record->artifactKey);
+
+	return filesystem::exists(artifact) ? artifact : "";
+}
+
+std::string assets::resolve(const std::string& path) {
+	std::string artifact = assets::artifactFor(path);
+
+	return artifact.empty() ? path : artifact;
+}
+
+// one model per line, optionally followed by its position
+std::vector<assets::sceneEntry> assets::readScene(const std::string& scenePath) {
+	std::vector<assets::sceneEntry> entries;
+
+	filesystem::fileView file = filesystem::open(scenePath);
+	filesystem::viewStream stream(file);
+
+	std::string line;
+
+	while (std::getline(stream, line)) {
+		if (!line.empty() && line.back() == '\r') {
+			line.pop_back();
+		}
+
+		std::istringstream tokens(line);
+		assets::sceneEntry entry{};
+
+		if (!(tokens >> entry.model) || entry.model[0] == '#') {
+			continue;
+		}
+
+		entry.model = filesystem::normalizePath(entry.model);
+
+		if (assets::typeOf(entry.model) != assets::assetType::model) {
+			continue;
+		}
+
+		tokens >> entry.position.x >> entry.position.y >> entry.position.z;
+
+		entries.push_back(entry);
+	}
+
+	if (entries.empty()) {
+		throw std::runtime_error("Failed to load scene, no models: " + scenePath);
+	}
+
+	return entries;
+}
\ No newline at end of file
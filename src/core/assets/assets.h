@@ -0,0 +1,95 @@
+#pragma once
+#ifndef assets_h
+#define assets_h
+
+#include "../src/engine.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <span>
+#include <cstdint>
+
+namespace assets {
+	using assetId = uint64_t;
+
+	enum class assetType : uint32_t {
+		unknown,
+		scene,
+		model,
+		material,
+		texture
+	};
+
+	// size and write time let unchanged sources skip hashing, the hash decides the artifact key
+	struct assetRecord {
+		assetId id;
+		assetType type;
+		std::string path;
+		uint64_t sourceSize;
+		int64_t sourceTime;
+		uint64_t sourceHash;
+		uint64_t artifactKey;
+		std::vector<std::string> dependencies;
+	};
+
+	// baked artifacts, stored as compression blobs under their content key
+	const char meshMagic[4] = {'B', 'M', 'S', 'H'};
+	const char textureMagic[4] = {'B', 'T', 'E', 'X'};
+
+	// followed by lodCount renderer::meshLod, meshletCount renderer::meshlet, the vertices and then the indices of every lod
+	struct meshHeader {
+		char magic[4];
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t vertexSize;
+		uint32_t lodCount;
+		uint32_t meshletCount;
+	};
+
+	struct textureHeader {
+		char magic[4];
+		uint32_t width;
+		uint32_t height;
+		uint32_t channels;
+	};
+
+	struct sceneEntry {
+		std::string model;
+		glm::vec3 position;
+	};
+
+	// bump whenever an importer or artifact layout changes, every key changes with it
+	const uint32_t importerVersion = 4;
+
+	const std::string databasePath = "cache/assets.db";
+	const std::string artifactDirectory = "cache/artifacts";
+
+	extern std::unordered_map<assetId, assetRecord> records;
+
+	assetId makeId(const std::string& path);
+	uint64_t hashBytes(std::span<const char> bytes, uint64_t seed = 14695981039346656037ull);
+	assetType typeOf(const std::string& path);
+
+	// drops a "#<mesh>" fragment, the source file every mesh of a gltf shares
+	std::string sourcePath(const std::string& path);
+	std::string artifactPath(uint64_t artifactKey);
+
+	void init();
+	void loadDatabase(const std::string& path);
+	void saveDatabase(const std::string& path);
+
+	const assetRecord* find(const std::string& path);
+	std::vector<std::string> scanDependencies(const std::string& path, assetType type);
+	std::vector<std::string> dependenciesOf(const std::string& path, assetType type);
+
+	// returns the number of rebuilt artifacts
+	uint32_t import(const std::string& directory, compression::codec codec = compression::codec::lz4);
+	void importAsset(const assetRecord& record, compression::codec codec);
+
+	std::string artifactFor(const std::string& path);
+	std::string resolve(const std::string& path);
+	std::vector<sceneEntry> readScene(const std::string& scenePath);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,915 @@
+#include "./benchmark.h"
+
+// only the obj benchmark still uses tinyobjloader, as the reference the engine's parser is measured against
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tinyobjloader/tiny_obj_loader.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+
+double benchmark::measure(const std::function<void()>& function) {
+	auto start = std::chrono::high_resolution_clock::now();
+
+	function();
+
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+double benchmark::percentile(std::vector<double> values, double fraction) {
+	if (values.empty()) {
+		return 0.0;
+	}
+
+	std::sort(values.begin(), values.end());
+
+	return values[std::min(values.size() - 1, static_cast<size_t>(fraction * (values.size() - 1) + 0.5))];
+}
+
+double benchmark::average(const std::vector<double>& values) {
+	if (values.empty()) {
+		return 0.0;
+	}
+
+	double sum = 0.0;
+
+	for (double value : values) {
+		sum += value;
+	}
+
+	return sum / static_cast<double>(values.size());
+}
+
+uint64_t benchmark::residentBytes() {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters{};
+
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return 0;
+	}
+
+	return static_cast<uint64_t>(counters.WorkingSetSize);
+#else
+	std::ifstream statm("/proc/self/statm");
+
+	uint64_t size = 0;
+	uint64_t resident = 0;
+
+	if (!(statm >> size >> resident)) {
+		return 0;
+	}
+
+	return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+std::vector<benchmark::ioResult> benchmark::runIO(const std::string& directory) {
+	filesystem::unmountAll();
+	filesystem::mountDirectory(directory);
+
+	std::vector<std::string> paths;
+
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(directory)) {
+		if (entry.is_regular_file()) {
+			paths.push_back(filesystem::normalizePath(std::filesystem::relative(entry.path(), directory).generic_string()));
+		}
+	}
+
+	std::sort(paths.begin(), paths.end());
+
+	std::atomic<uint64_t> bytes = 0;
+
+	auto loadSync = [&]() {
+		for (const auto& path : paths) {
+			filesystem::fileView view = filesystem::openImmediate(path);
+			filesystem::touchPages(view);
+
+			bytes += view.size();
+		}
+	};
+
+	auto loadAsync = [&]() {
+		filesystem::readBatch(paths, [&](size_t, filesystem::fileView view) {
+			bytes += view.size();
+		});
+	};
+
+	auto run = [&](const std::string& name, const std::function<void()>& load) {
+		ioResult result{};
+		result.name = name;
+
+		for (const auto& path : paths) {
+			filesystem::evictFromCache(path);
+		}
+
+		bytes = 0;
+		result.coldMilliseconds = benchmark::measure(load);
+		result.bytes = bytes;
+		result.warmMilliseconds = benchmark::measure(load);
+
+		return result;
+	};
+
+	std::vector<ioResult> results;
+
+	filesystem::ioBackend backend = filesystem::backend;
+
+	results.push_back(run("sync", loadSync));
+
+	filesystem::backend = filesystem::ioBackend::threadPool;
+	results.push_back(run("threadPool", loadAsync));
+
+#if defined(__linux__) && defined(BRUTAL_IO_URING)
+	filesystem::backend = filesystem::ioBackend::ioUring;
+	results.push_back(run("ioUring", loadAsync));
+#endif
+
+	filesystem::backend = backend;
+
+	for (const auto& result : results) {
+		double megabytes = static_cast<double>(result.bytes) / (1024.0 * 1024.0);
+
+		logger::log(result.name + ": " + std::to_string(paths.size()) + " files, " + std::to_string(megabytes) + " MB, cold " + std::to_string(result.coldMilliseconds) + " ms (" + std::to_string(megabytes / (result.coldMilliseconds / 1000.0)) + " MB/s), warm " + std::to_string(result.warmMilliseconds) + " ms (" + std::to_string(megabytes / (result.warmMilliseconds / 1000.0)) + " MB/s)", 4);
+	}
+
+	return results;
+}
+
+// the conversion parseModel used to do, so both sides produce the same vertices
+static std::vector<renderer::vertex> loadTinyobj(const filesystem::fileView& file) {
+	tinyobj::attrib_t attrib;
+	std::vector<tinyobj::shape_t> shapes;
+	std::vector<tinyobj::material_t> materials;
+	std::string err;
+
+	filesystem::viewStream stream(file);
+
+	if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &err, &stream, nullptr)) {
+		throw std::runtime_error("Failed to load model: " + err);
+	}
+
+	std::vector<renderer::vertex> vertices;
+
+	for (const auto& shape : shapes) {
+		for (const auto& index : shape.mesh.indices) {
+			renderer::vertex vertex{};
+
+			vertex.pos = {
+				attrib.vertices[3 * index.vertex_index + 0],
+				attrib.vertices[3 * index.vertex_index + 1],
+				attrib.vertices[3 * index.vertex_index + 2]
+			};
+
+			vertex.texCoord = {
+				attrib.texcoords[2 * index.texcoord_index + 0],
+				1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
+			};
+
+			vertex.color = { 1.0f, 1.0f, 1.0f };
+
+			vertices.push_back(vertex);
+		}
+	}
+
+	return vertices;
+}
+
+std::vector<benchmark::objResult> benchmark::runObj(const std::string& directory) {
+	std::filesystem::create_directories(directory);
+
+	filesystem::unmountAll();
+	filesystem::mountDirectory(directory);
+
+	std::vector<benchmark::objResult> results;
+
+	for (uint32_t triangles : { 100000u, 1000000u, 4000000u }) {
+		std::string name = "torus_" + std::to_string(triangles) + ".obj";
+
+		benchmark::writeMesh(directory + "/" + name, "none.mtl", "none", triangles, triangles);
+
+		filesystem::fileView file = filesystem::openImmediate(name);
+		filesystem::touchPages(file);
+
+		std::vector<renderer::vertex> reference;
+		engine::mesh parsed;
+
+		benchmark::objResult result{};
+		result.bytes = file.size();
+
+		result.tinyobjMilliseconds = benchmark::measure([&]() {
+			reference = loadTinyobj(file);
+		});
+
+		result.parserMilliseconds = benchmark::measure([&]() {
+			parsed = obj::parse(name, file);
+		});
+
+		result.triangles = static_cast<uint32_t>(parsed.indices().size() / 3);
+		result.matches = reference.size() == parsed.vertices().size() && std::equal(reference.begin(), reference.end(), parsed.vertices().begin(), [](const renderer::vertex& a, const renderer::vertex& b) {
+			// tinyobjloader rounds through double, the last bit may differ
+			return glm::length(a.pos - b.pos) < 1e-5f && glm::length(a.texCoord - b.texCoord) < 1e-5f;
+		});
+
+		double megabytes = static_cast<double>(result.bytes) / (1024.0 * 1024.0);
+
+		logger::log(name + ": " + std::to_string(megabytes) + " MB, tinyobjloader " + std::to_string(result.tinyobjMilliseconds) + " ms, obj::parse " + std::to_string(result.parserMilliseconds) + " ms (" + std::to_string(result.tinyobjMilliseconds / result.parserMilliseconds) + "x)" + (result.matches ? "" : ", output differs!"), result.matches ? 4 : 3);
+
+		results.push_back(result);
+	}
+
+	return results;
+}
+
+// xorshift, std distributions differ between standard libraries and would break determinism
+static uint32_t nextRandom(uint32_t& state) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+
+	return state;
+}
+
+static float randomFloat(uint32_t& state) {
+	return static_cast<float>(nextRandom(state) >> 8) * (1.0f / 16777216.0f);
+}
+
+static uint32_t seedState(uint32_t seed) {
+	uint32_t state = seed * 2654435761u + 0x9e3779b9u;
+
+	return state == 0 ? 1 : state;
+}
+
+std::vector<benchmark::sceneConfig> benchmark::defaultSuite() {
+	return {
+		{ "unique_small", 64, 2048, false, 4, 256, 1 },
+		{ "unique_large", 128, 8192, false, 16, 512, 2 },
+		{ "instanced_many", 4096, 512, true, 1, 256, 3 },
+		{ "instanced_dense", 1024, 32768, true, 1, 1024, 4 }
+	};
+}
+
+benchmark::sceneConfig benchmark::findConfig(const std::string& name) {
+	for (const auto& config : benchmark::defaultSuite()) {
+		if (config.name == name) {
+			return config;
+		}
+	}
+
+	throw std::runtime_error("Unknown benchmark scene: " + name);
+}
+
+std::string benchmark::generateScene(const sceneConfig& config, const std::string& directory) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	std::filesystem::create_directories(directory);
+
+	uint32_t textureCount = std::max(1u, config.textureCount);
+
+	for (uint32_t i = 0; i < textureCount; i++) {
+		benchmark::writeTexture(directory + "/texture_" + std::to_string(i) + ".tga", config.textureSize, config.seed * 131u + i);
+
+		std::ofstream material(directory + "/material_" + std::to_string(i) + ".mtl", std::ios::trunc);
+		material << "newmtl material_" << i << "\nmap_Kd texture_" << i << ".tga\n";
+	}
+
+	// instanced scenes reference one mesh from every object
+	uint32_t meshFiles = config.instanced ? 1 : config.meshCount;
+
+	jobs::parallelFor(meshFiles, 4, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			std::string material = "material_" + std::to_string(i % textureCount);
+
+			benchmark::writeMesh(directory + "/mesh_" + std::to_string(i) + ".obj", material + ".mtl", material, config.trianglesPerMesh, config.seed * 7919u + static_cast<uint32_t>(i));
+		}
+	});
+
+	// objects sit on a jittered grid around the origin, inside the far plane
+	uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(config.meshCount))));
+	const float spacing = 3.0f;
+
+	uint32_t state = seedState(config.seed);
+
+	std::string scene = "# " + config.name + ", generated by the benchmark suite\n";
+	char position[96];
+
+	for (uint32_t i = 0; i < config.meshCount; i++) {
+		float x = (static_cast<float>(i % side) - static_cast<float>(side - 1) * 0.5f) * spacing + (randomFloat(state) - 0.5f);
+		float z = (static_cast<float>(i / side) - static_cast<float>(side - 1) * 0.5f) * spacing + (randomFloat(state) - 0.5f);
+
+		snprintf(position, sizeof(position), " %.4f %.4f %.4f\n", x, 0.0f, z);
+
+		scene += directory + "/mesh_" + std::to_string(config.instanced ? 0 : i) + ".obj" + position;
+	}
+
+	std::string scenePath = directory + "/benchmark.scene";
+
+	std::ofstream file(scenePath, std::ios::binary | std::ios::trunc);
+
+	if (!file.is_open()) {
+		throw std::runtime_error("Failed to write benchmark scene: " + scenePath);
+	}
+
+	file.write(scene.data(), static_cast<std::streamsize>(scene.size()));
+
+	return filesystem::normalizePath(scenePath);
+}
+
+// a torus with a seeded ripple, no poles so every triangle has area
+void benchmark::writeMesh(const std::string& path, const std::string& materialLibrary, const std::string& material, uint32_t triangles, uint32_t seed) {
+	uint32_t rings = std::max(3u, static_cast<uint32_t>(std::sqrt(triangles / 4.0)));
+	uint32_t segments = std::max(3u, triangles / (2 * rings));
+
+	uint32_t state = seedState(seed);
+
+	float amplitude = 0.05f + 0.15f * randomFloat(state);
+	float frequency = static_cast<float>(2 + nextRandom(state) % 6);
+	float phase = glm::two_pi<float>() * randomFloat(state);
+
+	const float majorRadius = 0.7f;
+	const float minorRadius = 0.25f;
+
+	std::string obj = "mtllib " + materialLibrary + "\nusemtl " + material + "\n";
+	obj.reserve(static_cast<size_t>(rings + 1) * (segments + 1) * 64 + static_cast<size_t>(rings) * segments * 64);
+
+	char line[128];
+
+	for (uint32_t ring = 0; ring <= rings; ring++) {
+		float u = glm::two_pi<float>() * static_cast<float>(ring) / static_cast<float>(rings);
+
+		for (uint32_t segment = 0; segment <= segments; segment++) {
+			float v = glm::two_pi<float>() * static_cast<float>(segment) / static_cast<float>(segments);
+			float minor = minorRadius * (1.0f + amplitude * std::sin(frequency * u + phase) * std::cos(frequency * v));
+
+			snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", (majorRadius + minor * std::cos(v)) * std::cos(u), minor * std::sin(v), (majorRadius + minor * std::cos(v)) * std::sin(u));
+			obj += line;
+		}
+	}
+
+	for (uint32_t ring = 0; ring <= rings; ring++) {
+		for (uint32_t segment = 0; segment <= segments; segment++) {
+			snprintf(line, sizeof(line), "vt %.6f %.6f\n", static_cast<float>(ring) / static_cast<float>(rings), static_cast<float>(segment) / static_cast<float>(segments));
+			obj += line;
+		}
+	}
+
+	for (uint32_t ring = 0; ring < rings; ring++) {
+		for (uint32_t segment = 0; segment < segments; segment++) {
+			uint32_t a = ring * (segments + 1) + segment + 1;
+			uint32_t b = a + segments + 1;
+			uint32_t c = b + 1;
+			uint32_t d = a + 1;
+
+			snprintf(line, sizeof(line), "f %u/%u %u/%u %u/%u\nf %u/%u %u/%u %u/%u\n", a, a, b, b, c, c, a, a, c, c, d, d);
+			obj += line;
+		}
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+	if (!file.is_open()) {
+		throw std::runtime_error("Failed to write benchmark mesh: " + path);
+	}
+
+	file.write(obj.data(), static_cast<std::streamsize>(obj.size()));
+}
+
+// uncompressed 24 bit tga, a colored checker with noise so it does not compress to nothing
+void benchmark::writeTexture(const std::string& path, uint32_t size, uint32_t seed) {
+	uint32_t state = seedState(seed);
+
+	uint8_t base[3] = {
+		static_cast<uint8_t>(64 + nextRandom(state) % 192),
+		static_cast<uint8_t>(64 + nextRandom(state) % 192),
+		static_cast<uint8_t>(64 + nextRandom(state) % 192)
+	};
+
+	uint32_t cell = 8u << (nextRandom(state) % 3);
+
+	std::vector<uint8_t> image(18 + static_cast<size_t>(size) * size * 3);
+
+	image[2] = 2;
+	image[12] = static_cast<uint8_t>(size & 0xff);
+	image[13] = static_cast<uint8_t>(size >> 8);
+	image[14] = static_cast<uint8_t>(size & 0xff);
+	image[15] = static_cast<uint8_t>(size >> 8);
+	image[16] = 24;
+	image[17] = 0x20;
+
+	uint8_t* pixel = image.data() + 18;
+
+	for (uint32_t y = 0; y < size; y++) {
+		for (uint32_t x = 0; x < size; x++) {
+			bool dark = ((x / cell) + (y / cell)) % 2 == 1;
+			uint32_t noise = nextRandom(state) & 15;
+
+			// bgr
+			for (int channel = 2; channel >= 0; channel--) {
+				*pixel++ = static_cast<uint8_t>(std::min(255u, (dark ? base[channel] / 2u : static_cast<uint32_t>(base[channel])) + noise));
+			}
+		}
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+	if (!file.is_open()) {
+		throw std::runtime_error("Failed to write benchmark texture: " + path);
+	}
+
+	file.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+}
+
+benchmark::sceneResult benchmark::runScene(const sceneConfig& config) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	logger::log("Running benchmark scene: " + config.name + "...", 4);
+
+	benchmark::sceneResult result{};
+	result.config = config;
+
+	memory::resetHighWater();
+
+	std::string directory = benchmark::sceneDirectory + "/" + config.name;
+	std::string scenePath;
+
+	result.generateMilliseconds = benchmark::measure([&]() {
+		scenePath = benchmark::generateScene(config, directory);
+	});
+
+	renderer::loadScene(scenePath);
+
+	std::vector<std::string> files;
+
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(directory)) {
+		if (entry.is_regular_file()) {
+			files.push_back(filesystem::normalizePath(entry.path().generic_string()));
+		}
+	}
+
+	std::vector<std::string> textures;
+
+	for (const auto& model : renderer::models) {
+		for (const auto& texture : assets::dependenciesOf(model, assets::assetType::texture)) {
+			if (std::find(textures.begin(), textures.end(), texture) == textures.end()) {
+				textures.push_back(texture);
+			}
+		}
+	}
+
+	auto evict = [&]() {
+		for (const auto& file : files) {
+			filesystem::evictFromCache(file);
+		}
+	};
+
+	// source formats straight through tinyobj and stb, the database is not consulted
+	auto loadSources = [&]() {
+		jobs::parallelFor(renderer::models.size(), 1, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				engine::model::parseModel(renderer::models[i]);
+			}
+		});
+
+		for (const auto& texture : textures) {
+			filesystem::fileView file = filesystem::open(texture);
+
+			int width, height, channels;
+			stbi_uc* pixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(file.data()), static_cast<int>(file.size()), &width, &height, &channels, STBI_rgb_alpha);
+
+			if (!pixels) {
+				throw std::runtime_error("Failed to load texture image: " + texture);
+			}
+
+			stbi_image_free(pixels);
+		}
+	};
+
+	// the path the renderer takes, baked artifacts once imported
+	auto loadBaked = [&]() {
+		renderer::loadModels();
+
+		result.textureBytes = 0;
+
+		for (const auto& path : textures) {
+			engine::texture texture;
+			texture.textureStruct.texturePath = path;
+			texture.loadTexture(texture);
+
+			// what uploadTexture does for baked textures, with a vector in place of the staging buffer
+			if (!texture.textureStruct.artifactPath.empty()) {
+				std::vector<char> artifact(filesystem::fileSize(texture.textureStruct.artifactPath));
+				filesystem::read(texture.textureStruct.artifactPath, artifact);
+				engine::texture::readBakedHeader(texture, artifact);
+			}
+
+			result.textureBytes += static_cast<uint64_t>(texture.textureStruct.textureDimensionsX) * texture.textureStruct.textureDimensionsY * 4;
+
+			stbi_image_free(texture.textureStruct.data);
+		}
+	};
+
+	evict();
+	result.sourceColdMilliseconds = benchmark::measure(loadSources);
+	result.sourceWarmMilliseconds = benchmark::measure(loadSources);
+
+	// the import replaces the database, the game's records are put back afterwards
+	std::unordered_map<assets::assetId, assets::assetRecord> records = assets::records;
+
+	result.importMilliseconds = benchmark::measure([&]() {
+		assets::import(directory);
+	});
+
+	evict();
+	result.bakedColdMilliseconds = benchmark::measure(loadBaked);
+	result.bakedWarmMilliseconds = benchmark::measure(loadBaked);
+
+	result.meshBytes = 0;
+
+	for (const auto& mesh : renderer::meshData) {
+		result.meshBytes += mesh.bytes();
+	}
+	result.residentBytes = benchmark::residentBytes();
+
+	// no frames run here, so only the byte budgets apply
+	result.memory = memory::stats();
+	result.budgetExceeded = !memory::checkBudgets().empty();
+
+	for (const auto& object : renderer::objects) {
+		result.triangles += renderer::meshes[object.mesh].lods[0].indexCount / 3;
+	}
+
+	// artifacts are removed so every run imports from scratch
+	for (const auto& record : assets::records) {
+		if (record.second.artifactKey != 0) {
+			std::filesystem::remove(assets::artifactPath(record.second.artifactKey));
+		}
+	}
+
+	assets::records = records;
+	assets::saveDatabase(assets::databasePath);
+
+	// culling over the same camera path the headless renderer follows
+	camera::createCamera();
+
+	float aspectRatio = static_cast<float>(engine::width) / static_cast<float>(engine::height);
+
+	std::vector<double> cullTimes;
+	uint64_t visible = 0;
+	uint64_t drawn = 0;
+
+	for (uint32_t frame = 0; frame < headless::frameCount; frame++) {
+		headless::applyCamera(frame);
+
+		glm::mat4 viewProjection = renderer::projectionMatrix(aspectRatio) * camera::getView();
+
+		cullTimes.push_back(benchmark::measure([&viewProjection]() {
+			renderer::cullObjects(viewProjection);
+			renderer::selectLods(camera::camera.eye, static_cast<float>(engine::height));
+		}));
+
+		visible += renderer::visibleObjects.size();
+		drawn += renderer::drawnTriangles;
+	}
+
+	result.cullMilliseconds = benchmark::average(cullTimes);
+	result.cullP95Milliseconds = benchmark::percentile(cullTimes, 0.95);
+	result.visibleObjects = headless::frameCount > 0 ? static_cast<double>(visible) / headless::frameCount : 0.0;
+	result.drawnTriangles = headless::frameCount > 0 ? static_cast<double>(drawn) / headless::frameCount : 0.0;
+
+	logger::log(config.name + ": " + std::to_string(result.triangles) + " triangles (" + std::to_string(static_cast<uint64_t>(result.drawnTriangles)) + " drawn), source " + std::to_string(result.sourceColdMilliseconds) + " ms cold, baked " + std::to_string(result.bakedColdMilliseconds) + " ms cold, import " + std::to_string(result.importMilliseconds) + " ms, cull " + std::to_string(result.cullMilliseconds) + " ms", 4);
+
+	return result;
+}
+
+std::vector<benchmark::sceneResult> benchmark::runSuite(const std::vector<sceneConfig>& configs) {
+	std::vector<benchmark::sceneResult> results;
+
+	for (const auto& config : configs) {
+		results.push_back(benchmark::runScene(config));
+	}
+
+	return results;
+}
+
+benchmark::sceneResult benchmark::renderScene(const sceneConfig& config) {
+	benchmark::sceneResult result{};
+	result.config = config;
+
+	std::string directory = benchmark::sceneDirectory + "/" + config.name;
+	renderer::scenePath = benchmark::generateScene(config, directory);
+
+	// rendered from the baked artifacts like a shipped game, so the lod chains take part, the game's records are put back afterwards
+	std::unordered_map<assets::assetId, assets::assetRecord> records = assets::records;
+	assets::import(directory);
+
+	headless::enabled = true;
+	headless::reportPath = directory + ".csv";
+
+	memory::resetHighWater();
+
+	engine::init();
+
+	assets::records = records;
+	assets::saveDatabase(assets::databasePath);
+
+	for (const auto& object : renderer::objects) {
+		result.triangles += renderer::meshes[object.mesh].lods[0].indexCount / 3;
+	}
+
+	// what the gpu buffers hold, so runs with --vertex-format compact can be compared
+	result.meshBytes = static_cast<uint64_t>(renderer::vertexStride(renderer::activeVertexFormat)) * renderer::totalVertices + sizeof(uint32_t) * static_cast<uint64_t>(renderer::totalIndices);
+
+	// the first frames in flight pay for pipeline and cache warm up
+	std::vector<double> record;
+	std::vector<double> cpu;
+	std::vector<double> gpu;
+	std::vector<double> cull;
+	std::vector<double> drawn;
+	std::vector<double> pipelineBinds;
+	std::vector<double> descriptorBinds;
+
+	for (const auto& timing : headless::timings) {
+		if (timing.frame < renderer::maxFramesInFlight) {
+			continue;
+		}
+
+		record.push_back(timing.recordMilliseconds);
+		cpu.push_back(timing.cpuMilliseconds);
+		cull.push_back(timing.cullMilliseconds);
+		drawn.push_back(static_cast<double>(timing.triangles));
+		pipelineBinds.push_back(static_cast<double>(timing.pipelineBinds));
+		descriptorBinds.push_back(static_cast<double>(timing.descriptorBinds));
+
+		if (timing.gpuMilliseconds >= 0.0) {
+			gpu.push_back(timing.gpuMilliseconds);
+		}
+	}
+
+	result.rendered = true;
+	result.frames = static_cast<uint32_t>(headless::timings.size());
+	result.cullMilliseconds = benchmark::average(cull);
+	result.cullP95Milliseconds = benchmark::percentile(cull, 0.95);
+	result.drawnTriangles = benchmark::average(drawn);
+	result.recordMilliseconds = benchmark::average(record);
+	result.recordP95Milliseconds = benchmark::percentile(record, 0.95);
+	result.cpuFrameMilliseconds = benchmark::percentile(cpu, 0.5);
+	result.cpuFrameP95Milliseconds = benchmark::percentile(cpu, 0.95);
+	result.gpuFrameMilliseconds = gpu.empty() ? -1.0 : benchmark::percentile(gpu, 0.5);
+	result.gpuFrameP95Milliseconds = gpu.empty() ? -1.0 : benchmark::percentile(gpu, 0.95);
+	result.pipelineBinds = benchmark::average(pipelineBinds);
+	result.descriptorBinds = benchmark::average(descriptorBinds);
+	result.residentBytes = benchmark::residentBytes();
+	result.memory = memory::stats();
+	result.heaps = memory::deviceHeaps();
+	result.budgetExceeded = memory::budgetExceeded;
+
+	return result;
+}
+
+// one json document per run, keys are stable so results can be diffed and charted
+void benchmark::writeResults(const std::string& path, const std::vector<sceneResult>& results) {
+	std::ofstream file(path, std::ios::trunc);
+
+	if (!file.is_open()) {
+		throw std::runtime_error("Failed to write benchmark results: " + path);
+	}
+
+	file << "{\n\t\"version\": " << benchmark::resultsVersion << ",\n\t\"engine\": \"" << engine::name << "\",\n\t\"scenes\": [\n";
+
+	for (size_t i = 0; i < results.size(); i++) {
+		const benchmark::sceneResult& result = results[i];
+
+		file << "\t\t{\n";
+		file << "\t\t\t\"name\": \"" << result.config.name << "\",\n";
+		file << "\t\t\t\"meshes\": " << result.config.meshCount << ",\n";
+		file << "\t\t\t\"trianglesPerMesh\": " << result.config.trianglesPerMesh << ",\n";
+		file << "\t\t\t\"instanced\": " << (result.config.instanced ? "true" : "false") << ",\n";
+		file << "\t\t\t\"textures\": " << result.config.textureCount << ",\n";
+		file << "\t\t\t\"textureSize\": " << result.config.textureSize << ",\n";
+		file << "\t\t\t\"seed\": " << result.config.seed << ",\n";
+		file << "\t\t\t\"triangles\": " << result.triangles << ",\n";
+		file << "\t\t\t\"drawnTriangles\": " << result.drawnTriangles << ",\n";
+
+		if (result.rendered) {
+			file << "\t\t\t\"frames\": " << result.frames << ",\n";
+			file << "\t\t\t\"meshBytes\": " << result.meshBytes << ",\n";
+			file << "\t\t\t\"cullMs\": " << result.cullMilliseconds << ",\n";
+			file << "\t\t\t\"cullP95Ms\": " << result.cullP95Milliseconds << ",\n";
+			file << "\t\t\t\"recordMs\": " << result.recordMilliseconds << ",\n";
+			file << "\t\t\t\"recordP95Ms\": " << result.recordP95Milliseconds << ",\n";
+			file << "\t\t\t\"cpuFrameMs\": " << result.cpuFrameMilliseconds << ",\n";
+			file << "\t\t\t\"cpuFrameP95Ms\": " << result.cpuFrameP95Milliseconds << ",\n";
+			file << "\t\t\t\"gpuFrameMs\": " << result.gpuFrameMilliseconds << ",\n";
+			file << "\t\t\t\"gpuFrameP95Ms\": " << result.gpuFrameP95Milliseconds << ",\n";
+			file << "\t\t\t\"pipelineBinds\": " << result.pipelineBinds << ",\n";
+			file << "\t\t\t\"descriptorBinds\": " << result.descriptorBinds << ",\n";
+		}
+		else {
+			file << "\t\t\t\"generateMs\": " << result.generateMilliseconds << ",\n";
+			file << "\t\t\t\"sourceColdMs\": " << result.sourceColdMilliseconds << ",\n";
+			file << "\t\t\t\"sourceWarmMs\": " << result.sourceWarmMilliseconds << ",\n";
+			file << "\t\t\t\"importMs\": " << result.importMilliseconds << ",\n";
+			file << "\t\t\t\"bakedColdMs\": " << result.bakedColdMilliseconds << ",\n";
+			file << "\t\t\t\"bakedWarmMs\": " << result.bakedWarmMilliseconds << ",\n";
+			file << "\t\t\t\"meshBytes\": " << result.meshBytes << ",\n";
+			file << "\t\t\t\"textureBytes\": " << result.textureBytes << ",\n";
+			file << "\t\t\t\"cullMs\": " << result.cullMilliseconds << ",\n";
+			file << "\t\t\t\"cullP95Ms\": " << result.cullP95Milliseconds << ",\n";
+			file << "\t\t\t\"visibleObjects\": " << result.visibleObjects << ",\n";
+		}
+
+		file << "\t\t\t\"residentBytes\": " << result.residentBytes << ",\n";
+		file << "\t\t\t\"budgetExceeded\": " << (result.budgetExceeded ? "true" : "false") << ",\n";
+		file << "\t\t\t\"memory\": {\n";
+
+		for (size_t j = 0; j < result.memory.size(); j++) {
+			const memory::tagStats& stats = result.memory[j];
+
+			file << "\t\t\t\t\"" << stats.name << "\": { \"highWaterBytes\": " << stats.highWaterBytes << ", \"allocations\": " << stats.allocations << ", \"peakFrameAllocations\": " << stats.peakFrameAllocations << ", \"deviceHighWaterBytes\": " << stats.deviceHighWaterBytes << " }" << (j + 1 < result.memory.size() ? "," : "") << "\n";
+		}
+
+		file << "\t\t\t},\n";
+		file << "\t\t\t\"heaps\": [";
+
+		for (size_t j = 0; j < result.heaps.size(); j++) {
+			const memory::heapStats& heap = result.heaps[j];
+
+			file << (j == 0 ? "\n" : ",\n") << "\t\t\t\t{ \"heap\": " << heap.heap << ", \"deviceLocal\": " << (heap.deviceLocal ? "true" : "false") << ", \"size\": " << heap.size << ", \"highWaterBytes\": " << heap.highWaterBytes << " }";
+		}
+
+		file << (result.heaps.empty() ? "]\n" : "\n\t\t\t]\n");
+		file << "\t\t}" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+
+	file << "\t]\n}\n";
+
+	logger::log("Successfully wrote benchmark results: " + path, 1);
+}
+
+// unit box standing on the origin, buildings and props are scaled copies of it
+static engine::mesh createBox() {
+	std::vector<renderer::vertex> vertices;
+
+	for (uint32_t corner = 0; corner < 8; corner++) {
+		renderer::vertex vertex{};
+		vertex.pos = glm::vec3(static_cast<float>(corner & 1) - 0.5f, static_cast<float>((corner >> 1) & 1), static_cast<float>((corner >> 2) & 1) - 0.5f);
+		vertex.color = glm::vec3(1.0f);
+		vertices.push_back(vertex);
+	}
+
+	std::vector<uint32_t> indices = {
+		0, 2, 3, 0, 3, 1,
+		4, 5, 7, 4, 7, 6,
+		0, 1, 5, 0, 5, 4,
+		2, 6, 7, 2, 7, 3,
+		0, 4, 6, 0, 6, 2,
+		1, 3, 7, 1, 7, 5
+	};
+
+	return engine::mesh::fromVectors("benchmark/box", std::move(vertices), std::move(indices));
+}
+
+benchmark::occlusionResult benchmark::runOcclusion(uint32_t blocks, uint32_t seed) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	// blocks on a grid, streets run along the grid lines
+	const float pitch = 24.0f;
+	const uint32_t propsPerBlock = 12;
+
+	logger::log("Running occlusion benchmark: " + std::to_string(blocks) + "x" + std::to_string(blocks) + " blocks...", 4);
+
+	benchmark::occlusionResult result{};
+	result.blocks = blocks;
+	result.instructionSet = raster::instructionSet();
+
+	std::vector<engine::mesh> boxes;
+	boxes.push_back(createBox());
+
+	renderer::meshRange range{};
+	range.indexCount = static_cast<uint32_t>(boxes.front().indices().size());
+	range.vertexCount = static_cast<uint32_t>(boxes.front().vertices().size());
+	range.boundsCenter = glm::vec3(0.0f, 0.5f, 0.0f);
+	range.boundsRadius = glm::length(glm::vec3(0.5f));
+	range.boundsMinimum = glm::vec3(-0.5f, 0.0f, -0.5f);
+	range.boundsExtent = glm::vec3(1.0f);
+	range.dequantize = glm::mat4(1.0f);
+	range.lodCount = 1;
+	range.lods[0] = { 0, range.indexCount, 0.0f };
+
+	renderer::meshes = { range };
+	renderer::objects.clear();
+	renderer::visibleObjects.clear();
+
+	raster::enabled = true;
+	raster::buildOccluders(boxes);
+
+	uint32_t state = seedState(seed);
+	float half = static_cast<float>(blocks) * pitch * 0.5f;
+
+	for (uint32_t x = 0; x < blocks; x++) {
+		for (uint32_t z = 0; z < blocks; z++) {
+			glm::vec3 centre((static_cast<float>(x) + 0.5f) * pitch - half, 0.0f, (static_cast<float>(z) + 0.5f) * pitch - half);
+			glm::vec3 footprint(10.0f + 4.0f * randomFloat(state), 6.0f + 34.0f * randomFloat(state), 10.0f + 4.0f * randomFloat(state));
+
+			renderer::objects.push_back({ 0, glm::scale(glm::translate(glm::mat4(1.0f), centre), footprint), 0 });
+
+			// on the pavement around the building
+			for (uint32_t prop = 0; prop < propsPerBlock; prop++) {
+				uint32_t side = nextRandom(state) % 4;
+				float along = randomFloat(state) - 0.5f;
+				float out = 2.0f + 1.5f * randomFloat(state);
+
+				glm::vec3 offset = side < 2
+					? glm::vec3(along * footprint.x, 0.0f, (side == 0 ? -1.0f : 1.0f) * (footprint.z * 0.5f + out))
+					: glm::vec3((side == 2 ? -1.0f : 1.0f) * (footprint.x * 0.5f + out), 0.0f, along * footprint.z);
+
+				glm::vec3 size(0.6f + 0.8f * randomFloat(state), 0.8f + 1.5f * randomFloat(state), 0.6f + 0.8f * randomFloat(state));
+
+				renderer::objects.push_back({ 0, glm::scale(glm::translate(glm::mat4(1.0f), centre + offset), size), 0 });
+			}
+		}
+	}
+
+	result.objects = static_cast<uint32_t>(renderer::objects.size());
+	result.frames = headless::frameCount;
+
+	camera::createCamera();
+
+	float aspectRatio = static_cast<float>(engine::width) / static_cast<float>(engine::height);
+
+	std::vector<double> rasterTimes;
+	std::vector<double> testTimes;
+	uint64_t triangles = 0;
+	uint64_t frustumVisible = 0;
+	uint64_t occlusionVisible = 0;
+
+	// down the middle street at eye height, looking into the side streets and back
+	for (uint32_t frame = 0; frame < result.frames; frame++) {
+		float progress = result.frames > 1 ? static_cast<float>(frame) / static_cast<float>(result.frames - 1) : 0.0f;
+		float yaw = std::sin(progress * glm::two_pi<float>() * 2.0f) * 0.7f;
+
+		camera::camera.eye = glm::vec3(glm::mix(-half + pitch * 0.5f, half - pitch * 0.5f, progress), 1.7f, 0.0f);
+		camera::camera.viewDirection = glm::normalize(glm::vec3(std::cos(yaw), -0.02f, std::sin(yaw)));
+
+		glm::mat4 viewProjection = renderer::projectionMatrix(aspectRatio) * camera::getView();
+
+		renderer::cullObjects(viewProjection);
+		frustumVisible += renderer::visibleObjects.size();
+
+		raster::cull(viewProjection, camera::camera.eye);
+		occlusionVisible += renderer::visibleObjects.size();
+
+		rasterTimes.push_back(raster::rasterMilliseconds);
+		testTimes.push_back(raster::testMilliseconds);
+		triangles += raster::occluderTriangles;
+	}
+
+	double frames = std::max<double>(result.frames, 1.0);
+	double rasterTotal = benchmark::average(rasterTimes) * frames;
+	double testTotal = benchmark::average(testTimes) * frames;
+
+	result.occluderTriangles = static_cast<double>(triangles) / frames;
+	result.rasterMilliseconds = benchmark::average(rasterTimes);
+	result.rasterP95Milliseconds = benchmark::percentile(rasterTimes, 0.95);
+	result.testMilliseconds = benchmark::average(testTimes);
+	result.testP95Milliseconds = benchmark::percentile(testTimes, 0.95);
+	result.frustumVisible = static_cast<double>(frustumVisible) / frames;
+	result.occlusionVisible = static_cast<double>(occlusionVisible) / frames;
+	result.trianglesPerSecond = rasterTotal > 0.0 ? static_cast<double>(triangles) / (rasterTotal / 1000.0) : 0.0;
+	result.testsPerSecond = testTotal > 0.0 ? static_cast<double>(frustumVisible) / (testTotal / 1000.0) : 0.0;
+	result.cullingRate = frustumVisible > 0 ? 1.0 - static_cast<double>(occlusionVisible) / static_cast<double>(frustumVisible) : 0.0;
+
+	logger::log("Occlusion (" + result.instructionSet + "): " + std::to_string(result.objects) + " objects, " + std::to_string(static_cast<uint64_t>(result.frustumVisible)) + " in the frustum, " + std::to_string(static_cast<uint64_t>(result.occlusionVisible)) + " after occlusion, raster " + std::to_string(result.rasterMilliseconds) + " ms, test " + std::to_string(result.testMilliseconds) + " ms", 4);
+
+	return result;
+}
+
+void benchmark::writeOcclusionResults(const std::string& path, const occlusionResult& result) {
+	std::ofstream file(path, std::ios::trunc);
+
+	if (!file.is_open()) {
+		throw std::runtime_error("Failed to write benchmark results: " + path);
+	}
+
+	file << "{\n\t\"version\": " << benchmark::resultsVersion << ",\n\t\"engine\": \"" << engine::name << "\",\n\t\"occlusion\": {\n";
+	file << "\t\t\"instructionSet\": \"" << result.instructionSet << "\",\n";
+	file << "\t\t\"resolution\": [" << raster::width << ", " << raster::height << "],\n";
+	file << "\t\t\"blocks\": " << result.blocks << ",\n";
+	file << "\t\t\"objects\": " << result.objects << ",\n";
+	file << "\t\t\"frames\": " << result.frames << ",\n";
+	file << "\t\t\"occluderTriangles\": " << result.occluderTriangles << ",\n";
+	file << "\t\t\"rasterMs\": " << result.rasterMilliseconds << ",\n";
+	file << "\t\t\"rasterP95Ms\": " << result.rasterP95Milliseconds << ",\n";
+	file << "\t\t\"testMs\": " << result.testMilliseconds << ",\n";
+	file << "\t\t\"testP95Ms\": " << result.testP95Milliseconds << ",\n";
+	file << "\t\t\"trianglesPerSecond\": " << result.trianglesPerSecond << ",\n";
+	file << "\t\t\"testsPerSecond\": " << result.testsPerSecond << ",\n";
+	file << "\t\t\"frustumVisible\": " << result.frustumVisible << ",\n";
+	file << "\t\t\"occlusionVisible\": " << result.occlusionVisible << ",\n";
+	file << "\t\t\"cullingRate\": " << result.cullingRate << "\n";
+	file << "\t}\n}\n";
+
+	logger::log("Successfully wrote benchmark results: " + path, 1);
+}
\ No newline at end of file
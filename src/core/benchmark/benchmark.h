@@ -0,0 +1,143 @@
+#pragma once
+#ifndef benchmark_h
+#define benchmark_h
+
+#include "../src/engine.h"
+
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+#include <fstream>
+
+namespace benchmark {
+	struct ioResult {
+		std::string name;
+		double coldMilliseconds;
+		double warmMilliseconds;
+		uint64_t bytes;
+	};
+
+	// one generated obj parsed by tinyobjloader and by obj::parse, both from a warm file cache
+	struct objResult {
+		uint32_t triangles;
+		uint64_t bytes;
+		double tinyobjMilliseconds;
+		double parserMilliseconds;
+		bool matches;
+	};
+
+	// procedural scenes, the same config always generates byte identical files
+	struct sceneConfig {
+		std::string name;
+		uint32_t meshCount;
+		uint32_t trianglesPerMesh;
+		bool instanced;
+		uint32_t textureCount;
+		uint32_t textureSize;
+		uint32_t seed;
+	};
+
+	// milliseconds unless noted, the render fields are only filled by renderScene
+	struct sceneResult {
+		sceneConfig config;
+		uint64_t triangles;
+
+		double generateMilliseconds;
+		double sourceColdMilliseconds;
+		double sourceWarmMilliseconds;
+		double importMilliseconds;
+		double bakedColdMilliseconds;
+		double bakedWarmMilliseconds;
+
+		uint64_t meshBytes;
+		uint64_t textureBytes;
+		uint64_t residentBytes;
+
+		double cullMilliseconds;
+		double cullP95Milliseconds;
+		double visibleObjects;
+
+		// per frame average at the selected lods, triangles is every object at full detail
+		double drawnTriangles;
+
+		bool rendered;
+		uint32_t frames;
+		double recordMilliseconds;
+		double recordP95Milliseconds;
+		double cpuFrameMilliseconds;
+		double cpuFrameP95Milliseconds;
+		double gpuFrameMilliseconds;
+		double gpuFrameP95Milliseconds;
+		double pipelineBinds;
+		double descriptorBinds;
+
+		// high-water marks since the scene started, device heaps are only filled by renderScene
+		std::vector<memory::tagStats> memory;
+		std::vector<memory::heapStats> heaps;
+		bool budgetExceeded;
+	};
+
+	// a generated city of boxes at street level, frustum culling first and then the software rasterizer
+	struct occlusionResult {
+		uint32_t blocks;
+		uint32_t objects;
+		uint32_t frames;
+		std::string instructionSet;
+
+		// per frame averages
+		double occluderTriangles;
+		double rasterMilliseconds;
+		double rasterP95Milliseconds;
+		double testMilliseconds;
+		double testP95Milliseconds;
+		double frustumVisible;
+		double occlusionVisible;
+
+		// occluder triangles over raster time and box tests over test time
+		double trianglesPerSecond;
+		double testsPerSecond;
+		// share of the objects left by the frustum that the rasterizer hid
+		double cullingRate;
+	};
+
+	const std::string sceneDirectory = "cache/benchmark";
+	const uint32_t resultsVersion = 4;
+
+	double measure(const std::function<void()>& function);
+	double percentile(std::vector<double> values, double fraction);
+	double average(const std::vector<double>& values);
+	uint64_t residentBytes();
+
+	// loads every file under the directory synchronously and asynchronously, with and without the os file cache
+	std::vector<ioResult> runIO(const std::string& directory);
+
+	// writes tori of increasing size into the directory, the parser's output is checked against tinyobjloader's
+	std::vector<objResult> runObj(const std::string& directory);
+
+	std::vector<sceneConfig> defaultSuite();
+	sceneConfig findConfig(const std::string& name);
+
+	// writes meshes, materials, textures and a .scene into the directory, returns the scene path
+	std::string generateScene(const sceneConfig& config, const std::string& directory);
+	void writeMesh(const std::string& path, const std::string& materialLibrary, const std::string& material, uint32_t triangles, uint32_t seed);
+	void writeTexture(const std::string& path, uint32_t size, uint32_t seed);
+
+	// cpu side: load, import, memory and culling over the headless camera path, needs no device
+	sceneResult runScene(const sceneConfig& config);
+	std::vector<sceneResult> runSuite(const std::vector<sceneConfig>& configs);
+
+	// renders the scene headless and fills in recording and frame times
+	sceneResult renderScene(const sceneConfig& config);
+
+	void writeResults(const std::string& path, const std::vector<sceneResult>& results);
+
+	// fills renderer::meshes and renderer::objects directly, needs no device and no files
+	occlusionResult runOcclusion(uint32_t blocks, uint32_t seed);
+	void writeOcclusionResults(const std::string& path, const occlusionResult& result);
+}
+
+#endif
\ No newline at end of file
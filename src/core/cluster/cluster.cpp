@@ -0,0 +1,523 @@
+#include "./cluster.h"
+
+#include <cfloat>
+#include <cmath>
+
+bool cluster::enabled = true;
+
+std::vector<renderer::meshlet> cluster::meshlets;
+
+VkBuffer cluster::meshletBuffer = VK_NULL_HANDLE;
+VkDeviceMemory cluster::meshletBufferMemory = VK_NULL_HANDLE;
+
+std::array<VkBuffer, renderer::maxFramesInFlight> cluster::indexBuffers{};
+std::array<VkDeviceMemory, renderer::maxFramesInFlight> cluster::indexBuffersMemory{};
+uint32_t cluster::indexCapacity = 0;
+
+VkDescriptorSetLayout cluster::descriptorSetLayout = VK_NULL_HANDLE;
+VkPipelineLayout cluster::pipelineLayout = VK_NULL_HANDLE;
+VkPipeline cluster::pipeline = VK_NULL_HANDLE;
+VkDescriptorPool cluster::descriptorPool = VK_NULL_HANDLE;
+std::vector<VkDescriptorSet> cluster::descriptorSets;
+std::array<bool, renderer::maxFramesInFlight> cluster::descriptorsOutdated{};
+
+arena::vector<cluster::draw> cluster::draws;
+arena::vector<uint8_t> cluster::culled;
+
+std::array<VkDrawIndexedIndirectCommand*, renderer::maxFramesInFlight> cluster::commands{};
+std::array<uint32_t, renderer::maxFramesInFlight> cluster::commandCounts{};
+std::array<uint64_t, renderer::maxFramesInFlight> cluster::pendingTriangles{};
+VkDeviceSize cluster::commandOffset = 0;
+VkDeviceSize cluster::uniformOffset = 0;
+
+uint64_t cluster::submittedTriangles = 0;
+uint64_t cluster::visibleTriangles = 0;
+
+// sphere around the box of the corners, the cone axis is the mean of the unit normals and its opening the normal furthest from it
+static renderer::meshlet computeBounds(std::span<const renderer::vertex> vertices, std::span<const uint32_t> indices, uint32_t begin, uint32_t end) {
+	renderer::meshlet meshlet{};
+	meshlet.firstIndex = begin;
+	meshlet.triangleCount = (end - begin) / 3;
+
+	glm::vec3 minimum(FLT_MAX);
+	glm::vec3 maximum(-FLT_MAX);
+
+	for (uint32_t i = begin; i < end; i++) {
+		minimum = glm::min(minimum, vertices[indices[i]].pos);
+		maximum = glm::max(maximum, vertices[indices[i]].pos);
+	}
+
+	glm::vec3 center = (minimum + maximum) * 0.5f;
+	float radius = 0.0f;
+
+	for (uint32_t i = begin; i < end; i++) {
+		radius = std::max(radius, glm::length(vertices[indices[i]].pos - center));
+	}
+
+	meshlet.sphere = glm::vec4(center, radius);
+	meshlet.cone = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+
+	std::array<glm::vec3, cluster::maxTriangles> normals;
+	uint32_t normalCount = 0;
+	glm::vec3 axis(0.0f);
+
+	for (uint32_t i = begin; i < end; i += 3) {
+		glm::vec3 p0 = vertices[indices[i]].pos;
+		glm::vec3 p1 = vertices[indices[i + 1]].pos;
+		glm::vec3 p2 = vertices[indices[i + 2]].pos;
+
+		glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		float length = glm::length(normal);
+
+		// degenerate triangles are never rasterized, they do not widen the cone
+		if (length == 0.0f) {
+			continue;
+		}
+
+		normals[normalCount++] = normal / length;
+		axis += normal / length;
+	}
+
+	float axisLength = glm::length(axis);
+
+	if (axisLength == 0.0f) {
+		return meshlet;
+	}
+
+	axis /= axisLength;
+
+	float minimumDot = 1.0f;
+
+	for (uint32_t i = 0; i < normalCount; i++) {
+		minimumDot = std::min(minimumDot, glm::dot(axis, normals[i]));
+	}
+
+	if (minimumDot > cluster::minimumConeDot) {
+		meshlet.cone = glm::vec4(axis, std::sqrt(1.0f - minimumDot * minimumDot));
+	}
+
+	return meshlet;
+}
+
+std::vector<renderer::meshlet> cluster::build(const std::string& name, std::span<const renderer::vertex> vertices, std::span<const uint32_t> indices) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	std::vector<renderer::meshlet> result;
+
+	// the meshlet that last used each vertex, so counting a triangle's new vertices needs no set
+	std::vector<uint32_t> owner(vertices.size(), UINT32_MAX);
+
+	uint32_t begin = 0;
+	uint32_t vertexCount = 0;
+	uint32_t indexCount = static_cast<uint32_t>(indices.size() - indices.size() % 3);
+
+	auto newVertices = [&](uint32_t i, uint32_t current) {
+		uint32_t a = indices[i];
+		uint32_t b = indices[i + 1];
+		uint32_t c = indices[i + 2];
+
+		return static_cast<uint32_t>(owner[a] != current) + static_cast<uint32_t>(owner[b] != current && b != a) + static_cast<uint32_t>(owner[c] != current && c != a && c != b);
+	};
+
+	for (uint32_t i = 0; i < indexCount; i += 3) {
+		uint32_t current = static_cast<uint32_t>(result.size());
+		uint32_t added = newVertices(i, current);
+
+		if (vertexCount + added > cluster::maxVertices || (i - begin) / 3 == cluster::maxTriangles) {
+			result.push_back(computeBounds(vertices, indices, begin, i));
+
+			begin = i;
+			vertexCount = 0;
+			current = static_cast<uint32_t>(result.size());
+			added = newVertices(i, current);
+		}
+
+		owner[indices[i]] = current;
+		owner[indices[i + 1]] = current;
+		owner[indices[i + 2]] = current;
+
+		vertexCount += added;
+	}
+
+	if (begin < indexCount) {
+		result.push_back(computeBounds(vertices, indices, begin, indexCount));
+	}
+
+	size_t cones = std::count_if(result.begin(), result.end(), [](const renderer::meshlet& meshlet) { return meshlet.cone.w < 1.0f; });
+
+	logger::log("Built " + std::to_string(result.size()) + " meshlets for " + name + ": " + std::to_string(result.empty() ? 0 : indexCount / 3 / result.size()) + " triangles each on average, " + std::to_string(cones) + " with a back-face cone", 4);
+
+	return result;
+}
+
+// the compute pass only runs when the shader was compiled and some object of the scene has enough meshlets
+void cluster::init() {
+	BRUTAL_PROFILE_FUNCTION();
+
+	if (!cluster::enabled) {
+		return;
+	}
+
+	uint64_t capacity = 0;
+
+	for (const auto& object : renderer::objects) {
+		const renderer::meshRange& mesh = renderer::meshes[object.mesh];
+
+		if (mesh.meshletCount >= cluster::minimumMeshlets) {
+			capacity += mesh.lods[0].indexCount;
+		}
+	}
+
+	if (capacity == 0) {
+		logger::log("Cluster culling idle, no mesh of the scene has " + std::to_string(cluster::minimumMeshlets) + " meshlets", 4);
+		return;
+	}
+
+	if (!filesystem::exists(cluster::shaderPath)) {
+		logger::log("Cluster culling disabled, " + cluster::shaderPath + " is missing (see shaders/compile.bat)", 2);
+		return;
+	}
+
+	cluster::indexCapacity = static_cast<uint32_t>(std::min<uint64_t>(capacity, cluster::maxIndices));
+
+	std::array<VkDescriptorSetLayoutBinding, 5> bindings{};
+
+	for (uint32_t i = 0; i < bindings.size(); i++) {
+		bindings[i].binding = i;
+		bindings[i].descriptorCount = 1;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+
+	// frame uniforms and commands live in the gpu frame arena, so they are bound with dynamic offsets
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	bindings[4].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutInfo.pBindings = bindings.data();
+
+	if (vkCreateDescriptorSetLayout(renderer::device, &layoutInfo, nullptr, &cluster::descriptorSetLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create cluster culling descriptor set layout!");
+	}
+
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(cluster::pushConstants);
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &cluster::descriptorSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	if (vkCreatePipelineLayout(renderer::device, &pipelineLayoutInfo, nullptr, &cluster::pipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create cluster culling pipeline layout!");
+	}
+
+	filesystem::fileView shaderCode = filesystem::open(cluster::shaderPath);
+	cluster::pipeline = renderer::createComputePipeline(shaderCode.bytes, cluster::pipelineLayout);
+
+	for (size_t i = 0; i < renderer::maxFramesInFlight; i++) {
+		renderer::createBuffer(sizeof(uint32_t) * static_cast<VkDeviceSize>(cluster::indexCapacity), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, cluster::indexBuffers[i], cluster::indexBuffersMemory[i]);
+	}
+
+	cluster::uploadMeshlets();
+
+	std::array<VkDescriptorPoolSize, 3> poolSizes{};
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	poolSizes[0].descriptorCount = static_cast<uint32_t>(renderer::maxFramesInFlight);
+
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSizes[1].descriptorCount = static_cast<uint32_t>(renderer::maxFramesInFlight) * 3;
+
+	poolSizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	poolSizes[2].descriptorCount = static_cast<uint32_t>(renderer::maxFramesInFlight);
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+	poolInfo.maxSets = static_cast<uint32_t>(renderer::maxFramesInFlight);
+
+	if (vkCreateDescriptorPool(renderer::device, &poolInfo, nullptr, &cluster::descriptorPool) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create cluster culling descriptor pool!");
+	}
+
+	std::vector<VkDescriptorSetLayout> layouts(renderer::maxFramesInFlight, cluster::descriptorSetLayout);
+
+	VkDescriptorSetAllocateInfo allocateInfo{};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocateInfo.descriptorPool = cluster::descriptorPool;
+	allocateInfo.descriptorSetCount = static_cast<uint32_t>(renderer::maxFramesInFlight);
+	allocateInfo.pSetLayouts = layouts.data();
+
+	cluster::descriptorSets.resize(renderer::maxFramesInFlight);
+
+	if (vkAllocateDescriptorSets(renderer::device, &allocateInfo, cluster::descriptorSets.data()) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to allocate cluster culling descriptor sets!");
+	}
+
+	// written at each frame's first use, the same way a reload rewrites them
+	cluster::descriptorsOutdated.fill(true);
+
+	logger::log("Successfully initialized cluster culling: " + std::to_string(cluster::meshlets.size()) + " meshlets, " + std::to_string(cluster::indexCapacity) + " indices per frame", 1);
+}
+
+void cluster::cleanup() {
+	if (cluster::pipeline == VK_NULL_HANDLE) {
+		return;
+	}
+
+	vkDestroyPipeline(renderer::device, cluster::pipeline, nullptr);
+	vkDestroyPipelineLayout(renderer::device, cluster::pipelineLayout, nullptr);
+	vkDestroyDescriptorPool(renderer::device, cluster::descriptorPool, nullptr);
+	vkDestroyDescriptorSetLayout(renderer::device, cluster::descriptorSetLayout, nullptr);
+
+	for (size_t i = 0; i < renderer::maxFramesInFlight; i++) {
+		vkDestroyBuffer(renderer::device, cluster::indexBuffers[i], nullptr);
+		memory::freeDevice(cluster::indexBuffersMemory[i]);
+	}
+
+	if (cluster::meshletBuffer != VK_NULL_HANDLE) {
+		vkDestroyBuffer(renderer::device, cluster::meshletBuffer, nullptr);
+		memory::freeDevice(cluster::meshletBufferMemory);
+	}
+
+	cluster::pipeline = VK_NULL_HANDLE;
+	cluster::meshletBuffer = VK_NULL_HANDLE;
+	cluster::descriptorSets.clear();
+}
+
+void cluster::uploadMeshlets() {
+	if (cluster::meshlets.empty()) {
+		cluster::meshletBuffer = VK_NULL_HANDLE;
+		cluster::meshletBufferMemory = VK_NULL_HANDLE;
+
+		return;
+	}
+
+	renderer::uploadBuffer(cluster::meshlets.data(), sizeof(renderer::meshlet) * cluster::meshlets.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, cluster::meshletBuffer, cluster::meshletBufferMemory);
+}
+
+// meshes after this one keep their meshlets, they only move in the list
+std::function<void()> cluster::replaceMeshlets(uint32_t meshIndex, std::span<const renderer::meshlet> meshMeshlets) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	renderer::meshRange& range = renderer::meshes[meshIndex];
+
+	auto first = cluster::meshlets.begin() + range.firstMeshlet;
+
+	first = cluster::meshlets.erase(first, first + range.meshletCount);
+	cluster::meshlets.insert(first, meshMeshlets.begin(), meshMeshlets.end());
+
+	int64_t delta = static_cast<int64_t>(meshMeshlets.size()) - range.meshletCount;
+
+	for (size_t i = meshIndex + 1; i < renderer::meshes.size(); i++) {
+		renderer::meshes[i].firstMeshlet = static_cast<uint32_t>(renderer::meshes[i].firstMeshlet + delta);
+	}
+
+	range.meshletCount = static_cast<uint32_t>(meshMeshlets.size());
+
+	// the shared index buffer is replaced along with the meshlets, the sets point at both
+	cluster::descriptorsOutdated.fill(true);
+
+	if (cluster::pipeline == VK_NULL_HANDLE) {
+		return []() {};
+	}
+
+	VkBuffer oldMeshletBuffer = cluster::meshletBuffer;
+	VkDeviceMemory oldMeshletBufferMemory = cluster::meshletBufferMemory;
+
+	cluster::uploadMeshlets();
+
+	return [oldMeshletBuffer, oldMeshletBufferMemory]() {
+		if (oldMeshletBuffer != VK_NULL_HANDLE) {
+			vkDestroyBuffer(renderer::device, oldMeshletBuffer, nullptr);
+			memory::freeDevice(oldMeshletBufferMemory);
+		}
+	};
+}
+
+// the slot's last submission has finished, its commands hold how many indices survived
+void cluster::collect(uint32_t frame) {
+	const VkDrawIndexedIndirectCommand* slotCommands = cluster::commands[frame];
+
+	cluster::submittedTriangles = cluster::pendingTriangles[frame];
+	cluster::visibleTriangles = 0;
+
+	if (slotCommands == nullptr) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < cluster::commandCounts[frame]; i++) {
+		cluster::visibleTriangles += slotCommands[i].indexCount / 3;
+	}
+}
+
+static void writeDescriptorSet(uint32_t frame) {
+	std::array<VkDescriptorBufferInfo, 5> bufferInfos{};
+
+	// the dynamic ranges are fixed, each frame allocates them in full
+	bufferInfos[0] = { arena::gpuBuffer, 0, sizeof(cluster::frameUniforms) };
+	bufferInfos[1] = { cluster::meshletBuffer, 0, VK_WHOLE_SIZE };
+	bufferInfos[2] = { renderer::indexBuffer, 0, VK_WHOLE_SIZE };
+	bufferInfos[3] = { cluster::indexBuffers[frame], 0, VK_WHOLE_SIZE };
+	bufferInfos[4] = { arena::gpuBuffer, 0, sizeof(VkDrawIndexedIndirectCommand) * cluster::maxDraws };
+
+	std::array<VkWriteDescriptorSet, 5> descriptorWrites{};
+
+	for (uint32_t i = 0; i < descriptorWrites.size(); i++) {
+		descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[i].dstSet = cluster::descriptorSets[frame];
+		descriptorWrites[i].dstBinding = i;
+		descriptorWrites[i].dstArrayElement = 0;
+		descriptorWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		descriptorWrites[i].descriptorCount = 1;
+		descriptorWrites[i].pBufferInfo = &bufferInfos[i];
+	}
+
+	descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	descriptorWrites[4].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+
+	vkUpdateDescriptorSets(renderer::device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+
+	cluster::descriptorsOutdated[frame] = false;
+}
+
+void cluster::prepare() {
+	BRUTAL_PROFILE_FUNCTION();
+
+	uint32_t frame = renderer::currentFrame;
+
+	cluster::draws = arena::makeVector<cluster::draw>(std::min<size_t>(renderer::visibleObjects.size(), cluster::maxDraws));
+	cluster::culled = arena::makeVector<uint8_t>(renderer::objects.size());
+	cluster::culled.assign(renderer::objects.size(), 0);
+
+	cluster::commands[frame] = nullptr;
+	cluster::commandCounts[frame] = 0;
+	cluster::pendingTriangles[frame] = 0;
+
+	if (!cluster::enabled || cluster::pipeline == VK_NULL_HANDLE || cluster::meshletBuffer == VK_NULL_HANDLE) {
+		return;
+	}
+
+	uint32_t outputIndex = 0;
+
+	for (uint32_t objectIndex : renderer::visibleObjects) {
+		const renderer::sceneObject& object = renderer::objects[objectIndex];
+		const renderer::meshRange& mesh = renderer::meshes[object.mesh];
+
+		// coarser levels have no meshlets, and they are small on screen anyway
+		if (object.lod != 0 || mesh.meshletCount < cluster::minimumMeshlets || cluster::draws.size() == cluster::maxDraws) {
+			continue;
+		}
+
+		if (cluster::indexCapacity - outputIndex < mesh.lods[0].indexCount) {
+			continue;
+		}
+
+		// a mirroring transform turns the winding around, the cones would cull the side that is seen
+		if (glm::determinant(glm::mat3(object.transform)) < 0.0f) {
+			continue;
+		}
+
+		// under a non-uniform scale the normals do not follow mat3(transform) and the cone's angle changes, cones would cull faces that are seen
+		float scaleX = glm::length(glm::vec3(object.transform[0]));
+		float scaleY = glm::length(glm::vec3(object.transform[1]));
+		float scaleZ = glm::length(glm::vec3(object.transform[2]));
+		float longest = std::max(scaleX, std::max(scaleY, scaleZ));
+
+		if (longest - std::min(scaleX, std::min(scaleY, scaleZ)) > cluster::uniformScaleTolerance * longest) {
+			continue;
+		}
+
+		cluster::draws.push_back({ objectIndex, outputIndex });
+		cluster::culled[objectIndex] = 1;
+
+		outputIndex += mesh.lods[0].indexCount;
+	}
+
+	if (cluster::draws.empty()) {
+		return;
+	}
+
+	if (cluster::descriptorsOutdated[frame]) {
+		writeDescriptorSet(frame);
+	}
+
+	cluster::frameUniforms uniforms{};
+	renderer::frustumPlanes(renderer::viewProjection, uniforms.planes);
+	uniforms.eye = glm::vec4(camera::camera.eye, 1.0f);
+
+	arena::gpuAllocation uniformAllocation = arena::allocateGpu(sizeof(uniforms));
+	memcpy(uniformAllocation.mapped, &uniforms, sizeof(uniforms));
+
+	arena::gpuAllocation commandAllocation = arena::allocateGpu(sizeof(VkDrawIndexedIndirectCommand) * cluster::maxDraws);
+	VkDrawIndexedIndirectCommand* drawCommands = static_cast<VkDrawIndexedIndirectCommand*>(commandAllocation.mapped);
+
+	for (uint32_t i = 0; i < cluster::draws.size(); i++) {
+		const cluster::draw& draw = cluster::draws[i];
+		const renderer::meshRange& mesh = renderer::meshes[renderer::objects[draw.object].mesh];
+
+		// the compute pass counts indexCount up from zero
+		drawCommands[i].indexCount = 0;
+		drawCommands[i].instanceCount = 1;
+		drawCommands[i].firstIndex = draw.outputIndex;
+		drawCommands[i].vertexOffset = mesh.vertexOffset;
+		drawCommands[i].firstInstance = 0;
+
+		cluster::pendingTriangles[frame] += mesh.lods[0].indexCount / 3;
+	}
+
+	cluster::commands[frame] = drawCommands;
+	cluster::commandCounts[frame] = static_cast<uint32_t>(cluster::draws.size());
+	cluster::commandOffset = commandAllocation.offset;
+	cluster::uniformOffset = uniformAllocation.offset;
+}
+
+// one workgroup per meshlet, the survivors append their triangles to the object's range of the frame's index buffer
+void cluster::recordCulling(VkCommandBuffer commandBuffer) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cluster::pipeline);
+
+	std::array<uint32_t, 2> dynamicOffsets = { static_cast<uint32_t>(cluster::uniformOffset), static_cast<uint32_t>(cluster::commandOffset) };
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cluster::pipelineLayout, 0, 1, &cluster::descriptorSets[renderer::currentFrame], static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data());
+
+	for (uint32_t i = 0; i < cluster::draws.size(); i++) {
+		const renderer::sceneObject& object = renderer::objects[cluster::draws[i].object];
+		const renderer::meshRange& mesh = renderer::meshes[object.mesh];
+
+		cluster::pushConstants constants{};
+		constants.transform = object.transform;
+		constants.firstMeshlet = mesh.firstMeshlet;
+		constants.firstIndex = mesh.firstIndex;
+		constants.outputIndex = cluster::draws[i].outputIndex;
+		constants.command = i;
+		constants.scale = std::max(glm::length(glm::vec3(object.transform[0])), std::max(glm::length(glm::vec3(object.transform[1])), glm::length(glm::vec3(object.transform[2]))));
+
+		vkCmdPushConstants(commandBuffer, cluster::pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+		vkCmdDispatch(commandBuffer, mesh.meshletCount, 1, 1);
+	}
+}
+
+// one indirect draw per object, drawCount 1 needs neither multiDrawIndirect nor a draw count buffer
+void cluster::recordDraws(VkCommandBuffer commandBuffer) {
+	if (cluster::draws.empty()) {
+		return;
+	}
+
+	vkCmdBindIndexBuffer(commandBuffer, cluster::indexBuffers[renderer::currentFrame], 0, VK_INDEX_TYPE_UINT32);
+
+	for (uint32_t i = 0; i < cluster::draws.size(); i++) {
+		const renderer::sceneObject& object = renderer::objects[cluster::draws[i].object];
+		glm::mat4 transform = renderer::drawTransform(object, renderer::meshes[object.mesh]);
+
+		vkCmdPushConstants(commandBuffer, renderer::pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &transform);
+		vkCmdDrawIndexedIndirect(commandBuffer, arena::gpuBuffer, cluster::commandOffset + sizeof(VkDrawIndexedIndirectCommand) * i, 1, sizeof(VkDrawIndexedIndirectCommand));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+#pragma once
+#ifndef cluster_h
+#define cluster_h
+
+#include "../src/engine.h"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace cluster {
+	// the usual mesh shader limits, so the same meshlets would carry over to a mesh shader path
+	const uint32_t maxVertices = 64;
+	const uint32_t maxTriangles = 124;
+
+	// a cluster whose normals spread further than this from the axis (cosine) faces every way, its cone is left open
+	const float minimumConeDot = 0.1f;
+
+	// relative difference between the longest and shortest axis of an object's transform that still counts as a uniform scale
+	const float uniformScaleTolerance = 0.001f;
+
+	// meshes with fewer meshlets are drawn directly, a dispatch and an indirect draw cost more than culling saves
+	const uint32_t minimumMeshlets = 16;
+
+	// indirect commands per frame, objects past this are drawn without cluster culling
+	const uint32_t maxDraws = 1024;
+
+	// compacted indices per frame in flight, 32 mb each
+	const uint32_t maxIndices = 8 * 1024 * 1024;
+
+	// local_size_x of shaders/cluster.comp, each invocation copies every workgroupSize-th index of its meshlet
+	const uint32_t workgroupSize = 64;
+
+	const std::string shaderPath = "shaders/cluster.spv";
+
+	// std140 block of shaders/cluster.comp
+	struct frameUniforms {
+		std::array<glm::vec4, 6> planes;
+		glm::vec4 eye;
+	};
+
+	struct pushConstants {
+		glm::mat4 transform;
+		uint32_t firstMeshlet;
+		uint32_t firstIndex;
+		uint32_t outputIndex;
+		uint32_t command;
+		float scale;
+	};
+
+	// the object's indirect command is its position in draws
+	struct draw {
+		uint32_t object;
+		uint32_t outputIndex;
+	};
+
+	extern bool enabled;
+
+	// every mesh's meshlets back to back in mesh order, kept on the cpu so a replaced mesh only rebuilds this list
+	extern std::vector<renderer::meshlet> meshlets;
+
+	extern VkBuffer meshletBuffer;
+	extern VkDeviceMemory meshletBufferMemory;
+
+	// written by the compute pass and bound as the index buffer of the culled draws
+	extern std::array<VkBuffer, renderer::maxFramesInFlight> indexBuffers;
+	extern std::array<VkDeviceMemory, renderer::maxFramesInFlight> indexBuffersMemory;
+	extern uint32_t indexCapacity;
+
+	extern VkDescriptorSetLayout descriptorSetLayout;
+	extern VkPipelineLayout pipelineLayout;
+	extern VkPipeline pipeline;
+	extern VkDescriptorPool descriptorPool;
+	extern std::vector<VkDescriptorSet> descriptorSets;
+	// the meshlet and index buffers are swapped by mesh reloads, each set is rewritten once its frame is idle
+	extern std::array<bool, renderer::maxFramesInFlight> descriptorsOutdated;
+
+	// objects drawn through the compute pass this frame, culled is parallel to renderer::objects, both in the frame arena
+	extern arena::vector<draw> draws;
+	extern arena::vector<uint8_t> culled;
+
+	// this frame's indirect commands in the gpu arena, read back once the slot's fence has been waited on
+	extern std::array<VkDrawIndexedIndirectCommand*, renderer::maxFramesInFlight> commands;
+	extern std::array<uint32_t, renderer::maxFramesInFlight> commandCounts;
+	extern std::array<uint64_t, renderer::maxFramesInFlight> pendingTriangles;
+	extern VkDeviceSize commandOffset;
+	extern VkDeviceSize uniformOffset;
+
+	// triangles handed to the compute pass and the ones it kept, from the last finished frame in this slot
+	extern uint64_t submittedTriangles;
+	extern uint64_t visibleTriangles;
+
+	// greedy over the triangles in their cache optimised order, a meshlet ends once another triangle would break a limit
+	std::vector<renderer::meshlet> build(const std::string& name, std::span<const renderer::vertex> vertices, std::span<const uint32_t> indices);
+
+	// after the model buffers and the gpu arena exist
+	void init();
+	void cleanup();
+
+	void uploadMeshlets();
+
+	// swaps the mesh's meshlets in, returns the destruction of the previous buffer like renderer::replaceMesh
+	std::function<void()> replaceMeshlets(uint32_t meshIndex, std::span<const renderer::meshlet> meshMeshlets);
+
+	void collect(uint32_t frame);
+
+	// before the render graph runs, picks the visible objects at lod 0 with enough meshlets and writes their commands
+	void prepare();
+	// the render graph's clusterCulling pass, culls the prepared draws' meshlets on the gpu
+	void recordCulling(VkCommandBuffer commandBuffer);
+	// inside the render pass, after the direct draws since it binds its own index buffer
+	void recordDraws(VkCommandBuffer commandBuffer);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,398 @@
+#include "./compression.h"
+
+#ifdef BRUTAL_ZSTD
+#include <zstd.h>
+#endif
+
+std::vector<compression::assetStats> compression::history;
+std::mutex compression::historyMutex;
+
+compression::codec compression::parseCodec(const std::string& name) {
+	if (name == "none") {
+		return compression::codec::none;
+	}
+	else if (name == "lz4") {
+		return compression::codec::lz4;
+	}
+	else if (name == "zstd") {
+		return compression::codec::zstd;
+	}
+
+	throw std::runtime_error("Unknown compression codec: " + name);
+}
+
+std::string compression::codecName(codec type) {
+	switch (type) {
+		case compression::codec::lz4:
+			return "lz4";
+		case compression::codec::zstd:
+			return "zstd";
+		default:
+			return "none";
+	}
+}
+
+size_t compression::lz4CompressBound(size_t size) {
+	return size + size / 255 + 16;
+}
+
+static void writeLength(unsigned char*& output, size_t length) {
+	while (length >= 255) {
+		*output++ = 255;
+		length -= 255;
+	}
+
+	*output++ = static_cast<unsigned char>(length);
+}
+
+// greedy lz4 block compressor, the output is a standard lz4 block
+size_t compression::lz4Compress(const char* source, size_t sourceSize, char* destination) {
+	const size_t minMatch = 4;
+	const size_t lastLiterals = 5;
+	const size_t matchFindLimit = 12;
+	const uint32_t hashBits = 12;
+
+	const unsigned char* input = reinterpret_cast<const unsigned char*>(source);
+	unsigned char* output = reinterpret_cast<unsigned char*>(destination);
+
+	std::vector<uint32_t> hashTable(static_cast<size_t>(1) << hashBits, 0);
+
+	auto read32 = [input](size_t position) {
+		uint32_t value;
+		memcpy(&value, input + position, sizeof(value));
+		return value;
+	};
+
+	size_t position = 0;
+	size_t anchor = 0;
+
+	auto emitSequence = [&](size_t literalEnd, size_t offset, size_t matchLength) {
+		size_t literalLength = literalEnd - anchor;
+		unsigned char* token = output++;
+
+		*token = static_cast<unsigned char>(std::min<size_t>(literalLength, 15) << 4);
+
+		if (literalLength >= 15) {
+			writeLength(output, literalLength - 15);
+		}
+
+		memcpy(output, input + anchor, literalLength);
+		output += literalLength;
+
+		if (matchLength == 0) {
+			return;
+		}
+
+		*output++ = static_cast<unsigned char>(offset & 0xFF);
+		*output++ = static_cast<unsigned char>(offset >> 8);
+
+		size_t length = matchLength - minMatch;
+		*token |= static_cast<unsigned char>(std::min<size_t>(length, 15));
+
+		if (length >= 15) {
+			writeLength(output, length - 15);
+		}
+	};
+
+	if (sourceSize > matchFindLimit) {
+		size_t matchLimit = sourceSize - lastLiterals;
+		size_t positionLimit = sourceSize - matchFindLimit;
+
+		while (position < positionLimit) {
+			uint32_t sequence = read32(position);
+			uint32_t hash = (sequence * 2654435761u) >> (32 - hashBits);
+			size_t candidate = hashTable[hash];
+			hashTable[hash] = static_cast<uint32_t>(position);
+
+			if (candidate >= position || position - candidate > 65535 || read32(candidate) != sequence) {
+				position++;
+				continue;
+			}
+
+			while (position > anchor && candidate > 0 && input[position - 1] == input[candidate - 1]) {
+				position--;
+				candidate--;
+			}
+
+			size_t matchLength = minMatch;
+
+			while (position + matchLength < matchLimit && input[candidate + matchLength] == input[position + matchLength]) {
+				matchLength++;
+			}
+
+			emitSequence(position, position - candidate, matchLength);
+
+			position += matchLength;
+			anchor = position;
+		}
+	}
+
+	emitSequence(sourceSize, 0, 0);
+
+	return static_cast<size_t>(output - reinterpret_cast<unsigned char*>(destination));
+}
+
+void compression::lz4Decompress(const char* source, size_t sourceSize, char* destination, size_t destinationSize) {
+	const unsigned char* input = reinterpret_cast<const unsigned char*>(source);
+	unsigned char* output = reinterpret_cast<unsigned char*>(destination);
+
+	size_t in = 0;
+	size_t out = 0;
+
+	auto readLength = [&](size_t length) {
+		unsigned char value;
+
+		do {
+			if (in >= sourceSize) {
+				throw std::runtime_error("Failed to decompress lz4 block!");
+			}
+
+			value = input[in++];
+			length += value;
+		} while (value == 255);
+
+		return length;
+	};
+
+	while (true) {
+		if (in >= sourceSize) {
+			throw std::runtime_error("Failed to decompress lz4 block!");
+		}
+
+		unsigned char token = input[in++];
+		size_t literalLength = token >> 4;
+
+		if (literalLength == 15) {
+			literalLength = readLength(literalLength);
+		}
+
+		if (literalLength > sourceSize - in || literalLength > destinationSize - out) {
+			throw std::runtime_error("Failed to decompress lz4 block!");
+		}
+
+		memcpy(output + out, input + in, literalLength);
+		in += literalLength;
+		out += literalLength;
+
+		// the last sequence has literals only
+		if (in == sourceSize) {
+			break;
+		}
+
+		if (sourceSize - in < 2) {
+			throw std::runtime_error("Failed to decompress lz4 block!");
+		}
+
+		size_t offset = input[in] | (static_cast<size_t>(input[in + 1]) << 8);
+		in += 2;
+
+		size_t matchLength = token & 15;
+
+		if (matchLength == 15) {
+			matchLength = readLength(matchLength);
+		}
+
+		matchLength += 4;
+
+		if (offset == 0 || offset > out || matchLength > destinationSize - out) {
+			throw std::runtime_error("Failed to decompress lz4 block!");
+		}
+
+		if (offset >= matchLength) {
+			memcpy(output + out, output + out - offset, matchLength);
+			out += matchLength;
+		}
+		else {
+			for (size_t i = 0; i < matchLength; i++, out++) {
+				output[out] = output[out - offset];
+			}
+		}
+	}
+
+	if (out != destinationSize) {
+		throw std::runtime_error("Failed to decompress lz4 block!");
+	}
+}
+
+bool compression::isBlob(std::span<const char> bytes) {
+	return bytes.size() >= sizeof(compression::blobHeader) && memcmp(bytes.data(), compression::blobMagic, sizeof(compression::blobMagic)) == 0;
+}
+
+uint64_t compression::blobSize(std::span<const char> bytes) {
+	compression::blobHeader header{};
+	memcpy(&header, bytes.data(), sizeof(header));
+
+	return header.uncompressedSize;
+}
+
+std::vector<char> compression::compressBlob(std::span<const char> bytes, codec type, uint32_t chunkSize) {
+	BRUTAL_PROFILE_FUNCTION();
+
+#ifndef BRUTAL_ZSTD
+	if (type == compression::codec::zstd) {
+		throw std::runtime_error("Failed to compress, zstd support was not built in!");
+	}
+#endif
+
+	compression::blobHeader header{};
+	memcpy(header.magic, compression::blobMagic, sizeof(header.magic));
+	header.codec = static_cast<uint32_t>(type);
+	header.chunkSize = chunkSize;
+	header.chunkCount = static_cast<uint32_t>((bytes.size() + chunkSize - 1) / chunkSize);
+	header.uncompressedSize = bytes.size();
+
+	std::vector<std::vector<char>> chunks(header.chunkCount);
+	std::vector<uint32_t> chunkSizes(header.chunkCount);
+
+	jobs::parallelFor(header.chunkCount, 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			std::span<const char> chunk = bytes.subspan(i * chunkSize, std::min<size_t>(chunkSize, bytes.size() - i * chunkSize));
+			size_t compressedSize = 0;
+
+			if (type == compression::codec::lz4) {
+				chunks[i].resize(compression::lz4CompressBound(chunk.size()));
+				compressedSize = compression::lz4Compress(chunk.data(), chunk.size(), chunks[i].data());
+			}
+#ifdef BRUTAL_ZSTD
+			else if (type == compression::codec::zstd) {
+				chunks[i].resize(ZSTD_compressBound(chunk.size()));
+				compressedSize = ZSTD_compress(chunks[i].data(), chunks[i].size(), chunk.data(), chunk.size(), 19);
+
+				if (ZSTD_isError(compressedSize)) {
+					compressedSize = chunk.size();
+				}
+			}
+#endif
+			else {
+				compressedSize = chunk.size();
+			}
+
+			// incompressible chunks are stored as they are
+			if (compressedSize >= chunk.size()) {
+				chunks[i].assign(chunk.begin(), chunk.end());
+				chunkSizes[i] = static_cast<uint32_t>(chunk.size()) | compression::storedChunkFlag;
+			}
+			else {
+				chunks[i].resize(compressedSize);
+				chunkSizes[i] = static_cast<uint32_t>(compressedSize);
+			}
+		}
+	});
+
+	size_t blobSize = sizeof(header) + chunkSizes.size() * sizeof(uint32_t);
+
+	for (const auto& chunk : chunks) {
+		blobSize += chunk.size();
+	}
+
+	std::vector<char> blob(blobSize);
+	char* cursor = blob.data();
+
+	memcpy(cursor, &header, sizeof(header));
+	cursor += sizeof(header);
+
+	if (!chunkSizes.empty()) {
+		memcpy(cursor, chunkSizes.data(), chunkSizes.size() * sizeof(uint32_t));
+		cursor += chunkSizes.size() * sizeof(uint32_t);
+	}
+
+	for (const auto& chunk : chunks) {
+		memcpy(cursor, chunk.data(), chunk.size());
+		cursor += chunk.size();
+	}
+
+	return blob;
+}
+
+void compression::decompressBlob(std::span<const char> blob, std::span<char> destination) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	compression::blobHeader header{};
+
+	if (!compression::isBlob(blob)) {
+		throw std::runtime_error("Failed to decompress, invalid blob!");
+	}
+
+	memcpy(&header, blob.data(), sizeof(header));
+
+	size_t tableSize = static_cast<size_t>(header.chunkCount) * sizeof(uint32_t);
+
+	if (header.uncompressedSize != destination.size() || header.chunkSize == 0 || sizeof(header) + tableSize > blob.size() || (header.uncompressedSize + header.chunkSize - 1) / header.chunkSize != header.chunkCount) {
+		throw std::runtime_error("Failed to decompress, invalid blob!");
+	}
+
+	if (header.chunkCount == 0) {
+		return;
+	}
+
+	std::vector<uint32_t> chunkSizes(header.chunkCount);
+	memcpy(chunkSizes.data(), blob.data() + sizeof(header), tableSize);
+
+	std::vector<size_t> chunkOffsets(header.chunkCount);
+	size_t offset = sizeof(header) + tableSize;
+
+	for (uint32_t i = 0; i < header.chunkCount; i++) {
+		chunkOffsets[i] = offset;
+		offset += chunkSizes[i] & ~compression::storedChunkFlag;
+	}
+
+	if (offset > blob.size()) {
+		throw std::runtime_error("Failed to decompress, invalid blob!");
+	}
+
+	// every chunk lands at its final position in the destination, no intermediate copies
+	jobs::parallelFor(header.chunkCount, 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			const char* source = blob.data() + chunkOffsets[i];
+			size_t sourceSize = chunkSizes[i] & ~compression::storedChunkFlag;
+			std::span<char> chunk = destination.subspan(i * header.chunkSize, std::min<size_t>(header.chunkSize, destination.size() - i * header.chunkSize));
+
+			if (chunkSizes[i] & compression::storedChunkFlag) {
+				if (sourceSize != chunk.size()) {
+					throw std::runtime_error("Failed to decompress, invalid blob!");
+				}
+
+				memcpy(chunk.data(), source, sourceSize);
+			}
+			else if (header.codec == static_cast<uint32_t>(compression::codec::lz4)) {
+				compression::lz4Decompress(source, sourceSize, chunk.data(), chunk.size());
+			}
+#ifdef BRUTAL_ZSTD
+			else if (header.codec == static_cast<uint32_t>(compression::codec::zstd)) {
+				if (ZSTD_decompress(chunk.data(), chunk.size(), source, sourceSize) != chunk.size()) {
+					throw std::runtime_error("Failed to decompress zstd chunk!");
+				}
+			}
+#endif
+			else {
+				throw std::runtime_error("Failed to decompress, unsupported codec: " + compression::codecName(static_cast<compression::codec>(header.codec)));
+			}
+		}
+	});
+}
+
+void compression::record(const std::string& path, std::span<const char> blob, double milliseconds) {
+	compression::blobHeader header{};
+	memcpy(&header, blob.data(), sizeof(header));
+
+	compression::assetStats stats{};
+	stats.path = path;
+	stats.type = static_cast<compression::codec>(header.codec);
+	stats.storedSize = blob.size();
+	stats.uncompressedSize = header.uncompressedSize;
+	stats.milliseconds = milliseconds;
+
+	std::lock_guard<std::mutex> lock(compression::historyMutex);
+	compression::history.push_back(std::move(stats));
+}
+
+void compression::report() {
+	std::lock_guard<std::mutex> lock(compression::historyMutex);
+
+	for (const auto& stats : compression::history) {
+		double ratio = stats.storedSize > 0 ? static_cast<double>(stats.uncompressedSize) / static_cast<double>(stats.storedSize) : 0.0;
+		double throughput = stats.milliseconds > 0.0 ? (static_cast<double>(stats.uncompressedSize) / (1024.0 * 1024.0)) / (stats.milliseconds / 1000.0) : 0.0;
+
+		logger::log(stats.path + " (" + compression::codecName(stats.type) + "): " + std::to_string(stats.storedSize) + " -> " + std::to_string(stats.uncompressedSize) + " bytes, ratio " + std::to_string(ratio) + ", " + std::to_string(stats.milliseconds) + " ms, " + std::to_string(throughput) + " MB/s", 4);
+	}
+}
\ No newline at end of file
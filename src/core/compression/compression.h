@@ -0,0 +1,66 @@
+#pragma once
+#ifndef compression_h
+#define compression_h
+
+#include "../src/engine.h"
+
+#include <vector>
+#include <string>
+#include <span>
+#include <mutex>
+#include <cstdint>
+
+namespace compression {
+	// lz4 favours decompression speed, zstd favours size (BRUTAL_ZSTD builds only)
+	enum class codec : uint32_t {
+		none,
+		lz4,
+		zstd
+	};
+
+	// blobs are independently compressed chunks so they can be decompressed in parallel
+	const char blobMagic[4] = {'B', 'C', 'M', 'P'};
+	// loose files are only treated as blobs by this extension, pack entries by their codec, never by the magic
+	const std::string blobExtension = ".bcmp";
+	const uint32_t defaultChunkSize = 256 * 1024;
+
+	// high bit of a chunk size marks a chunk that was stored uncompressed
+	const uint32_t storedChunkFlag = 0x80000000u;
+
+	struct blobHeader {
+		char magic[4];
+		uint32_t codec;
+		uint32_t chunkSize;
+		uint32_t chunkCount;
+		uint64_t uncompressedSize;
+	};
+
+	struct assetStats {
+		std::string path;
+		codec type;
+		uint64_t storedSize;
+		uint64_t uncompressedSize;
+		double milliseconds;
+	};
+
+	extern std::vector<assetStats> history;
+	extern std::mutex historyMutex;
+
+	codec parseCodec(const std::string& name);
+	std::string codecName(codec type);
+
+	size_t lz4CompressBound(size_t size);
+	size_t lz4Compress(const char* source, size_t sourceSize, char* destination);
+	void lz4Decompress(const char* source, size_t sourceSize, char* destination, size_t destinationSize);
+
+	bool isBlob(std::span<const char> bytes);
+	uint64_t blobSize(std::span<const char> bytes);
+
+	std::vector<char> compressBlob(std::span<const char> bytes, codec type, uint32_t chunkSize = defaultChunkSize);
+	void decompressBlob(std::span<const char> blob, std::span<char> destination);
+
+	void record(const std::string& path, std::span<const char> blob, double milliseconds);
+	void report();
+}
+
+#endif
\ No newline at end of file
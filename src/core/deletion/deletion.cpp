@@ -0,0 +1,135 @@
+#include "./deletion.h"
+
+uint64_t deletion::frameIndex = 1;
+uint64_t deletion::completedFrame = 0;
+std::array<uint64_t, renderer::maxFramesInFlight> deletion::submittedFrames{};
+
+std::vector<deletion::entry> deletion::queue;
+
+static void destroy(deletion::entry& entry) {
+	switch (entry.type) {
+		case deletion::kind::image:
+			vkDestroyImage(renderer::device, entry.object.image, nullptr);
+			break;
+		case deletion::kind::imageView:
+			vkDestroyImageView(renderer::device, entry.object.imageView, nullptr);
+			break;
+		case deletion::kind::pipeline:
+			vkDestroyPipeline(renderer::device, entry.object.pipeline, nullptr);
+			break;
+		case deletion::kind::descriptorPool:
+			vkDestroyDescriptorPool(renderer::device, entry.object.descriptorPool, nullptr);
+			break;
+		case deletion::kind::framebuffer:
+			vkDestroyFramebuffer(renderer::device, entry.object.framebuffer, nullptr);
+			break;
+		case deletion::kind::swapchain:
+			vkDestroySwapchainKHR(renderer::device, entry.object.swapchain, nullptr);
+			break;
+		case deletion::kind::callback:
+			entry.destroy();
+			break;
+	}
+
+	if (entry.memory != VK_NULL_HANDLE) {
+		memory::freeDevice(entry.memory);
+	}
+}
+
+// the last submitted frame is the last one that can use it
+static void push(deletion::entry&& entry) {
+	entry.frame = deletion::frameIndex - 1;
+
+	if (entry.frame <= deletion::completedFrame) {
+		destroy(entry);
+		return;
+	}
+
+	deletion::queue.push_back(std::move(entry));
+}
+
+static deletion::entry makeEntry(deletion::kind type, VkDeviceMemory memory = VK_NULL_HANDLE) {
+	deletion::entry entry{};
+	entry.type = type;
+	entry.memory = memory;
+
+	return entry;
+}
+
+void deletion::retireImage(VkImage image, VkDeviceMemory memory) {
+	deletion::entry entry = makeEntry(deletion::kind::image, memory);
+	entry.object.image = image;
+
+	push(std::move(entry));
+}
+
+void deletion::retireImageView(VkImageView imageView) {
+	deletion::entry entry = makeEntry(deletion::kind::imageView);
+	entry.object.imageView = imageView;
+
+	push(std::move(entry));
+}
+
+void deletion::retirePipeline(VkPipeline pipeline) {
+	deletion::entry entry = makeEntry(deletion::kind::pipeline);
+	entry.object.pipeline = pipeline;
+
+	push(std::move(entry));
+}
+
+void deletion::retireDescriptorPool(VkDescriptorPool descriptorPool) {
+	deletion::entry entry = makeEntry(deletion::kind::descriptorPool);
+	entry.object.descriptorPool = descriptorPool;
+
+	push(std::move(entry));
+}
+
+void deletion::retireFramebuffer(VkFramebuffer framebuffer) {
+	deletion::entry entry = makeEntry(deletion::kind::framebuffer);
+	entry.object.framebuffer = framebuffer;
+
+	push(std::move(entry));
+}
+
+void deletion::retireSwapchain(VkSwapchainKHR swapchain) {
+	deletion::entry entry = makeEntry(deletion::kind::swapchain);
+	entry.object.swapchain = swapchain;
+
+	push(std::move(entry));
+}
+
+void deletion::retire(std::function<void()> destroy) {
+	deletion::entry entry = makeEntry(deletion::kind::callback);
+	entry.destroy = std::move(destroy);
+
+	push(std::move(entry));
+}
+
+void deletion::beginFrame(uint32_t frame) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	// the queue runs in submission order, the slot's fence covers every frame submitted before it too
+	deletion::completedFrame = std::max(deletion::completedFrame, deletion::submittedFrames[frame]);
+
+	size_t released = 0;
+
+	while (released < deletion::queue.size() && deletion::queue[released].frame <= deletion::completedFrame) {
+		destroy(deletion::queue[released]);
+		released++;
+	}
+
+	deletion::queue.erase(deletion::queue.begin(), deletion::queue.begin() + released);
+}
+
+void deletion::endFrame(uint32_t frame) {
+	deletion::submittedFrames[frame] = deletion::frameIndex;
+	deletion::frameIndex++;
+}
+
+void deletion::flush() {
+	for (deletion::entry& entry : deletion::queue) {
+		destroy(entry);
+	}
+
+	deletion::queue.clear();
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+#ifndef deletion_h
+#define deletion_h
+
+#include "../src/engine.h"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace deletion {
+	enum class kind : uint8_t {
+		image,
+		imageView,
+		pipeline,
+		descriptorPool,
+		framebuffer,
+		swapchain,
+		// anything the handles above do not cover, like a mesh's shared buffers or the graph's memory blocks
+		callback
+	};
+
+	union handle {
+		VkImage image;
+		VkImageView imageView;
+		VkPipeline pipeline;
+		VkDescriptorPool descriptorPool;
+		VkFramebuffer framebuffer;
+		VkSwapchainKHR swapchain;
+	};
+
+	// destroyed once the last frame that used it has finished, images give their memory back through memory::freeDevice
+	struct entry {
+		uint64_t frame;
+		kind type;
+		handle object;
+		VkDeviceMemory memory;
+		std::function<void()> destroy;
+	};
+
+	// the frame being recorded, counts submissions from 1 so a skipped frame does not advance it
+	extern uint64_t frameIndex;
+	// every frame up to it has finished, its fence or a later one has been waited on
+	extern uint64_t completedFrame;
+	// the frame each slot submitted last, 0 until its first submission
+	extern std::array<uint64_t, renderer::maxFramesInFlight> submittedFrames;
+
+	// in retirement order, so the frames only go up and a release frees a prefix
+	extern std::vector<entry> queue;
+
+	// every submitted frame may still use it, the frame being recorded must not have recorded it
+	// with nothing in flight it is destroyed right away, so loading before the first frame does not pile up copies
+	void retireImage(VkImage image, VkDeviceMemory memory);
+	void retireImageView(VkImageView imageView);
+	void retirePipeline(VkPipeline pipeline);
+	void retireDescriptorPool(VkDescriptorPool descriptorPool);
+	void retireFramebuffer(VkFramebuffer framebuffer);
+	void retireSwapchain(VkSwapchainKHR swapchain);
+	void retire(std::function<void()> destroy);
+
+	// right after the slot's fence was waited on, frees in one go everything retired up to its last submission
+	void beginFrame(uint32_t frame);
+	// right after the slot's submission
+	void endFrame(uint32_t frame);
+
+	// once the device is idle, at shutdown
+	void flush();
+}
+
+#endif
\ No newline at end of file
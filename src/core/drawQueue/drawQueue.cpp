@@ -0,0 +1,169 @@
+#include "./drawQueue.h"
+
+#include <array>
+
+bool drawQueue::depthPrepass = false;
+bool drawQueue::sorted = true;
+
+arena::vector<drawQueue::item> drawQueue::items;
+arena::vector<drawQueue::item> drawQueue::scratch;
+
+uint32_t drawQueue::boundPipeline = UINT32_MAX;
+bool drawQueue::descriptorsBound = false;
+
+uint32_t drawQueue::pipelineBinds = 0;
+uint32_t drawQueue::descriptorBinds = 0;
+uint32_t drawQueue::drawCalls = 0;
+
+static uint64_t field(uint64_t value, uint32_t bits, uint32_t shift) {
+	return (value & ((uint64_t(1) << bits) - 1)) << shift;
+}
+
+uint64_t drawQueue::makeKey(pass drawPass, renderer::pipelineKind pipeline, float distance, uint32_t mesh) {
+	const uint64_t depthSteps = (uint64_t(1) << drawQueue::depthBits) - 1;
+
+	uint64_t depth = static_cast<uint64_t>(std::clamp(distance / renderer::farPlane, 0.0f, 1.0f) * static_cast<float>(depthSteps));
+
+	return field(static_cast<uint64_t>(drawPass), drawQueue::passBits, drawQueue::passShift)
+		| field(static_cast<uint64_t>(pipeline), drawQueue::pipelineBits, drawQueue::pipelineShift)
+		| field(depth, drawQueue::depthBits, drawQueue::depthShift)
+		| field(mesh, drawQueue::meshBits, drawQueue::meshShift);
+}
+
+void drawQueue::build(const glm::vec3& eye) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	size_t passes = drawQueue::depthPrepass ? 2 : 1;
+
+	drawQueue::items = arena::makeVector<drawQueue::item>(renderer::visibleObjects.size() * passes);
+	drawQueue::scratch = arena::makeVector<drawQueue::item>(drawQueue::sorted ? drawQueue::items.capacity() : 0);
+
+	drawQueue::boundPipeline = UINT32_MAX;
+	drawQueue::descriptorsBound = false;
+	drawQueue::pipelineBinds = 0;
+	drawQueue::descriptorBinds = 0;
+	drawQueue::drawCalls = 0;
+
+	renderer::pipelineKind opaquePipeline = drawQueue::depthPrepass ? renderer::pipelineKind::opaqueAfterPrepass : renderer::pipelineKind::opaque;
+
+	for (uint32_t objectIndex : renderer::visibleObjects) {
+		if (cluster::culled[objectIndex]) {
+			continue;
+		}
+
+		const renderer::sceneObject& object = renderer::objects[objectIndex];
+		const renderer::meshRange& mesh = renderer::meshes[object.mesh];
+
+		glm::vec3 center = glm::vec3(object.transform * glm::vec4(mesh.boundsCenter, 1.0f));
+		float scale = std::max(glm::length(glm::vec3(object.transform[0])), std::max(glm::length(glm::vec3(object.transform[1])), glm::length(glm::vec3(object.transform[2]))));
+		float distance = std::max(glm::length(center - eye) - mesh.boundsRadius * scale, 0.0f);
+
+		if (drawQueue::depthPrepass) {
+			drawQueue::items.push_back({ drawQueue::makeKey(drawQueue::pass::depthPrepass, renderer::pipelineKind::depthPrepass, distance, object.mesh), objectIndex });
+		}
+
+		drawQueue::items.push_back({ drawQueue::makeKey(drawQueue::pass::opaque, opaquePipeline, distance, object.mesh), objectIndex });
+	}
+
+	if (drawQueue::sorted) {
+		drawQueue::radixSort(drawQueue::items, drawQueue::scratch);
+	}
+}
+
+void drawQueue::radixSort(arena::vector<item>& values, arena::vector<item>& temporary) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	size_t count = values.size();
+
+	if (count < 2) {
+		return;
+	}
+
+	// all eight histograms in one read of the keys
+	std::array<std::array<uint32_t, 256>, 8> histograms{};
+
+	for (const auto& value : values) {
+		for (uint32_t digit = 0; digit < 8; digit++) {
+			histograms[digit][(value.key >> (digit * 8)) & 0xFF]++;
+		}
+	}
+
+	temporary.resize(count);
+
+	drawQueue::item* source = values.data();
+	drawQueue::item* destination = temporary.data();
+
+	for (uint32_t digit = 0; digit < 8; digit++) {
+		std::array<uint32_t, 256>& histogram = histograms[digit];
+		uint32_t shift = digit * 8;
+
+		if (histogram[(source[0].key >> shift) & 0xFF] == count) {
+			continue;
+		}
+
+		uint32_t offset = 0;
+
+		for (uint32_t& bucket : histogram) {
+			uint32_t size = bucket;
+			bucket = offset;
+			offset += size;
+		}
+
+		for (size_t i = 0; i < count; i++) {
+			destination[histogram[(source[i].key >> shift) & 0xFF]++] = source[i];
+		}
+
+		std::swap(source, destination);
+	}
+
+	if (source != values.data()) {
+		values.swap(temporary);
+	}
+}
+
+void drawQueue::bindPipeline(VkCommandBuffer commandBuffer, renderer::pipelineKind pipeline) {
+	if (drawQueue::boundPipeline == static_cast<uint32_t>(pipeline)) {
+		return;
+	}
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderer::graphicsPipelines[static_cast<size_t>(pipeline)]);
+
+	drawQueue::boundPipeline = static_cast<uint32_t>(pipeline);
+	drawQueue::pipelineBinds++;
+}
+
+// the frame's descriptor set holds the only texture, so it is bound once per command buffer
+void drawQueue::bindDescriptors(VkCommandBuffer commandBuffer) {
+	if (drawQueue::descriptorsBound) {
+		return;
+	}
+
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderer::pipelineLayout, 0, 1, &renderer::descriptorSets[renderer::currentFrame], 1, &renderer::uniformOffset);
+
+	drawQueue::descriptorsBound = true;
+	drawQueue::descriptorBinds++;
+}
+
+void drawQueue::record(VkCommandBuffer commandBuffer, pass drawPass) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	for (const auto& item : drawQueue::items) {
+		if (item.key >> drawQueue::passShift != static_cast<uint64_t>(drawPass)) {
+			continue;
+		}
+
+		drawQueue::bindPipeline(commandBuffer, static_cast<renderer::pipelineKind>((item.key >> drawQueue::pipelineShift) & ((uint64_t(1) << drawQueue::pipelineBits) - 1)));
+		drawQueue::bindDescriptors(commandBuffer);
+
+		const renderer::sceneObject& object = renderer::objects[item.object];
+		const renderer::meshRange& mesh = renderer::meshes[object.mesh];
+		const renderer::meshLod& lod = mesh.lods[object.lod];
+
+		glm::mat4 transform = renderer::drawTransform(object, mesh);
+		vkCmdPushConstants(commandBuffer, renderer::pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &transform);
+
+		vkCmdDrawIndexed(commandBuffer, lod.indexCount, 1, mesh.firstIndex + lod.firstIndex, mesh.vertexOffset, 0);
+
+		drawQueue::drawCalls++;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+#ifndef drawQueue_h
+#define drawQueue_h
+
+#include "../src/engine.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace drawQueue {
+	// in the order they are recorded
+	enum class pass : uint8_t {
+		depthPrepass,
+		opaque
+	};
+
+	// sort keys from the top: pass, pipeline, depth, mesh, a material field goes between pipeline and depth once objects have materials
+	const uint32_t meshBits = 32;
+	const uint32_t depthBits = 24;
+	const uint32_t pipelineBits = 6;
+	const uint32_t passBits = 2;
+
+	const uint32_t meshShift = 0;
+	const uint32_t depthShift = meshShift + meshBits;
+	const uint32_t pipelineShift = depthShift + depthBits;
+	const uint32_t passShift = pipelineShift + pipelineBits;
+
+	static_assert(passShift + passBits == 64, "drawQueue key fields must fill 64 bits");
+
+	struct item {
+		uint64_t key;
+		uint32_t object;
+	};
+
+	// depth only draws of the opaque objects first, so the opaque pass shades each pixel once
+	extern bool depthPrepass;
+	// off records in renderer::visibleObjects order, to compare against
+	extern bool sorted;
+
+	// in the frame arena, only valid while the frame that built them is recorded
+	extern arena::vector<item> items;
+	extern arena::vector<item> scratch;
+
+	// what the command buffer being recorded has bound, UINT32_MAX before the first bind
+	extern uint32_t boundPipeline;
+	extern bool descriptorsBound;
+
+	// the frame recorded last, indirect draws count as one
+	extern uint32_t pipelineBinds;
+	extern uint32_t descriptorBinds;
+	extern uint32_t drawCalls;
+
+	// distance is to the nearest point of the bounds, quantized over the depth range
+	uint64_t makeKey(pass drawPass, renderer::pipelineKind pipeline, float distance, uint32_t mesh);
+
+	// after cluster::prepare, the objects it took are drawn by cluster::recordDraws instead
+	void build(const glm::vec3& eye);
+
+	// lsd radix sort on 8 bit digits, digits every key shares are skipped
+	void radixSort(arena::vector<item>& values, arena::vector<item>& temporary);
+
+	// only bind when the state changes, and count the binds
+	void bindPipeline(VkCommandBuffer commandBuffer, renderer::pipelineKind pipeline);
+	void bindDescriptors(VkCommandBuffer commandBuffer);
+
+	// inside the render pass, the vertex and index buffers are bound already
+	void record(VkCommandBuffer commandBuffer, pass drawPass);
+}
+
+#endif
\ No newline at end of file
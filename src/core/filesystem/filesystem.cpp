@@ -1,24 +1,729 @@
 #include "./filesystem.h"
 
-extern std::vector<char> filesystem::readFile(const std::string& fileName) {
-	std::ifstream file(fileName, std::ios::ate | std::ios::binary);
+#include <filesystem>
 
-	if (!file.is_open()) {
-		throw std::runtime_error("Failed to open file!");
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(BRUTAL_IO_URING)
+#include <liburing.h>
+#endif
+
+std::vector<filesystem::mount> filesystem::mounts;
+
+#if defined(__linux__) && defined(BRUTAL_IO_URING)
+filesystem::ioBackend filesystem::backend = filesystem::ioBackend::ioUring;
+#else
+filesystem::ioBackend filesystem::backend = filesystem::ioBackend::threadPool;
+#endif
+
+std::unordered_map<std::string, std::future<filesystem::fileView>> filesystem::prefetched;
+std::mutex filesystem::prefetchedMutex;
+
+static bool hasBlobExtension(const std::string& path) {
+	return path.size() >= compression::blobExtension.size() && path.compare(path.size() - compression::blobExtension.size(), compression::blobExtension.size(), compression::blobExtension) == 0;
+}
+
+filesystem::mappedFile::mappedFile(const std::string& path) {
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("Failed to open file: " + path);
+	}
+
+	LARGE_INTEGER fileSize{};
+	GetFileSizeEx(file, &fileSize);
+
+	if (fileSize.QuadPart > 0) {
+		filesystem::mappedFile::mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if (filesystem::mappedFile::mappingHandle != nullptr) {
+			filesystem::mappedFile::mappedData = static_cast<const char*>(MapViewOfFile(filesystem::mappedFile::mappingHandle, FILE_MAP_READ, 0, 0, 0));
+		}
+
+		if (filesystem::mappedFile::mappedData == nullptr) {
+			if (filesystem::mappedFile::mappingHandle != nullptr) {
+				CloseHandle(filesystem::mappedFile::mappingHandle);
+			}
+
+			CloseHandle(file);
+
+			throw std::runtime_error("Failed to map file: " + path);
+		}
+
+		filesystem::mappedFile::mappedSize = static_cast<size_t>(fileSize.QuadPart);
+	}
+
+	CloseHandle(file);
+#else
+	int file = ::open(path.c_str(), O_RDONLY);
+
+	if (file < 0) {
+		throw std::runtime_error("Failed to open file: " + path);
+	}
+
+	struct stat fileStat{};
+	fstat(file, &fileStat);
+
+	if (fileStat.st_size > 0) {
+		void* data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+		if (data == MAP_FAILED) {
+			::close(file);
+
+			throw std::runtime_error("Failed to map file: " + path);
+		}
+
+		filesystem::mappedFile::mappedData = static_cast<const char*>(data);
+		filesystem::mappedFile::mappedSize = static_cast<size_t>(fileStat.st_size);
+	}
+
+	::close(file);
+#endif
+}
+
+filesystem::mappedFile::~mappedFile() {
+#ifdef _WIN32
+	if (filesystem::mappedFile::mappedData != nullptr) {
+		UnmapViewOfFile(filesystem::mappedFile::mappedData);
+	}
+
+	if (filesystem::mappedFile::mappingHandle != nullptr) {
+		CloseHandle(filesystem::mappedFile::mappingHandle);
+	}
+#else
+	if (filesystem::mappedFile::mappedData != nullptr) {
+		munmap(const_cast<char*>(filesystem::mappedFile::mappedData), filesystem::mappedFile::mappedSize);
+	}
+#endif
+}
+
+void filesystem::init() {
+	// packs first, so loose files in the working directory override their contents
+	std::vector<std::string> packs;
+
+	for (const auto& entry : std::filesystem::directory_iterator(".")) {
+		if (entry.is_regular_file() && entry.path().extension() == ".pak") {
+			packs.push_back(entry.path().generic_string());
+		}
+	}
+
+	std::sort(packs.begin(), packs.end());
+
+	for (const auto& pack : packs) {
+		filesystem::mountPack(pack);
+	}
+
+	filesystem::mountDirectory(".");
+}
+
+void filesystem::mountDirectory(const std::string& directory) {
+	filesystem::mount mount{};
+	mount.root = directory;
+
+	filesystem::mounts.push_back(std::move(mount));
+
+	logger::log("Successfully mounted directory: " + directory, 1);
+}
+
+void filesystem::mountPack(const std::string& packPath) {
+	filesystem::mount mount{};
+	mount.root = packPath;
+	mount.pack = std::make_shared<filesystem::mappedFile>(packPath);
+
+	std::span<const char> bytes = mount.pack->bytes();
+
+	filesystem::packHeader header{};
+
+	if (bytes.size() < sizeof(header)) {
+		throw std::runtime_error("Invalid pack file: " + packPath);
+	}
+
+	memcpy(&header, bytes.data(), sizeof(header));
+
+	if (memcmp(header.magic, filesystem::packMagic, sizeof(header.magic)) != 0 || header.version != filesystem::packVersion || sizeof(header) + header.tocSize > bytes.size()) {
+		throw std::runtime_error("Invalid pack file: " + packPath);
+	}
+
+	size_t cursor = sizeof(header);
+	size_t tocEnd = sizeof(header) + header.tocSize;
+
+	for (uint32_t i = 0; i < header.entryCount; i++) {
+		filesystem::packEntry entry{};
+		uint32_t pathLength = 0;
+
+		if (cursor + sizeof(entry) + sizeof(pathLength) > tocEnd) {
+			throw std::runtime_error("Invalid pack file: " + packPath);
+		}
+
+		memcpy(&entry, bytes.data() + cursor, sizeof(entry));
+		cursor += sizeof(entry);
+
+		memcpy(&pathLength, bytes.data() + cursor, sizeof(pathLength));
+		cursor += sizeof(pathLength);
+
+		if (cursor + pathLength > tocEnd || entry.offset > bytes.size() || entry.size > bytes.size() - entry.offset) {
+			throw std::runtime_error("Invalid pack file: " + packPath);
+		}
+
+		mount.entries.emplace(std::string(bytes.data() + cursor, pathLength), entry);
+		cursor += pathLength;
+	}
+
+	logger::log("Successfully mounted pack: " + packPath + " (" + std::to_string(mount.entries.size()) + " entries)", 1);
+
+	filesystem::mounts.push_back(std::move(mount));
+}
+
+void filesystem::unmountAll() {
+	filesystem::mounts.clear();
+}
+
+std::string filesystem::normalizePath(const std::string& path) {
+	std::vector<std::string> parts;
+	std::string part;
+
+	for (size_t i = 0; i <= path.size(); i++) {
+		if (i == path.size() || path[i] == '/' || path[i] == '\\') {
+			if (part == "..") {
+				if (!parts.empty()) {
+					parts.pop_back();
+				}
+			}
+			else if (!part.empty() && part != ".") {
+				parts.push_back(part);
+			}
+
+			part.clear();
+		}
+		else {
+			part += path[i];
+		}
+	}
+
+	std::string normalized;
+
+	for (size_t i = 0; i < parts.size(); i++) {
+		if (i > 0) {
+			normalized += '/';
+		}
+
+		normalized += parts[i];
+	}
+
+	return normalized;
+}
+
+std::string filesystem::resolveLoosePath(const std::string& path) {
+	std::string virtualPath = filesystem::normalizePath(path);
+
+	for (auto mount = filesystem::mounts.rbegin(); mount != filesystem::mounts.rend(); mount++) {
+		if (mount->pack) {
+			if (mount->entries.count(virtualPath) != 0) {
+				return "";
+			}
+		}
+		else if (std::filesystem::is_regular_file(mount->root + "/" + virtualPath)) {
+			return mount->root + "/" + virtualPath;
+		}
+	}
+
+	return "";
+}
+
+bool filesystem::exists(const std::string& path) {
+	std::string virtualPath = filesystem::normalizePath(path);
+
+	for (auto mount = filesystem::mounts.rbegin(); mount != filesystem::mounts.rend(); mount++) {
+		if (mount->pack) {
+			if (mount->entries.count(virtualPath) != 0) {
+				return true;
+			}
+		}
+		else if (std::filesystem::is_regular_file(mount->root + "/" + virtualPath)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+filesystem::fileView filesystem::open(const std::string& path) {
+	std::future<filesystem::fileView> pending;
+
+	{
+		std::lock_guard<std::mutex> lock(filesystem::prefetchedMutex);
+
+		auto entry = filesystem::prefetched.find(filesystem::normalizePath(path));
+
+		if (entry != filesystem::prefetched.end()) {
+			pending = std::move(entry->second);
+			filesystem::prefetched.erase(entry);
+		}
+	}
+
+	if (pending.valid()) {
+		return jobs::wait(pending);
+	}
+
+	return filesystem::openImmediate(path);
+}
+
+filesystem::fileView filesystem::openImmediate(const std::string& path) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	filesystem::fileView stored = filesystem::openStored(path);
+
+	if (!stored.compressed) {
+		return stored;
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	auto buffer = std::make_shared<std::vector<char>>(compression::blobSize(stored.bytes));
+	compression::decompressBlob(stored.bytes, *buffer);
+
+	compression::record(filesystem::normalizePath(path), stored.bytes, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+
+	filesystem::fileView view{};
+	view.bytes = std::span<const char>(buffer->data(), buffer->size());
+	view.owner = std::move(buffer);
+
+	return view;
+}
+
+uint64_t filesystem::fileSize(const std::string& path) {
+	filesystem::fileView stored = filesystem::openStored(path);
+
+	return stored.compressed ? compression::blobSize(stored.bytes) : stored.size();
+}
+
+void filesystem::read(const std::string& path, std::span<char> destination) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	filesystem::fileView stored = filesystem::openStored(path);
+
+	if (!stored.compressed) {
+		if (stored.size() != destination.size()) {
+			throw std::runtime_error("Failed to read file, size mismatch: " + path);
+		}
+
+		memcpy(destination.data(), stored.data(), stored.size());
+		return;
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	compression::decompressBlob(stored.bytes, destination);
+
+	compression::record(filesystem::normalizePath(path), stored.bytes, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+}
+
+filesystem::fileView filesystem::openStored(const std::string& path) {
+	std::string virtualPath = filesystem::normalizePath(path);
+
+	// later mounts overlay earlier ones
+	for (auto mount = filesystem::mounts.rbegin(); mount != filesystem::mounts.rend(); mount++) {
+		if (mount->pack) {
+			auto entry = mount->entries.find(virtualPath);
+
+			if (entry != mount->entries.end()) {
+				filesystem::fileView view{};
+				view.owner = mount->pack;
+				view.bytes = mount->pack->bytes().subspan(entry->second.offset, entry->second.size);
+
+				// blobs packed as they are keep codec none and are recognised by their extension like loose ones
+				if (entry->second.codec != static_cast<uint32_t>(compression::codec::none)) {
+					if (!compression::isBlob(view.bytes) || compression::blobSize(view.bytes) != entry->second.uncompressedSize) {
+						throw std::runtime_error("Invalid pack entry: " + path);
+					}
+
+					view.compressed = true;
+				}
+				else {
+					view.compressed = hasBlobExtension(virtualPath);
+				}
+
+				return view;
+			}
+		}
+		else {
+			std::string loosePath = mount->root + "/" + virtualPath;
+
+			if (std::filesystem::is_regular_file(loosePath)) {
+				auto mapping = std::make_shared<filesystem::mappedFile>(loosePath);
+
+				filesystem::fileView view{};
+				view.bytes = mapping->bytes();
+				view.owner = std::move(mapping);
+				view.compressed = hasBlobExtension(virtualPath);
+
+				return view;
+			}
+		}
+	}
+
+	throw std::runtime_error("Failed to open file: " + path);
+}
+
+std::future<filesystem::fileView> filesystem::openAsync(const std::string& path) {
+	return jobs::async([path]() {
+		filesystem::fileView view = filesystem::openImmediate(path);
+		filesystem::touchPages(view);
+
+		return view;
+	});
+}
+
+#if defined(__linux__) && defined(BRUTAL_IO_URING)
+// reads every loose file with one submission per batch, pack entries are already mapped and go through the workers
+static bool readBatchUring(const std::vector<std::string>& paths, std::vector<size_t>& pending, const std::function<void(size_t index, filesystem::fileView view)>& callback) {
+	const unsigned queueDepth = 64;
+
+	struct io_uring ring;
+
+	if (io_uring_queue_init(queueDepth, &ring, 0) < 0) {
+		return false;
+	}
+
+	struct readRequest {
+		size_t index;
+		int file;
+		size_t offset;
+		std::shared_ptr<std::vector<char>> buffer;
+	};
+
+	std::vector<size_t> packed;
+	std::vector<std::future<void>> callbacks;
+	std::string failure;
+
+	// a failure stops new batches, but the current one is still drained so no file or in-flight buffer leaks
+	for (size_t first = 0; first < pending.size() && failure.empty(); first += queueDepth) {
+		std::vector<readRequest> requests;
+		requests.reserve(queueDepth);
+
+		for (size_t i = first; i < std::min(pending.size(), first + queueDepth); i++) {
+			std::string loosePath = filesystem::resolveLoosePath(paths[pending[i]]);
+
+			if (loosePath.empty()) {
+				packed.push_back(pending[i]);
+				continue;
+			}
+
+			int file = ::open(loosePath.c_str(), O_RDONLY);
+
+			if (file < 0) {
+				failure = "Failed to open file: " + paths[pending[i]];
+				break;
+			}
+
+			struct stat fileStat{};
+			fstat(file, &fileStat);
+
+			readRequest request{};
+			request.index = pending[i];
+			request.file = file;
+			request.buffer = std::make_shared<std::vector<char>>(static_cast<size_t>(fileStat.st_size));
+			requests.push_back(std::move(request));
+		}
+
+		size_t inFlight = 0;
+
+		for (auto& request : requests) {
+			struct io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+			io_uring_prep_read(sqe, request.file, request.buffer->data(), static_cast<unsigned>(request.buffer->size()), 0);
+			io_uring_sqe_set_data(sqe, &request);
+			inFlight++;
+		}
+
+		io_uring_submit(&ring);
+
+		while (inFlight > 0) {
+			struct io_uring_cqe* cqe = nullptr;
+			io_uring_wait_cqe(&ring, &cqe);
+
+			readRequest* request = static_cast<readRequest*>(io_uring_cqe_get_data(cqe));
+			int result = cqe->res;
+			io_uring_cqe_seen(&ring, cqe);
+
+			if (result < 0) {
+				if (failure.empty()) {
+					failure = "Failed to read file: " + paths[request->index];
+				}
+
+				::close(request->file);
+				inFlight--;
+				continue;
+			}
+
+			request->offset += static_cast<size_t>(result);
+
+			// short read, queue the remainder
+			if (result > 0 && request->offset < request->buffer->size()) {
+				struct io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+				io_uring_prep_read(sqe, request->file, request->buffer->data() + request->offset, static_cast<unsigned>(request->buffer->size() - request->offset), request->offset);
+				io_uring_sqe_set_data(sqe, request);
+				io_uring_submit(&ring);
+				continue;
+			}
+
+			::close(request->file);
+			inFlight--;
+
+			filesystem::fileView view{};
+			view.bytes = std::span<const char>(request->buffer->data(), request->offset);
+			view.owner = request->buffer;
+			view.compressed = hasBlobExtension(paths[request->index]);
+
+			size_t index = request->index;
+			std::string path = paths[index];
+
+			callbacks.push_back(jobs::async([&callback, index, view, path]() {
+				if (!view.compressed) {
+					callback(index, view);
+					return;
+				}
+
+				auto start = std::chrono::high_resolution_clock::now();
+
+				auto buffer = std::make_shared<std::vector<char>>(compression::blobSize(view.bytes));
+				compression::decompressBlob(view.bytes, *buffer);
+
+				compression::record(filesystem::normalizePath(path), view.bytes, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+
+				filesystem::fileView decompressed{};
+				decompressed.bytes = std::span<const char>(buffer->data(), buffer->size());
+				decompressed.owner = std::move(buffer);
+
+				callback(index, decompressed);
+			}));
+		}
+	}
+
+	io_uring_queue_exit(&ring);
+
+	// the callbacks reference the caller's callback, every one finishes before anything is rethrown
+	std::exception_ptr exception;
+
+	for (auto& future : callbacks) {
+		try {
+			jobs::wait(future);
+		}
+		catch (...) {
+			if (!exception) {
+				exception = std::current_exception();
+			}
+		}
+	}
+
+	if (exception) {
+		std::rethrow_exception(exception);
+	}
+
+	if (!failure.empty()) {
+		throw std::runtime_error(failure);
+	}
+
+	pending = packed;
+
+	return true;
+}
+#endif
+
+void filesystem::readBatch(const std::vector<std::string>& paths, const std::function<void(size_t index, fileView view)>& callback) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	std::vector<size_t> pending(paths.size());
+
+	for (size_t i = 0; i < paths.size(); i++) {
+		pending[i] = i;
 	}
-	else {
-		logger::log("Successfully opened file: " + std::string(fileName), 1);
+
+#if defined(__linux__) && defined(BRUTAL_IO_URING)
+	if (filesystem::backend == filesystem::ioBackend::ioUring && !readBatchUring(paths, pending, callback)) {
+		logger::log("io_uring unavailable, falling back to the thread pool!", 2);
+
+		filesystem::backend = filesystem::ioBackend::threadPool;
+	}
+#endif
+
+	// each worker maps and faults in its file, then hands it straight to the callback for decoding
+	jobs::parallelFor(pending.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			filesystem::fileView view = filesystem::openImmediate(paths[pending[i]]);
+			filesystem::touchPages(view);
+
+			callback(pending[i], std::move(view));
+		}
+	});
+}
+
+void filesystem::prefetch(const std::vector<std::string>& paths) {
+	std::lock_guard<std::mutex> lock(filesystem::prefetchedMutex);
+
+	for (const auto& path : paths) {
+		std::string virtualPath = filesystem::normalizePath(path);
+
+		if (filesystem::prefetched.count(virtualPath) == 0) {
+			filesystem::prefetched.emplace(virtualPath, filesystem::openAsync(virtualPath));
+		}
+	}
+}
+
+void filesystem::clearPrefetched() {
+	std::lock_guard<std::mutex> lock(filesystem::prefetchedMutex);
+
+	if (!filesystem::prefetched.empty()) {
+		logger::log("Dropping " + std::to_string(filesystem::prefetched.size()) + " unused prefetches", 1);
+	}
+
+	filesystem::prefetched.clear();
+}
+
+void filesystem::touchPages(const fileView& view) {
+	const size_t pageSize = 4096;
+
+#ifndef _WIN32
+	if (!view.empty()) {
+		uintptr_t begin = reinterpret_cast<uintptr_t>(view.data()) & ~static_cast<uintptr_t>(pageSize - 1);
+		madvise(reinterpret_cast<void*>(begin), reinterpret_cast<uintptr_t>(view.data()) + view.size() - begin, MADV_WILLNEED);
+	}
+#endif
+
+	volatile char sink = 0;
+
+	for (size_t offset = 0; offset < view.size(); offset += pageSize) {
+		sink = sink + view.data()[offset];
+	}
+}
+
+void filesystem::evictFromCache(const std::string& path) {
+	std::string loosePath = filesystem::resolveLoosePath(path);
+
+	if (loosePath.empty()) {
+		return;
+	}
+
+#ifdef _WIN32
+	// opening without buffering makes the cache manager drop the file's cached pages
+	HANDLE file = CreateFileA(loosePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, nullptr);
+
+	if (file != INVALID_HANDLE_VALUE) {
+		CloseHandle(file);
+	}
+#else
+	int file = ::open(loosePath.c_str(), O_RDONLY);
+
+	if (file >= 0) {
+		posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED);
+		::close(file);
+	}
+#endif
+}
+
+void filesystem::writePack(const std::string& directory, const std::string& packPath, compression::codec codec) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	std::vector<std::string> paths;
+	std::error_code error;
+
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(directory)) {
+		if (entry.is_regular_file() && !std::filesystem::equivalent(entry.path(), packPath, error)) {
+			paths.push_back(entry.path().generic_string());
+		}
+	}
+
+	std::sort(paths.begin(), paths.end());
+
+	auto alignOffset = [](uint64_t offset) {
+		return (offset + filesystem::packAlignment - 1) & ~static_cast<uint64_t>(filesystem::packAlignment - 1);
+	};
+
+	filesystem::packHeader header{};
+	memcpy(header.magic, filesystem::packMagic, sizeof(header.magic));
+	header.version = filesystem::packVersion;
+	header.entryCount = static_cast<uint32_t>(paths.size());
+	header.alignment = filesystem::packAlignment;
+
+	std::vector<std::string> virtualPaths;
+	std::vector<filesystem::packEntry> entries;
+
+	// virtual paths are relative to the packed directory, so the pack mounts like that directory would
+	for (const auto& path : paths) {
+		virtualPaths.push_back(filesystem::normalizePath(std::filesystem::path(path).lexically_relative(directory).generic_string()));
+		header.tocSize += sizeof(filesystem::packEntry) + sizeof(uint32_t) + virtualPaths.back().size();
 	}
 
-	size_t fileSize = (size_t)file.tellg();
-	std::vector<char> buffer(fileSize);
+	uint64_t offset = alignOffset(sizeof(header) + header.tocSize);
+
+	std::vector<filesystem::fileView> contents;
+	uint64_t uncompressedTotal = 0;
+
+	for (const auto& path : paths) {
+		auto source = std::make_shared<filesystem::mappedFile>(path);
+
+		filesystem::fileView content{};
+		content.bytes = source->bytes();
+		content.owner = source;
+
+		filesystem::packEntry entry{};
+		entry.offset = offset;
+		entry.uncompressedSize = content.size();
+		entry.codec = static_cast<uint32_t>(compression::codec::none);
+
+		// blob files are already compressed and stay readable by their extension
+		if (codec != compression::codec::none && !content.empty() && !hasBlobExtension(path)) {
+			auto blob = std::make_shared<std::vector<char>>(compression::compressBlob(content.bytes, codec));
 
-	logger::log("File size: " + std::to_string(fileSize) + " bytes", 4);
+			// keep already compressed data (png, ...) as it is
+			if (blob->size() < content.size()) {
+				content.bytes = std::span<const char>(blob->data(), blob->size());
+				content.owner = std::move(blob);
+				entry.codec = static_cast<uint32_t>(codec);
+			}
+		}
 
-	file.seekg(0);
-	file.read(buffer.data(), fileSize);
+		entry.size = content.size();
+		uncompressedTotal += entry.uncompressedSize;
+
+		entries.push_back(entry);
+		contents.push_back(std::move(content));
+		offset = alignOffset(offset + entry.size);
+	}
+
+	std::ofstream pack(packPath, std::ios::binary | std::ios::trunc);
+
+	if (!pack.is_open()) {
+		throw std::runtime_error("Failed to create pack: " + packPath);
+	}
+
+	pack.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	for (size_t i = 0; i < entries.size(); i++) {
+		uint32_t pathLength = static_cast<uint32_t>(virtualPaths[i].size());
+
+		pack.write(reinterpret_cast<const char*>(&entries[i]), sizeof(entries[i]));
+		pack.write(reinterpret_cast<const char*>(&pathLength), sizeof(pathLength));
+		pack.write(virtualPaths[i].data(), pathLength);
+	}
+
+	const char padding[filesystem::packAlignment] = {};
+
+	for (size_t i = 0; i < entries.size(); i++) {
+		uint64_t position = static_cast<uint64_t>(pack.tellp());
+		pack.write(padding, static_cast<std::streamsize>(entries[i].offset - position));
+
+		pack.write(contents[i].data(), static_cast<std::streamsize>(contents[i].size()));
+	}
 
-	file.close();
+	pack.close();
 
-	return buffer;
+	logger::log("Successfully wrote pack: " + packPath + " (" + std::to_string(entries.size()) + " entries, " + std::to_string(uncompressedTotal) + " -> " + std::to_string(offset) + " bytes, " + compression::codecName(codec) + ")", 1);
 }
\ No newline at end of file
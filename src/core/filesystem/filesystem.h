@@ -6,9 +6,130 @@
 
 #include <fstream>
 #include <vector>
+#include <string>
+#include <span>
+#include <memory>
+#include <streambuf>
+#include <istream>
+#include <unordered_map>
+#include <future>
+#include <functional>
+#include <mutex>
+
+#include "../compression/compression.h"
 
 namespace filesystem {
-	extern std::vector<char> readFile(const std::string& fileName);
+	// read-only bytes of a file, the owner keeps the mapping (or pack mapping) alive
+	struct fileView {
+		std::shared_ptr<const void> owner;
+		std::span<const char> bytes;
+		// still a compression blob, set by openStored from the pack entry's codec or the blob extension
+		bool compressed = false;
+
+		const char* data() const { return bytes.data(); }
+		size_t size() const { return bytes.size(); }
+		bool empty() const { return bytes.empty(); }
+	};
+
+	class mappedFile {
+		public:
+			mappedFile(const std::string& path);
+			~mappedFile();
+
+			mappedFile(const mappedFile&) = delete;
+			mappedFile& operator=(const mappedFile&) = delete;
+
+			std::span<const char> bytes() const { return std::span<const char>(mappedData, mappedSize); }
+		private:
+			const char* mappedData = nullptr;
+			size_t mappedSize = 0;
+#ifdef _WIN32
+			void* mappingHandle = nullptr;
+#endif
+	};
+
+	// lets std::istream based parsers (tinyobj) read a view without copying it
+	class viewStreamBuffer : public std::streambuf {
+		public:
+			viewStreamBuffer(std::span<const char> bytes) {
+				char* begin = const_cast<char*>(bytes.data());
+				setg(begin, begin, begin + bytes.size());
+			}
+	};
+
+	class viewStream : public std::istream {
+		public:
+			viewStream(const fileView& view) : std::istream(&buffer), buffer(view.bytes) {}
+		private:
+			viewStreamBuffer buffer;
+	};
+
+	// pack files: header, table of contents, then every entry at an aligned offset
+	const char packMagic[4] = {'B', 'P', 'A', 'K'};
+	const uint32_t packVersion = 2;
+	const uint32_t packAlignment = 64;
+
+	struct packHeader {
+		char magic[4];
+		uint32_t version;
+		uint32_t entryCount;
+		uint32_t alignment;
+		uint64_t tocSize;
+	};
+
+	// compressed entries are stored as compression blobs, size is the stored size and codec decides whether they are unpacked
+	struct packEntry {
+		uint64_t offset;
+		uint64_t size;
+		uint64_t uncompressedSize;
+		uint32_t codec;
+		uint32_t reserved;
+	};
+
+	struct mount {
+		std::string root;
+		std::shared_ptr<mappedFile> pack;
+		std::unordered_map<std::string, packEntry> entries;
+	};
+
+	extern std::vector<mount> mounts;
+
+	// threadPool maps and faults files in on the job workers, ioUring batches reads of loose files (BRUTAL_IO_URING builds on Linux)
+	enum class ioBackend {
+		threadPool,
+		ioUring
+	};
+
+	extern ioBackend backend;
+	extern std::unordered_map<std::string, std::future<fileView>> prefetched;
+	extern std::mutex prefetchedMutex;
+
+	void init();
+	void mountDirectory(const std::string& directory);
+	void mountPack(const std::string& packPath);
+	void unmountAll();
+
+	std::string normalizePath(const std::string& path);
+	std::string resolveLoosePath(const std::string& path);
+	bool exists(const std::string& path);
+	fileView open(const std::string& path);
+	fileView openImmediate(const std::string& path);
+	fileView openStored(const std::string& path);
+
+	// decompresses (or copies) straight into caller owned memory such as a mapped staging buffer
+	uint64_t fileSize(const std::string& path);
+	void read(const std::string& path, std::span<char> destination);
+
+	std::future<fileView> openAsync(const std::string& path);
+	void readBatch(const std::vector<std::string>& paths, const std::function<void(size_t index, fileView view)>& callback);
+	void prefetch(const std::vector<std::string>& paths);
+	// drops prefetches nothing opened, so their mappings do not outlive loading
+	void clearPrefetched();
+
+	void touchPages(const fileView& view);
+	void evictFromCache(const std::string& path);
+
+	void writePack(const std::string& directory, const std::string& packPath, compression::codec codec = compression::codec::none);
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,893 @@
+#include "./gltf.h"
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+// nested deeper than any exporter writes, keeps a hostile file from exhausting the stack
+static const uint32_t maximumDepth = 64;
+
+static const gltf::json nullJson{};
+
+const gltf::json& gltf::json::operator[](const std::string& key) const {
+	if (type == kind::object) {
+		for (const auto& [name, value] : object) {
+			if (name == key) {
+				return value;
+			}
+		}
+	}
+
+	return nullJson;
+}
+
+const gltf::json& gltf::json::operator[](size_t index) const {
+	if (type == kind::array && index < array.size()) {
+		return array[index];
+	}
+
+	return nullJson;
+}
+
+bool gltf::json::has(const std::string& key) const {
+	return (*this)[key].type != kind::null;
+}
+
+size_t gltf::json::size() const {
+	return type == kind::array ? array.size() : type == kind::object ? object.size() : 0;
+}
+
+[[noreturn]] static void failJson(const std::string& reason) {
+	throw std::runtime_error("Failed to parse json: " + reason);
+}
+
+static void skipWhitespace(const char*& cursor, const char* end) {
+	while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r')) {
+		cursor++;
+	}
+}
+
+static void appendUtf8(std::string& result, uint32_t codepoint) {
+	if (codepoint < 0x80) {
+		result += static_cast<char>(codepoint);
+	}
+	else if (codepoint < 0x800) {
+		result += static_cast<char>(0xC0 | (codepoint >> 6));
+		result += static_cast<char>(0x80 | (codepoint & 0x3F));
+	}
+	else if (codepoint < 0x10000) {
+		result += static_cast<char>(0xE0 | (codepoint >> 12));
+		result += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+		result += static_cast<char>(0x80 | (codepoint & 0x3F));
+	}
+	else {
+		result += static_cast<char>(0xF0 | (codepoint >> 18));
+		result += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+		result += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+		result += static_cast<char>(0x80 | (codepoint & 0x3F));
+	}
+}
+
+static uint32_t parseHex(const char*& cursor, const char* end) {
+	uint32_t value = 0;
+
+	if (end - cursor < 4 || std::from_chars(cursor, cursor + 4, value, 16).ptr != cursor + 4) {
+		failJson("invalid unicode escape");
+	}
+
+	cursor += 4;
+
+	return value;
+}
+
+static std::string parseString(const char*& cursor, const char* end) {
+	if (cursor >= end || *cursor != '"') {
+		failJson("expected a string");
+	}
+
+	cursor++;
+
+	std::string result;
+
+	while (cursor < end && *cursor != '"') {
+		if (*cursor != '\\') {
+			result += *cursor++;
+			continue;
+		}
+
+		if (++cursor >= end) {
+			break;
+		}
+
+		char escape = *cursor++;
+
+		switch (escape) {
+			case '"': result += '"'; break;
+			case '\\': result += '\\'; break;
+			case '/': result += '/'; break;
+			case 'b': result += '\b'; break;
+			case 'f': result += '\f'; break;
+			case 'n': result += '\n'; break;
+			case 'r': result += '\r'; break;
+			case 't': result += '\t'; break;
+			case 'u': {
+				uint32_t codepoint = parseHex(cursor, end);
+
+				// surrogate pairs come as two escapes
+				if (codepoint >= 0xD800 && codepoint < 0xDC00 && end - cursor >= 2 && cursor[0] == '\\' && cursor[1] == 'u') {
+					cursor += 2;
+					uint32_t low = parseHex(cursor, end);
+					codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+				}
+
+				appendUtf8(result, codepoint);
+				break;
+			}
+			default:
+				failJson("invalid escape");
+		}
+	}
+
+	if (cursor >= end) {
+		failJson("unterminated string");
+	}
+
+	cursor++;
+
+	return result;
+}
+
+static gltf::json parseValue(const char*& cursor, const char* end, uint32_t depth) {
+	if (depth > maximumDepth) {
+		failJson("nested too deeply");
+	}
+
+	skipWhitespace(cursor, end);
+
+	if (cursor >= end) {
+		failJson("unexpected end");
+	}
+
+	gltf::json value;
+
+	if (*cursor == '{') {
+		value.type = gltf::json::kind::object;
+		cursor++;
+		skipWhitespace(cursor, end);
+
+		if (cursor < end && *cursor == '}') {
+			cursor++;
+			return value;
+		}
+
+		while (true) {
+			skipWhitespace(cursor, end);
+			std::string key = parseString(cursor, end);
+
+			skipWhitespace(cursor, end);
+
+			if (cursor >= end || *cursor != ':') {
+				failJson("expected ':'");
+			}
+
+			cursor++;
+			value.object.emplace_back(std::move(key), parseValue(cursor, end, depth + 1));
+
+			skipWhitespace(cursor, end);
+
+			if (cursor < end && *cursor == ',') {
+				cursor++;
+			}
+			else if (cursor < end && *cursor == '}') {
+				cursor++;
+				break;
+			}
+			else {
+				failJson("expected ',' or '}'");
+			}
+		}
+	}
+	else if (*cursor == '[') {
+		value.type = gltf::json::kind::array;
+		cursor++;
+		skipWhitespace(cursor, end);
+
+		if (cursor < end && *cursor == ']') {
+			cursor++;
+			return value;
+		}
+
+		while (true) {
+			value.array.push_back(parseValue(cursor, end, depth + 1));
+
+			skipWhitespace(cursor, end);
+
+			if (cursor < end && *cursor == ',') {
+				cursor++;
+			}
+			else if (cursor < end && *cursor == ']') {
+				cursor++;
+				break;
+			}
+			else {
+				failJson("expected ',' or ']'");
+			}
+		}
+	}
+	else if (*cursor == '"') {
+		value.type = gltf::json::kind::string;
+		value.string = parseString(cursor, end);
+	}
+	else if (end - cursor >= 4 && memcmp(cursor, "true", 4) == 0) {
+		value.type = gltf::json::kind::boolean;
+		value.boolean = true;
+		cursor += 4;
+	}
+	else if (end - cursor >= 5 && memcmp(cursor, "false", 5) == 0) {
+		value.type = gltf::json::kind::boolean;
+		cursor += 5;
+	}
+	else if (end - cursor >= 4 && memcmp(cursor, "null", 4) == 0) {
+		cursor += 4;
+	}
+	else {
+		std::from_chars_result result = std::from_chars(cursor, end, value.number);
+
+		if (result.ec != std::errc()) {
+			failJson("unexpected character");
+		}
+
+		value.type = gltf::json::kind::number;
+		cursor = result.ptr;
+	}
+
+	return value;
+}
+
+gltf::json gltf::parseJson(std::string_view text) {
+	const char* cursor = text.data();
+	const char* end = cursor + text.size();
+
+	gltf::json document = parseValue(cursor, end, 0);
+
+	skipWhitespace(cursor, end);
+
+	// glb pads the json chunk with spaces, anything else after the document is an error
+	if (cursor != end && *cursor != '\0') {
+		failJson("trailing characters");
+	}
+
+	return document;
+}
+
+static std::vector<char> decodeBase64(std::string_view text) {
+	std::vector<char> result;
+	result.reserve(text.size() / 4 * 3);
+
+	uint32_t buffer = 0;
+	int bits = 0;
+
+	for (char character : text) {
+		int value;
+
+		if (character >= 'A' && character <= 'Z') value = character - 'A';
+		else if (character >= 'a' && character <= 'z') value = character - 'a' + 26;
+		else if (character >= '0' && character <= '9') value = character - '0' + 52;
+		else if (character == '+') value = 62;
+		else if (character == '/') value = 63;
+		else if (character == '=') break;
+		else continue;
+
+		buffer = (buffer << 6) | static_cast<uint32_t>(value);
+		bits += 6;
+
+		if (bits >= 8) {
+			bits -= 8;
+			result.push_back(static_cast<char>((buffer >> bits) & 0xFF));
+		}
+	}
+
+	return result;
+}
+
+static std::string baseDirectoryOf(const std::string& path) {
+	return path.substr(0, path.find_last_of("/\\") + 1);
+}
+
+// the json text and, for glb files, the binary chunk, both point into the file's mapping
+static std::string_view readContainer(const filesystem::fileView& file, filesystem::fileView& binary, const std::string& path) {
+	uint32_t header[3] = {};
+
+	if (file.size() < sizeof(header)) {
+		return std::string_view(file.data(), file.size());
+	}
+
+	memcpy(header, file.data(), sizeof(header));
+
+	if (header[0] != gltf::glbMagic) {
+		return std::string_view(file.data(), file.size());
+	}
+
+	if (header[1] != gltf::glbVersion || header[2] > file.size()) {
+		throw std::runtime_error("Failed to load glb: " + path);
+	}
+
+	std::string_view text;
+	size_t offset = sizeof(header);
+
+	while (offset + 8 <= header[2]) {
+		uint32_t chunk[2];
+		memcpy(chunk, file.data() + offset, sizeof(chunk));
+		offset += sizeof(chunk);
+
+		if (offset + chunk[0] > header[2]) {
+			throw std::runtime_error("Failed to load glb, truncated chunk: " + path);
+		}
+
+		if (chunk[1] == gltf::jsonChunk && text.empty()) {
+			text = std::string_view(file.data() + offset, chunk[0]);
+		}
+		else if (chunk[1] == gltf::binaryChunk && binary.empty()) {
+			binary.owner = file.owner;
+			binary.bytes = file.bytes.subspan(offset, chunk[0]);
+		}
+
+		// chunks are padded to four bytes
+		offset += (chunk[0] + 3) & ~3u;
+	}
+
+	if (text.empty()) {
+		throw std::runtime_error("Failed to load glb, missing json chunk: " + path);
+	}
+
+	return text;
+}
+
+gltf::asset gltf::open(const std::string& path) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	gltf::asset result;
+	result.path = path;
+
+	filesystem::fileView file = filesystem::open(path);
+	filesystem::fileView binary;
+
+	result.document = gltf::parseJson(readContainer(file, binary, path));
+
+	const gltf::json& buffers = result.document["buffers"];
+	std::string baseDirectory = baseDirectoryOf(path);
+
+	for (size_t i = 0; i < buffers.size(); i++) {
+		std::string uri = buffers[i]["uri"].stringOr("");
+		filesystem::fileView buffer;
+
+		if (uri.empty()) {
+			buffer = binary;
+		}
+		else if (uri.rfind("data:", 0) == 0) {
+			size_t comma = uri.find(',');
+
+			if (comma == std::string::npos || uri.find(";base64") > comma) {
+				throw std::runtime_error("Failed to load gltf, unsupported data uri: " + path);
+			}
+
+			auto decoded = std::make_shared<std::vector<char>>(decodeBase64(std::string_view(uri).substr(comma + 1)));
+
+			buffer.bytes = std::span<const char>(decoded->data(), decoded->size());
+			buffer.owner = std::move(decoded);
+		}
+		else {
+			buffer = filesystem::open(filesystem::normalizePath(baseDirectory + uri));
+		}
+
+		uint64_t byteLength = static_cast<uint64_t>(buffers[i]["byteLength"].integerOr(0));
+
+		if (byteLength > buffer.size()) {
+			throw std::runtime_error("Failed to load gltf, buffer " + std::to_string(i) + " is truncated: " + path);
+		}
+
+		buffer.bytes = buffer.bytes.subspan(0, static_cast<size_t>(byteLength));
+
+		result.buffers.push_back(std::move(buffer));
+	}
+
+	return result;
+}
+
+bool gltf::isGltf(const std::string& path) {
+	std::string extension = std::filesystem::path(assets::sourcePath(path)).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char character) { return static_cast<char>(std::tolower(character)); });
+
+	return extension == ".gltf" || extension == ".glb";
+}
+
+std::string gltf::meshPath(const std::string& path, uint32_t mesh) {
+	return mesh == 0 ? path : path + "#" + std::to_string(mesh);
+}
+
+void gltf::splitMeshPath(const std::string& meshPath, std::string& path, uint32_t& mesh) {
+	size_t fragment = meshPath.find_last_of('#');
+
+	path = meshPath.substr(0, fragment);
+	mesh = 0;
+
+	if (fragment != std::string::npos) {
+		std::from_chars(meshPath.data() + fragment + 1, meshPath.data() + meshPath.size(), mesh);
+	}
+}
+
+uint32_t gltf::meshCount(const gltf::asset& file) {
+	return static_cast<uint32_t>(file.document["meshes"].size());
+}
+
+// one accessor resolved down to its bytes, bounds checked against the buffer view
+struct accessorView {
+	const char* data;
+	size_t count;
+	size_t stride;
+	uint32_t componentType;
+	uint32_t components;
+	bool normalized;
+	int64_t buffer;
+};
+
+static uint32_t componentSize(uint32_t componentType) {
+	switch (componentType) {
+		case gltf::componentSignedByte:
+		case gltf::componentUnsignedByte:
+			return 1;
+		case gltf::componentSignedShort:
+		case gltf::componentUnsignedShort:
+			return 2;
+		case gltf::componentUnsignedInt:
+		case gltf::componentFloat:
+			return 4;
+	}
+
+	throw std::runtime_error("Failed to load gltf, unknown component type: " + std::to_string(componentType));
+}
+
+static uint32_t componentCount(const std::string& type) {
+	if (type == "SCALAR") return 1;
+	if (type == "VEC2") return 2;
+	if (type == "VEC3") return 3;
+	if (type == "VEC4") return 4;
+	if (type == "MAT4") return 16;
+
+	throw std::runtime_error("Failed to load gltf, unsupported accessor type: " + type);
+}
+
+static accessorView accessorAt(const gltf::asset& file, int64_t index) {
+	const gltf::json& accessor = file.document["accessors"][static_cast<size_t>(index)];
+
+	if (accessor.type != gltf::json::kind::object || !accessor.has("bufferView") || accessor.has("sparse")) {
+		throw std::runtime_error("Failed to load gltf, unsupported accessor " + std::to_string(index) + ": " + file.path);
+	}
+
+	const gltf::json& bufferView = file.document["bufferViews"][static_cast<size_t>(accessor["bufferView"].integerOr(-1))];
+
+	accessorView view{};
+	view.buffer = bufferView["buffer"].integerOr(-1);
+	view.componentType = static_cast<uint32_t>(accessor["componentType"].integerOr(0));
+	view.components = componentCount(accessor["type"].stringOr(""));
+	view.normalized = accessor["normalized"].boolean;
+
+	size_t elementSize = componentSize(view.componentType) * view.components;
+
+	int64_t count = accessor["count"].integerOr(0);
+	int64_t stride = bufferView["byteStride"].integerOr(static_cast<int64_t>(elementSize));
+	int64_t viewOffset = bufferView["byteOffset"].integerOr(0);
+	int64_t viewLength = bufferView["byteLength"].integerOr(0);
+	int64_t accessorOffset = accessor["byteOffset"].integerOr(0);
+
+	if (count < 0 || viewOffset < 0 || viewLength < 0 || accessorOffset < 0 || stride < static_cast<int64_t>(elementSize) || view.buffer < 0 || static_cast<size_t>(view.buffer) >= file.buffers.size()) {
+		throw std::runtime_error("Failed to load gltf, accessor " + std::to_string(index) + " is malformed: " + file.path);
+	}
+
+	view.count = static_cast<size_t>(count);
+	view.stride = static_cast<size_t>(stride);
+
+	size_t offset = static_cast<size_t>(viewOffset);
+	size_t length = static_cast<size_t>(viewLength);
+	size_t start = static_cast<size_t>(accessorOffset);
+	size_t bufferSize = file.buffers[view.buffer].size();
+
+	// in subtraction form, so offsets and counts near the top of the range can not wrap past the checks
+	bool outside = offset > bufferSize || length > bufferSize - offset;
+
+	if (!outside && view.count > 0) {
+		outside = start > length || elementSize > length - start || view.count - 1 > (length - start - elementSize) / view.stride;
+	}
+
+	if (outside) {
+		throw std::runtime_error("Failed to load gltf, accessor " + std::to_string(index) + " is out of bounds: " + file.path);
+	}
+
+	view.data = file.buffers[view.buffer].data() + offset + start;
+
+	return view;
+}
+
+static float readComponent(const char* source, uint32_t componentType, bool normalized) {
+	switch (componentType) {
+		case gltf::componentFloat: {
+			float value;
+			memcpy(&value, source, sizeof(value));
+			return value;
+		}
+		case gltf::componentUnsignedByte: {
+			uint8_t value = static_cast<uint8_t>(*source);
+			return normalized ? value / 255.0f : value;
+		}
+		case gltf::componentSignedByte: {
+			int8_t value = static_cast<int8_t>(*source);
+			return normalized ? std::max(value / 127.0f, -1.0f) : value;
+		}
+		case gltf::componentUnsignedShort: {
+			uint16_t value;
+			memcpy(&value, source, sizeof(value));
+			return normalized ? value / 65535.0f : value;
+		}
+		case gltf::componentSignedShort: {
+			int16_t value;
+			memcpy(&value, source, sizeof(value));
+			return normalized ? std::max(value / 32767.0f, -1.0f) : value;
+		}
+		case gltf::componentUnsignedInt: {
+			uint32_t value;
+			memcpy(&value, source, sizeof(value));
+			return static_cast<float>(value);
+		}
+	}
+
+	return 0.0f;
+}
+
+// tightly packed floats are copied in one go, anything else goes component by component
+template<typename vectorType>
+static void readAttribute(const accessorView& view, std::vector<renderer::vertex>& vertices, size_t base, vectorType renderer::vertex::* member) {
+	const uint32_t components = std::min<uint32_t>(view.components, vectorType::length());
+
+	if (view.componentType == gltf::componentFloat && view.components == vectorType::length()) {
+		for (size_t i = 0; i < view.count; i++) {
+			memcpy(&(vertices[base + i].*member), view.data + i * view.stride, sizeof(vectorType));
+		}
+
+		return;
+	}
+
+	uint32_t size = componentSize(view.componentType);
+
+	for (size_t i = 0; i < view.count; i++) {
+		const char* element = view.data + i * view.stride;
+
+		for (uint32_t component = 0; component < components; component++) {
+			(vertices[base + i].*member)[component] = readComponent(element + component * size, view.componentType, view.normalized);
+		}
+	}
+}
+
+static uint32_t readIndex(const char* source, uint32_t componentType) {
+	if (componentType == gltf::componentUnsignedByte) {
+		return static_cast<uint8_t>(*source);
+	}
+
+	if (componentType == gltf::componentUnsignedShort) {
+		uint16_t value;
+		memcpy(&value, source, sizeof(value));
+		return value;
+	}
+
+	uint32_t value;
+	memcpy(&value, source, sizeof(value));
+	return value;
+}
+
+// interleaved pos, color, texCoord floats with a 32 byte stride and 32 bit indices in the same buffer need no conversion
+static bool viewDirectly(const gltf::asset& file, const gltf::json& primitive, const std::string& path, engine::mesh& result) {
+	const gltf::json& attributes = primitive["attributes"];
+
+	if (primitive["mode"].integerOr(gltf::modeTriangles) != gltf::modeTriangles || !attributes.has("POSITION") || !attributes.has("COLOR_0") || !attributes.has("TEXCOORD_0") || !primitive.has("indices")) {
+		return false;
+	}
+
+	accessorView positions = accessorAt(file, attributes["POSITION"].integerOr(-1));
+	accessorView colors = accessorAt(file, attributes["COLOR_0"].integerOr(-1));
+	accessorView texcoords = accessorAt(file, attributes["TEXCOORD_0"].integerOr(-1));
+	accessorView indices = accessorAt(file, primitive["indices"].integerOr(-1));
+
+	bool interleaved = positions.stride == sizeof(renderer::vertex) && colors.stride == sizeof(renderer::vertex) && texcoords.stride == sizeof(renderer::vertex)
+		&& positions.componentType == gltf::componentFloat && colors.componentType == gltf::componentFloat && texcoords.componentType == gltf::componentFloat
+		&& positions.components == 3 && colors.components == 3 && texcoords.components == 2 && colors.count == positions.count && texcoords.count == positions.count
+		&& colors.data == positions.data + offsetof(renderer::vertex, color) && texcoords.data == positions.data + offsetof(renderer::vertex, texCoord)
+		&& reinterpret_cast<uintptr_t>(positions.data) % alignof(renderer::vertex) == 0;
+
+	bool packedIndices = indices.componentType == gltf::componentUnsignedInt && indices.stride == sizeof(uint32_t) && indices.buffer == positions.buffer
+		&& reinterpret_cast<uintptr_t>(indices.data) % alignof(uint32_t) == 0;
+
+	if (!interleaved || !packedIndices) {
+		return false;
+	}
+
+	std::span<const renderer::vertex> vertexSpan(reinterpret_cast<const renderer::vertex*>(positions.data), positions.count);
+	std::span<const uint32_t> indexSpan(reinterpret_cast<const uint32_t*>(indices.data), indices.count);
+
+	for (uint32_t index : indexSpan) {
+		if (index >= positions.count) {
+			throw std::runtime_error("Failed to load gltf, index out of range: " + path);
+		}
+	}
+
+	result = engine::mesh::fromView(path, file.buffers[positions.buffer], vertexSpan, indexSpan);
+
+	return true;
+}
+
+engine::mesh gltf::loadMesh(const gltf::asset& file, uint32_t mesh) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	const gltf::json& primitives = file.document["meshes"][mesh]["primitives"];
+	std::string path = gltf::meshPath(file.path, mesh);
+
+	if (primitives.size() == 0) {
+		throw std::runtime_error("Failed to load gltf, mesh has no primitives: " + path);
+	}
+
+	engine::mesh direct;
+
+	if (primitives.size() == 1 && viewDirectly(file, primitives[0], path, direct)) {
+		return direct;
+	}
+
+	std::vector<renderer::vertex> vertices;
+	std::vector<uint32_t> indices;
+
+	for (const auto& primitive : primitives.array) {
+		if (primitive["mode"].integerOr(gltf::modeTriangles) != gltf::modeTriangles) {
+			logger::log("Skipping non-triangle primitive in: " + path, 2);
+			continue;
+		}
+
+		const gltf::json& attributes = primitive["attributes"];
+
+		if (!attributes.has("POSITION")) {
+			throw std::runtime_error("Failed to load gltf, primitive without positions: " + path);
+		}
+
+		accessorView positions = accessorAt(file, attributes["POSITION"].integerOr(-1));
+
+		if (positions.components != 3) {
+			throw std::runtime_error("Failed to load gltf, positions are not vec3: " + path);
+		}
+
+		size_t base = vertices.size();
+
+		renderer::vertex blank{};
+		blank.color = { 1.0f, 1.0f, 1.0f };
+
+		vertices.resize(base + positions.count, blank);
+
+		readAttribute(positions, vertices, base, &renderer::vertex::pos);
+
+		for (const char* name : { "COLOR_0", "TEXCOORD_0" }) {
+			if (!attributes.has(name)) {
+				continue;
+			}
+
+			accessorView attribute = accessorAt(file, attributes[name].integerOr(-1));
+
+			if (attribute.count != positions.count) {
+				throw std::runtime_error(std::string("Failed to load gltf, ") + name + " count differs from positions: " + path);
+			}
+
+			// gltf texture coordinates already start at the top left like vulkan's, unlike obj's
+			if (name[0] == 'C') {
+				readAttribute(attribute, vertices, base, &renderer::vertex::color);
+			}
+			else {
+				readAttribute(attribute, vertices, base, &renderer::vertex::texCoord);
+			}
+		}
+
+		if (primitive.has("indices")) {
+			accessorView view = accessorAt(file, primitive["indices"].integerOr(-1));
+
+			size_t first = indices.size();
+			indices.resize(first + view.count);
+
+			for (size_t i = 0; i < view.count; i++) {
+				uint32_t index = readIndex(view.data + i * view.stride, view.componentType);
+
+				if (index >= positions.count) {
+					throw std::runtime_error("Failed to load gltf, index out of range: " + path);
+				}
+
+				indices[first + i] = static_cast<uint32_t>(base + index);
+			}
+		}
+		else {
+			for (size_t i = 0; i < positions.count; i++) {
+				indices.push_back(static_cast<uint32_t>(base + i));
+			}
+		}
+	}
+
+	return engine::mesh::fromVectors(path, std::move(vertices), std::move(indices));
+}
+
+engine::mesh gltf::loadMesh(const std::string& meshPath) {
+	std::string path;
+	uint32_t mesh;
+
+	gltf::splitMeshPath(meshPath, path, mesh);
+
+	gltf::asset file = gltf::open(path);
+
+	if (mesh >= gltf::meshCount(file)) {
+		throw std::runtime_error("Failed to load gltf, no such mesh: " + meshPath);
+	}
+
+	return gltf::loadMesh(file, mesh);
+}
+
+static std::string imagePath(const gltf::asset& file, int64_t texture) {
+	const gltf::json& image = file.document["images"][static_cast<size_t>(file.document["textures"][static_cast<size_t>(texture)]["source"].integerOr(-1))];
+	std::string uri = image["uri"].stringOr("");
+
+	// embedded images are not separate assets
+	if (uri.empty() || uri.rfind("data:", 0) == 0) {
+		return "";
+	}
+
+	return filesystem::normalizePath(baseDirectoryOf(file.path) + uri);
+}
+
+std::vector<gltf::material> gltf::materials(const gltf::asset& file) {
+	std::vector<gltf::material> result;
+
+	for (const auto& entry : file.document["materials"].array) {
+		const gltf::json& pbr = entry["pbrMetallicRoughness"];
+		const gltf::json& factor = pbr["baseColorFactor"];
+
+		gltf::material material{};
+		material.name = entry["name"].stringOr("");
+		material.baseColor = glm::vec4(1.0f);
+
+		for (size_t i = 0; i < 4 && i < factor.size(); i++) {
+			material.baseColor[static_cast<glm::length_t>(i)] = static_cast<float>(factor[i].numberOr(1.0));
+		}
+
+		if (pbr["baseColorTexture"].has("index")) {
+			material.baseColorTexture = imagePath(file, pbr["baseColorTexture"]["index"].integerOr(-1));
+		}
+
+		result.push_back(material);
+	}
+
+	return result;
+}
+
+static glm::mat4 localTransform(const gltf::json& node) {
+	const gltf::json& matrix = node["matrix"];
+
+	if (matrix.size() == 16) {
+		glm::mat4 result;
+
+		for (size_t i = 0; i < 16; i++) {
+			glm::value_ptr(result)[i] = static_cast<float>(matrix[i].numberOr(0.0));
+		}
+
+		return result;
+	}
+
+	const gltf::json& translation = node["translation"];
+	const gltf::json& rotation = node["rotation"];
+	const gltf::json& scale = node["scale"];
+
+	glm::vec3 t(static_cast<float>(translation[0].numberOr(0.0)), static_cast<float>(translation[1].numberOr(0.0)), static_cast<float>(translation[2].numberOr(0.0)));
+	glm::quat r(static_cast<float>(rotation[3].numberOr(1.0)), static_cast<float>(rotation[0].numberOr(0.0)), static_cast<float>(rotation[1].numberOr(0.0)), static_cast<float>(rotation[2].numberOr(0.0)));
+	glm::vec3 s(static_cast<float>(scale[0].numberOr(1.0)), static_cast<float>(scale[1].numberOr(1.0)), static_cast<float>(scale[2].numberOr(1.0)));
+
+	return glm::translate(glm::mat4(1.0f), t) * glm::mat4_cast(r) * glm::scale(glm::mat4(1.0f), s);
+}
+
+// depth first from the default scene's roots, parents always come before their children
+std::vector<gltf::node> gltf::nodes(const gltf::asset& file) {
+	const gltf::json& nodes = file.document["nodes"];
+	const gltf::json& scene = file.document["scenes"][static_cast<size_t>(file.document["scene"].integerOr(0))];
+
+	std::vector<int64_t> roots;
+
+	if (scene.has("nodes")) {
+		for (const auto& root : scene["nodes"].array) {
+			roots.push_back(root.integerOr(-1));
+		}
+	}
+	else {
+		std::vector<bool> isChild(nodes.size(), false);
+
+		for (const auto& node : nodes.array) {
+			for (const auto& child : node["children"].array) {
+				if (child.integerOr(-1) >= 0 && static_cast<size_t>(child.integerOr(-1)) < nodes.size()) {
+					isChild[static_cast<size_t>(child.integerOr(-1))] = true;
+				}
+			}
+		}
+
+		for (size_t i = 0; i < nodes.size(); i++) {
+			if (!isChild[i]) {
+				roots.push_back(static_cast<int64_t>(i));
+			}
+		}
+	}
+
+	struct pending {
+		int64_t node;
+		int32_t parent;
+	};
+
+	std::vector<gltf::node> result;
+	std::vector<bool> visited(nodes.size(), false);
+	std::vector<pending> stack;
+
+	for (auto root = roots.rbegin(); root != roots.rend(); root++) {
+		stack.push_back({ *root, -1 });
+	}
+
+	while (!stack.empty()) {
+		pending current = stack.back();
+		stack.pop_back();
+
+		// a node may only appear once, cycles and shared children are dropped
+		if (current.node < 0 || static_cast<size_t>(current.node) >= nodes.size() || visited[static_cast<size_t>(current.node)]) {
+			continue;
+		}
+
+		visited[static_cast<size_t>(current.node)] = true;
+
+		const gltf::json& entry = nodes[static_cast<size_t>(current.node)];
+
+		gltf::node node{};
+		node.name = entry["name"].stringOr("");
+		node.parent = current.parent;
+		node.mesh = static_cast<int32_t>(entry["mesh"].integerOr(-1));
+		node.material = node.mesh >= 0 ? static_cast<int32_t>(file.document["meshes"][static_cast<size_t>(node.mesh)]["primitives"][0]["material"].integerOr(-1)) : -1;
+		node.transform = current.parent >= 0 ? result[current.parent].transform * localTransform(entry) : localTransform(entry);
+
+		int32_t index = static_cast<int32_t>(result.size());
+		result.push_back(node);
+
+		const gltf::json& children = entry["children"];
+
+		for (size_t i = children.size(); i > 0; i--) {
+			stack.push_back({ children[i - 1].integerOr(-1), index });
+		}
+	}
+
+	return result;
+}
+
+std::vector<std::string> gltf::dependencies(const std::string& path) {
+	filesystem::fileView file = filesystem::open(path);
+	filesystem::fileView binary;
+
+	gltf::json document = gltf::parseJson(readContainer(file, binary, path));
+
+	std::vector<std::string> result;
+	std::string baseDirectory = baseDirectoryOf(path);
+
+	for (const char* key : { "buffers", "images" }) {
+		for (const auto& entry : document[key].array) {
+			std::string uri = entry["uri"].stringOr("");
+
+			if (!uri.empty() && uri.rfind("data:", 0) != 0) {
+				result.push_back(filesystem::normalizePath(baseDirectory + uri));
+			}
+		}
+	}
+
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+#pragma once
+#ifndef gltf_h
+#define gltf_h
+
+#include "../src/engine.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace gltf {
+	const uint32_t glbMagic = 0x46546C67;
+	const uint32_t glbVersion = 2;
+	const uint32_t jsonChunk = 0x4E4F534A;
+	const uint32_t binaryChunk = 0x004E4942;
+
+	const uint32_t componentSignedByte = 5120;
+	const uint32_t componentUnsignedByte = 5121;
+	const uint32_t componentSignedShort = 5122;
+	const uint32_t componentUnsignedShort = 5123;
+	const uint32_t componentUnsignedInt = 5125;
+	const uint32_t componentFloat = 5126;
+
+	const uint32_t modeTriangles = 4;
+
+	// just enough json for gltf documents, objects keep their key order
+	struct json {
+		enum class kind : uint8_t {
+			null,
+			boolean,
+			number,
+			string,
+			array,
+			object
+		};
+
+		kind type = kind::null;
+		bool boolean = false;
+		double number = 0.0;
+		std::string string;
+		std::vector<json> array;
+		std::vector<std::pair<std::string, json>> object;
+
+		// missing keys and indices return a null value instead of throwing
+		const json& operator[](const std::string& key) const;
+		const json& operator[](size_t index) const;
+
+		bool has(const std::string& key) const;
+		size_t size() const;
+
+		double numberOr(double fallback) const { return type == kind::number ? number : fallback; }
+		// clamped, a number past the range of int64_t does not convert
+		int64_t integerOr(int64_t fallback) const { return type != kind::number ? fallback : number >= 0x1p63 ? INT64_MAX : number < -0x1p63 ? INT64_MIN : static_cast<int64_t>(number); }
+		std::string stringOr(const std::string& fallback) const { return type == kind::string ? string : fallback; }
+	};
+
+	json parseJson(std::string_view text);
+
+	struct material {
+		std::string name;
+		glm::vec4 baseColor;
+		std::string baseColorTexture;
+	};
+
+	// world transforms, parent is an index into the same list or -1
+	struct node {
+		std::string name;
+		int32_t parent;
+		int32_t mesh;
+		int32_t material;
+		glm::mat4 transform;
+	};
+
+	// the document and its buffers, glb binary chunks and external .bin files stay mapped
+	struct asset {
+		std::string path;
+		json document;
+		std::vector<filesystem::fileView> buffers;
+	};
+
+	asset open(const std::string& path);
+
+	bool isGltf(const std::string& path);
+
+	// "<file>#<mesh>" names one mesh of a file, a path without a fragment is its first mesh
+	std::string meshPath(const std::string& path, uint32_t mesh);
+	void splitMeshPath(const std::string& meshPath, std::string& path, uint32_t& mesh);
+
+	uint32_t meshCount(const asset& file);
+
+	// primitives laid out like renderer::vertex are handed out as views into the buffer, everything else is converted
+	engine::mesh loadMesh(const asset& file, uint32_t mesh);
+	engine::mesh loadMesh(const std::string& meshPath);
+
+	std::vector<material> materials(const asset& file);
+	std::vector<node> nodes(const asset& file);
+
+	std::vector<std::string> dependencies(const std::string& path);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,890 @@
+#include "./graph.h"
+
+#include <algorithm>
+#include <array>
+
+std::vector<graph::resource> graph::resources;
+std::vector<graph::pass> graph::passes;
+std::vector<graph::state> graph::states;
+std::vector<graph::memoryBlock> graph::blocks;
+std::vector<graph::access> graph::finalAccesses;
+
+bool graph::compiled = false;
+VkExtent2D graph::extent = {0, 0};
+
+std::vector<VkImageMemoryBarrier> graph::imageBarriers;
+std::vector<VkImageMemoryBarrier2> graph::imageBarriers2;
+
+uint32_t graph::barrierBatches = 0;
+uint32_t graph::imageBarrierCount = 0;
+
+// the legacy write bits have the same values in synchronization2, so one mask serves both
+static const VkAccessFlags2 writeAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_HOST_WRITE_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+
+static const std::array<graph::usageInfo, static_cast<size_t>(graph::usage::count)> usageTable = {{
+	{ VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_UNDEFINED, false },
+	{ VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false },
+	// fills and clears as well as copies
+	{ VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_CLEAR_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true },
+	{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, true },
+	{ VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, true },
+	{ VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, false },
+	{ VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false },
+	{ VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, false },
+	{ VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, true },
+	{ VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, true },
+	{ VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, false },
+	{ VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, false },
+	// the index fetch alone, vertex attributes stay out of it
+	{ VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT, VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT, VK_ACCESS_2_INDEX_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, false },
+	// the stage the acquire semaphore is waited on, so next frame's transition out of it chains with the wait
+	{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, false }
+}};
+
+const graph::usageInfo& graph::describe(usage use) {
+	return usageTable[static_cast<size_t>(use)];
+}
+
+// states and barriers are kept in whichever flags the device records barriers with
+static VkPipelineStageFlags2 stagesOf(const graph::usageInfo& info) {
+	return renderer::synchronization2 ? info.stages2 : info.stages;
+}
+
+static VkAccessFlags2 accessOf(const graph::usageInfo& info) {
+	return renderer::synchronization2 ? info.access2 : info.access;
+}
+
+static VkImageMemoryBarrier imageBarrier(VkImage image, VkImageAspectFlags aspect, uint32_t levels, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccess, VkAccessFlags dstAccess) {
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = oldLayout;
+	barrier.newLayout = newLayout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = aspect;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = levels;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+	barrier.srcAccessMask = srcAccess;
+	barrier.dstAccessMask = dstAccess;
+
+	return barrier;
+}
+
+static VkImageMemoryBarrier2 imageBarrier2(VkImage image, VkImageAspectFlags aspect, uint32_t levels, VkImageLayout oldLayout, VkImageLayout newLayout, VkPipelineStageFlags2 srcStages, VkAccessFlags2 srcAccess, VkPipelineStageFlags2 dstStages, VkAccessFlags2 dstAccess) {
+	VkImageMemoryBarrier2 barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+	barrier.srcStageMask = srcStages;
+	barrier.srcAccessMask = srcAccess;
+	barrier.dstStageMask = dstStages;
+	barrier.dstAccessMask = dstAccess;
+	barrier.oldLayout = oldLayout;
+	barrier.newLayout = newLayout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = aspect;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = levels;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+
+	return barrier;
+}
+
+static void pipelineBarrier2(VkCommandBuffer commandBuffer, const VkMemoryBarrier2* memoryBarrier, uint32_t imageBarrierCount, const VkImageMemoryBarrier2* imageBarriers) {
+	VkDependencyInfo dependencyInfo{};
+	dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+	dependencyInfo.memoryBarrierCount = memoryBarrier != nullptr ? 1 : 0;
+	dependencyInfo.pMemoryBarriers = memoryBarrier;
+	dependencyInfo.imageMemoryBarrierCount = imageBarrierCount;
+	dependencyInfo.pImageMemoryBarriers = imageBarriers;
+
+	renderer::cmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+}
+
+void graph::transition(VkCommandBuffer commandBuffer, VkImage image, VkImageAspectFlags aspect, uint32_t levels, usage from, usage to) {
+	const graph::usageInfo& source = graph::describe(from);
+	const graph::usageInfo& destination = graph::describe(to);
+
+	if (renderer::synchronization2) {
+		VkImageMemoryBarrier2 barrier = imageBarrier2(image, aspect, levels, source.layout, destination.layout, source.stages2, source.access2 & writeAccessMask, destination.stages2, destination.access2);
+
+		pipelineBarrier2(commandBuffer, nullptr, 1, &barrier);
+		return;
+	}
+
+	VkImageMemoryBarrier barrier = imageBarrier(image, aspect, levels, source.layout, destination.layout, static_cast<VkAccessFlags>(source.access & writeAccessMask), destination.access);
+
+	vkCmdPipelineBarrier(commandBuffer, source.stages, destination.stages, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+static uint32_t addResource(graph::resource&& resource) {
+	resource.firstPass = UINT32_MAX;
+	resource.lastPass = UINT32_MAX;
+	resource.block = UINT32_MAX;
+	resource.memory = VK_NULL_HANDLE;
+
+	graph::resources.push_back(std::move(resource));
+
+	return static_cast<uint32_t>(graph::resources.size() - 1);
+}
+
+uint32_t graph::importImage(const std::string& name, VkFormat format, VkImageAspectFlags aspect, bool preserved, usage finalUsage) {
+	graph::resource resource{};
+	resource.name = name;
+	resource.image = true;
+	resource.imported = true;
+	resource.preserved = preserved;
+	resource.finalUsage = finalUsage;
+	resource.format = format;
+	resource.aspect = aspect;
+	resource.levels = 1;
+
+	return addResource(std::move(resource));
+}
+
+uint32_t graph::importBuffer(const std::string& name, bool preserved) {
+	graph::resource resource{};
+	resource.name = name;
+	resource.image = false;
+	resource.imported = true;
+	resource.preserved = preserved;
+	resource.finalUsage = graph::usage::undefined;
+
+	return addResource(std::move(resource));
+}
+
+uint32_t graph::createImage(const std::string& name, VkFormat format, VkImageAspectFlags aspect, VkImageUsageFlags imageUsage) {
+	graph::resource resource{};
+	resource.name = name;
+	resource.image = true;
+	resource.imported = false;
+	resource.preserved = false;
+	resource.finalUsage = graph::usage::undefined;
+	resource.format = format;
+	resource.aspect = aspect;
+	resource.levels = 1;
+	resource.imageUsage = imageUsage;
+
+	return addResource(std::move(resource));
+}
+
+uint32_t graph::addPass(const std::string& name, passKind kind, std::function<void(VkCommandBuffer)> record) {
+	graph::pass pass{};
+	pass.name = name;
+	pass.kind = kind;
+	pass.record = std::move(record);
+	pass.renderPass = VK_NULL_HANDLE;
+
+	graph::passes.push_back(std::move(pass));
+
+	return static_cast<uint32_t>(graph::passes.size() - 1);
+}
+
+void graph::use(uint32_t passIndex, uint32_t resourceIndex, usage use) {
+	graph::passes[passIndex].accesses.push_back({ resourceIndex, use });
+}
+
+void graph::colorAttachment(uint32_t passIndex, uint32_t resourceIndex, VkAttachmentLoadOp loadOp, VkAttachmentStoreOp storeOp, VkClearValue clearValue) {
+	graph::passes[passIndex].colorAttachments.push_back({ resourceIndex, loadOp, storeOp, clearValue });
+	graph::use(passIndex, resourceIndex, graph::usage::colorAttachment);
+}
+
+void graph::depthAttachment(uint32_t passIndex, uint32_t resourceIndex, VkAttachmentLoadOp loadOp, VkAttachmentStoreOp storeOp, VkClearValue clearValue) {
+	graph::pass& pass = graph::passes[passIndex];
+	pass.hasDepthAttachment = true;
+	pass.depthAttachment = { resourceIndex, loadOp, storeOp, clearValue };
+
+	graph::use(passIndex, resourceIndex, graph::usage::depthAttachment);
+}
+
+void graph::bindImage(uint32_t resourceIndex, const std::vector<VkImage>& images, const std::vector<VkImageView>& views, uint32_t levels) {
+	graph::resource& resource = graph::resources[resourceIndex];
+
+	// the stages stay, frames in flight may still be using what was bound before
+	if (resource.images != images && resourceIndex < graph::states.size()) {
+		graph::states[resourceIndex].layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	}
+
+	resource.images = images;
+	resource.views = views;
+	resource.levels = levels;
+}
+
+// attachments only read what was there before when they load it
+static bool readsPrevious(const graph::pass& pass, const graph::access& access) {
+	if (access.use == graph::usage::colorAttachment) {
+		for (const graph::attachment& attachment : pass.colorAttachments) {
+			if (attachment.resource == access.resource) {
+				return attachment.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD;
+			}
+		}
+	}
+
+	if (access.use == graph::usage::depthAttachment) {
+		return pass.depthAttachment.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD;
+	}
+
+	const graph::usageInfo& info = graph::describe(access.use);
+
+	return !info.writes || (info.access & ~writeAccessMask) != 0;
+}
+
+static VkRenderPass createRenderPass(graph::pass& pass) {
+	std::vector<VkAttachmentDescription> descriptions;
+	std::vector<VkAttachmentReference> colorReferences;
+	VkAttachmentReference depthReference{};
+
+	pass.clearValues.clear();
+
+	// the graph's barriers move the attachments in and out, the render pass never changes their layout
+	auto describeAttachment = [&](const graph::attachment& attachment, VkImageLayout layout) {
+		VkAttachmentDescription description{};
+		description.format = graph::resources[attachment.resource].format;
+		description.samples = VK_SAMPLE_COUNT_1_BIT;
+		description.loadOp = attachment.loadOp;
+		description.storeOp = attachment.storeOp;
+		description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		description.initialLayout = layout;
+		description.finalLayout = layout;
+
+		descriptions.push_back(description);
+		pass.clearValues.push_back(attachment.clearValue);
+
+		return VkAttachmentReference{ static_cast<uint32_t>(descriptions.size() - 1), layout };
+	};
+
+	for (const graph::attachment& attachment : pass.colorAttachments) {
+		colorReferences.push_back(describeAttachment(attachment, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL));
+	}
+
+	if (pass.hasDepthAttachment) {
+		depthReference = describeAttachment(pass.depthAttachment, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+	}
+
+	VkSubpassDescription subpass{};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = static_cast<uint32_t>(colorReferences.size());
+	subpass.pColorAttachments = colorReferences.data();
+	subpass.pDepthStencilAttachment = pass.hasDepthAttachment ? &depthReference : nullptr;
+
+	VkRenderPassCreateInfo renderPassInfo{};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.attachmentCount = static_cast<uint32_t>(descriptions.size());
+	renderPassInfo.pAttachments = descriptions.data();
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+
+	VkRenderPass renderPass;
+
+	if (vkCreateRenderPass(renderer::device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create render pass for " + pass.name + "!");
+	}
+
+	return renderPass;
+}
+
+// the attachment infos of dynamic rendering, the views change with the swapchain and are filled in when the pass begins
+static void describeRenderingAttachments(graph::pass& pass) {
+	pass.renderingAttachments.clear();
+
+	auto describeAttachment = [&](const graph::attachment& attachment, VkImageLayout layout) {
+		VkRenderingAttachmentInfo info{};
+		info.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+		info.imageView = VK_NULL_HANDLE;
+		info.imageLayout = layout;
+		info.resolveMode = VK_RESOLVE_MODE_NONE;
+		info.loadOp = attachment.loadOp;
+		info.storeOp = attachment.storeOp;
+		info.clearValue = attachment.clearValue;
+
+		pass.renderingAttachments.push_back(info);
+	};
+
+	for (const graph::attachment& attachment : pass.colorAttachments) {
+		describeAttachment(attachment, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+	}
+
+	if (pass.hasDepthAttachment) {
+		describeAttachment(pass.depthAttachment, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+	}
+}
+
+void graph::compile() {
+	BRUTAL_PROFILE_FUNCTION();
+
+	// walking backwards, a pass is needed when it writes something a needed pass reads, or something read after the frame
+	std::vector<uint8_t> needed(graph::resources.size(), 0);
+
+	for (size_t i = 0; i < graph::resources.size(); i++) {
+		const graph::resource& resource = graph::resources[i];
+
+		needed[i] = resource.imported && (resource.preserved || resource.finalUsage != graph::usage::undefined) ? 1 : 0;
+	}
+
+	uint32_t culledPasses = 0;
+
+	for (size_t i = graph::passes.size(); i-- > 0;) {
+		graph::pass& pass = graph::passes[i];
+
+		bool keep = pass.sideEffects;
+
+		for (const graph::access& access : pass.accesses) {
+			keep = keep || (graph::describe(access.use).writes && needed[access.resource]);
+		}
+
+		pass.culled = !keep;
+
+		if (pass.culled) {
+			culledPasses++;
+			continue;
+		}
+
+		for (const graph::access& access : pass.accesses) {
+			if (readsPrevious(pass, access)) {
+				needed[access.resource] = 1;
+			}
+		}
+	}
+
+	for (graph::resource& resource : graph::resources) {
+		resource.firstPass = UINT32_MAX;
+		resource.lastPass = UINT32_MAX;
+	}
+
+	for (uint32_t i = 0; i < graph::passes.size(); i++) {
+		if (graph::passes[i].culled) {
+			continue;
+		}
+
+		for (const graph::access& access : graph::passes[i].accesses) {
+			graph::resource& resource = graph::resources[access.resource];
+
+			resource.firstPass = std::min(resource.firstPass, i);
+			resource.lastPass = resource.lastPass == UINT32_MAX ? i : std::max(resource.lastPass, i);
+		}
+	}
+
+	for (graph::pass& pass : graph::passes) {
+		if (pass.kind != graph::passKind::graphics || pass.culled) {
+			continue;
+		}
+
+		if (renderer::dynamicRendering) {
+			describeRenderingAttachments(pass);
+		}
+		else {
+			pass.renderPass = createRenderPass(pass);
+		}
+	}
+
+	graph::finalAccesses.clear();
+
+	for (uint32_t i = 0; i < graph::resources.size(); i++) {
+		if (graph::resources[i].finalUsage != graph::usage::undefined) {
+			graph::finalAccesses.push_back({ i, graph::resources[i].finalUsage });
+		}
+	}
+
+	graph::states.assign(graph::resources.size(), graph::state{});
+	graph::compiled = true;
+
+	logger::log("Compiled render graph: " + std::to_string(graph::passes.size()) + " passes, " + std::to_string(culledPasses) + " culled, " + std::to_string(graph::resources.size()) + " resources", 4);
+}
+
+static void createTransientImages() {
+	// kept by retireTargets, the extent did not change
+	if (!graph::blocks.empty()) {
+		return;
+	}
+
+	std::vector<uint32_t> transient;
+	std::vector<VkMemoryRequirements> requirements(graph::resources.size());
+
+	for (uint32_t i = 0; i < graph::resources.size(); i++) {
+		graph::resource& resource = graph::resources[i];
+
+		// nothing that survived culling uses it
+		if (resource.imported || resource.firstPass == UINT32_MAX) {
+			continue;
+		}
+
+		VkImageCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		createInfo.imageType = VK_IMAGE_TYPE_2D;
+		createInfo.extent = { graph::extent.width, graph::extent.height, 1 };
+		createInfo.mipLevels = 1;
+		createInfo.arrayLayers = 1;
+		createInfo.format = resource.format;
+		createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		createInfo.usage = resource.imageUsage;
+		createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+
+		VkImage image;
+
+		if (vkCreateImage(renderer::device, &createInfo, nullptr, &image) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create transient image " + resource.name + "!");
+		}
+
+		resource.images = { image };
+		graph::states[i].layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		vkGetImageMemoryRequirements(renderer::device, image, &requirements[i]);
+
+		transient.push_back(i);
+	}
+
+	// largest first, so a block is as large as the first image placed in it
+	std::sort(transient.begin(), transient.end(), [&](uint32_t a, uint32_t b) { return requirements[a].size > requirements[b].size; });
+
+	for (uint32_t index : transient) {
+		graph::resource& resource = graph::resources[index];
+		const VkMemoryRequirements& requirement = requirements[index];
+
+		resource.block = UINT32_MAX;
+
+		for (uint32_t i = 0; i < graph::blocks.size() && resource.block == UINT32_MAX; i++) {
+			graph::memoryBlock& block = graph::blocks[i];
+
+			if (requirement.size > block.size || (requirement.memoryTypeBits & block.memoryTypeBits) == 0) {
+				continue;
+			}
+
+			bool overlaps = false;
+
+			for (uint32_t other : block.resources) {
+				const graph::resource& placed = graph::resources[other];
+
+				overlaps = overlaps || (resource.firstPass <= placed.lastPass && placed.firstPass <= resource.lastPass);
+			}
+
+			if (!overlaps) {
+				block.memoryTypeBits &= requirement.memoryTypeBits;
+				block.resources.push_back(index);
+				resource.block = i;
+			}
+		}
+
+		if (resource.block == UINT32_MAX) {
+			graph::blocks.push_back({ VK_NULL_HANDLE, requirement.size, requirement.memoryTypeBits, { index } });
+			resource.block = static_cast<uint32_t>(graph::blocks.size() - 1);
+		}
+	}
+
+	VkDeviceSize aliasedBytes = 0;
+
+	for (graph::memoryBlock& block : graph::blocks) {
+		VkMemoryAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocateInfo.allocationSize = block.size;
+		allocateInfo.memoryTypeIndex = renderer::findMemoryType(block.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		if (memory::allocateDevice(allocateInfo, block.memory) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to allocate render graph memory!");
+		}
+
+		for (uint32_t index : block.resources) {
+			graph::resource& resource = graph::resources[index];
+
+			vkBindImageMemory(renderer::device, resource.images[0], block.memory, 0);
+
+			// depth stencil views see the depth alone, so the same view can be attached and sampled
+			VkImageAspectFlags viewAspect = (resource.aspect & VK_IMAGE_ASPECT_DEPTH_BIT) != 0 ? VK_IMAGE_ASPECT_DEPTH_BIT : resource.aspect;
+
+			resource.memory = block.memory;
+			resource.views = { renderer::createImageView(resource.images[0], resource.format, viewAspect) };
+		}
+
+		for (size_t i = 1; i < block.resources.size(); i++) {
+			aliasedBytes += requirements[block.resources[i]].size;
+		}
+	}
+
+	if (!transient.empty()) {
+		logger::log("Placed " + std::to_string(transient.size()) + " transient images in " + std::to_string(graph::blocks.size()) + " blocks, " + std::to_string(aliasedBytes / 1024) + " KiB aliased", 4);
+	}
+}
+
+// colors then depth, like the render pass and the rendering attachments
+static std::vector<uint32_t> boundAttachments(const graph::pass& pass) {
+	std::vector<uint32_t> attachments;
+
+	for (const graph::attachment& attachment : pass.colorAttachments) {
+		attachments.push_back(attachment.resource);
+	}
+
+	if (pass.hasDepthAttachment) {
+		attachments.push_back(pass.depthAttachment.resource);
+	}
+
+	for (uint32_t index : attachments) {
+		if (graph::resources[index].views.empty()) {
+			throw std::runtime_error("Failed to create targets for " + pass.name + ", " + graph::resources[index].name + " has no image bound!");
+		}
+	}
+
+	return attachments;
+}
+
+static void createFramebuffers(graph::pass& pass) {
+	std::vector<uint32_t> attachments = boundAttachments(pass);
+
+	// one framebuffer per swapchain image when one of the attachments is it
+	size_t variants = 1;
+
+	for (uint32_t index : attachments) {
+		variants = std::max(variants, graph::resources[index].views.size());
+	}
+
+	pass.framebuffers.resize(variants);
+
+	std::vector<VkImageView> views(attachments.size());
+
+	for (size_t variant = 0; variant < variants; variant++) {
+		for (size_t i = 0; i < attachments.size(); i++) {
+			const graph::resource& resource = graph::resources[attachments[i]];
+
+			views[i] = resource.views[variant % resource.views.size()];
+		}
+
+		VkFramebufferCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		createInfo.renderPass = pass.renderPass;
+		createInfo.attachmentCount = static_cast<uint32_t>(views.size());
+		createInfo.pAttachments = views.data();
+		createInfo.width = graph::extent.width;
+		createInfo.height = graph::extent.height;
+		createInfo.layers = 1;
+
+		if (vkCreateFramebuffer(renderer::device, &createInfo, nullptr, &pass.framebuffers[variant]) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create framebuffer for " + pass.name + "!");
+		}
+	}
+}
+
+void graph::createTargets(VkExtent2D frameExtent) {
+	BRUTAL_PROFILE_FUNCTION();
+	BRUTAL_MEMORY_SCOPE(memory::tag::renderer);
+
+	graph::extent = frameExtent;
+
+	createTransientImages();
+
+	// dynamic rendering has nothing to create, its views are looked up when the pass begins
+	for (graph::pass& pass : graph::passes) {
+		if (pass.renderPass != VK_NULL_HANDLE) {
+			createFramebuffers(pass);
+		}
+		else if (!pass.renderingAttachments.empty()) {
+			boundAttachments(pass);
+		}
+	}
+
+	logger::log("Successfully created render graph targets!", 1);
+}
+
+// what a release takes from the graph, the handles stay valid until the caller destroys or retires them
+struct detachedTargets {
+	std::vector<VkFramebuffer> framebuffers;
+	std::vector<VkImageView> views;
+	std::vector<VkImage> images;
+	std::vector<VkDeviceMemory> memoryBlocks;
+};
+
+static detachedTargets detachTargets(VkExtent2D nextExtent) {
+	detachedTargets targets;
+
+	for (graph::pass& pass : graph::passes) {
+		targets.framebuffers.insert(targets.framebuffers.end(), pass.framebuffers.begin(), pass.framebuffers.end());
+		pass.framebuffers.clear();
+	}
+
+	bool keepTransient = nextExtent.width == graph::extent.width && nextExtent.height == graph::extent.height;
+
+	for (graph::resource& resource : graph::resources) {
+		if (resource.imported || keepTransient) {
+			continue;
+		}
+
+		targets.views.insert(targets.views.end(), resource.views.begin(), resource.views.end());
+		targets.images.insert(targets.images.end(), resource.images.begin(), resource.images.end());
+
+		resource.views.clear();
+		resource.images.clear();
+		resource.block = UINT32_MAX;
+		resource.memory = VK_NULL_HANDLE;
+	}
+
+	if (!keepTransient) {
+		for (graph::memoryBlock& block : graph::blocks) {
+			targets.memoryBlocks.push_back(block.memory);
+		}
+
+		graph::blocks.clear();
+	}
+
+	return targets;
+}
+
+void graph::retireTargets(VkExtent2D nextExtent) {
+	detachedTargets targets = detachTargets(nextExtent);
+
+	for (VkFramebuffer framebuffer : targets.framebuffers) {
+		deletion::retireFramebuffer(framebuffer);
+	}
+
+	for (VkImageView view : targets.views) {
+		deletion::retireImageView(view);
+	}
+
+	for (VkImage image : targets.images) {
+		deletion::retireImage(image, VK_NULL_HANDLE);
+	}
+
+	// blocks are shared by several images, retired after all of them since the queue frees in order
+	for (VkDeviceMemory block : targets.memoryBlocks) {
+		deletion::retire([block]() {
+			memory::freeDevice(block);
+		});
+	}
+}
+
+void graph::destroyTargets() {
+	detachedTargets targets = detachTargets({0, 0});
+
+	for (VkFramebuffer framebuffer : targets.framebuffers) {
+		vkDestroyFramebuffer(renderer::device, framebuffer, nullptr);
+	}
+
+	for (VkImageView view : targets.views) {
+		vkDestroyImageView(renderer::device, view, nullptr);
+	}
+
+	for (VkImage image : targets.images) {
+		vkDestroyImage(renderer::device, image, nullptr);
+	}
+
+	for (VkDeviceMemory block : targets.memoryBlocks) {
+		memory::freeDevice(block);
+	}
+}
+
+// one barrier command for everything the accesses need, layout changes as image barriers and the rest as a single memory barrier
+// the legacy command has one pair of stage masks for all of it, with synchronization2 each image barrier carries its own
+static void recordBarriers(VkCommandBuffer commandBuffer, const std::vector<graph::access>& accesses, uint32_t imageIndex) {
+	bool synchronization2 = renderer::synchronization2;
+
+	VkPipelineStageFlags2 sourceStages = 0;
+	VkPipelineStageFlags2 destinationStages = 0;
+
+	VkMemoryBarrier2 memoryBarrier{};
+	memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+
+	graph::imageBarriers.clear();
+	graph::imageBarriers2.clear();
+
+	for (const graph::access& access : accesses) {
+		const graph::resource& resource = graph::resources[access.resource];
+		const graph::usageInfo& info = graph::describe(access.use);
+		graph::state& state = graph::states[access.resource];
+
+		VkPipelineStageFlags2 stages = stagesOf(info);
+		VkAccessFlags2 accessMask = accessOf(info);
+
+		VkPipelineStageFlags2 previousStages = state.writeStages | state.readStages;
+
+		// an aliased image's memory was last used through the other images in its block
+		if (state.discarded && resource.block != UINT32_MAX) {
+			for (uint32_t other : graph::blocks[resource.block].resources) {
+				previousStages |= graph::states[other].writeStages | graph::states[other].readStages;
+			}
+		}
+
+		bool layoutChange = resource.image && state.layout != info.layout;
+
+		// reads after reads need nothing, a write after reads only waits for them to execute
+		bool hazard = info.writes ? previousStages != 0 : state.writeStages != 0 && (stages & ~state.visibleStages) != 0;
+
+		if (layoutChange) {
+			VkImage image = resource.images[imageIndex % resource.images.size()];
+
+			if (synchronization2) {
+				graph::imageBarriers2.push_back(imageBarrier2(image, resource.aspect, resource.levels, state.layout, info.layout, previousStages, state.writeAccess, stages, accessMask));
+			}
+			else {
+				graph::imageBarriers.push_back(imageBarrier(image, resource.aspect, resource.levels, state.layout, info.layout, static_cast<VkAccessFlags>(state.writeAccess), static_cast<VkAccessFlags>(accessMask)));
+			}
+
+			sourceStages |= previousStages;
+			destinationStages |= stages;
+		}
+		else if (hazard) {
+			// without a write to make visible, waiting for the reads to execute is enough
+			if (state.writeAccess != 0) {
+				memoryBarrier.srcAccessMask |= state.writeAccess;
+				memoryBarrier.dstAccessMask |= accessMask;
+			}
+
+			memoryBarrier.srcStageMask |= info.writes ? previousStages : state.writeStages;
+			memoryBarrier.dstStageMask |= stages;
+
+			sourceStages |= memoryBarrier.srcStageMask;
+			destinationStages |= stages;
+		}
+
+		state.layout = resource.image ? info.layout : state.layout;
+		state.discarded = false;
+
+		if (info.writes) {
+			state.writeStages = stages;
+			state.writeAccess = accessMask & writeAccessMask;
+			state.readStages = 0;
+			state.visibleStages = 0;
+		}
+		else {
+			state.readStages |= stages;
+			state.visibleStages |= stages;
+		}
+	}
+
+	if (destinationStages == 0) {
+		return;
+	}
+
+	if (synchronization2) {
+		// an execution dependency alone still needs the memory barrier to carry its stages
+		pipelineBarrier2(commandBuffer, memoryBarrier.dstStageMask != 0 ? &memoryBarrier : nullptr, static_cast<uint32_t>(graph::imageBarriers2.size()), graph::imageBarriers2.data());
+
+		graph::imageBarrierCount += static_cast<uint32_t>(graph::imageBarriers2.size());
+	}
+	else {
+		VkMemoryBarrier legacyBarrier{};
+		legacyBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		legacyBarrier.srcAccessMask = static_cast<VkAccessFlags>(memoryBarrier.srcAccessMask);
+		legacyBarrier.dstAccessMask = static_cast<VkAccessFlags>(memoryBarrier.dstAccessMask);
+
+		uint32_t memoryBarrierCount = legacyBarrier.srcAccessMask != 0 || legacyBarrier.dstAccessMask != 0 ? 1 : 0;
+		VkPipelineStageFlags legacySourceStages = sourceStages != 0 ? static_cast<VkPipelineStageFlags>(sourceStages) : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer, legacySourceStages, static_cast<VkPipelineStageFlags>(destinationStages), 0, memoryBarrierCount, &legacyBarrier, 0, nullptr, static_cast<uint32_t>(graph::imageBarriers.size()), graph::imageBarriers.data());
+
+		graph::imageBarrierCount += static_cast<uint32_t>(graph::imageBarriers.size());
+	}
+
+	graph::barrierBatches++;
+}
+
+// points the rendering attachments at this frame's views, the depth one doubles as the stencil one when the format has it
+static void beginRendering(VkCommandBuffer commandBuffer, graph::pass& pass, uint32_t imageIndex) {
+	size_t colorCount = pass.colorAttachments.size();
+
+	for (size_t i = 0; i < colorCount; i++) {
+		const graph::resource& resource = graph::resources[pass.colorAttachments[i].resource];
+
+		pass.renderingAttachments[i].imageView = resource.views[imageIndex % resource.views.size()];
+	}
+
+	VkRenderingInfo renderingInfo{};
+	renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+	renderingInfo.renderArea.offset = {0, 0};
+	renderingInfo.renderArea.extent = graph::extent;
+	renderingInfo.layerCount = 1;
+	renderingInfo.colorAttachmentCount = static_cast<uint32_t>(colorCount);
+	renderingInfo.pColorAttachments = pass.renderingAttachments.data();
+
+	VkRenderingAttachmentInfo stencilAttachment{};
+
+	if (pass.hasDepthAttachment) {
+		const graph::resource& resource = graph::resources[pass.depthAttachment.resource];
+		VkRenderingAttachmentInfo& depthAttachment = pass.renderingAttachments[colorCount];
+
+		depthAttachment.imageView = resource.views[imageIndex % resource.views.size()];
+		renderingInfo.pDepthAttachment = &depthAttachment;
+
+		// like the render pass, the stencil is neither loaded nor stored
+		if (resource.aspect & VK_IMAGE_ASPECT_STENCIL_BIT) {
+			stencilAttachment = depthAttachment;
+			stencilAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			stencilAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+			renderingInfo.pStencilAttachment = &stencilAttachment;
+		}
+	}
+
+	renderer::cmdBeginRendering(commandBuffer, &renderingInfo);
+}
+
+void graph::execute(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	graph::barrierBatches = 0;
+	graph::imageBarrierCount = 0;
+
+	// the stages stay, the next frame's first access still has to wait for this frame's last one
+	for (size_t i = 0; i < graph::resources.size(); i++) {
+		if (!graph::resources[i].preserved) {
+			graph::states[i].layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			graph::states[i].discarded = true;
+		}
+	}
+
+	for (graph::pass& pass : graph::passes) {
+		if (pass.culled || (pass.active && !pass.active())) {
+			continue;
+		}
+
+		recordBarriers(commandBuffer, pass.accesses, imageIndex);
+
+		uint32_t zone = profiler::beginGpuZone(commandBuffer, pass.name.c_str());
+
+		if (pass.kind == graph::passKind::graphics && renderer::dynamicRendering) {
+			beginRendering(commandBuffer, pass, imageIndex);
+
+			pass.record(commandBuffer);
+
+			renderer::cmdEndRendering(commandBuffer);
+		}
+		else if (pass.kind == graph::passKind::graphics) {
+			VkRenderPassBeginInfo renderPassInfo{};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			renderPassInfo.renderPass = pass.renderPass;
+			renderPassInfo.framebuffer = pass.framebuffers[imageIndex % pass.framebuffers.size()];
+			renderPassInfo.renderArea.offset = {0, 0};
+			renderPassInfo.renderArea.extent = graph::extent;
+			renderPassInfo.clearValueCount = static_cast<uint32_t>(pass.clearValues.size());
+			renderPassInfo.pClearValues = pass.clearValues.data();
+
+			vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+			pass.record(commandBuffer);
+
+			vkCmdEndRenderPass(commandBuffer);
+		}
+		else {
+			pass.record(commandBuffer);
+		}
+
+		profiler::endGpuZone(commandBuffer, zone);
+	}
+
+	recordBarriers(commandBuffer, graph::finalAccesses, imageIndex);
+}
+
+void graph::cleanup() {
+	graph::destroyTargets();
+
+	for (graph::pass& pass : graph::passes) {
+		vkDestroyRenderPass(renderer::device, pass.renderPass, nullptr);
+	}
+
+	graph::passes.clear();
+	graph::resources.clear();
+	graph::states.clear();
+	graph::finalAccesses.clear();
+	graph::compiled = false;
+}
\ No newline at end of file
@@ -0,0 +1,190 @@
+#pragma once
+#ifndef graph_h
+#define graph_h
+
+#include "../src/engine.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace graph {
+	// how a pass touches a resource, describe() has the stages, access and layout of each
+	enum class usage : uint8_t {
+		undefined,
+		transferRead,
+		transferWrite,
+		colorAttachment,
+		depthAttachment,
+		// sampled by a compute shader in the read only depth layout
+		depthSampled,
+		fragmentSampled,
+		// storage images stay in the general layout, and so do images sampled next to them
+		computeRead,
+		computeWrite,
+		computeReadWrite,
+		vertexRead,
+		indirectRead,
+		indexRead,
+		present,
+		count
+	};
+
+	struct usageInfo {
+		VkPipelineStageFlags stages;
+		VkAccessFlags access;
+		// the same with synchronization2, which can tell copies from clears and sampled from storage reads
+		VkPipelineStageFlags2 stages2;
+		VkAccessFlags2 access2;
+		// ignored for buffers
+		VkImageLayout layout;
+		bool writes;
+	};
+
+	enum class passKind : uint8_t {
+		graphics,
+		compute,
+		transfer
+	};
+
+	struct resource {
+		std::string name;
+		bool image;
+		// owned by whoever imported it, the others are created by the graph and may share memory
+		bool imported;
+		// contents are read next frame, otherwise the first access of a frame discards them
+		bool preserved;
+		// where the frame leaves it for whoever uses it outside the graph, undefined leaves it at its last access
+		usage finalUsage;
+
+		VkFormat format;
+		VkImageAspectFlags aspect;
+		uint32_t levels;
+		// transient images only, they are as large as the frame
+		VkImageUsageFlags imageUsage;
+
+		// the swapchain has one per image, the frame's image index picks one
+		std::vector<VkImage> images;
+		std::vector<VkImageView> views;
+
+		// passes that use it in execution order, UINT32_MAX when no pass that survived culling does
+		uint32_t firstPass;
+		uint32_t lastPass;
+
+		// transient images only
+		uint32_t block;
+		VkDeviceMemory memory;
+	};
+
+	struct attachment {
+		uint32_t resource;
+		VkAttachmentLoadOp loadOp;
+		VkAttachmentStoreOp storeOp;
+		VkClearValue clearValue;
+	};
+
+	struct access {
+		uint32_t resource;
+		usage use;
+	};
+
+	struct pass {
+		std::string name;
+		passKind kind;
+		std::vector<access> accesses;
+
+		// graphics passes only, the graph creates the render pass and framebuffers from them, or begins dynamic rendering with them
+		std::vector<attachment> colorAttachments;
+		bool hasDepthAttachment;
+		attachment depthAttachment;
+
+		// checked every frame, a pass that has nothing to do is skipped together with its barriers
+		std::function<bool()> active;
+		std::function<void(VkCommandBuffer)> record;
+
+		// kept by culling even though nothing reads what it writes
+		bool sideEffects;
+		bool culled;
+
+		VkRenderPass renderPass;
+		std::vector<VkFramebuffer> framebuffers;
+		std::vector<VkClearValue> clearValues;
+
+		// dynamic rendering only, colors then depth, their views are set when the pass is executed
+		std::vector<VkRenderingAttachmentInfo> renderingAttachments;
+	};
+
+	// what the last executed access did to a resource, carried over into the next frame, in synchronization2 flags when it is on
+	struct state {
+		VkImageLayout layout;
+		VkPipelineStageFlags2 writeStages;
+		VkAccessFlags2 writeAccess;
+		// reads since the last write, and the stages the write was made visible to
+		VkPipelineStageFlags2 readStages;
+		VkPipelineStageFlags2 visibleStages;
+		// discarded at the start of the frame and not accessed since
+		bool discarded;
+	};
+
+	// transient images whose lifetimes do not overlap are bound to the same block
+	struct memoryBlock {
+		VkDeviceMemory memory;
+		VkDeviceSize size;
+		uint32_t memoryTypeBits;
+		std::vector<uint32_t> resources;
+	};
+
+	extern std::vector<resource> resources;
+	extern std::vector<pass> passes;
+	extern std::vector<state> states;
+	extern std::vector<memoryBlock> blocks;
+	// the resources with a final usage, applied after the last pass
+	extern std::vector<access> finalAccesses;
+
+	extern bool compiled;
+	extern VkExtent2D extent;
+
+	// filled per pass while executing, kept so a frame does not allocate, the second with synchronization2
+	extern std::vector<VkImageMemoryBarrier> imageBarriers;
+	extern std::vector<VkImageMemoryBarrier2> imageBarriers2;
+
+	// the frame executed last
+	extern uint32_t barrierBatches;
+	extern uint32_t imageBarrierCount;
+
+	const usageInfo& describe(usage use);
+
+	// a single barrier outside of the graph, for images that are set up once like uploaded textures
+	void transition(VkCommandBuffer commandBuffer, VkImage image, VkImageAspectFlags aspect, uint32_t levels, usage from, usage to);
+
+	uint32_t importImage(const std::string& name, VkFormat format, VkImageAspectFlags aspect, bool preserved, usage finalUsage = usage::undefined);
+	uint32_t importBuffer(const std::string& name, bool preserved);
+	uint32_t createImage(const std::string& name, VkFormat format, VkImageAspectFlags aspect, VkImageUsageFlags imageUsage);
+
+	uint32_t addPass(const std::string& name, passKind kind, std::function<void(VkCommandBuffer)> record);
+	void use(uint32_t passIndex, uint32_t resourceIndex, usage use);
+	void colorAttachment(uint32_t passIndex, uint32_t resourceIndex, VkAttachmentLoadOp loadOp, VkAttachmentStoreOp storeOp, VkClearValue clearValue = {});
+	void depthAttachment(uint32_t passIndex, uint32_t resourceIndex, VkAttachmentLoadOp loadOp, VkAttachmentStoreOp storeOp, VkClearValue clearValue = {});
+
+	// imported images change with the swapchain, they are bound again before createTargets, new images start out undefined
+	void bindImage(uint32_t resourceIndex, const std::vector<VkImage>& images, const std::vector<VkImageView>& views, uint32_t levels = 1);
+
+	// once every pass is added, culls the passes nothing depends on and creates the render passes, unless rendering is dynamic
+	void compile();
+
+	// with the frame's extent, creates the transient images, aliases their memory and creates the framebuffers if there are render passes
+	void createTargets(VkExtent2D frameExtent);
+	// hands the targets to the deletion queue, frames in flight may still use them
+	// the transient images stay when nextExtent is the extent they were created with, only the framebuffers go
+	void retireTargets(VkExtent2D nextExtent);
+	void destroyTargets();
+
+	// records every active pass with one batched barrier in front of each, then moves the resources to their final usage
+	// with synchronization2 each image barrier only waits for the stages of its own image
+	void execute(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+
+	void cleanup();
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,422 @@
+#include "./headless.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+
+bool headless::enabled = false;
+bool headless::failed = false;
+
+uint32_t headless::frameCount = 300;
+uint32_t headless::captureInterval = 0;
+std::string headless::cameraPathFile;
+std::string headless::reportPath = "headless_report.csv";
+std::string headless::captureDirectory;
+std::string headless::goldenDirectory;
+
+uint32_t headless::channelTolerance = 8;
+double headless::pixelTolerance = 0.005;
+uint32_t headless::allocationFreeAfter = 0;
+
+std::vector<headless::cameraKey> headless::cameraPath;
+std::vector<headless::frameTiming> headless::timings;
+
+// switches take on or off, anything else is an error
+static bool parseSwitch(const std::string& argument, const std::string& value) {
+	if (value != "on" && value != "off") {
+		throw std::runtime_error("Failed to parse " + argument + ": " + value + " (expected on or off)");
+	}
+
+	return value == "on";
+}
+
+void headless::parseArguments(int argc, char* argv[], int first) {
+	headless::enabled = true;
+
+	for (int i = first; i < argc; i++) {
+		std::string argument = argv[i];
+
+		if (i + 1 >= argc) {
+			throw std::runtime_error("Missing value for argument: " + argument);
+		}
+
+		std::string value = argv[++i];
+
+		if (argument == "--frames") {
+			headless::frameCount = static_cast<uint32_t>(std::stoul(value));
+		}
+		else if (argument == "--scene") {
+			renderer::scenePath = value;
+		}
+		else if (argument == "--profile") {
+			profiler::start(value);
+		}
+		else if (argument == "--camera") {
+			headless::cameraPathFile = value;
+		}
+		else if (argument == "--report") {
+			headless::reportPath = value;
+		}
+		else if (argument == "--capture") {
+			headless::captureDirectory = value;
+		}
+		else if (argument == "--capture-every") {
+			headless::captureInterval = static_cast<uint32_t>(std::stoul(value));
+		}
+		else if (argument == "--golden") {
+			headless::goldenDirectory = value;
+		}
+		else if (argument == "--tolerance") {
+			headless::pixelTolerance = std::stod(value);
+		}
+		else if (argument == "--width") {
+			engine::width = static_cast<uint32_t>(std::stoul(value));
+		}
+		else if (argument == "--height") {
+			engine::height = static_cast<uint32_t>(std::stoul(value));
+		}
+		else if (argument == "--assert-no-allocations") {
+			headless::allocationFreeAfter = static_cast<uint32_t>(std::stoul(value));
+
+#ifndef BRUTAL_MEMORY_TRACKING
+			logger::log("Global allocations are not tracked in this build, --assert-no-allocations only sees tagged allocators!", 2);
+#endif
+		}
+		else if (argument == "--memory-budget") {
+			memory::parseBudget(value);
+			memory::reportOnExit = true;
+		}
+		else if (argument == "--lod-error") {
+			renderer::lodErrorPixels = std::stof(value);
+		}
+		else if (argument == "--vertex-format") {
+			renderer::requestedVertexFormat = renderer::parseVertexFormat(value);
+		}
+		else if (argument == "--cluster-culling") {
+			cluster::enabled = parseSwitch(argument, value);
+		}
+		else if (argument == "--gpu-culling") {
+			occlusion::enabled = parseSwitch(argument, value);
+		}
+		else if (argument == "--software-occlusion") {
+			raster::enabled = parseSwitch(argument, value);
+		}
+		else if (argument == "--depth-prepass") {
+			drawQueue::depthPrepass = parseSwitch(argument, value);
+		}
+		else if (argument == "--draw-sorting") {
+			drawQueue::sorted = parseSwitch(argument, value);
+		}
+		else if (argument == "--dynamic-rendering") {
+			renderer::dynamicRendering = parseSwitch(argument, value);
+		}
+		else if (argument == "--synchronization2") {
+			renderer::synchronization2 = parseSwitch(argument, value);
+		}
+		else {
+			throw std::runtime_error("Unknown argument: " + argument);
+		}
+	}
+
+	if (!headless::cameraPathFile.empty()) {
+		headless::loadCameraPath(headless::cameraPathFile);
+	}
+}
+
+void headless::loadCameraPath(const std::string& path) {
+	std::ifstream file(path);
+
+	if (!file.is_open()) {
+		throw std::runtime_error("Failed to open camera path: " + path);
+	}
+
+	headless::cameraPath.clear();
+
+	std::string line;
+
+	// frame eyeX eyeY eyeZ directionX directionY directionZ
+	while (std::getline(file, line)) {
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+
+		std::istringstream values(line);
+		headless::cameraKey key{};
+
+		if (!(values >> key.frame >> key.eye.x >> key.eye.y >> key.eye.z >> key.viewDirection.x >> key.viewDirection.y >> key.viewDirection.z)) {
+			throw std::runtime_error("Invalid camera path: " + path);
+		}
+
+		key.viewDirection = glm::normalize(key.viewDirection);
+
+		headless::cameraPath.push_back(key);
+	}
+
+	std::sort(headless::cameraPath.begin(), headless::cameraPath.end(), [](const headless::cameraKey& a, const headless::cameraKey& b) { return a.frame < b.frame; });
+
+	logger::log("Successfully loaded camera path: " + path + " (" + std::to_string(headless::cameraPath.size()) + " keys)", 1);
+}
+
+void headless::applyCamera(uint32_t frame) {
+	// without a path, orbit the origin once over the run
+	if (headless::cameraPath.empty()) {
+		float angle = glm::two_pi<float>() * static_cast<float>(frame) / static_cast<float>(std::max(1u, headless::frameCount));
+
+		camera::camera.eye = glm::vec3(std::sin(angle) * 6.0f, 3.0f, std::cos(angle) * 6.0f);
+		camera::camera.viewDirection = glm::normalize(-camera::camera.eye);
+
+		return;
+	}
+
+	const headless::cameraKey* previous = &headless::cameraPath.front();
+	const headless::cameraKey* next = &headless::cameraPath.back();
+
+	for (size_t i = 0; i < headless::cameraPath.size(); i++) {
+		if (headless::cameraPath[i].frame <= frame) {
+			previous = &headless::cameraPath[i];
+		}
+
+		if (headless::cameraPath[i].frame >= frame) {
+			next = &headless::cameraPath[i];
+			break;
+		}
+	}
+
+	float blend = next->frame > previous->frame ? static_cast<float>(frame - previous->frame) / static_cast<float>(next->frame - previous->frame) : 0.0f;
+	blend = std::clamp(blend, 0.0f, 1.0f);
+
+	camera::camera.eye = glm::mix(previous->eye, next->eye, blend);
+	camera::camera.viewDirection = glm::normalize(glm::mix(previous->viewDirection, next->viewDirection, blend));
+}
+
+void headless::run() {
+	BRUTAL_PROFILE_FUNCTION();
+
+	logger::log("Rendering " + std::to_string(headless::frameCount) + " headless frames...", 4);
+
+	headless::timings.assign(headless::frameCount, headless::frameTiming{});
+
+	for (uint32_t frame = 0; frame < headless::frameCount; frame++) {
+		headless::timings[frame].frame = frame;
+		headless::timings[frame].gpuMilliseconds = -1.0;
+
+		headless::applyCamera(frame);
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		renderer::drawFrame();
+
+		headless::timings[frame].cpuMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		headless::timings[frame].cullMilliseconds = renderer::cullMilliseconds;
+		headless::timings[frame].recordMilliseconds = renderer::recordMilliseconds;
+		headless::timings[frame].triangles = renderer::drawnTriangles;
+		headless::timings[frame].clusterTriangles = cluster::visibleTriangles;
+		headless::timings[frame].occludedObjects = occlusion::active() ? occlusion::occludedObjects : raster::occludedObjects;
+		headless::timings[frame].pipelineBinds = drawQueue::pipelineBinds;
+		headless::timings[frame].descriptorBinds = drawQueue::descriptorBinds;
+
+		memory::endFrame();
+
+		for (uint64_t allocations : memory::lastFrameAllocations) {
+			headless::timings[frame].allocations += allocations;
+		}
+
+		if (headless::allocationFreeAfter > 0 && frame >= headless::allocationFreeAfter && headless::timings[frame].allocations > 0 && !headless::failed) {
+			for (size_t i = 0; i < memory::tagCount; i++) {
+				if (memory::lastFrameAllocations[i] > 0) {
+					logger::log("Steady state frame " + std::to_string(frame) + " allocated " + std::to_string(memory::lastFrameAllocations[i]) + " times in " + memory::tagName(static_cast<memory::tag>(i)) + "!", 3);
+				}
+			}
+
+			headless::failed = true;
+		}
+
+		// drawFrame read the timestamps of the frame that used this slot before
+		if (frame >= renderer::maxFramesInFlight) {
+			headless::timings[frame - renderer::maxFramesInFlight].gpuMilliseconds = renderer::gpuFrameMilliseconds;
+		}
+
+		bool lastFrame = frame + 1 == headless::frameCount;
+		bool intervalFrame = headless::captureInterval > 0 && (frame + 1) % headless::captureInterval == 0;
+
+		if ((lastFrame || intervalFrame) && (!headless::captureDirectory.empty() || !headless::goldenDirectory.empty())) {
+			headless::capture(frame, frame % renderer::maxFramesInFlight);
+		}
+	}
+
+	vkDeviceWaitIdle(renderer::device);
+
+	for (uint32_t frame = headless::frameCount > renderer::maxFramesInFlight ? headless::frameCount - renderer::maxFramesInFlight : 0; frame < headless::frameCount; frame++) {
+		headless::timings[frame].gpuMilliseconds = profiler::collectGpuSlice(frame % renderer::maxFramesInFlight);
+	}
+
+	headless::writeReport(headless::reportPath);
+
+	if (memory::enforceBudgets && memory::budgetExceeded) {
+		logger::log("Memory budget exceeded during headless run!", 3);
+		headless::failed = true;
+	}
+
+	engine::running = false;
+}
+
+void headless::capture(uint32_t frame, uint32_t imageIndex) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	std::vector<uint8_t> pixels;
+	renderer::readbackImage(imageIndex, pixels);
+
+	char name[32];
+	snprintf(name, sizeof(name), "frame_%05u.ppm", frame);
+
+	if (!headless::captureDirectory.empty()) {
+		std::filesystem::create_directories(headless::captureDirectory);
+		headless::writeImage(headless::captureDirectory + "/" + name, pixels, renderer::swapChainExtent.width, renderer::swapChainExtent.height);
+	}
+
+	if (headless::goldenDirectory.empty()) {
+		return;
+	}
+
+	std::string goldenPath = headless::goldenDirectory + "/" + name;
+
+	std::vector<uint8_t> expected;
+	uint32_t width = 0;
+	uint32_t height = 0;
+
+	if (!headless::readImage(goldenPath, expected, width, height)) {
+		std::filesystem::create_directories(headless::goldenDirectory);
+		headless::writeImage(goldenPath, pixels, renderer::swapChainExtent.width, renderer::swapChainExtent.height);
+
+		logger::log("Golden image missing, wrote: " + goldenPath, 2);
+
+		return;
+	}
+
+	double differentPixels = 1.0;
+
+	if (width != renderer::swapChainExtent.width || height != renderer::swapChainExtent.height || !headless::compareImages(pixels, expected, differentPixels)) {
+		headless::failed = true;
+
+		logger::log("Golden image mismatch: " + goldenPath + " (" + std::to_string(differentPixels * 100.0) + "% of pixels differ)", 3);
+	}
+	else {
+		logger::log("Successfully matched golden image: " + goldenPath, 1);
+	}
+}
+
+// binary ppm, rgba in, rgb out
+void headless::writeImage(const std::string& path, const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height) {
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+	if (!file.is_open()) {
+		throw std::runtime_error("Failed to write image: " + path);
+	}
+
+	file << "P6\n" << width << " " << height << "\n255\n";
+
+	std::vector<uint8_t> row(static_cast<size_t>(width) * 3);
+
+	for (uint32_t y = 0; y < height; y++) {
+		for (uint32_t x = 0; x < width; x++) {
+			const uint8_t* pixel = &pixels[(static_cast<size_t>(y) * width + x) * 4];
+
+			row[x * 3 + 0] = pixel[0];
+			row[x * 3 + 1] = pixel[1];
+			row[x * 3 + 2] = pixel[2];
+		}
+
+		file.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+	}
+}
+
+bool headless::readImage(const std::string& path, std::vector<uint8_t>& pixels, uint32_t& width, uint32_t& height) {
+	std::ifstream file(path, std::ios::binary);
+
+	if (!file.is_open()) {
+		return false;
+	}
+
+	std::string magic;
+	uint32_t maximum = 0;
+
+	file >> magic >> width >> height >> maximum;
+	file.get();
+
+	if (magic != "P6" || maximum != 255) {
+		throw std::runtime_error("Invalid image: " + path);
+	}
+
+	std::vector<uint8_t> rgb(static_cast<size_t>(width) * height * 3);
+	file.read(reinterpret_cast<char*>(rgb.data()), static_cast<std::streamsize>(rgb.size()));
+
+	if (!file) {
+		throw std::runtime_error("Invalid image: " + path);
+	}
+
+	pixels.resize(static_cast<size_t>(width) * height * 4);
+
+	for (size_t i = 0; i < static_cast<size_t>(width) * height; i++) {
+		pixels[i * 4 + 0] = rgb[i * 3 + 0];
+		pixels[i * 4 + 1] = rgb[i * 3 + 1];
+		pixels[i * 4 + 2] = rgb[i * 3 + 2];
+		pixels[i * 4 + 3] = 255;
+	}
+
+	return true;
+}
+
+bool headless::compareImages(const std::vector<uint8_t>& actual, const std::vector<uint8_t>& expected, double& differentPixels) {
+	if (actual.size() != expected.size() || actual.empty()) {
+		differentPixels = 1.0;
+		return false;
+	}
+
+	size_t pixelCount = actual.size() / 4;
+	size_t different = 0;
+
+	for (size_t i = 0; i < pixelCount; i++) {
+		for (size_t channel = 0; channel < 3; channel++) {
+			if (static_cast<uint32_t>(std::abs(static_cast<int>(actual[i * 4 + channel]) - static_cast<int>(expected[i * 4 + channel]))) > headless::channelTolerance) {
+				different++;
+				break;
+			}
+		}
+	}
+
+	differentPixels = static_cast<double>(different) / static_cast<double>(pixelCount);
+
+	return differentPixels <= headless::pixelTolerance;
+}
+
+void headless::writeReport(const std::string& path) {
+	std::ofstream report(path, std::ios::trunc);
+
+	if (!report.is_open()) {
+		throw std::runtime_error("Failed to write report: " + path);
+	}
+
+	report << "frame,cpu_ms,gpu_ms,cull_ms,record_ms,triangles,cluster_triangles,occluded_objects,pipeline_binds,descriptor_binds,allocations\n";
+
+	std::vector<double> cpu;
+	std::vector<double> gpu;
+
+	for (const auto& timing : headless::timings) {
+		report << timing.frame << "," << timing.cpuMilliseconds << "," << timing.gpuMilliseconds << "," << timing.cullMilliseconds << "," << timing.recordMilliseconds << "," << timing.triangles << "," << timing.clusterTriangles << "," << timing.occludedObjects << "," << timing.pipelineBinds << "," << timing.descriptorBinds << "," << timing.allocations << "\n";
+
+		cpu.push_back(timing.cpuMilliseconds);
+
+		if (timing.gpuMilliseconds >= 0.0) {
+			gpu.push_back(timing.gpuMilliseconds);
+		}
+	}
+
+	logger::log("CPU frame: p50 " + std::to_string(benchmark::percentile(cpu, 0.5)) + " ms, p95 " + std::to_string(benchmark::percentile(cpu, 0.95)) + " ms, max " + std::to_string(benchmark::percentile(cpu, 1.0)) + " ms", 4);
+
+	if (!gpu.empty()) {
+		logger::log("GPU frame: p50 " + std::to_string(benchmark::percentile(gpu, 0.5)) + " ms, p95 " + std::to_string(benchmark::percentile(gpu, 0.95)) + " ms, max " + std::to_string(benchmark::percentile(gpu, 1.0)) + " ms", 4);
+	}
+
+	logger::log("Successfully wrote report: " + path, 1);
+}
\ No newline at end of file
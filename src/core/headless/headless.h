@@ -0,0 +1,70 @@
+#pragma once
+#ifndef headless_h
+#define headless_h
+
+#include "../src/engine.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace headless {
+	// camera keyframes are placed by frame number, so every run renders the same images
+	struct cameraKey {
+		uint32_t frame;
+		glm::vec3 eye;
+		glm::vec3 viewDirection;
+	};
+
+	struct frameTiming {
+		uint32_t frame;
+		double cpuMilliseconds;
+		double gpuMilliseconds;
+		double cullMilliseconds;
+		double recordMilliseconds;
+		uint64_t triangles;
+		// what the cluster culling pass kept of its objects, like gpuMilliseconds from the slot's previous frame
+		uint64_t clusterTriangles;
+		// hidden by the gpu pass or the software rasterizer, whichever culled the frame
+		uint32_t occludedObjects;
+		uint32_t pipelineBinds;
+		uint32_t descriptorBinds;
+		uint64_t allocations;
+	};
+
+	extern bool enabled;
+	extern bool failed;
+
+	extern uint32_t frameCount;
+	extern uint32_t captureInterval;
+	extern std::string cameraPathFile;
+	extern std::string reportPath;
+	extern std::string captureDirectory;
+	extern std::string goldenDirectory;
+
+	// a pixel counts as different when any channel is further off than channelTolerance
+	extern uint32_t channelTolerance;
+	extern double pixelTolerance;
+
+	// frames after the warm up must not touch the heap at all, 0 disables the check
+	extern uint32_t allocationFreeAfter;
+
+	extern std::vector<cameraKey> cameraPath;
+	extern std::vector<frameTiming> timings;
+
+	void parseArguments(int argc, char* argv[], int first);
+
+	void loadCameraPath(const std::string& path);
+	void applyCamera(uint32_t frame);
+
+	void run();
+	void capture(uint32_t frame, uint32_t imageIndex);
+
+	void writeImage(const std::string& path, const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height);
+	bool readImage(const std::string& path, std::vector<uint8_t>& pixels, uint32_t& width, uint32_t& height);
+	bool compareImages(const std::vector<uint8_t>& actual, const std::vector<uint8_t>& expected, double& differentPixels);
+
+	void writeReport(const std::string& path);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,500 @@
+#include "./hotreload.h"
+
+#include <filesystem>
+#include <cstdlib>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#ifdef NDEBUG
+const bool hotreload::enabled = false;
+#else
+const bool hotreload::enabled = true;
+#endif
+
+std::thread hotreload::watcher;
+std::atomic<bool> hotreload::watching = false;
+
+std::unordered_map<std::string, std::chrono::steady_clock::time_point> hotreload::changes;
+std::mutex hotreload::changesMutex;
+
+std::future<std::array<VkPipeline, renderer::pipelineKindCount>> hotreload::pendingPipeline;
+bool hotreload::pipelineOutdated = false;
+std::vector<std::future<engine::texture>> hotreload::pendingTextures;
+std::vector<std::future<engine::mesh>> hotreload::pendingModels;
+std::array<bool, renderer::maxFramesInFlight> hotreload::descriptorsOutdated{};
+
+template<typename type>
+static bool ready(const std::future<type>& future) {
+	return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+static void recordChange(const std::string& path) {
+	std::lock_guard<std::mutex> lock(hotreload::changesMutex);
+	hotreload::changes[filesystem::normalizePath(path)] = std::chrono::steady_clock::now();
+}
+
+void hotreload::init() {
+	if (!hotreload::enabled) {
+		return;
+	}
+
+	hotreload::watching = true;
+	hotreload::watcher = std::thread(hotreload::watch);
+
+	logger::log("Successfully started watching for asset changes!", 1);
+}
+
+void hotreload::shutdown() {
+	if (hotreload::watcher.joinable()) {
+		hotreload::watching = false;
+		hotreload::watcher.join();
+	}
+
+	// the device is idle here, finish whatever is still loading and drop it
+	if (hotreload::pendingPipeline.valid()) {
+		try {
+			for (VkPipeline pipeline : jobs::wait(hotreload::pendingPipeline)) {
+				vkDestroyPipeline(renderer::device, pipeline, nullptr);
+			}
+		}
+		catch (const std::exception&) {}
+	}
+
+	for (auto& pendingTexture : hotreload::pendingTextures) {
+		try {
+			engine::texture texture = jobs::wait(pendingTexture);
+			texture.destroyTexture(texture.textureStruct.data);
+		}
+		catch (const std::exception&) {}
+	}
+
+	for (auto& pendingModel : hotreload::pendingModels) {
+		try {
+			jobs::wait(pendingModel);
+		}
+		catch (const std::exception&) {}
+	}
+
+	hotreload::pendingTextures.clear();
+	hotreload::pendingModels.clear();
+}
+
+void hotreload::watch() {
+#ifdef __linux__
+	int notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+	if (notify < 0) {
+		logger::log("Failed to initialize inotify, hot reload disabled!", 2);
+		return;
+	}
+
+	std::unordered_map<int, std::string> directories;
+
+	auto addWatch = [&](const std::string& directory) {
+		int descriptor = inotify_add_watch(notify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+
+		if (descriptor >= 0) {
+			directories[descriptor] = directory;
+		}
+	};
+
+	for (const auto& directory : hotreload::watchedDirectories) {
+		std::error_code error;
+
+		if (!std::filesystem::is_directory(directory, error)) {
+			continue;
+		}
+
+		addWatch(directory);
+
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, error)) {
+			if (entry.is_directory()) {
+				addWatch(entry.path().generic_string());
+			}
+		}
+	}
+
+	alignas(inotify_event) char buffer[4096];
+
+	while (hotreload::watching) {
+		pollfd descriptor{};
+		descriptor.fd = notify;
+		descriptor.events = POLLIN;
+
+		if (poll(&descriptor, 1, 100) <= 0) {
+			continue;
+		}
+
+		ssize_t length = read(notify, buffer, sizeof(buffer));
+
+		for (char* cursor = buffer; length > 0 && cursor < buffer + length;) {
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(cursor);
+			cursor += sizeof(inotify_event) + event->len;
+
+			auto directory = directories.find(event->wd);
+
+			if (event->len == 0 || directory == directories.end()) {
+				continue;
+			}
+
+			std::string path = directory->second + "/" + event->name;
+
+			if (event->mask & IN_ISDIR) {
+				if (event->mask & IN_CREATE) {
+					addWatch(path);
+				}
+			}
+			// new files are reported once they are closed after writing
+			else if (!(event->mask & IN_CREATE)) {
+				recordChange(path);
+			}
+		}
+	}
+
+	close(notify);
+#else
+	// no inotify, compare write times instead
+	std::unordered_map<std::string, std::filesystem::file_time_type> writeTimes;
+
+	auto scan = [&](bool report) {
+		for (const auto& directory : hotreload::watchedDirectories) {
+			std::error_code error;
+
+			for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, error)) {
+				if (!entry.is_regular_file(error)) {
+					continue;
+				}
+
+				std::string path = entry.path().generic_string();
+				auto writeTime = entry.last_write_time(error);
+				auto previous = writeTimes.find(path);
+
+				if (previous == writeTimes.end() || previous->second != writeTime) {
+					writeTimes[path] = writeTime;
+
+					if (report) {
+						recordChange(path);
+					}
+				}
+			}
+		}
+	};
+
+	scan(false);
+
+	while (hotreload::watching) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(250));
+		scan(true);
+	}
+#endif
+}
+
+void hotreload::update() {
+	BRUTAL_PROFILE_FUNCTION();
+	BRUTAL_MEMORY_SCOPE(memory::tag::assets);
+
+	if (!hotreload::enabled) {
+		return;
+	}
+
+	std::vector<std::string> settled;
+
+	{
+		std::lock_guard<std::mutex> lock(hotreload::changesMutex);
+
+		auto now = std::chrono::steady_clock::now();
+
+		for (auto change = hotreload::changes.begin(); change != hotreload::changes.end();) {
+			if (now - change->second >= hotreload::settleTime) {
+				settled.push_back(change->first);
+				change = hotreload::changes.erase(change);
+			}
+			else {
+				change++;
+			}
+		}
+	}
+
+	for (const auto& path : settled) {
+		hotreload::onChanged(path);
+	}
+
+	if (ready(hotreload::pendingPipeline)) {
+		try {
+			std::array<VkPipeline, renderer::pipelineKindCount> pipelines = hotreload::pendingPipeline.get();
+			std::array<VkPipeline, renderer::pipelineKindCount> oldPipelines = renderer::graphicsPipelines;
+
+			renderer::graphicsPipelines = pipelines;
+
+			for (VkPipeline pipeline : oldPipelines) {
+				deletion::retirePipeline(pipeline);
+			}
+
+			logger::log("Successfully reloaded graphics pipelines!", 1);
+		}
+		catch (const std::exception& exception) {
+			logger::log(std::string("Failed to reload graphics pipelines: ") + exception.what(), 3);
+		}
+
+		if (hotreload::pipelineOutdated) {
+			hotreload::pipelineOutdated = false;
+			hotreload::rebuildPipeline();
+		}
+	}
+
+	// uploads still wait on the graphics queue, but nothing in flight is torn down
+	for (auto pendingTexture = hotreload::pendingTextures.begin(); pendingTexture != hotreload::pendingTextures.end();) {
+		if (!ready(*pendingTexture)) {
+			pendingTexture++;
+			continue;
+		}
+
+		try {
+			engine::texture texture = pendingTexture->get();
+
+			VkImage image;
+			VkDeviceMemory imageMemory;
+
+			renderer::uploadTexture(texture, image, imageMemory);
+
+			VkImage oldImage = renderer::textureImage;
+			VkDeviceMemory oldImageMemory = renderer::textureImageMemory;
+			VkImageView oldImageView = renderer::textureImageView;
+
+			renderer::textureImage = image;
+			renderer::textureImageMemory = imageMemory;
+			renderer::textureImageView = renderer::createImageView(image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT);
+
+			deletion::retireImageView(oldImageView);
+			deletion::retireImage(oldImage, oldImageMemory);
+
+			hotreload::descriptorsOutdated.fill(true);
+
+			logger::log("Successfully reloaded texture: " + texture.textureStruct.texturePath, 1);
+		}
+		catch (const std::exception& exception) {
+			logger::log(std::string("Failed to reload texture: ") + exception.what(), 3);
+		}
+
+		pendingTexture = hotreload::pendingTextures.erase(pendingTexture);
+	}
+
+	for (auto pendingModel = hotreload::pendingModels.begin(); pendingModel != hotreload::pendingModels.end();) {
+		if (!ready(*pendingModel)) {
+			pendingModel++;
+			continue;
+		}
+
+		try {
+			engine::mesh mesh = pendingModel->get();
+			std::string modelPath = mesh.path;
+
+			// only the changed mesh is staged, the rest of the shared buffers is copied on the gpu
+			deletion::retire(renderer::replaceMesh(modelPath, std::move(mesh)));
+
+			logger::log("Successfully reloaded model: " + modelPath, 1);
+		}
+		catch (const std::exception& exception) {
+			logger::log(std::string("Failed to reload model: ") + exception.what(), 3);
+		}
+
+		pendingModel = hotreload::pendingModels.erase(pendingModel);
+	}
+
+	// only this frame's descriptor set is idle, the others are rewritten at their own boundary
+	if (hotreload::descriptorsOutdated[renderer::currentFrame]) {
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = renderer::textureImageView;
+		imageInfo.sampler = renderer::textureSampler;
+
+		VkWriteDescriptorSet descriptorWrite{};
+		descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrite.dstSet = renderer::descriptorSets[renderer::currentFrame];
+		descriptorWrite.dstBinding = 1;
+		descriptorWrite.dstArrayElement = 0;
+		descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		descriptorWrite.descriptorCount = 1;
+		descriptorWrite.pImageInfo = &imageInfo;
+
+		vkUpdateDescriptorSets(renderer::device, 1, &descriptorWrite, 0, nullptr);
+
+		hotreload::descriptorsOutdated[renderer::currentFrame] = false;
+	}
+}
+
+void hotreload::onChanged(const std::string& path) {
+	std::string extension = std::filesystem::path(path).extension().string();
+
+	if (extension == ".vert" || extension == ".frag" || extension == ".comp" || extension == ".geom" || extension == ".tesc" || extension == ".tese") {
+		jobs::submit([path]() {
+			hotreload::compileShader(path);
+		});
+	}
+	else if (path == cluster::shaderPath || path == occlusion::cullShaderPath || path == occlusion::pyramidShaderPath) {
+		hotreload::rebuildComputePipeline(path);
+	}
+	else if (extension == ".spv") {
+		hotreload::rebuildPipeline();
+	}
+
+	assets::assetType type = assets::typeOf(path);
+
+	if (type == assets::assetType::texture && path == renderer::texturePath) {
+		hotreload::pendingTextures.push_back(jobs::async([path]() {
+			engine::texture texture;
+			texture.textureStruct.texturePath = path;
+			texture.loadTexture(texture);
+
+			return texture;
+		}));
+	}
+	else if (type == assets::assetType::model || type == assets::assetType::material) {
+		for (const auto& model : renderer::models) {
+			std::vector<std::string> materials = assets::dependenciesOf(model, assets::assetType::material);
+
+			if (assets::sourcePath(model) != path && std::find(materials.begin(), materials.end(), path) == materials.end()) {
+				continue;
+			}
+
+			hotreload::pendingModels.push_back(jobs::async([model]() {
+				return engine::model::parseModel(model);
+			}));
+		}
+	}
+}
+
+std::string hotreload::findShaderCompiler() {
+	const char* sdk = std::getenv("VULKAN_SDK");
+
+	if (sdk) {
+#ifdef _WIN32
+		std::string compiler = std::string(sdk) + "/Bin/glslc.exe";
+#else
+		std::string compiler = std::string(sdk) + "/bin/glslc";
+#endif
+
+		if (std::filesystem::exists(compiler)) {
+			return compiler;
+		}
+	}
+
+	return "glslc";
+}
+
+// compiles to a temporary file first, the rename is what the watcher picks up so the pipeline never sees a half written file
+static void compileShaderVariant(const std::string& path, const std::string& sourcePath, const std::string& outputPath, const std::string& defines) {
+	std::string temporaryPath = outputPath + ".tmp";
+
+	std::string command = "\"" + hotreload::findShaderCompiler() + "\" " + (defines.empty() ? "" : defines + " ") + "\"" + sourcePath + "\" -o \"" + temporaryPath + "\"";
+
+#ifdef _WIN32
+	// cmd strips the outer quotes
+	command = "\"" + command + "\"";
+#endif
+
+	logger::log("Compiling shader: " + path + (defines.empty() ? "" : " " + defines), 4);
+
+	std::error_code error;
+
+	if (std::system(command.c_str()) != 0) {
+		std::filesystem::remove(temporaryPath, error);
+		logger::log("Failed to compile shader: " + path, 3);
+
+		return;
+	}
+
+	std::filesystem::rename(temporaryPath, outputPath, error);
+
+	if (error) {
+		logger::log("Failed to replace shader: " + outputPath, 3);
+	}
+	else {
+		logger::log("Successfully compiled shader: " + outputPath, 1);
+	}
+}
+
+void hotreload::compileShader(const std::string& path) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	std::string sourcePath = filesystem::resolveLoosePath(path);
+
+	if (sourcePath.empty()) {
+		return;
+	}
+
+	// same naming as compile.bat, shader.frag becomes frag.spv next to it and any other shader keeps its name, cluster.comp becomes cluster.spv
+	std::filesystem::path source(sourcePath);
+	std::string stage = source.extension().string().substr(1);
+
+	if (source.stem() != "shader") {
+		compileShaderVariant(path, sourcePath, (source.parent_path() / (source.stem().string() + ".spv")).generic_string(), "");
+		return;
+	}
+
+	if (stage != "vert") {
+		compileShaderVariant(path, sourcePath, (source.parent_path() / (stage + ".spv")).generic_string(), "");
+		return;
+	}
+
+	// every vertex format has its own variant, they all come from the same source
+	for (const auto& variant : renderer::vertexShaderVariants) {
+		compileShaderVariant(path, sourcePath, (source.parent_path() / (stage + variant.suffix + ".spv")).generic_string(), variant.defines);
+	}
+}
+
+void hotreload::rebuildPipeline() {
+	BRUTAL_PROFILE_FUNCTION();
+
+	if (hotreload::pendingPipeline.valid()) {
+		hotreload::pipelineOutdated = true;
+		return;
+	}
+
+	hotreload::pendingPipeline = jobs::async([]() {
+		filesystem::fileView vertexShaderCode = filesystem::openImmediate(renderer::vertexShaderPath(renderer::activeVertexFormat));
+		filesystem::fileView fragmentShaderCode = filesystem::openImmediate("shaders/frag.spv");
+
+		return renderer::buildGraphicsPipelines(vertexShaderCode.bytes, fragmentShaderCode.bytes);
+	});
+}
+
+// compute pipelines build quickly, so these are swapped in right away instead of on a worker
+void hotreload::rebuildComputePipeline(const std::string& path) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	VkPipeline* pipeline = &cluster::pipeline;
+	VkPipelineLayout layout = cluster::pipelineLayout;
+
+	if (path == occlusion::cullShaderPath) {
+		pipeline = &occlusion::pipeline;
+		layout = occlusion::pipelineLayout;
+	}
+	else if (path == occlusion::pyramidShaderPath) {
+		pipeline = &occlusion::pyramidPipeline;
+		layout = occlusion::pyramidPipelineLayout;
+	}
+
+	// a pass that never started has no layout to build against
+	if (*pipeline == VK_NULL_HANDLE) {
+		return;
+	}
+
+	try {
+		filesystem::fileView shaderCode = filesystem::openImmediate(path);
+		VkPipeline oldPipeline = *pipeline;
+
+		*pipeline = renderer::createComputePipeline(shaderCode.bytes, layout);
+
+		deletion::retirePipeline(oldPipeline);
+
+		logger::log("Successfully reloaded compute pipeline: " + path, 1);
+	}
+	catch (const std::exception& exception) {
+		logger::log("Failed to reload compute pipeline " + path + ": " + exception.what(), 3);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+#ifndef hotreload_h
+#define hotreload_h
+
+#include "../src/engine.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace hotreload {
+	extern const bool enabled;
+
+	const std::vector<std::string> watchedDirectories = {
+		"shaders",
+		"assets"
+	};
+
+	// editors write in bursts, a path is handled once it has been quiet this long
+	const std::chrono::milliseconds settleTime(100);
+
+	extern std::thread watcher;
+	extern std::atomic<bool> watching;
+
+	extern std::unordered_map<std::string, std::chrono::steady_clock::time_point> changes;
+	extern std::mutex changesMutex;
+
+	extern std::future<std::array<VkPipeline, renderer::pipelineKindCount>> pendingPipeline;
+	extern bool pipelineOutdated;
+	extern std::vector<std::future<engine::texture>> pendingTextures;
+	extern std::vector<std::future<engine::mesh>> pendingModels;
+	extern std::array<bool, renderer::maxFramesInFlight> descriptorsOutdated;
+
+	void init();
+	void shutdown();
+	void watch();
+
+	// called at the frame boundary, right after the current frame's fence was waited on
+	void update();
+
+	void onChanged(const std::string& path);
+	std::string findShaderCompiler();
+	void compileShader(const std::string& path);
+	void rebuildPipeline();
+	void rebuildComputePipeline(const std::string& path);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "./jobs.h"
+
+std::vector<std::thread> jobs::workers;
+std::deque<jobs::task> jobs::queue;
+std::mutex jobs::queueMutex;
+std::condition_variable jobs::queueCondition;
+bool jobs::stopping = false;
+
+void jobs::init(uint32_t workerCount) {
+	if (!jobs::workers.empty()) {
+		return;
+	}
+
+	if (workerCount == 0) {
+		workerCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+	}
+
+	jobs::stopping = false;
+
+	for (uint32_t i = 0; i < workerCount; i++) {
+		jobs::workers.emplace_back([i]() {
+			profiler::setThreadName("worker " + std::to_string(i));
+
+			while (true) {
+				jobs::task job;
+
+				{
+					std::unique_lock<std::mutex> lock(jobs::queueMutex);
+					jobs::queueCondition.wait(lock, []() { return jobs::stopping || !jobs::queue.empty(); });
+
+					if (jobs::stopping && jobs::queue.empty()) {
+						return;
+					}
+
+					job = std::move(jobs::queue.front());
+					jobs::queue.pop_front();
+				}
+
+				BRUTAL_PROFILE_ZONE("job");
+				BRUTAL_MEMORY_SCOPE(job.tag);
+
+				job.function();
+			}
+		});
+	}
+
+	logger::log("Successfully started " + std::to_string(workerCount) + " job workers!", 1);
+}
+
+void jobs::shutdown() {
+	{
+		std::lock_guard<std::mutex> lock(jobs::queueMutex);
+		jobs::stopping = true;
+	}
+
+	jobs::queueCondition.notify_all();
+
+	for (auto& worker : jobs::workers) {
+		worker.join();
+	}
+
+	jobs::workers.clear();
+}
+
+uint32_t jobs::workerCount() {
+	return static_cast<uint32_t>(jobs::workers.size());
+}
+
+void jobs::submit(std::function<void()> job) {
+	if (jobs::workers.empty()) {
+		job();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(jobs::queueMutex);
+		jobs::queue.push_back({ std::move(job), memory::currentTag() });
+	}
+
+	jobs::queueCondition.notify_one();
+}
+
+bool jobs::runPending() {
+	jobs::task job;
+
+	{
+		std::lock_guard<std::mutex> lock(jobs::queueMutex);
+
+		if (jobs::queue.empty()) {
+			return false;
+		}
+
+		job = std::move(jobs::queue.front());
+		jobs::queue.pop_front();
+	}
+
+	BRUTAL_MEMORY_SCOPE(job.tag);
+
+	job.function();
+
+	return true;
+}
+
+void jobs::parallelFor(size_t count, size_t batchSize, const std::function<void(size_t begin, size_t end)>& function) {
+	if (count == 0) {
+		return;
+	}
+
+	batchSize = std::max<size_t>(1, batchSize);
+	size_t batchCount = (count + batchSize - 1) / batchSize;
+
+	if (batchCount == 1 || jobs::workers.empty()) {
+		function(0, count);
+		return;
+	}
+
+	std::atomic<size_t> remaining = batchCount;
+	std::exception_ptr exception;
+	std::mutex exceptionMutex;
+
+	auto runBatch = [&](size_t batch) {
+		size_t begin = batch * batchSize;
+		size_t end = std::min(count, begin + batchSize);
+
+		try {
+			function(begin, end);
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> lock(exceptionMutex);
+			exception = std::current_exception();
+		}
+
+		remaining--;
+	};
+
+	for (size_t batch = 1; batch < batchCount; batch++) {
+		jobs::submit([&runBatch, batch]() { runBatch(batch); });
+	}
+
+	runBatch(0);
+
+	while (remaining > 0) {
+		if (!jobs::runPending()) {
+			std::this_thread::yield();
+		}
+	}
+
+	if (exception) {
+		std::rethrow_exception(exception);
+	}
+}
\ No newline at end of file
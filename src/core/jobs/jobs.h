@@ -0,0 +1,61 @@
+#pragma once
+#ifndef jobs_h
+#define jobs_h
+
+#include "../src/engine.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <deque>
+#include <atomic>
+
+namespace jobs {
+	// jobs run under the memory tag of the thread that submitted them
+	struct task {
+		std::function<void()> function;
+		memory::tag tag;
+	};
+
+	extern std::vector<std::thread> workers;
+	extern std::deque<task> queue;
+	extern std::mutex queueMutex;
+	extern std::condition_variable queueCondition;
+	extern bool stopping;
+
+	void init(uint32_t workerCount = 0);
+	void shutdown();
+	uint32_t workerCount();
+
+	void submit(std::function<void()> job);
+	bool runPending();
+
+	// splits [0, count) into batches and runs them on the workers and the calling thread
+	void parallelFor(size_t count, size_t batchSize, const std::function<void(size_t begin, size_t end)>& function);
+
+	template<typename function>
+	auto async(function&& job) -> std::future<decltype(job())> {
+		auto task = std::make_shared<std::packaged_task<decltype(job())()>>(std::forward<function>(job));
+		std::future<decltype(job())> result = task->get_future();
+
+		jobs::submit([task]() { (*task)(); });
+
+		return result;
+	}
+
+	// waits on a future while helping with queued jobs, so nested waits on workers cannot deadlock
+	template<typename type>
+	type wait(std::future<type>& future) {
+		while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+			if (!jobs::runPending()) {
+				future.wait_for(std::chrono::microseconds(100));
+			}
+		}
+
+		return future.get();
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,353 @@
+#include "./lod.h"
+
+#include <cfloat>
+#include <cmath>
+#include <unordered_map>
+
+// symmetric 4x4 matrix of the summed planes, weight is the summed area so errors come out as a mean squared distance
+struct quadric {
+	double a00, a01, a02, a03;
+	double a11, a12, a13;
+	double a22, a23;
+	double a33;
+	double weight;
+};
+
+static void addPlane(quadric& q, const glm::dvec3& normal, double distance, double weight) {
+	q.a00 += weight * normal.x * normal.x;
+	q.a01 += weight * normal.x * normal.y;
+	q.a02 += weight * normal.x * normal.z;
+	q.a03 += weight * normal.x * distance;
+	q.a11 += weight * normal.y * normal.y;
+	q.a12 += weight * normal.y * normal.z;
+	q.a13 += weight * normal.y * distance;
+	q.a22 += weight * normal.z * normal.z;
+	q.a23 += weight * normal.z * distance;
+	q.a33 += weight * distance * distance;
+	q.weight += weight;
+}
+
+static void addQuadric(quadric& q, const quadric& other) {
+	q.a00 += other.a00;
+	q.a01 += other.a01;
+	q.a02 += other.a02;
+	q.a03 += other.a03;
+	q.a11 += other.a11;
+	q.a12 += other.a12;
+	q.a13 += other.a13;
+	q.a22 += other.a22;
+	q.a23 += other.a23;
+	q.a33 += other.a33;
+	q.weight += other.weight;
+}
+
+// mean squared distance of the point to the planes of the two quadrics
+static double collapseCost(const quadric& a, const quadric& b, const glm::vec3& position) {
+	quadric q = a;
+	addQuadric(q, b);
+
+	double x = position.x;
+	double y = position.y;
+	double z = position.z;
+
+	double error = q.a00 * x * x + 2.0 * q.a01 * x * y + 2.0 * q.a02 * x * z + 2.0 * q.a03 * x
+		+ q.a11 * y * y + 2.0 * q.a12 * y * z + 2.0 * q.a13 * y
+		+ q.a22 * z * z + 2.0 * q.a23 * z
+		+ q.a33;
+
+	return q.weight > 0.0 ? std::max(error, 0.0) / q.weight : 0.0;
+}
+
+// bitwise like optimize::weld, vertices that only differ in uv or color share a position
+struct positionKey {
+	const glm::vec3* position;
+
+	bool operator==(const positionKey& other) const {
+		return memcmp(position, other.position, sizeof(glm::vec3)) == 0;
+	}
+};
+
+struct positionKeyHash {
+	size_t operator()(const positionKey& key) const {
+		return static_cast<size_t>(assets::hashBytes(std::span<const char>(reinterpret_cast<const char*>(key.position), sizeof(glm::vec3))));
+	}
+};
+
+struct collapse {
+	uint32_t from;
+	uint32_t to;
+	double cost;
+};
+
+float lod::simplify(std::span<const renderer::vertex> vertices, std::span<const uint32_t> indices, size_t targetIndexCount, float maximumError, std::vector<uint32_t>& result) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	result.assign(indices.begin(), indices.end());
+
+	if (result.size() <= targetIndexCount) {
+		return 0.0f;
+	}
+
+	size_t vertexCount = vertices.size();
+
+	// quadrics, locks and adjacency are per position, the vertices sharing one are its wedges
+	std::unordered_map<positionKey, uint32_t, positionKeyHash> unique;
+	unique.reserve(vertexCount);
+
+	std::vector<uint32_t> positionOf(vertexCount);
+
+	for (size_t i = 0; i < vertexCount; i++) {
+		positionOf[i] = unique.try_emplace(positionKey{ &vertices[i].pos }, static_cast<uint32_t>(i)).first->second;
+	}
+
+	std::vector<quadric> quadrics(vertexCount, quadric{});
+
+	for (size_t i = 0; i + 2 < result.size(); i += 3) {
+		glm::dvec3 p0 = vertices[result[i]].pos;
+		glm::dvec3 p1 = vertices[result[i + 1]].pos;
+		glm::dvec3 p2 = vertices[result[i + 2]].pos;
+
+		glm::dvec3 cross = glm::cross(p1 - p0, p2 - p0);
+		double length = glm::length(cross);
+
+		if (length == 0.0) {
+			continue;
+		}
+
+		glm::dvec3 normal = cross / length;
+
+		for (size_t corner = 0; corner < 3; corner++) {
+			addPlane(quadrics[positionOf[result[i + corner]]], normal, -glm::dot(normal, p0), length * 0.5);
+		}
+	}
+
+	std::unordered_map<uint64_t, uint32_t> edgeUses;
+	std::vector<uint32_t> wedge(vertexCount);
+	std::vector<uint8_t> movable(vertexCount);
+	std::vector<uint32_t> offsets(vertexCount + 1);
+	std::vector<uint32_t> adjacency;
+	std::vector<collapse> candidates;
+	std::vector<uint8_t> touched(vertexCount);
+	std::vector<uint32_t> remap(vertexCount);
+
+	double error = 0.0;
+	double maximumCost = static_cast<double>(maximumError) * maximumError;
+
+	// every pass collapses the cheapest edges whose neighbourhoods do not overlap, then compacts the index list
+	while (result.size() > targetIndexCount) {
+		size_t triangleCount = result.size() / 3;
+
+		// a position is movable when one wedge uses it and every edge around it has exactly two triangles
+		std::fill(wedge.begin(), wedge.end(), UINT32_MAX);
+		std::fill(movable.begin(), movable.end(), 1);
+
+		for (uint32_t index : result) {
+			uint32_t position = positionOf[index];
+
+			if (wedge[position] == UINT32_MAX) {
+				wedge[position] = index;
+			}
+			else if (wedge[position] != index) {
+				movable[position] = 0;
+			}
+		}
+
+		edgeUses.clear();
+		edgeUses.reserve(result.size());
+
+		for (size_t i = 0; i < result.size(); i += 3) {
+			for (size_t corner = 0; corner < 3; corner++) {
+				uint32_t a = positionOf[result[i + corner]];
+				uint32_t b = positionOf[result[i + (corner + 1) % 3]];
+
+				edgeUses[(static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b)]++;
+			}
+		}
+
+		for (const auto& [edge, uses] : edgeUses) {
+			if (uses != 2) {
+				movable[static_cast<uint32_t>(edge >> 32)] = 0;
+				movable[static_cast<uint32_t>(edge)] = 0;
+			}
+		}
+
+		std::fill(offsets.begin(), offsets.end(), 0);
+
+		for (uint32_t index : result) {
+			offsets[positionOf[index] + 1]++;
+		}
+
+		for (size_t position = 0; position < vertexCount; position++) {
+			offsets[position + 1] += offsets[position];
+		}
+
+		adjacency.resize(result.size());
+		std::vector<uint32_t> filled(offsets.begin(), offsets.end() - 1);
+
+		for (size_t i = 0; i < result.size(); i++) {
+			adjacency[filled[positionOf[result[i]]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		// a manifold edge shows up in two triangles with opposite winding, only the one going up in position is taken
+		candidates.clear();
+
+		for (size_t i = 0; i < result.size(); i += 3) {
+			for (size_t corner = 0; corner < 3; corner++) {
+				uint32_t a = result[i + corner];
+				uint32_t b = result[i + (corner + 1) % 3];
+
+				if (positionOf[a] >= positionOf[b]) {
+					continue;
+				}
+
+				double cost = collapseCost(quadrics[positionOf[a]], quadrics[positionOf[b]], vertices[b].pos);
+
+				if (movable[positionOf[a]]) {
+					candidates.push_back({ a, b, cost });
+				}
+
+				if (movable[positionOf[b]]) {
+					candidates.push_back({ b, a, collapseCost(quadrics[positionOf[a]], quadrics[positionOf[b]], vertices[a].pos) });
+				}
+			}
+		}
+
+		std::sort(candidates.begin(), candidates.end(), [](const collapse& a, const collapse& b) { return a.cost < b.cost; });
+
+		// an interior collapse removes two triangles
+		size_t collapsesLeft = (triangleCount - targetIndexCount / 3 + 1) / 2;
+		size_t collapses = 0;
+
+		std::fill(touched.begin(), touched.end(), 0);
+
+		for (size_t i = 0; i < remap.size(); i++) {
+			remap[i] = static_cast<uint32_t>(i);
+		}
+
+		for (const auto& candidate : candidates) {
+			if (collapsesLeft == 0 || candidate.cost > maximumCost) {
+				break;
+			}
+
+			uint32_t from = positionOf[candidate.from];
+			uint32_t to = positionOf[candidate.to];
+
+			if (touched[from] || touched[to]) {
+				continue;
+			}
+
+			// the triangles that survive the collapse must keep roughly facing the same way
+			bool flips = false;
+
+			for (uint32_t j = offsets[from]; j < offsets[from + 1] && !flips; j++) {
+				const uint32_t* triangle = &result[static_cast<size_t>(adjacency[j]) * 3];
+
+				if (positionOf[triangle[0]] == to || positionOf[triangle[1]] == to || positionOf[triangle[2]] == to) {
+					continue;
+				}
+
+				glm::vec3 corners[3];
+				glm::vec3 moved[3];
+
+				for (size_t corner = 0; corner < 3; corner++) {
+					corners[corner] = vertices[triangle[corner]].pos;
+					moved[corner] = positionOf[triangle[corner]] == from ? vertices[candidate.to].pos : corners[corner];
+				}
+
+				glm::vec3 before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+				glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+
+				// anything turning by more than about 75 degrees counts, small turns add up over many collapses
+				flips = glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after);
+			}
+
+			if (flips) {
+				continue;
+			}
+
+			for (uint32_t j = offsets[from]; j < offsets[from + 1]; j++) {
+				const uint32_t* triangle = &result[static_cast<size_t>(adjacency[j]) * 3];
+
+				touched[positionOf[triangle[0]]] = 1;
+				touched[positionOf[triangle[1]]] = 1;
+				touched[positionOf[triangle[2]]] = 1;
+			}
+
+			remap[candidate.from] = candidate.to;
+			addQuadric(quadrics[to], quadrics[from]);
+
+			error = std::max(error, candidate.cost);
+
+			collapsesLeft--;
+			collapses++;
+		}
+
+		if (collapses == 0) {
+			break;
+		}
+
+		size_t write = 0;
+
+		for (size_t i = 0; i < result.size(); i += 3) {
+			uint32_t a = remap[result[i]];
+			uint32_t b = remap[result[i + 1]];
+			uint32_t c = remap[result[i + 2]];
+
+			if (positionOf[a] == positionOf[b] || positionOf[b] == positionOf[c] || positionOf[a] == positionOf[c]) {
+				continue;
+			}
+
+			result[write++] = a;
+			result[write++] = b;
+			result[write++] = c;
+		}
+
+		result.resize(write);
+	}
+
+	return static_cast<float>(std::sqrt(error));
+}
+
+std::vector<renderer::meshLod> lod::buildChain(const std::string& name, std::span<const renderer::vertex> vertices, std::vector<uint32_t>& indices) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	std::vector<renderer::meshLod> lods;
+	lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.0f });
+
+	std::vector<uint32_t> source = indices;
+	std::vector<uint32_t> simplified;
+
+	size_t previous = source.size();
+	float error = 0.0f;
+
+	std::string counts = std::to_string(previous / 3);
+
+	while (lods.size() < renderer::maxLods) {
+		size_t target = static_cast<size_t>(static_cast<float>(previous / 3) * lod::reduction) * 3;
+
+		if (target / 3 < lod::minimumTriangles) {
+			break;
+		}
+
+		float levelError = lod::simplify(vertices, source, target, FLT_MAX, simplified);
+
+		if (static_cast<float>(simplified.size()) > static_cast<float>(previous) * lod::minimumReduction) {
+			break;
+		}
+
+		optimize::optimizeVertexCache(simplified, vertices.size());
+
+		// each level is simplified from lod 0, so a coarser one can come out with a smaller error, selection needs them increasing
+		error = std::max(error, levelError);
+
+		lods.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(simplified.size()), error });
+		indices.insert(indices.end(), simplified.begin(), simplified.end());
+
+		previous = simplified.size();
+		counts += " -> " + std::to_string(previous / 3);
+	}
+
+	logger::log("Built " + std::to_string(lods.size()) + " lods for " + name + ": " + counts + " triangles, error " + std::to_string(error), 4);
+
+	return lods;
+}
\ No newline at end of file
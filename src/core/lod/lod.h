@@ -0,0 +1,30 @@
+#pragma once
+#ifndef lod_h
+#define lod_h
+
+#include "../src/engine.h"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace lod {
+	// every level aims for this fraction of the triangles of the level before it
+	const float reduction = 0.5f;
+
+	// a level keeping more than this fraction of the previous one means the mesh stopped simplifying, the chain ends there
+	const float minimumReduction = 0.8f;
+
+	// below this many triangles a level costs more in draw calls than it saves in vertices
+	const uint32_t minimumTriangles = 64;
+
+	// garland and heckbert's quadric error metric, edges collapse onto one of their own vertices so every level indexes the same vertex buffer
+	// borders and uv seams stay put, returns the largest collapse error in mesh units
+	float simplify(std::span<const renderer::vertex> vertices, std::span<const uint32_t> indices, size_t targetIndexCount, float maximumError, std::vector<uint32_t>& result);
+
+	// lod 0 is indices as they are, the coarser levels are appended to indices, each one simplified from lod 0
+	std::vector<renderer::meshLod> buildChain(const std::string& name, std::span<const renderer::vertex> vertices, std::vector<uint32_t>& indices);
+}
+
+#endif
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "./logger.h"
 
 void logger::log(std::string message, uint32_t type) {
+	BRUTAL_MEMORY_SCOPE(memory::tag::logging);
 
 	// 1 = green, 2 = yellow, 3 = error, 4 = standard
 	// success, warning, error, normal
@@ -0,0 +1,468 @@
+#include "./memory.h"
+
+std::array<memory::counters, memory::tagCount> memory::cpu{};
+std::array<memory::counters, memory::tagCount> memory::device{};
+std::array<memory::counters, memory::maxHeaps> memory::heaps{};
+
+std::array<uint64_t, memory::tagCount> memory::lastFrameAllocations{};
+std::array<uint64_t, memory::tagCount> memory::peakFrameAllocations{};
+uint64_t memory::frame = 0;
+
+std::array<memory::budget, memory::tagCount> memory::budgets{};
+bool memory::enforceBudgets = false;
+bool memory::budgetExceeded = false;
+bool memory::reportOnExit = false;
+
+VkPhysicalDeviceMemoryProperties memory::deviceMemoryProperties{};
+bool memory::deviceMemoryPropertiesRead = false;
+std::unordered_map<VkDeviceMemory, memory::deviceAllocation> memory::deviceAllocations;
+std::mutex memory::deviceAllocationsMutex;
+
+// plain data so it is usable before any static constructor has run
+static thread_local memory::tag threadTag = memory::tag::general;
+
+// one bit per budget kind and tag, so each violation is only logged once
+static std::array<uint8_t, memory::tagCount> reportedViolations{};
+
+// sits right in front of every tracked allocation
+struct allocationHeader {
+	uint64_t size;
+	uint32_t offset;
+	memory::tag owner;
+	uint8_t reserved[3];
+};
+
+static_assert(sizeof(allocationHeader) == 16, "allocation header must keep 16 byte alignment");
+
+static void raise(std::atomic<uint64_t>& highWater, uint64_t value) {
+	uint64_t current = highWater.load(std::memory_order_relaxed);
+
+	while (value > current && !highWater.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+static void charge(memory::counters& counters, uint64_t size) {
+	uint64_t bytes = counters.bytes.fetch_add(size, std::memory_order_relaxed) + size;
+
+	raise(counters.highWaterBytes, bytes);
+
+	counters.allocations.fetch_add(1, std::memory_order_relaxed);
+	counters.frameAllocations.fetch_add(1, std::memory_order_relaxed);
+	counters.frameBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+static void release(memory::counters& counters, uint64_t size) {
+	counters.bytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+memory::scope::scope(memory::tag current) {
+	previous = threadTag;
+	threadTag = current;
+}
+
+memory::scope::~scope() {
+	threadTag = previous;
+}
+
+memory::tag memory::currentTag() {
+	return threadTag;
+}
+
+void memory::setCurrentTag(memory::tag current) {
+	threadTag = current;
+}
+
+const char* memory::tagName(memory::tag current) {
+	switch (current) {
+		case memory::tag::general:
+			return "general";
+		case memory::tag::renderer:
+			return "renderer";
+		case memory::tag::assets:
+			return "assets";
+		case memory::tag::ecs:
+			return "ecs";
+		case memory::tag::logging:
+			return "logging";
+		case memory::tag::profiler:
+			return "profiler";
+		default:
+			return "unknown";
+	}
+}
+
+bool memory::parseTag(const std::string& name, memory::tag& result) {
+	for (size_t i = 0; i < memory::tagCount; i++) {
+		if (name == memory::tagName(static_cast<memory::tag>(i))) {
+			result = static_cast<memory::tag>(i);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void* memory::allocate(size_t size, size_t alignment, memory::tag owner) {
+	alignment = std::max(alignment, alignof(allocationHeader));
+	alignment = std::max(alignment, alignof(std::max_align_t));
+
+	// malloc already returns max_align_t aligned blocks, larger alignments need slack to shift into
+	size_t padding = std::max(alignment, sizeof(allocationHeader));
+	size_t slack = alignment > alignof(std::max_align_t) ? alignment : 0;
+
+	char* base = static_cast<char*>(std::malloc(size + padding + slack));
+
+	if (base == nullptr) {
+		return nullptr;
+	}
+
+	uintptr_t address = reinterpret_cast<uintptr_t>(base) + sizeof(allocationHeader);
+	address = (address + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+
+	char* pointer = reinterpret_cast<char*>(address);
+
+	allocationHeader* header = reinterpret_cast<allocationHeader*>(pointer) - 1;
+	header->size = size;
+	header->offset = static_cast<uint32_t>(pointer - base);
+	header->owner = owner;
+
+	charge(memory::cpu[static_cast<size_t>(owner)], size);
+
+	return pointer;
+}
+
+void memory::deallocate(void* pointer) {
+	if (pointer == nullptr) {
+		return;
+	}
+
+	allocationHeader* header = static_cast<allocationHeader*>(pointer) - 1;
+
+	release(memory::cpu[static_cast<size_t>(header->owner)], header->size);
+
+	std::free(static_cast<char*>(pointer) - header->offset);
+}
+
+VkResult memory::allocateDevice(const VkMemoryAllocateInfo& allocateInfo, VkDeviceMemory& deviceMemory) {
+	VkResult result = vkAllocateMemory(renderer::device, &allocateInfo, nullptr, &deviceMemory);
+
+	if (result != VK_SUCCESS) {
+		return result;
+	}
+
+	std::lock_guard<std::mutex> lock(memory::deviceAllocationsMutex);
+
+	if (!memory::deviceMemoryPropertiesRead) {
+		vkGetPhysicalDeviceMemoryProperties(renderer::physicalDevice, &memory::deviceMemoryProperties);
+		memory::deviceMemoryPropertiesRead = true;
+	}
+
+	memory::deviceAllocation allocation{};
+	allocation.size = allocateInfo.allocationSize;
+	allocation.heap = memory::deviceMemoryProperties.memoryTypes[allocateInfo.memoryTypeIndex].heapIndex;
+	allocation.owner = threadTag;
+
+	charge(memory::heaps[allocation.heap], allocation.size);
+	charge(memory::device[static_cast<size_t>(allocation.owner)], allocation.size);
+
+	memory::deviceAllocations[deviceMemory] = allocation;
+
+	return result;
+}
+
+void memory::freeDevice(VkDeviceMemory deviceMemory) {
+	if (deviceMemory == VK_NULL_HANDLE) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(memory::deviceAllocationsMutex);
+
+		auto allocation = memory::deviceAllocations.find(deviceMemory);
+
+		if (allocation != memory::deviceAllocations.end()) {
+			release(memory::heaps[allocation->second.heap], allocation->second.size);
+			release(memory::device[static_cast<size_t>(allocation->second.owner)], allocation->second.size);
+
+			memory::deviceAllocations.erase(allocation);
+		}
+	}
+
+	vkFreeMemory(renderer::device, deviceMemory, nullptr);
+}
+
+void memory::endFrame() {
+	for (size_t i = 0; i < memory::tagCount; i++) {
+		uint64_t allocations = memory::cpu[i].frameAllocations.exchange(0, std::memory_order_relaxed);
+		memory::cpu[i].frameBytes.store(0, std::memory_order_relaxed);
+
+		memory::lastFrameAllocations[i] = allocations;
+
+		// the first frame also carries everything allocated during init
+		if (memory::frame > 0) {
+			memory::peakFrameAllocations[i] = std::max(memory::peakFrameAllocations[i], allocations);
+		}
+	}
+
+	memory::frame++;
+
+	if (memory::frame == 1) {
+		return;
+	}
+
+	bool newViolations = false;
+
+	for (size_t i = 0; i < memory::tagCount; i++) {
+		const memory::budget& budget = memory::budgets[i];
+
+		uint8_t violations = 0;
+
+		if (budget.bytes > 0 && memory::cpu[i].bytes.load(std::memory_order_relaxed) > budget.bytes) {
+			violations |= 1;
+		}
+
+		if (budget.deviceBytes > 0 && memory::device[i].bytes.load(std::memory_order_relaxed) > budget.deviceBytes) {
+			violations |= 2;
+		}
+
+		if (budget.frameAllocations > 0 && memory::lastFrameAllocations[i] > budget.frameAllocations) {
+			violations |= 4;
+		}
+
+		if ((violations & ~reportedViolations[i]) != 0) {
+			reportedViolations[i] |= violations;
+			newViolations = true;
+		}
+	}
+
+	if (!newViolations) {
+		return;
+	}
+
+	memory::budgetExceeded = true;
+
+	for (const auto& message : memory::checkBudgets()) {
+		logger::log(message + " (frame " + std::to_string(memory::frame) + ")", memory::enforceBudgets ? 3 : 2);
+	}
+}
+
+void memory::resetHighWater() {
+	for (size_t i = 0; i < memory::tagCount; i++) {
+		memory::cpu[i].highWaterBytes.store(memory::cpu[i].bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		memory::device[i].highWaterBytes.store(memory::device[i].bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+		memory::peakFrameAllocations[i] = 0;
+	}
+
+	for (auto& heap : memory::heaps) {
+		heap.highWaterBytes.store(heap.bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	}
+
+	memory::frame = 0;
+	memory::budgetExceeded = false;
+	reportedViolations.fill(0);
+}
+
+void memory::parseBudget(const std::string& value) {
+	size_t equals = value.find('=');
+
+	if (equals == std::string::npos) {
+		throw std::runtime_error("Failed to parse memory budget: " + value);
+	}
+
+	std::string name = value.substr(0, equals);
+	std::string limits = value.substr(equals + 1);
+
+	bool deviceBudget = name.rfind("device.", 0) == 0;
+
+	if (deviceBudget) {
+		name = name.substr(7);
+	}
+
+	memory::tag current;
+
+	if (!memory::parseTag(name, current)) {
+		throw std::runtime_error("Unknown memory tag: " + name);
+	}
+
+	memory::budget& budget = memory::budgets[static_cast<size_t>(current)];
+
+	size_t colon = limits.find(':');
+	uint64_t bytes = static_cast<uint64_t>(std::stod(limits.substr(0, colon)) * 1024.0 * 1024.0);
+
+	if (deviceBudget) {
+		budget.deviceBytes = bytes;
+	}
+	else {
+		budget.bytes = bytes;
+	}
+
+	if (colon != std::string::npos) {
+		budget.frameAllocations = std::stoull(limits.substr(colon + 1));
+	}
+
+	memory::enforceBudgets = true;
+}
+
+std::vector<std::string> memory::checkBudgets() {
+	std::vector<std::string> violations;
+
+	for (size_t i = 0; i < memory::tagCount; i++) {
+		const memory::budget& budget = memory::budgets[i];
+		std::string name = memory::tagName(static_cast<memory::tag>(i));
+
+		uint64_t bytes = memory::cpu[i].bytes.load(std::memory_order_relaxed);
+		uint64_t deviceBytes = memory::device[i].bytes.load(std::memory_order_relaxed);
+
+		if (budget.bytes > 0 && bytes > budget.bytes) {
+			violations.push_back("Memory budget exceeded: " + name + " uses " + std::to_string(bytes) + " of " + std::to_string(budget.bytes) + " bytes");
+		}
+
+		if (budget.deviceBytes > 0 && deviceBytes > budget.deviceBytes) {
+			violations.push_back("Device memory budget exceeded: " + name + " uses " + std::to_string(deviceBytes) + " of " + std::to_string(budget.deviceBytes) + " bytes");
+		}
+
+		if (budget.frameAllocations > 0 && memory::lastFrameAllocations[i] > budget.frameAllocations) {
+			violations.push_back("Allocation budget exceeded: " + name + " made " + std::to_string(memory::lastFrameAllocations[i]) + " of " + std::to_string(budget.frameAllocations) + " allocations per frame");
+		}
+	}
+
+	return violations;
+}
+
+std::vector<memory::tagStats> memory::stats() {
+	std::vector<memory::tagStats> result;
+
+	for (size_t i = 0; i < memory::tagCount; i++) {
+		memory::tagStats stats{};
+		stats.name = memory::tagName(static_cast<memory::tag>(i));
+		stats.bytes = memory::cpu[i].bytes.load(std::memory_order_relaxed);
+		stats.highWaterBytes = memory::cpu[i].highWaterBytes.load(std::memory_order_relaxed);
+		stats.allocations = memory::cpu[i].allocations.load(std::memory_order_relaxed);
+		stats.lastFrameAllocations = memory::lastFrameAllocations[i];
+		stats.peakFrameAllocations = memory::peakFrameAllocations[i];
+		stats.deviceBytes = memory::device[i].bytes.load(std::memory_order_relaxed);
+		stats.deviceHighWaterBytes = memory::device[i].highWaterBytes.load(std::memory_order_relaxed);
+
+		result.push_back(stats);
+	}
+
+	return result;
+}
+
+std::vector<memory::heapStats> memory::deviceHeaps() {
+	std::vector<memory::heapStats> result;
+
+	std::lock_guard<std::mutex> lock(memory::deviceAllocationsMutex);
+
+	if (!memory::deviceMemoryPropertiesRead) {
+		return result;
+	}
+
+	for (uint32_t i = 0; i < memory::deviceMemoryProperties.memoryHeapCount; i++) {
+		memory::heapStats stats{};
+		stats.heap = i;
+		stats.deviceLocal = (memory::deviceMemoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+		stats.size = memory::deviceMemoryProperties.memoryHeaps[i].size;
+		stats.bytes = memory::heaps[i].bytes.load(std::memory_order_relaxed);
+		stats.highWaterBytes = memory::heaps[i].highWaterBytes.load(std::memory_order_relaxed);
+		stats.allocations = memory::heaps[i].allocations.load(std::memory_order_relaxed);
+
+		result.push_back(stats);
+	}
+
+	return result;
+}
+
+void memory::report() {
+#ifndef BRUTAL_MEMORY_TRACKING
+	logger::log("Global allocations are not tracked in this build, only tagged allocators and device memory are counted", 2);
+#endif
+
+	logger::log("Memory by subsystem (current / high-water bytes, allocations, last / peak per frame, device current / high-water bytes):", 4);
+
+	for (const auto& stats : memory::stats()) {
+		logger::log("  " + stats.name + ": " + std::to_string(stats.bytes) + " / " + std::to_string(stats.highWaterBytes) + ", " + std::to_string(stats.allocations) + ", " + std::to_string(stats.lastFrameAllocations) + " / " + std::to_string(stats.peakFrameAllocations) + ", " + std::to_string(stats.deviceBytes) + " / " + std::to_string(stats.deviceHighWaterBytes), 4);
+	}
+
+	for (const auto& heap : memory::deviceHeaps()) {
+		logger::log("  heap " + std::to_string(heap.heap) + (heap.deviceLocal ? " (device local)" : "") + ": " + std::to_string(heap.bytes) + " / " + std::to_string(heap.highWaterBytes) + " of " + std::to_string(heap.size) + " bytes, " + std::to_string(heap.allocations) + " allocations", 4);
+	}
+}
+
+#ifdef BRUTAL_MEMORY_TRACKING
+void* operator new(size_t size) {
+	void* pointer = memory::allocate(size, alignof(std::max_align_t), threadTag);
+
+	if (pointer == nullptr) {
+		throw std::bad_alloc();
+	}
+
+	return pointer;
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+	void* pointer = memory::allocate(size, static_cast<size_t>(alignment), threadTag);
+
+	if (pointer == nullptr) {
+		throw std::bad_alloc();
+	}
+
+	return pointer;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+	return operator new(size, alignment);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	return memory::allocate(size, alignof(std::max_align_t), threadTag);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+	return memory::allocate(size, alignof(std::max_align_t), threadTag);
+}
+
+void operator delete(void* pointer) noexcept {
+	memory::deallocate(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+	memory::deallocate(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+	memory::deallocate(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+	memory::deallocate(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+	memory::deallocate(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept {
+	memory::deallocate(pointer);
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept {
+	memory::deallocate(pointer);
+}
+
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept {
+	memory::deallocate(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+	memory::deallocate(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+	memory::deallocate(pointer);
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,169 @@
+#pragma once
+#ifndef memory_h
+#define memory_h
+
+#include "../src/engine.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// global new and delete are only replaced when profiling is compiled in, tagged allocators and device memory are always counted
+#if !defined(NDEBUG) || defined(BRUTAL_PROFILER)
+#define BRUTAL_MEMORY_TRACKING
+#endif
+
+#define BRUTAL_MEMORY_CONCAT_INNER(a, b) a##b
+#define BRUTAL_MEMORY_CONCAT(a, b) BRUTAL_MEMORY_CONCAT_INNER(a, b)
+#define BRUTAL_MEMORY_SCOPE(tag) memory::scope BRUTAL_MEMORY_CONCAT(memoryScope, __LINE__)(tag)
+
+namespace memory {
+	enum class tag : uint8_t {
+		general,
+		renderer,
+		assets,
+		ecs,
+		logging,
+		profiler,
+		count
+	};
+
+	const size_t tagCount = static_cast<size_t>(tag::count);
+	const uint32_t maxHeaps = VK_MAX_MEMORY_HEAPS;
+
+	struct counters {
+		std::atomic<uint64_t> bytes;
+		std::atomic<uint64_t> highWaterBytes;
+		std::atomic<uint64_t> allocations;
+		std::atomic<uint64_t> frameAllocations;
+		std::atomic<uint64_t> frameBytes;
+	};
+
+	// zero means unlimited, frameAllocations catches per frame copies that never show up as resident bytes
+	struct budget {
+		uint64_t bytes;
+		uint64_t deviceBytes;
+		uint64_t frameAllocations;
+	};
+
+	struct tagStats {
+		std::string name;
+		uint64_t bytes;
+		uint64_t highWaterBytes;
+		uint64_t allocations;
+		uint64_t lastFrameAllocations;
+		uint64_t peakFrameAllocations;
+		uint64_t deviceBytes;
+		uint64_t deviceHighWaterBytes;
+	};
+
+	struct heapStats {
+		uint32_t heap;
+		bool deviceLocal;
+		uint64_t size;
+		uint64_t bytes;
+		uint64_t highWaterBytes;
+		uint64_t allocations;
+	};
+
+	struct deviceAllocation {
+		VkDeviceSize size;
+		uint32_t heap;
+		tag owner;
+	};
+
+	extern std::array<counters, tagCount> cpu;
+	extern std::array<counters, tagCount> device;
+	extern std::array<counters, maxHeaps> heaps;
+
+	extern std::array<uint64_t, tagCount> lastFrameAllocations;
+	extern std::array<uint64_t, tagCount> peakFrameAllocations;
+	extern uint64_t frame;
+
+	extern std::array<budget, tagCount> budgets;
+	extern bool enforceBudgets;
+	extern bool budgetExceeded;
+	extern bool reportOnExit;
+
+	extern VkPhysicalDeviceMemoryProperties deviceMemoryProperties;
+	extern bool deviceMemoryPropertiesRead;
+	extern std::unordered_map<VkDeviceMemory, deviceAllocation> deviceAllocations;
+	extern std::mutex deviceAllocationsMutex;
+
+	// allocations on this thread are charged to the innermost scope, jobs inherit the tag of the thread that submitted them
+	class scope {
+		public:
+			scope(tag current);
+			~scope();
+
+			scope(const scope&) = delete;
+			scope& operator=(const scope&) = delete;
+		private:
+			tag previous;
+	};
+
+	tag currentTag();
+	void setCurrentTag(tag current);
+	const char* tagName(tag current);
+	bool parseTag(const std::string& name, tag& result);
+
+	void* allocate(size_t size, size_t alignment, tag owner);
+	void deallocate(void* pointer);
+
+	// wraps vkAllocateMemory and vkFreeMemory so device memory is charged per heap and per tag
+	VkResult allocateDevice(const VkMemoryAllocateInfo& allocateInfo, VkDeviceMemory& deviceMemory);
+	void freeDevice(VkDeviceMemory deviceMemory);
+
+	// closes the frame's allocation counts and checks the budgets, called once per rendered frame
+	void endFrame();
+	void resetHighWater();
+
+	// "<tag>=<megabytes>[:<allocations per frame>]", "device.<tag>=<megabytes>" for device memory
+	void parseBudget(const std::string& value);
+	std::vector<std::string> checkBudgets();
+
+	std::vector<tagStats> stats();
+	std::vector<heapStats> deviceHeaps();
+	void report();
+
+	// stl allocator charging a fixed subsystem regardless of the calling thread's scope
+	template<typename type, tag owner>
+	struct taggedAllocator {
+		using value_type = type;
+
+		template<typename otherType>
+		struct rebind {
+			using other = taggedAllocator<otherType, owner>;
+		};
+
+		taggedAllocator() noexcept = default;
+
+		template<typename otherType>
+		taggedAllocator(const taggedAllocator<otherType, owner>&) noexcept {}
+
+		type* allocate(size_t count) {
+			return static_cast<type*>(memory::allocate(count * sizeof(type), alignof(type), owner));
+		}
+
+		void deallocate(type* pointer, size_t) noexcept {
+			memory::deallocate(pointer);
+		}
+
+		template<typename otherType>
+		bool operator==(const taggedAllocator<otherType, owner>&) const noexcept { return true; }
+
+		template<typename otherType>
+		bool operator!=(const taggedAllocator<otherType, owner>&) const noexcept { return false; }
+	};
+
+	template<typename type, tag owner>
+	using vector = std::vector<type, taggedAllocator<type, owner>>;
+}
+
+#endif
\ No newline at end of file
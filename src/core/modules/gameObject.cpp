@@ -1,16 +1,24 @@
 #include "./gameObject.h"
 
-engine::gameObject::data engine::gameObject::createGameObject(std::string modelPath) {
-	engine::model model;
+std::vector<engine::gameObject::data> engine::gameObject::gameObjects;
 
-	model.createModel(modelPath);
+engine::gameObject::data& engine::gameObject::createGameObject(const std::string& modelPath, const glm::mat4& transform) {
+	BRUTAL_MEMORY_SCOPE(memory::tag::ecs);
 
 	engine::gameObject::data gameObject{};
-	gameObject.model = model;
+	gameObject.model = engine::model::createModel(modelPath);
+	gameObject.object = static_cast<uint32_t>(renderer::objects.size());
 
-	engine::gameObject::gameObjects.push_back(gameObject);
+	renderer::sceneObject object{};
+	object.mesh = gameObject.model.mesh;
+	object.transform = transform;
+
+	renderer::objects.push_back(object);
+	renderer::sceneVersion++;
+
+	engine::gameObject::gameObjects.push_back(std::move(gameObject));
 
 	logger::log("Successfully created game object!", 1);
 
-	return gameObject;
+	return engine::gameObject::gameObjects.back();
 }
\ No newline at end of file
@@ -9,11 +9,13 @@ namespace engine {
 		public:
 			struct data {
 				engine::model model;
-			} dataObject;
+				uint32_t object;
+			};
 
 			static std::vector<data> gameObjects;
 
-			engine::gameObject::data createGameObject(std::string modelPath);
+			// the returned reference is only valid until the next game object is created
+			static engine::gameObject::data& createGameObject(const std::string& modelPath, const glm::mat4& transform = glm::mat4(1.0f));
 		private:
 	};
 }
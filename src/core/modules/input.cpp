@@ -16,17 +16,18 @@ void input::initializeInput() {
 }
 
 void input::inputLoop() {
-	SDL_PollEvent(&inputEvent);
+	bool polled = SDL_PollEvent(&inputEvent) == 1;
 
 	if (inputEvent.type == SDL_QUIT) {
 		engine::running = false;
 	}
 
-	if (inputEvent.type == SDL_WINDOWEVENT) {
+	// the event stays around when nothing new was polled, a resize only marks the swapchain and a burst of them ends in one recreation
+	if (polled && inputEvent.type == SDL_WINDOWEVENT) {
 		if (inputEvent.window.event == SDL_WINDOWEVENT_MOVED) {
 		}
-		if (inputEvent.window.event == SDL_WINDOWEVENT_RESIZED) {
-			renderer::recreateSwapChain();
+		if (inputEvent.window.event == SDL_WINDOWEVENT_RESIZED || inputEvent.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+			renderer::framebufferResized = true;
 		}
 	}
 
@@ -1,107 +1,163 @@
 #include "model.h"
 
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <tinyobjloader/tiny_obj_loader.h>
+engine::mesh::mesh(engine::mesh&& other) noexcept {
+	*this = std::move(other);
+}
+
+engine::mesh& engine::mesh::operator=(engine::mesh&& other) noexcept {
+	path = std::move(other.path);
+	lods = std::move(other.lods);
+	meshlets = std::move(other.meshlets);
+	view = std::move(other.view);
+	ownedVertices = std::move(other.ownedVertices);
+	ownedIndices = std::move(other.ownedIndices);
+
+	// moving a vector keeps its buffer, so the spans stay valid in the new owner
+	vertexSpan = other.vertexSpan;
+	indexSpan = other.indexSpan;
+
+	other.vertexSpan = {};
+	other.indexSpan = {};
+
+	return *this;
+}
+
+engine::mesh engine::mesh::fromVectors(const std::string& path, std::vector<renderer::vertex>&& vertices, std::vector<uint32_t>&& indices) {
+	engine::mesh result;
+	result.path = path;
+	result.ownedVertices = std::move(vertices);
+	result.ownedIndices = std::move(indices);
+	result.vertexSpan = result.ownedVertices;
+	result.indexSpan = result.ownedIndices;
+
+	return result;
+}
+
+engine::mesh engine::mesh::fromView(const std::string& path, filesystem::fileView view, std::span<const renderer::vertex> vertices, std::span<const uint32_t> indices) {
+	engine::mesh result;
+	result.path = path;
+	result.view = std::move(view);
+	result.vertexSpan = vertices;
+	result.indexSpan = indices;
+
+	return result;
+}
+
+void engine::mesh::release() {
+	view = {};
+	ownedVertices = {};
+	ownedIndices = {};
+	vertexSpan = {};
+	indexSpan = {};
+}
+
+engine::model engine::model::createModel(const std::string& modelPath) {
+	BRUTAL_MEMORY_SCOPE(memory::tag::ecs);
 
-engine::model engine::model::createModel(std::string modelPath) {
 	engine::model model;
+	model.modelPath = modelPath;
 
-	model.data.modelPath = modelPath;
+	auto found = std::find(renderer::models.begin(), renderer::models.end(), modelPath);
 
-	engine::model::loadModel(model);
+	if (found != renderer::models.end()) {
+		model.mesh = static_cast<uint32_t>(found - renderer::models.begin());
+		return model;
+	}
 
-	engine::model::createVertexBuffer();
-	engine::model::createIndexBuffer();
+	// frames in flight still draw from the old buffers
+	deletion::retire(renderer::appendMesh(engine::model::loadMesh(modelPath), model.mesh));
 
 	return model;
 }
 
-void engine::model::loadModel(engine::model model) {
-	tinyobj::attrib_t attrib;
-	std::vector<tinyobj::shape_t> shapes;
-	std::vector<tinyobj::material_t> materials;
-	std::string err;
+engine::mesh engine::model::loadMesh(const std::string& modelPath) {
+	std::string artifactPath = assets::artifactFor(modelPath);
 
-	if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &err, model.data.modelPath.c_str())) {
-		throw std::runtime_error("Failed to load model!");
-	}
-	else {
-		logger::log("Successfully loaded model!", 1);
+	if (!artifactPath.empty()) {
+		return engine::model::loadBakedModel(artifactPath, modelPath);
 	}
 
-	for (const auto& shape : shapes) {
-		for (const auto& index : shape.mesh.indices) {
-			engine::model::vertexStruct vertex{};
+	return engine::model::parseModel(modelPath);
+}
 
-			vertex.position = {
-				attrib.vertices[3 * index.vertex_index + 0],
-				attrib.vertices[3 * index.vertex_index + 1],
-				attrib.vertices[3 * index.vertex_index + 2]
-			};
+// the artifact's view is kept instead of copying out of it, the data is copied once more into staging memory
+engine::mesh engine::model::loadBakedModel(const std::string& artifactPath, const std::string& modelPath) {
+	BRUTAL_PROFILE_FUNCTION();
 
-			vertex.textureCoordinates = {
-				attrib.texcoords[2 * index.texcoord_index + 0],
-				1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
-			};
+	filesystem::fileView file = filesystem::open(artifactPath);
 
-			vertex.color = { 1.0f, 1.0f, 1.0f };
+	assets::meshHeader header{};
 
-			model.data.vertices.push_back(vertex);
-			model.data.indices.push_back(model.data.indices.size());
-		}
+	if (file.size() < sizeof(header)) {
+		throw std::runtime_error("Failed to load baked model: " + artifactPath);
 	}
-}
 
-void engine::model::renderModel() {
+	memcpy(&header, file.data(), sizeof(header));
 
-}
+	size_t lodsSize = static_cast<size_t>(header.lodCount) * sizeof(renderer::meshLod);
+	size_t meshletsSize = static_cast<size_t>(header.meshletCount) * sizeof(renderer::meshlet);
+	size_t verticesSize = static_cast<size_t>(header.vertexCount) * sizeof(renderer::vertex);
+	size_t indicesSize = static_cast<size_t>(header.indexCount) * sizeof(uint32_t);
 
-void engine::model::destroyModel() {
+	if (memcmp(header.magic, assets::meshMagic, sizeof(header.magic)) != 0 || header.vertexSize != sizeof(renderer::vertex) || header.lodCount == 0 || header.lodCount > renderer::maxLods || sizeof(header) + lodsSize + meshletsSize + verticesSize + indicesSize > file.size()) {
+		throw std::runtime_error("Failed to load baked model: " + artifactPath);
+	}
 
-}
+	std::vector<renderer::meshLod> lods(header.lodCount);
+	memcpy(lods.data(), file.data() + sizeof(header), lodsSize);
 
-void engine::model::createVertexBuffer() {
-	VkDeviceSize bufferSize = sizeof(engine::model::data.vertices[0]) * engine::model::data.vertices.size();
+	for (const auto& level : lods) {
+		if (static_cast<uint64_t>(level.firstIndex) + level.indexCount > header.indexCount) {
+			throw std::runtime_error("Failed to load baked model, lod out of range: " + artifactPath);
+		}
+	}
 
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
+	std::vector<renderer::meshlet> meshlets(header.meshletCount);
+	memcpy(meshlets.data(), file.data() + sizeof(header) + lodsSize, meshletsSize);
 
-	renderer::createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+	for (const auto& meshlet : meshlets) {
+		if (static_cast<uint64_t>(meshlet.firstIndex) + meshlet.triangleCount * 3ull > lods[0].indexCount) {
+			throw std::runtime_error("Failed to load baked model, meshlet out of range: " + artifactPath);
+		}
+	}
 
-	void* data;
-	vkMapMemory(renderer::device, stagingBufferMemory, 0, bufferSize, 0, &data);
-	memcpy(data, engine::model::data.vertices.data(), (size_t)bufferSize);
-	vkUnmapMemory(renderer::device, stagingBufferMemory);
+	const char* verticesData = file.data() + sizeof(header) + lodsSize + meshletsSize;
+	const char* indicesData = verticesData + verticesSize;
 
-	renderer::createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, renderer::vertexBuffer, renderer::vertexBufferMemory);
+	// mappings and pack entries are aligned, only a foreign artifact could land here
+	if (reinterpret_cast<uintptr_t>(verticesData) % alignof(renderer::vertex) != 0) {
+		std::vector<renderer::vertex> vertices(header.vertexCount);
+		std::vector<uint32_t> indices(header.indexCount);
 
-	renderer::copyBuffer(stagingBuffer, renderer::vertexBuffer, bufferSize);
+		memcpy(vertices.data(), verticesData, verticesSize);
+		memcpy(indices.data(), indicesData, indicesSize);
 
-	vkDestroyBuffer(renderer::device, stagingBuffer, nullptr);
-	vkFreeMemory(renderer::device, stagingBufferMemory, nullptr);
+		engine::mesh mesh = engine::mesh::fromVectors(modelPath, std::move(vertices), std::move(indices));
+		mesh.lods = std::move(lods);
+		mesh.meshlets = std::move(meshlets);
 
-	logger::log("Successfully created vertex buffer!", 1);
-}
+		return mesh;
+	}
 
-void engine::model::createIndexBuffer() {
-	VkDeviceSize bufferSize = sizeof(engine::model::data.indices[0]) * engine::model::data.indices.size();
+	std::span<const renderer::vertex> vertices(reinterpret_cast<const renderer::vertex*>(verticesData), header.vertexCount);
+	std::span<const uint32_t> indices(reinterpret_cast<const uint32_t*>(indicesData), header.indexCount);
 
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
+	logger::log("Successfully loaded baked model!", 1);
 
-	renderer::createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+	engine::mesh mesh = engine::mesh::fromView(modelPath, std::move(file), vertices, indices);
+	mesh.lods = std::move(lods);
+	mesh.meshlets = std::move(meshlets);
 
-	void* data;
-	vkMapMemory(renderer::device, stagingBufferMemory, 0, bufferSize, 0, &data);
-	memcpy(data, engine::model::data.indices.data(), (size_t)bufferSize);
-	vkUnmapMemory(renderer::device, stagingBufferMemory);
+	return mesh;
+}
 
-	renderer::createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, renderer::indexBuffer, renderer::indexBufferMemory);
+// chunked parallel parser, see obj::parse, materials are not part of the mesh yet so mtllib files are not read
+engine::mesh engine::model::parseModel(const std::string& modelPath) {
+	BRUTAL_PROFILE_FUNCTION();
 
-	renderer::copyBuffer(stagingBuffer, renderer::indexBuffer, bufferSize);
+	engine::mesh mesh = gltf::isGltf(modelPath) ? gltf::loadMesh(modelPath) : obj::load(modelPath);
 
-	vkDestroyBuffer(renderer::device, stagingBuffer, nullptr);
-	vkFreeMemory(renderer::device, stagingBufferMemory, nullptr);
+	logger::log("Successfully loaded model!", 1);
 
-	logger::log("Successfully created index buffer!", 1);
+	return mesh;
 }
\ No newline at end of file
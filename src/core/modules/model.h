@@ -5,31 +5,67 @@
 
 #include "../src/engine.h"
 
+#include <span>
 #include <string>
 
 namespace engine {
-	class model {
+	// move-only cpu copy of one mesh, baked meshes point straight into the artifact, parsed meshes own their vectors
+	class mesh {
 		public:
-			struct vertexStruct {
-				glm::vec3 position;
-				glm::vec3 color;
-				glm::vec2 textureCoordinates;
-			} vertex;
-
-			struct modelStruct {
-				std::string modelPath;
-				std::vector<vertexStruct> vertices;
-				std::vector<uint32_t> indices;
-			} data;
-
-			engine::model createModel(std::string modelPath);
-
-			void loadModel(engine::model model);
-			void renderModel();
-			void destroyModel();
+			std::string path;
+
+			// empty for meshes without a baked lod chain, they draw all their indices
+			std::vector<renderer::meshLod> lods;
+			// clusters of lod 0 for cluster culling, empty for meshes that were not baked
+			std::vector<renderer::meshlet> meshlets;
+
+			mesh() = default;
+			mesh(mesh&& other) noexcept;
+			mesh& operator=(mesh&& other) noexcept;
+
+			mesh(const mesh&) = delete;
+			mesh& operator=(const mesh&) = delete;
+
+			static engine::mesh fromVectors(const std::string& path, std::vector<renderer::vertex>&& vertices, std::vector<uint32_t>&& indices);
+			static engine::mesh fromView(const std::string& path, filesystem::fileView view, std::span<const renderer::vertex> vertices, std::span<const uint32_t> indices);
+
+			std::span<const renderer::vertex> vertices() const { return vertexSpan; }
+			std::span<const uint32_t> indices() const { return indexSpan; }
+
+			bool empty() const { return vertexSpan.empty() || indexSpan.empty(); }
+			uint64_t bytes() const { return vertexSpan.size_bytes() + indexSpan.size_bytes(); }
+
+			// drops the cpu data (or the artifact mapping), the handle keeps its path
+			void release();
 		private:
-			void createVertexBuffer();
-			void createIndexBuffer();
+			filesystem::fileView view;
+			std::vector<renderer::vertex> ownedVertices;
+			std::vector<uint32_t> ownedIndices;
+
+			std::span<const renderer::vertex> vertexSpan;
+			std::span<const uint32_t> indexSpan;
+	};
+
+	// a model is a handle to a mesh range in the renderer's shared buffers, it owns no geometry itself
+	class model {
+		public:
+			std::string modelPath;
+			uint32_t mesh = UINT32_MAX;
+
+			model() = default;
+			model(model&&) noexcept = default;
+			model& operator=(model&&) noexcept = default;
+
+			model(const model&) = delete;
+			model& operator=(const model&) = delete;
+
+			// reuses the scene's mesh when the model is already loaded, uploads it otherwise
+			static engine::model createModel(const std::string& modelPath);
+
+			// baked artifact when the database has one, source otherwise
+			static engine::mesh loadMesh(const std::string& modelPath);
+			static engine::mesh parseModel(const std::string& modelPath);
+			static engine::mesh loadBakedModel(const std::string& artifactPath, const std::string& modelPath);
 	};
 }
 
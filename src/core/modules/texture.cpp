@@ -13,8 +13,21 @@ engine::texture engine::texture::createTexture(std::string texturePath) {
 	return texture;
 }
 
-void engine::texture::loadTexture(engine::texture texture) {
-	texture.textureStruct.data = stbi_load(texture.textureStruct.texturePath.c_str(), &texture.textureStruct.textureDimensionsX, &texture.textureStruct.textureDimensionsY, &texture.textureStruct.textureChannels, STBI_rgb_alpha);
+void engine::texture::loadTexture(engine::texture& texture) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	std::string artifactPath = assets::artifactFor(texture.textureStruct.texturePath);
+
+	// baked textures are already rgba8, no png decoding at load time and no copy until the staging buffer
+	if (!artifactPath.empty()) {
+		texture.textureStruct.artifactPath = artifactPath;
+
+		return;
+	}
+
+	filesystem::fileView file = filesystem::open(texture.textureStruct.texturePath);
+
+	texture.textureStruct.data = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(file.data()), static_cast<int>(file.size()), &texture.textureStruct.textureDimensionsX, &texture.textureStruct.textureDimensionsY, &texture.textureStruct.textureChannels, STBI_rgb_alpha);
 
 	if (!texture.textureStruct.data) {
 		throw std::runtime_error("Failed to load texture image!");
@@ -24,6 +37,28 @@ void engine::texture::loadTexture(engine::texture texture) {
 	}
 }
 
+size_t engine::texture::readBakedHeader(engine::texture& texture, std::span<const char> artifact) {
+	assets::textureHeader header{};
+
+	if (artifact.size() >= sizeof(header)) {
+		memcpy(&header, artifact.data(), sizeof(header));
+	}
+
+	size_t pixelsSize = static_cast<size_t>(header.width) * header.height * 4;
+
+	if (memcmp(header.magic, assets::textureMagic, sizeof(header.magic)) != 0 || header.channels != 4 || sizeof(header) + pixelsSize > artifact.size()) {
+		throw std::runtime_error("Failed to load baked texture: " + texture.textureStruct.artifactPath);
+	}
+
+	texture.textureStruct.textureDimensionsX = static_cast<int>(header.width);
+	texture.textureStruct.textureDimensionsY = static_cast<int>(header.height);
+	texture.textureStruct.textureChannels = 4;
+
+	logger::log("Successfully loaded baked texture image!", 1);
+
+	return sizeof(header);
+}
+
 void engine::texture::destroyTexture(stbi_uc* data) {
 	std::cout << "in progress" << std::endl;
 
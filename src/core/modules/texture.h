@@ -4,6 +4,7 @@
 #define texture_h
 
 #include <string>
+#include <span>
 
 #include <stb/stb_image.h>
 #include <glm/glm.hpp>
@@ -18,12 +19,17 @@ namespace engine {
 				int textureDimensionsY;
 				int textureChannels;
 				std::string texturePath;
-				stbi_uc* data;
+				stbi_uc* data = nullptr;
+				// baked textures are not read here, renderer::uploadTexture decompresses the artifact straight into staging memory
+				std::string artifactPath;
 			} textureStruct;
 			
 			engine::texture createTexture(std::string texturePath);
-			void loadTexture(engine::texture texture);
+			void loadTexture(engine::texture& texture);
 			void destroyTexture(stbi_uc* data);
+
+			// validates a baked artifact and takes its dimensions, returns the offset of the pixels
+			static size_t readBakedHeader(engine::texture& texture, std::span<const char> artifact);
 		private:
 	};
 }
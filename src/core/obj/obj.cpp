@@ -0,0 +1,427 @@
+#include "./obj.h"
+
+#include <charconv>
+#include <cstring>
+
+static bool isSpace(char character) {
+	return character == ' ' || character == '\t';
+}
+
+static void skipSpaces(const char*& cursor, const char* end) {
+	while (cursor < end && isSpace(*cursor)) {
+		cursor++;
+	}
+}
+
+static bool startsWith(const char* cursor, const char* end, std::string_view keyword) {
+	return static_cast<size_t>(end - cursor) > keyword.size() && memcmp(cursor, keyword.data(), keyword.size()) == 0 && isSpace(cursor[keyword.size()]);
+}
+
+static bool parseFloat(const char*& cursor, const char* end, float& value) {
+	skipSpaces(cursor, end);
+
+	// from_chars rejects a leading plus, some exporters write one
+	if (cursor < end && *cursor == '+') {
+		cursor++;
+	}
+
+	std::from_chars_result result = std::from_chars(cursor, end, value);
+
+	if (result.ec != std::errc()) {
+		return false;
+	}
+
+	cursor = result.ptr;
+
+	return true;
+}
+
+static bool parseIndex(const char*& cursor, const char* end, int32_t& value) {
+	bool negative = false;
+
+	if (cursor < end && (*cursor == '-' || *cursor == '+')) {
+		negative = *cursor == '-';
+		cursor++;
+	}
+
+	if (cursor >= end || *cursor < '0' || *cursor > '9') {
+		return false;
+	}
+
+	int64_t result = 0;
+
+	while (cursor < end && *cursor >= '0' && *cursor <= '9' && result < obj::relativeBias) {
+		result = result * 10 + (*cursor - '0');
+		cursor++;
+	}
+
+	value = static_cast<int32_t>(negative ? -result : result);
+
+	return value != 0 && result < obj::relativeBias;
+}
+
+// positive indices are absolute, negative ones count back from the chunk's current end
+static int32_t resolveIndex(int32_t index, size_t localCount) {
+	if (index > 0) {
+		return index - 1;
+	}
+
+	return static_cast<int32_t>(localCount) + index - obj::relativeBias;
+}
+
+static std::string trimmedLine(const char* begin, const char* end) {
+	while (end > begin && (end[-1] == '\r' || isSpace(end[-1]))) {
+		end--;
+	}
+
+	return std::string(begin, end);
+}
+
+std::vector<std::string_view> obj::splitChunks(std::string_view text, size_t chunkCount) {
+	std::vector<std::string_view> chunks;
+
+	size_t begin = 0;
+
+	for (size_t i = 1; i <= chunkCount && begin < text.size(); i++) {
+		size_t end = text.size();
+
+		if (i < chunkCount) {
+			size_t target = std::max(begin, text.size() * i / chunkCount);
+			const void* newline = memchr(text.data() + target, '\n', text.size() - target);
+
+			end = newline ? static_cast<size_t>(static_cast<const char*>(newline) - text.data()) + 1 : text.size();
+		}
+
+		chunks.push_back(text.substr(begin, end - begin));
+		begin = end;
+	}
+
+	return chunks;
+}
+
+void obj::parseChunk(std::string_view text, obj::chunk& result) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	result.positions.clear();
+	result.texcoords.clear();
+	result.normalCount = 0;
+	result.corners.clear();
+	result.materialLibraries.clear();
+
+	// vertex and face lines are around thirty bytes each, reserving avoids most regrowth on large scans
+	result.corners.reserve(text.size() / 32 * 3);
+
+	const char* cursor = text.data();
+	const char* end = cursor + text.size();
+
+	while (cursor < end) {
+		const char* lineEnd = static_cast<const char*>(memchr(cursor, '\n', end - cursor));
+
+		if (!lineEnd) {
+			lineEnd = end;
+		}
+
+		const char* line = cursor;
+		bool valid = true;
+
+		skipSpaces(cursor, lineEnd);
+
+		if (startsWith(cursor, lineEnd, "v")) {
+			cursor += 1;
+
+			glm::vec3 position;
+			valid = parseFloat(cursor, lineEnd, position.x) && parseFloat(cursor, lineEnd, position.y) && parseFloat(cursor, lineEnd, position.z);
+
+			result.positions.push_back(position);
+		}
+		else if (startsWith(cursor, lineEnd, "vt")) {
+			cursor += 2;
+
+			// the v coordinate is optional for 1d textures
+			glm::vec2 texcoord(0.0f);
+			valid = parseFloat(cursor, lineEnd, texcoord.x);
+			parseFloat(cursor, lineEnd, texcoord.y);
+
+			result.texcoords.push_back(texcoord);
+		}
+		else if (startsWith(cursor, lineEnd, "vn")) {
+			result.normalCount++;
+		}
+		else if (startsWith(cursor, lineEnd, "f")) {
+			cursor += 1;
+
+			obj::corner first{};
+			obj::corner previous{};
+			uint32_t count = 0;
+
+			while (valid) {
+				skipSpaces(cursor, lineEnd);
+
+				if (cursor >= lineEnd || *cursor == '\r' || *cursor == '#') {
+					break;
+				}
+
+				int32_t index;
+
+				if (!parseIndex(cursor, lineEnd, index)) {
+					valid = false;
+					break;
+				}
+
+				obj::corner current{};
+				current.position = resolveIndex(index, result.positions.size());
+				current.texcoord = obj::missingIndex;
+
+				if (cursor < lineEnd && *cursor == '/') {
+					cursor++;
+
+					if (cursor < lineEnd && *cursor != '/') {
+						valid = parseIndex(cursor, lineEnd, index);
+						current.texcoord = resolveIndex(index, result.texcoords.size());
+					}
+
+					// normals are not part of the vertex format, only validated
+					if (valid && cursor < lineEnd && *cursor == '/') {
+						cursor++;
+						valid = parseIndex(cursor, lineEnd, index);
+					}
+				}
+
+				// polygons are fanned around their first corner
+				if (count == 0) {
+					first = current;
+				}
+				else if (count >= 2) {
+					result.corners.push_back(first);
+					result.corners.push_back(previous);
+					result.corners.push_back(current);
+				}
+
+				previous = current;
+				count++;
+			}
+
+			valid = valid && count >= 3;
+		}
+		else if (startsWith(cursor, lineEnd, "mtllib")) {
+			cursor += 6;
+
+			while (true) {
+				skipSpaces(cursor, lineEnd);
+
+				const char* nameEnd = cursor;
+
+				while (nameEnd < lineEnd && !isSpace(*nameEnd) && *nameEnd != '\r') {
+					nameEnd++;
+				}
+
+				if (nameEnd == cursor) {
+					break;
+				}
+
+				result.materialLibraries.emplace_back(cursor, nameEnd);
+				cursor = nameEnd;
+			}
+		}
+
+		if (!valid) {
+			throw std::runtime_error("Failed to parse obj line: " + trimmedLine(line, lineEnd));
+		}
+
+		cursor = lineEnd + 1;
+	}
+}
+
+std::vector<obj::material> obj::parseMaterials(std::string_view text) {
+	std::vector<obj::material> materials;
+
+	const char* cursor = text.data();
+	const char* end = cursor + text.size();
+
+	auto parseColor = [](const char*& cursor, const char* end, glm::vec3& color) {
+		return parseFloat(cursor, end, color.r) && parseFloat(cursor, end, color.g) && parseFloat(cursor, end, color.b);
+	};
+
+	while (cursor < end) {
+		const char* lineEnd = static_cast<const char*>(memchr(cursor, '\n', end - cursor));
+
+		if (!lineEnd) {
+			lineEnd = end;
+		}
+
+		skipSpaces(cursor, lineEnd);
+
+		if (startsWith(cursor, lineEnd, "newmtl")) {
+			cursor += 6;
+			skipSpaces(cursor, lineEnd);
+
+			obj::material material{};
+			material.name = trimmedLine(cursor, lineEnd);
+			material.shininess = 1.0f;
+			material.dissolve = 1.0f;
+
+			materials.push_back(material);
+		}
+		else if (!materials.empty()) {
+			obj::material& material = materials.back();
+
+			if (startsWith(cursor, lineEnd, "Ka")) {
+				cursor += 2;
+				parseColor(cursor, lineEnd, material.ambient);
+			}
+			else if (startsWith(cursor, lineEnd, "Kd")) {
+				cursor += 2;
+				parseColor(cursor, lineEnd, material.diffuse);
+			}
+			else if (startsWith(cursor, lineEnd, "Ks")) {
+				cursor += 2;
+				parseColor(cursor, lineEnd, material.specular);
+			}
+			else if (startsWith(cursor, lineEnd, "Ns")) {
+				cursor += 2;
+				parseFloat(cursor, lineEnd, material.shininess);
+			}
+			else if (startsWith(cursor, lineEnd, "d")) {
+				cursor += 1;
+				parseFloat(cursor, lineEnd, material.dissolve);
+			}
+			else if (startsWith(cursor, lineEnd, "Tr")) {
+				cursor += 2;
+
+				float transparency = 0.0f;
+
+				if (parseFloat(cursor, lineEnd, transparency)) {
+					material.dissolve = 1.0f - transparency;
+				}
+			}
+			else if (startsWith(cursor, lineEnd, "map_Kd")) {
+				// options come first, the texture name is the last token
+				std::string arguments = trimmedLine(cursor + 6, lineEnd);
+				size_t last = arguments.find_last_of(" \t");
+
+				material.diffuseTexture = last == std::string::npos ? arguments : arguments.substr(last + 1);
+			}
+		}
+
+		cursor = lineEnd + 1;
+	}
+
+	return materials;
+}
+
+engine::mesh obj::parse(const std::string& path, const filesystem::fileView& file, std::vector<obj::material>* materials) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	std::string_view text(file.data(), file.size());
+
+	size_t maximumChunks = std::max<size_t>(1, static_cast<size_t>(jobs::workerCount()) * 4);
+	size_t chunkCount = std::clamp<size_t>(text.size() / obj::minimumChunkSize, 1, maximumChunks);
+
+	std::vector<std::string_view> slices = obj::splitChunks(text, chunkCount);
+	std::vector<obj::chunk> chunks(slices.size());
+
+	jobs::parallelFor(slices.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			obj::parseChunk(slices[i], chunks[i]);
+		}
+	});
+
+	// every chunk's attributes and corners start where the previous chunk's ended
+	std::vector<size_t> positionBase(chunks.size());
+	std::vector<size_t> texcoordBase(chunks.size());
+	std::vector<size_t> cornerBase(chunks.size());
+
+	size_t positionCount = 0;
+	size_t texcoordCount = 0;
+	size_t cornerCount = 0;
+
+	for (size_t i = 0; i < chunks.size(); i++) {
+		positionBase[i] = positionCount;
+		texcoordBase[i] = texcoordCount;
+		cornerBase[i] = cornerCount;
+
+		positionCount += chunks[i].positions.size();
+		texcoordCount += chunks[i].texcoords.size();
+		cornerCount += chunks[i].corners.size();
+	}
+
+	if (cornerCount > UINT32_MAX) {
+		throw std::runtime_error("Failed to load model, too many vertices: " + path);
+	}
+
+	std::vector<glm::vec3> positions(positionCount);
+	std::vector<glm::vec2> texcoords(texcoordCount);
+
+	jobs::parallelFor(chunks.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			std::copy(chunks[i].positions.begin(), chunks[i].positions.end(), positions.begin() + positionBase[i]);
+			std::copy(chunks[i].texcoords.begin(), chunks[i].texcoords.end(), texcoords.begin() + texcoordBase[i]);
+
+			chunks[i].positions = {};
+			chunks[i].texcoords = {};
+		}
+	});
+
+	std::vector<renderer::vertex> vertices(cornerCount);
+	std::vector<uint32_t> indices(cornerCount);
+
+	jobs::parallelFor(chunks.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			auto resolve = [](int32_t index, size_t base, size_t count) {
+				int64_t resolved = index >= 0 ? index : static_cast<int64_t>(base) + index + obj::relativeBias;
+
+				if (resolved < 0 || resolved >= static_cast<int64_t>(count)) {
+					throw std::runtime_error("Failed to load model, index out of range!");
+				}
+
+				return static_cast<size_t>(resolved);
+			};
+
+			size_t output = cornerBase[i];
+
+			for (const auto& corner : chunks[i].corners) {
+				renderer::vertex& vertex = vertices[output];
+
+				vertex.pos = positions[resolve(corner.position, positionBase[i], positionCount)];
+
+				glm::vec2 texcoord = corner.texcoord == obj::missingIndex ? glm::vec2(0.0f) : texcoords[resolve(corner.texcoord, texcoordBase[i], texcoordCount)];
+				vertex.texCoord = { texcoord.x, 1.0f - texcoord.y };
+
+				vertex.color = { 1.0f, 1.0f, 1.0f };
+
+				indices[output] = static_cast<uint32_t>(output);
+				output++;
+			}
+
+			chunks[i].corners = {};
+		}
+	});
+
+	if (materials) {
+		std::string baseDirectory = path.substr(0, path.find_last_of("/\\") + 1);
+
+		for (const auto& chunk : chunks) {
+			for (const auto& library : chunk.materialLibraries) {
+				std::string libraryPath = filesystem::normalizePath(baseDirectory + library);
+
+				if (!filesystem::exists(libraryPath)) {
+					logger::log("Material file not found: " + libraryPath, 2);
+					continue;
+				}
+
+				filesystem::fileView libraryFile = filesystem::open(libraryPath);
+				std::vector<obj::material> parsed = obj::parseMaterials(std::string_view(libraryFile.data(), libraryFile.size()));
+
+				materials->insert(materials->end(), parsed.begin(), parsed.end());
+			}
+		}
+	}
+
+	return engine::mesh::fromVectors(path, std::move(vertices), std::move(indices));
+}
+
+engine::mesh obj::load(const std::string& path, std::vector<obj::material>* materials) {
+	filesystem::fileView file = filesystem::open(path);
+
+	return obj::parse(path, file, materials);
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+#ifndef obj_h
+#define obj_h
+
+#include "../src/engine.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace obj {
+	// smaller files are parsed on the calling thread, splitting them costs more than it saves
+	const size_t minimumChunkSize = 1024 * 1024;
+
+	// negative obj indices are stored relative to the chunk until the chunk's base is known
+	const int32_t relativeBias = 1 << 30;
+	const int32_t missingIndex = INT32_MAX;
+
+	struct material {
+		std::string name;
+		glm::vec3 ambient;
+		glm::vec3 diffuse;
+		glm::vec3 specular;
+		float shininess;
+		float dissolve;
+		std::string diffuseTexture;
+	};
+
+	struct corner {
+		int32_t position;
+		int32_t texcoord;
+	};
+
+	// everything one line-aligned slice of the file produced, in file order
+	struct chunk {
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec2> texcoords;
+		uint32_t normalCount;
+
+		// already triangulated, three corners per triangle
+		std::vector<corner> corners;
+		std::vector<std::string> materialLibraries;
+	};
+
+	// mtllib files are read through the mounted filesystem relative to the obj, missing ones are skipped
+	engine::mesh parse(const std::string& path, const filesystem::fileView& file, std::vector<material>* materials = nullptr);
+	engine::mesh load(const std::string& path, std::vector<material>* materials = nullptr);
+
+	std::vector<material> parseMaterials(std::string_view text);
+
+	// splits at line boundaries, every chunk but the last ends after a newline
+	std::vector<std::string_view> splitChunks(std::string_view text, size_t chunkCount);
+	void parseChunk(std::string_view text, chunk& result);
+}
+
+#endif
\ No newline at end of file
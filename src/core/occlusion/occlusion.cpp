@@ -0,0 +1,663 @@
+#include "./occlusion.h"
+
+#include <cmath>
+
+bool occlusion::enabled = true;
+
+VkDescriptorSetLayout occlusion::descriptorSetLayout = VK_NULL_HANDLE;
+VkPipelineLayout occlusion::pipelineLayout = VK_NULL_HANDLE;
+VkPipeline occlusion::pipeline = VK_NULL_HANDLE;
+VkDescriptorPool occlusion::descriptorPool = VK_NULL_HANDLE;
+std::vector<VkDescriptorSet> occlusion::descriptorSets;
+std::array<bool, renderer::maxFramesInFlight> occlusion::descriptorsOutdated{};
+
+std::array<occlusion::frameBuffers, renderer::maxFramesInFlight> occlusion::frames{};
+
+VkDescriptorSetLayout occlusion::pyramidSetLayout = VK_NULL_HANDLE;
+VkPipelineLayout occlusion::pyramidPipelineLayout = VK_NULL_HANDLE;
+VkPipeline occlusion::pyramidPipeline = VK_NULL_HANDLE;
+VkSampler occlusion::pyramidSampler = VK_NULL_HANDLE;
+
+VkImage occlusion::pyramidImage = VK_NULL_HANDLE;
+VkDeviceMemory occlusion::pyramidImageMemory = VK_NULL_HANDLE;
+VkImageView occlusion::pyramidImageView = VK_NULL_HANDLE;
+std::vector<VkImageView> occlusion::pyramidLevelViews;
+VkExtent2D occlusion::pyramidExtent{};
+uint32_t occlusion::pyramidLevels = 0;
+VkDescriptorPool occlusion::pyramidDescriptorPool = VK_NULL_HANDLE;
+std::vector<VkDescriptorSet> occlusion::pyramidDescriptorSets;
+VkImageView occlusion::pyramidDepthView = VK_NULL_HANDLE;
+
+VkDeviceSize occlusion::uniformOffset = 0;
+
+bool occlusion::pyramidValid = false;
+glm::mat4 occlusion::previousViewProjection = glm::mat4(1.0f);
+
+uint32_t occlusion::drawnObjects = 0;
+uint32_t occlusion::occludedObjects = 0;
+
+static uint32_t previousPowerOfTwo(uint32_t value) {
+	uint32_t result = 1;
+
+	while (result * 2 <= value) {
+		result *= 2;
+	}
+
+	return result;
+}
+
+static void destroyMappedBuffer(VkBuffer buffer, VkDeviceMemory bufferMemory) {
+	if (buffer == VK_NULL_HANDLE) {
+		return;
+	}
+
+	vkUnmapMemory(renderer::device, bufferMemory);
+	vkDestroyBuffer(renderer::device, buffer, nullptr);
+	memory::freeDevice(bufferMemory);
+}
+
+static VkDescriptorSetLayout createSetLayout(std::span<const VkDescriptorSetLayoutBinding> bindings) {
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutInfo.pBindings = bindings.data();
+
+	VkDescriptorSetLayout layout;
+
+	if (vkCreateDescriptorSetLayout(renderer::device, &layoutInfo, nullptr, &layout) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create gpu culling descriptor set layout!");
+	}
+
+	return layout;
+}
+
+static VkPipelineLayout createPipelineLayout(VkDescriptorSetLayout setLayout, uint32_t pushConstantSize) {
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = pushConstantSize;
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &setLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = pushConstantSize > 0 ? 1 : 0;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	VkPipelineLayout layout;
+
+	if (vkCreatePipelineLayout(renderer::device, &pipelineLayoutInfo, nullptr, &layout) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create gpu culling pipeline layout!");
+	}
+
+	return layout;
+}
+
+// gpu driven culling needs indirect draws with a gpu written count, the vertex shader finds the object through firstInstance
+void occlusion::init() {
+	BRUTAL_PROFILE_FUNCTION();
+
+	if (!occlusion::enabled) {
+		return;
+	}
+
+	if (!renderer::indirectCountSupported) {
+		logger::log("GPU culling disabled, the device lacks drawIndirectCount, multiDrawIndirect or drawIndirectFirstInstance", 2);
+		return;
+	}
+
+	if (!filesystem::exists(occlusion::cullShaderPath) || !filesystem::exists(occlusion::pyramidShaderPath)) {
+		logger::log("GPU culling disabled, " + occlusion::cullShaderPath + " or " + occlusion::pyramidShaderPath + " is missing (see shaders/compile.bat)", 2);
+		return;
+	}
+
+	std::array<VkDescriptorSetLayoutBinding, 6> bindings{};
+
+	for (uint32_t i = 0; i < bindings.size(); i++) {
+		bindings[i].binding = i;
+		bindings[i].descriptorCount = 1;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+
+	// the frame uniforms live in the gpu frame arena
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	bindings[5].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
+	occlusion::descriptorSetLayout = createSetLayout(bindings);
+	occlusion::pipelineLayout = createPipelineLayout(occlusion::descriptorSetLayout, 0);
+
+	std::array<VkDescriptorSetLayoutBinding, 2> pyramidBindings{};
+
+	for (uint32_t i = 0; i < pyramidBindings.size(); i++) {
+		pyramidBindings[i].binding = i;
+		pyramidBindings[i].descriptorCount = 1;
+		pyramidBindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+
+	pyramidBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	pyramidBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+
+	occlusion::pyramidSetLayout = createSetLayout(pyramidBindings);
+	occlusion::pyramidPipelineLayout = createPipelineLayout(occlusion::pyramidSetLayout, sizeof(occlusion::pyramidConstants));
+
+	filesystem::fileView cullShaderCode = filesystem::open(occlusion::cullShaderPath);
+	filesystem::fileView pyramidShaderCode = filesystem::open(occlusion::pyramidShaderPath);
+
+	occlusion::pipeline = renderer::createComputePipeline(cullShaderCode.bytes, occlusion::pipelineLayout);
+	occlusion::pyramidPipeline = renderer::createComputePipeline(pyramidShaderCode.bytes, occlusion::pyramidPipelineLayout);
+
+	// the shaders only texelFetch, filtering never comes into it
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+	if (vkCreateSampler(renderer::device, &samplerInfo, nullptr, &occlusion::pyramidSampler) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create depth pyramid sampler!");
+	}
+
+	std::array<VkDescriptorPoolSize, 3> poolSizes{};
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	poolSizes[0].descriptorCount = static_cast<uint32_t>(renderer::maxFramesInFlight);
+
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSizes[1].descriptorCount = static_cast<uint32_t>(renderer::maxFramesInFlight) * 4;
+
+	poolSizes[2].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[2].descriptorCount = static_cast<uint32_t>(renderer::maxFramesInFlight);
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+	poolInfo.maxSets = static_cast<uint32_t>(renderer::maxFramesInFlight);
+
+	if (vkCreateDescriptorPool(renderer::device, &poolInfo, nullptr, &occlusion::descriptorPool) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create gpu culling descriptor pool!");
+	}
+
+	std::vector<VkDescriptorSetLayout> layouts(renderer::maxFramesInFlight, occlusion::descriptorSetLayout);
+
+	VkDescriptorSetAllocateInfo allocateInfo{};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocateInfo.descriptorPool = occlusion::descriptorPool;
+	allocateInfo.descriptorSetCount = static_cast<uint32_t>(renderer::maxFramesInFlight);
+	allocateInfo.pSetLayouts = layouts.data();
+
+	occlusion::descriptorSets.resize(renderer::maxFramesInFlight);
+
+	if (vkAllocateDescriptorSets(renderer::device, &allocateInfo, occlusion::descriptorSets.data()) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to allocate gpu culling descriptor sets!");
+	}
+
+	occlusion::createPyramid();
+
+	logger::log("Successfully initialized gpu culling: " + std::to_string(occlusion::pyramidExtent.width) + "x" + std::to_string(occlusion::pyramidExtent.height) + " depth pyramid, " + std::to_string(occlusion::pyramidLevels) + " levels", 1);
+}
+
+void occlusion::cleanup() {
+	if (occlusion::pipeline == VK_NULL_HANDLE) {
+		return;
+	}
+
+	occlusion::destroyPyramid();
+
+	for (auto& buffers : occlusion::frames) {
+		destroyMappedBuffer(buffers.instances, buffers.instancesMemory);
+		destroyMappedBuffer(buffers.meshes, buffers.meshesMemory);
+		destroyMappedBuffer(buffers.commands, buffers.commandsMemory);
+		destroyMappedBuffer(buffers.counts, buffers.countsMemory);
+
+		buffers = occlusion::frameBuffers{};
+	}
+
+	vkDestroySampler(renderer::device, occlusion::pyramidSampler, nullptr);
+
+	vkDestroyPipeline(renderer::device, occlusion::pipeline, nullptr);
+	vkDestroyPipelineLayout(renderer::device, occlusion::pipelineLayout, nullptr);
+	vkDestroyDescriptorPool(renderer::device, occlusion::descriptorPool, nullptr);
+	vkDestroyDescriptorSetLayout(renderer::device, occlusion::descriptorSetLayout, nullptr);
+
+	vkDestroyPipeline(renderer::device, occlusion::pyramidPipeline, nullptr);
+	vkDestroyPipelineLayout(renderer::device, occlusion::pyramidPipelineLayout, nullptr);
+	vkDestroyDescriptorSetLayout(renderer::device, occlusion::pyramidSetLayout, nullptr);
+
+	occlusion::pipeline = VK_NULL_HANDLE;
+	occlusion::pyramidPipeline = VK_NULL_HANDLE;
+	occlusion::descriptorSets.clear();
+}
+
+bool occlusion::active() {
+	return occlusion::pipeline != VK_NULL_HANDLE && occlusion::pyramidPipeline != VK_NULL_HANDLE;
+}
+
+void occlusion::createPyramid() {
+	BRUTAL_PROFILE_FUNCTION();
+
+	occlusion::pyramidExtent.width = previousPowerOfTwo(renderer::swapChainExtent.width);
+	occlusion::pyramidExtent.height = previousPowerOfTwo(renderer::swapChainExtent.height);
+	occlusion::pyramidLevels = static_cast<uint32_t>(std::log2(std::max(occlusion::pyramidExtent.width, occlusion::pyramidExtent.height))) + 1;
+
+	renderer::createImage(occlusion::pyramidExtent.width, occlusion::pyramidExtent.height, VK_FORMAT_R32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, occlusion::pyramidImage, occlusion::pyramidImageMemory, occlusion::pyramidLevels);
+
+	occlusion::pyramidImageView = renderer::createImageView(occlusion::pyramidImage, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, 0, occlusion::pyramidLevels);
+	occlusion::pyramidLevelViews.resize(occlusion::pyramidLevels);
+
+	for (uint32_t level = 0; level < occlusion::pyramidLevels; level++) {
+		occlusion::pyramidLevelViews[level] = renderer::createImageView(occlusion::pyramidImage, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, level, 1);
+	}
+
+	std::array<VkDescriptorPoolSize, 2> poolSizes{};
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[0].descriptorCount = occlusion::pyramidLevels;
+
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	poolSizes[1].descriptorCount = occlusion::pyramidLevels;
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+	poolInfo.maxSets = occlusion::pyramidLevels;
+
+	if (vkCreateDescriptorPool(renderer::device, &poolInfo, nullptr, &occlusion::pyramidDescriptorPool) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create depth pyramid descriptor pool!");
+	}
+
+	std::vector<VkDescriptorSetLayout> layouts(occlusion::pyramidLevels, occlusion::pyramidSetLayout);
+
+	VkDescriptorSetAllocateInfo allocateInfo{};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocateInfo.descriptorPool = occlusion::pyramidDescriptorPool;
+	allocateInfo.descriptorSetCount = occlusion::pyramidLevels;
+	allocateInfo.pSetLayouts = layouts.data();
+
+	occlusion::pyramidDescriptorSets.resize(occlusion::pyramidLevels);
+
+	if (vkAllocateDescriptorSets(renderer::device, &allocateInfo, occlusion::pyramidDescriptorSets.data()) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to allocate depth pyramid descriptor sets!");
+	}
+
+	// level 0 reads the depth buffer, which the render graph creates later, see occlusion::bindDepth
+	for (uint32_t level = 0; level < occlusion::pyramidLevels; level++) {
+		VkDescriptorImageInfo sourceInfo{};
+		sourceInfo.sampler = occlusion::pyramidSampler;
+		sourceInfo.imageView = level > 0 ? occlusion::pyramidLevelViews[level - 1] : VK_NULL_HANDLE;
+		sourceInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkDescriptorImageInfo destinationInfo{};
+		destinationInfo.imageView = occlusion::pyramidLevelViews[level];
+		destinationInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
+
+		descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[0].dstSet = occlusion::pyramidDescriptorSets[level];
+		descriptorWrites[0].dstBinding = 1;
+		descriptorWrites[0].dstArrayElement = 0;
+		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		descriptorWrites[0].descriptorCount = 1;
+		descriptorWrites[0].pImageInfo = &destinationInfo;
+
+		descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[1].dstSet = occlusion::pyramidDescriptorSets[level];
+		descriptorWrites[1].dstBinding = 0;
+		descriptorWrites[1].dstArrayElement = 0;
+		descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		descriptorWrites[1].descriptorCount = 1;
+		descriptorWrites[1].pImageInfo = &sourceInfo;
+
+		vkUpdateDescriptorSets(renderer::device, level > 0 ? 2 : 1, descriptorWrites.data(), 0, nullptr);
+	}
+
+	occlusion::pyramidDepthView = VK_NULL_HANDLE;
+
+	// the culling sets sample the whole pyramid
+	occlusion::descriptorsOutdated.fill(true);
+	occlusion::pyramidValid = false;
+}
+
+// the handles were destroyed or retired, the next createPyramid starts over
+static void detachPyramid() {
+	occlusion::pyramidImage = VK_NULL_HANDLE;
+	occlusion::pyramidLevelViews.clear();
+	occlusion::pyramidDescriptorSets.clear();
+	occlusion::pyramidValid = false;
+}
+
+void occlusion::destroyPyramid() {
+	if (occlusion::pyramidImage == VK_NULL_HANDLE) {
+		return;
+	}
+
+	vkDestroyDescriptorPool(renderer::device, occlusion::pyramidDescriptorPool, nullptr);
+
+	for (VkImageView view : occlusion::pyramidLevelViews) {
+		vkDestroyImageView(renderer::device, view, nullptr);
+	}
+
+	vkDestroyImageView(renderer::device, occlusion::pyramidImageView, nullptr);
+	vkDestroyImage(renderer::device, occlusion::pyramidImage, nullptr);
+	memory::freeDevice(occlusion::pyramidImageMemory);
+
+	detachPyramid();
+}
+
+void occlusion::bindDepth(VkImageView depthView) {
+	// frames in flight may use the sets, they are only written while new or when the depth buffer changed with them
+	if (occlusion::pyramidDescriptorSets.empty() || depthView == occlusion::pyramidDepthView) {
+		return;
+	}
+
+	VkDescriptorImageInfo sourceInfo{};
+	sourceInfo.sampler = occlusion::pyramidSampler;
+	sourceInfo.imageView = depthView;
+	sourceInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+	VkWriteDescriptorSet descriptorWrite{};
+	descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite.dstSet = occlusion::pyramidDescriptorSets[0];
+	descriptorWrite.dstBinding = 0;
+	descriptorWrite.dstArrayElement = 0;
+	descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorWrite.descriptorCount = 1;
+	descriptorWrite.pImageInfo = &sourceInfo;
+
+	vkUpdateDescriptorSets(renderer::device, 1, &descriptorWrite, 0, nullptr);
+
+	occlusion::pyramidDepthView = depthView;
+}
+
+void occlusion::resize() {
+	if (!occlusion::active()) {
+		return;
+	}
+
+	// the frames in flight test against the old pyramid, it goes once they are done
+	if (occlusion::pyramidImage != VK_NULL_HANDLE) {
+		deletion::retireDescriptorPool(occlusion::pyramidDescriptorPool);
+
+		for (VkImageView view : occlusion::pyramidLevelViews) {
+			deletion::retireImageView(view);
+		}
+
+		deletion::retireImageView(occlusion::pyramidImageView);
+		deletion::retireImage(occlusion::pyramidImage, occlusion::pyramidImageMemory);
+
+		detachPyramid();
+	}
+
+	occlusion::createPyramid();
+}
+
+// the slot's last submission has finished, its counts and commands can be read
+void occlusion::collect(uint32_t frame) {
+	const occlusion::frameBuffers& buffers = occlusion::frames[frame];
+
+	if (!occlusion::active() || buffers.mappedCounts == nullptr) {
+		return;
+	}
+
+	occlusion::drawnObjects = buffers.mappedCounts[0];
+	occlusion::occludedObjects = buffers.mappedCounts[1];
+
+	renderer::drawnTriangles = 0;
+
+	for (uint32_t i = 0; i < std::min(occlusion::drawnObjects, buffers.objectCount); i++) {
+		renderer::drawnTriangles += buffers.mappedCommands[i].indexCount / 3;
+	}
+}
+
+template<typename type>
+static void createMappedBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& bufferMemory, type*& mapped) {
+	destroyMappedBuffer(buffer, bufferMemory);
+
+	renderer::createBuffer(size, usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, buffer, bufferMemory);
+
+	void* data;
+	vkMapMemory(renderer::device, bufferMemory, 0, size, 0, &data);
+
+	mapped = static_cast<type*>(data);
+}
+
+// grows the slot's buffers when the scene outgrew them, the graphics set of the slot points at the new instances
+static void reserveFrameBuffers(uint32_t frame) {
+	occlusion::frameBuffers& buffers = occlusion::frames[frame];
+
+	uint32_t objectCount = static_cast<uint32_t>(renderer::objects.size());
+	uint32_t meshCount = static_cast<uint32_t>(renderer::meshes.size());
+
+	if (buffers.meshCapacity < meshCount) {
+		buffers.meshCapacity = std::max(meshCount, buffers.meshCapacity * 2);
+
+		createMappedBuffer(sizeof(occlusion::meshInfo) * static_cast<VkDeviceSize>(buffers.meshCapacity), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, buffers.meshes, buffers.meshesMemory, buffers.mappedMeshes);
+
+		occlusion::descriptorsOutdated[frame] = true;
+	}
+
+	if (buffers.objectCapacity >= objectCount) {
+		return;
+	}
+
+	buffers.objectCapacity = std::max(objectCount, buffers.objectCapacity * 2);
+
+	createMappedBuffer(sizeof(occlusion::instance) * static_cast<VkDeviceSize>(buffers.objectCapacity), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, buffers.instances, buffers.instancesMemory, buffers.mappedInstances);
+	createMappedBuffer(sizeof(VkDrawIndexedIndirectCommand) * static_cast<VkDeviceSize>(buffers.objectCapacity), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, buffers.commands, buffers.commandsMemory, buffers.mappedCommands);
+
+	if (buffers.counts == VK_NULL_HANDLE) {
+		createMappedBuffer(sizeof(uint32_t) * 2, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, buffers.counts, buffers.countsMemory, buffers.mappedCounts);
+	}
+
+	occlusion::descriptorsOutdated[frame] = true;
+
+	VkDescriptorBufferInfo bufferInfo{ buffers.instances, 0, VK_WHOLE_SIZE };
+
+	VkWriteDescriptorSet descriptorWrite{};
+	descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite.dstSet = renderer::descriptorSets[frame];
+	descriptorWrite.dstBinding = 2;
+	descriptorWrite.dstArrayElement = 0;
+	descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	descriptorWrite.descriptorCount = 1;
+	descriptorWrite.pBufferInfo = &bufferInfo;
+
+	vkUpdateDescriptorSets(renderer::device, 1, &descriptorWrite, 0, nullptr);
+}
+
+// objects do not move once placed, the slot only rewrites them when the scene or a mesh changed
+static void writeScene(uint32_t frame) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	reserveFrameBuffers(frame);
+
+	occlusion::frameBuffers& buffers = occlusion::frames[frame];
+
+	for (size_t i = 0; i < renderer::meshes.size(); i++) {
+		const renderer::meshRange& mesh = renderer::meshes[i];
+
+		occlusion::meshInfo info{};
+		info.firstIndex = mesh.firstIndex;
+		info.vertexOffset = mesh.vertexOffset;
+		info.lodCount = mesh.lodCount;
+
+		for (uint32_t lod = 0; lod < mesh.lodCount; lod++) {
+			info.lodErrors[lod] = mesh.lods[lod].error;
+			info.lodFirstIndex[lod] = mesh.lods[lod].firstIndex;
+			info.lodIndexCount[lod] = mesh.lods[lod].indexCount;
+		}
+
+		buffers.mappedMeshes[i] = info;
+	}
+
+	for (size_t i = 0; i < renderer::objects.size(); i++) {
+		const renderer::sceneObject& object = renderer::objects[i];
+		const renderer::meshRange& mesh = renderer::meshes[object.mesh];
+
+		float scale = std::max(glm::length(glm::vec3(object.transform[0])), std::max(glm::length(glm::vec3(object.transform[1])), glm::length(glm::vec3(object.transform[2]))));
+
+		occlusion::instance instance{};
+		instance.transform = renderer::drawTransform(object, mesh);
+		instance.sphere = glm::vec4(glm::vec3(object.transform * glm::vec4(mesh.boundsCenter, 1.0f)), mesh.boundsRadius * scale);
+		instance.mesh = object.mesh;
+		instance.lod = std::min(object.lod, mesh.lodCount - 1);
+		instance.scale = scale;
+
+		buffers.mappedInstances[i] = instance;
+	}
+
+	buffers.sceneVersion = renderer::sceneVersion;
+}
+
+static void writeDescriptorSet(uint32_t frame) {
+	const occlusion::frameBuffers& buffers = occlusion::frames[frame];
+
+	std::array<VkDescriptorBufferInfo, 5> bufferInfos{};
+
+	// the dynamic range is fixed, each frame allocates the uniforms in full
+	bufferInfos[0] = { arena::gpuBuffer, 0, sizeof(occlusion::frameUniforms) };
+	bufferInfos[1] = { buffers.instances, 0, VK_WHOLE_SIZE };
+	bufferInfos[2] = { buffers.meshes, 0, VK_WHOLE_SIZE };
+	bufferInfos[3] = { buffers.commands, 0, VK_WHOLE_SIZE };
+	bufferInfos[4] = { buffers.counts, 0, VK_WHOLE_SIZE };
+
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.sampler = occlusion::pyramidSampler;
+	imageInfo.imageView = occlusion::pyramidImageView;
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	std::array<VkWriteDescriptorSet, 6> descriptorWrites{};
+
+	for (uint32_t i = 0; i < descriptorWrites.size(); i++) {
+		descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[i].dstSet = occlusion::descriptorSets[frame];
+		descriptorWrites[i].dstBinding = i;
+		descriptorWrites[i].dstArrayElement = 0;
+		descriptorWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		descriptorWrites[i].descriptorCount = 1;
+
+		if (i < bufferInfos.size()) {
+			descriptorWrites[i].pBufferInfo = &bufferInfos[i];
+		}
+	}
+
+	descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	descriptorWrites[5].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorWrites[5].pImageInfo = &imageInfo;
+
+	vkUpdateDescriptorSets(renderer::device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+
+	occlusion::descriptorsOutdated[frame] = false;
+}
+
+void occlusion::prepare() {
+	BRUTAL_PROFILE_FUNCTION();
+
+	uint32_t frame = renderer::currentFrame;
+	occlusion::frameBuffers& buffers = occlusion::frames[frame];
+
+	buffers.objectCount = 0;
+
+	if (!occlusion::active() || renderer::objects.empty()) {
+		return;
+	}
+
+	if (buffers.sceneVersion != renderer::sceneVersion || buffers.instances == VK_NULL_HANDLE) {
+		writeScene(frame);
+	}
+
+	if (occlusion::descriptorsOutdated[frame]) {
+		writeDescriptorSet(frame);
+	}
+
+	buffers.objectCount = static_cast<uint32_t>(renderer::objects.size());
+
+	occlusion::frameUniforms uniforms{};
+	renderer::frustumPlanes(renderer::viewProjection, uniforms.planes);
+	uniforms.previousViewProjection = occlusion::previousViewProjection;
+	uniforms.eye = glm::vec4(camera::camera.eye, 1.0f);
+	uniforms.viewportScale = glm::vec2(static_cast<float>(renderer::swapChainExtent.width / 2) / renderer::swapChainExtent.width, static_cast<float>(renderer::swapChainExtent.height / 2) / renderer::swapChainExtent.height);
+	uniforms.pyramidSize = glm::vec2(occlusion::pyramidExtent.width, occlusion::pyramidExtent.height);
+	uniforms.objectCount = buffers.objectCount;
+	uniforms.pyramidLevels = occlusion::pyramidLevels;
+	uniforms.pyramidValid = occlusion::pyramidValid ? 1 : 0;
+	uniforms.pixelsPerUnit = static_cast<float>(renderer::swapChainExtent.height) / (2.0f * std::tan(camera::getFOV() * 0.5f));
+	uniforms.lodErrorPixels = renderer::lodErrorPixels;
+	uniforms.lodHysteresis = renderer::lodHysteresis;
+
+	arena::gpuAllocation uniformAllocation = arena::allocateGpu(sizeof(uniforms));
+	memcpy(uniformAllocation.mapped, &uniforms, sizeof(uniforms));
+
+	occlusion::uniformOffset = uniformAllocation.offset;
+}
+
+void occlusion::recordClear(VkCommandBuffer commandBuffer) {
+	vkCmdFillBuffer(commandBuffer, occlusion::frames[renderer::currentFrame].counts, 0, sizeof(uint32_t) * 2, 0);
+}
+
+// one invocation per object, the survivors append an indirect command and bump the draw count
+void occlusion::recordCulling(VkCommandBuffer commandBuffer) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	uint32_t frame = renderer::currentFrame;
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, occlusion::pipeline);
+
+	uint32_t dynamicOffset = static_cast<uint32_t>(occlusion::uniformOffset);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, occlusion::pipelineLayout, 0, 1, &occlusion::descriptorSets[frame], 1, &dynamicOffset);
+
+	vkCmdDispatch(commandBuffer, (occlusion::frames[frame].objectCount + occlusion::workgroupSize - 1) / occlusion::workgroupSize, 1, 1);
+}
+
+// the shared index buffer is still bound, the vertex shader takes the transform from the instance firstInstance names
+void occlusion::recordDraws(VkCommandBuffer commandBuffer) {
+	const occlusion::frameBuffers& buffers = occlusion::frames[renderer::currentFrame];
+
+	if (buffers.objectCount == 0) {
+		return;
+	}
+
+	uint32_t instanced = 1;
+	vkCmdPushConstants(commandBuffer, renderer::pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, offsetof(renderer::objectConstants, instanced), sizeof(instanced), &instanced);
+
+	vkCmdDrawIndexedIndirectCount(commandBuffer, buffers.commands, 0, buffers.counts, 0, buffers.objectCount, sizeof(VkDrawIndexedIndirectCommand));
+}
+
+// a max reduction of the depth buffer, each level is a dispatch reading the one below
+void occlusion::recordPyramid(VkCommandBuffer commandBuffer) {
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, occlusion::pyramidPipeline);
+
+	VkExtent2D source = renderer::swapChainExtent;
+
+	// the levels depend on each other inside the pass, the render graph only orders whole passes
+	VkMemoryBarrier levelBarrier{};
+	levelBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	levelBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	levelBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	for (uint32_t level = 0; level < occlusion::pyramidLevels; level++) {
+		VkExtent2D destination = { std::max(occlusion::pyramidExtent.width >> level, 1u), std::max(occlusion::pyramidExtent.height >> level, 1u) };
+
+		occlusion::pyramidConstants constants{};
+		constants.sourceSize = glm::ivec2(source.width, source.height);
+		constants.destinationSize = glm::ivec2(destination.width, destination.height);
+
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, occlusion::pyramidPipelineLayout, 0, 1, &occlusion::pyramidDescriptorSets[level], 0, nullptr);
+		vkCmdPushConstants(commandBuffer, occlusion::pyramidPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+		vkCmdDispatch(commandBuffer, (destination.width + occlusion::pyramidWorkgroupSize - 1) / occlusion::pyramidWorkgroupSize, (destination.height + occlusion::pyramidWorkgroupSize - 1) / occlusion::pyramidWorkgroupSize, 1);
+
+		if (level + 1 < occlusion::pyramidLevels) {
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &levelBarrier, 0, nullptr, 0, nullptr);
+		}
+
+		source = destination;
+	}
+
+	occlusion::previousViewProjection = renderer::viewProjection;
+	occlusion::pyramidValid = true;
+}
\ No newline at end of file
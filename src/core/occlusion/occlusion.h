@@ -0,0 +1,159 @@
+#pragma once
+#ifndef occlusion_h
+#define occlusion_h
+
+#include "../src/engine.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace occlusion {
+	// local_size_x of shaders/cull.comp, one invocation per object
+	const uint32_t workgroupSize = 64;
+	// local_size_x and y of shaders/hiz.comp
+	const uint32_t pyramidWorkgroupSize = 8;
+
+	const std::string cullShaderPath = "shaders/cull.spv";
+	const std::string pyramidShaderPath = "shaders/hiz.spv";
+
+	// std430 struct of shaders/cull.comp, the vertex shader reads transform for the indirect draws
+	struct instance {
+		// renderer::drawTransform of the object
+		glm::mat4 transform;
+		// world space center and radius
+		glm::vec4 sphere;
+		uint32_t mesh;
+		// written back by the shader, the hysteresis works on the level this slot drew last
+		uint32_t lod;
+		float scale;
+		uint32_t padding;
+	};
+
+	// std430 struct of shaders/cull.comp, a renderer::meshRange without the cpu side bounds
+	struct meshInfo {
+		uint32_t firstIndex;
+		int32_t vertexOffset;
+		uint32_t lodCount;
+		uint32_t padding;
+		glm::vec4 lodErrors;
+		glm::uvec4 lodFirstIndex;
+		glm::uvec4 lodIndexCount;
+	};
+
+	// std140 block of shaders/cull.comp
+	struct frameUniforms {
+		std::array<glm::vec4, 6> planes;
+		glm::mat4 previousViewProjection;
+		glm::vec4 eye;
+		// the part of the depth buffer the viewport covers, uv of the pyramid
+		glm::vec2 viewportScale;
+		glm::vec2 pyramidSize;
+		uint32_t objectCount;
+		uint32_t pyramidLevels;
+		uint32_t pyramidValid;
+		float pixelsPerUnit;
+		float lodErrorPixels;
+		float lodHysteresis;
+	};
+
+	struct pyramidConstants {
+		glm::ivec2 sourceSize;
+		glm::ivec2 destinationSize;
+	};
+
+	// host visible and mapped for good, a slot's buffers are only touched once its fence was waited on
+	struct frameBuffers {
+		VkBuffer instances;
+		VkDeviceMemory instancesMemory;
+		instance* mappedInstances;
+
+		VkBuffer meshes;
+		VkDeviceMemory meshesMemory;
+		meshInfo* mappedMeshes;
+
+		VkBuffer commands;
+		VkDeviceMemory commandsMemory;
+		VkDrawIndexedIndirectCommand* mappedCommands;
+
+		// drawn and occluded objects, the first is the draw count
+		VkBuffer counts;
+		VkDeviceMemory countsMemory;
+		uint32_t* mappedCounts;
+
+		uint32_t objectCapacity;
+		uint32_t meshCapacity;
+
+		// renderer::sceneVersion the instances and meshes were written at
+		uint64_t sceneVersion;
+		uint32_t objectCount;
+	};
+
+	extern bool enabled;
+
+	extern VkDescriptorSetLayout descriptorSetLayout;
+	extern VkPipelineLayout pipelineLayout;
+	extern VkPipeline pipeline;
+	extern VkDescriptorPool descriptorPool;
+	extern std::vector<VkDescriptorSet> descriptorSets;
+	// grown buffers and a rebuilt pyramid are picked up once the slot is idle
+	extern std::array<bool, renderer::maxFramesInFlight> descriptorsOutdated;
+
+	extern std::array<frameBuffers, renderer::maxFramesInFlight> frames;
+
+	extern VkDescriptorSetLayout pyramidSetLayout;
+	extern VkPipelineLayout pyramidPipelineLayout;
+	extern VkPipeline pyramidPipeline;
+	extern VkSampler pyramidSampler;
+
+	// r32 max depth, level 0 is the depth buffer's extent rounded down to powers of two, the render graph keeps it in the general layout
+	extern VkImage pyramidImage;
+	extern VkDeviceMemory pyramidImageMemory;
+	extern VkImageView pyramidImageView;
+	extern std::vector<VkImageView> pyramidLevelViews;
+	extern VkExtent2D pyramidExtent;
+	extern uint32_t pyramidLevels;
+	// one set per level, they read the depth buffer or the level below, so they are rebuilt with the swapchain
+	extern VkDescriptorPool pyramidDescriptorPool;
+	extern std::vector<VkDescriptorSet> pyramidDescriptorSets;
+	// the render graph's depth buffer, what level 0 samples
+	extern VkImageView pyramidDepthView;
+
+	// offset of this frame's frameUniforms in the gpu frame arena
+	extern VkDeviceSize uniformOffset;
+
+	// false until a frame has built the pyramid, tests need last frame's depth and the matrix it was drawn with
+	extern bool pyramidValid;
+	extern glm::mat4 previousViewProjection;
+
+	// from the last finished frame in this slot, like renderer::gpuFrameMilliseconds
+	extern uint32_t drawnObjects;
+	extern uint32_t occludedObjects;
+
+	// after the descriptor sets, needs renderer::indirectCountSupported and both shaders
+	void init();
+	void cleanup();
+	bool active();
+
+	void createPyramid();
+	void destroyPyramid();
+	// after the render graph created its targets, the depth buffer is only recreated together with the pyramid
+	void bindDepth(VkImageView depthView);
+	// with the new depth buffer, the old pyramid is retired until the frames in flight are done with it
+	void resize();
+
+	void collect(uint32_t frame);
+
+	// before the render graph runs, writes the scene and this frame's uniforms, objectCount stays 0 when there is nothing to cull
+	void prepare();
+	// the render graph's passes, occlusionClear zeroes the counts and gpuCulling replaces the cpu frustum culling and lod selection
+	void recordClear(VkCommandBuffer commandBuffer);
+	void recordCulling(VkCommandBuffer commandBuffer);
+	// inside the main pass, one vkCmdDrawIndexedIndirectCount for every object
+	void recordDraws(VkCommandBuffer commandBuffer);
+	// the depthPyramid pass after the main pass, next frame tests against it
+	void recordPyramid(VkCommandBuffer commandBuffer);
+}
+
+#endif
\ No newline at end of file
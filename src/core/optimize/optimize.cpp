@@ -0,0 +1,407 @@
+#include "./optimize.h"
+
+#include <cmath>
+#include <numeric>
+
+// tom forsyth, "linear-speed vertex cache optimisation", with the constants from the article
+static const float cacheDecayPower = 1.5f;
+static const float lastTriangleScore = 0.75f;
+static const float valenceBoostScale = 2.0f;
+static const float valenceBoostPower = 0.5f;
+
+optimize::cacheStats optimize::analyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize) {
+	optimize::cacheStats stats{};
+
+	if (indices.size() < 3 || vertexCount == 0) {
+		return stats;
+	}
+
+	// a vertex is still cached while fewer than cacheSize misses happened since it was loaded
+	std::vector<uint32_t> loadedAt(vertexCount, 0);
+	uint32_t timestamp = cacheSize + 1;
+
+	size_t misses = 0;
+	size_t used = 0;
+
+	for (uint32_t index : indices) {
+		if (loadedAt[index] == 0) {
+			used++;
+		}
+
+		if (timestamp - loadedAt[index] > cacheSize) {
+			loadedAt[index] = timestamp++;
+			misses++;
+		}
+	}
+
+	stats.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+	stats.atvr = static_cast<float>(misses) / static_cast<float>(used);
+
+	return stats;
+}
+
+// bitwise, so -0 and 0 stay apart, which only costs a duplicate vertex
+struct vertexKey {
+	const renderer::vertex* vertex;
+
+	bool operator==(const vertexKey& other) const {
+		return memcmp(vertex, other.vertex, sizeof(renderer::vertex)) == 0;
+	}
+};
+
+struct vertexKeyHash {
+	size_t operator()(const vertexKey& key) const {
+		return static_cast<size_t>(assets::hashBytes(std::span<const char>(reinterpret_cast<const char*>(key.vertex), sizeof(renderer::vertex))));
+	}
+};
+
+void optimize::weld(std::span<const renderer::vertex> vertices, std::span<const uint32_t> indices, std::vector<renderer::vertex>& weldedVertices, std::vector<uint32_t>& weldedIndices) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	std::unordered_map<vertexKey, uint32_t, vertexKeyHash> unique;
+	unique.reserve(vertices.size());
+
+	std::vector<uint32_t> remap(vertices.size());
+
+	weldedVertices.clear();
+	weldedVertices.reserve(vertices.size());
+
+	for (size_t i = 0; i < vertices.size(); i++) {
+		auto [entry, inserted] = unique.try_emplace(vertexKey{ &vertices[i] }, static_cast<uint32_t>(weldedVertices.size()));
+
+		if (inserted) {
+			weldedVertices.push_back(vertices[i]);
+		}
+
+		remap[i] = entry->second;
+	}
+
+	weldedIndices.resize(indices.size());
+
+	for (size_t i = 0; i < indices.size(); i++) {
+		weldedIndices[i] = remap[indices[i]];
+	}
+}
+
+static float vertexScore(int32_t cachePosition, uint32_t remaining) {
+	if (remaining == 0) {
+		return -1.0f;
+	}
+
+	float score = 0.0f;
+
+	// the last triangle's vertices get a fixed score so the next triangle does not just reuse the same edge
+	if (cachePosition >= 0 && cachePosition < 3) {
+		score = lastTriangleScore;
+	}
+	else if (cachePosition >= 3) {
+		score = std::pow(1.0f - static_cast<float>(cachePosition - 3) / static_cast<float>(optimize::forsythCacheSize - 3), cacheDecayPower);
+	}
+
+	// vertices with few triangles left are worth finishing before they fall out of the cache
+	return score + valenceBoostScale * std::pow(static_cast<float>(remaining), -valenceBoostPower);
+}
+
+void optimize::optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	size_t triangleCount = indices.size() / 3;
+
+	if (triangleCount < 2) {
+		return;
+	}
+
+	// triangles of every vertex, the first remaining[vertex] entries of its slice are the ones not yet emitted
+	std::vector<uint32_t> remaining(vertexCount, 0);
+
+	for (uint32_t index : indices) {
+		remaining[index]++;
+	}
+
+	std::vector<uint32_t> offsets(vertexCount + 1, 0);
+
+	for (size_t vertex = 0; vertex < vertexCount; vertex++) {
+		offsets[vertex + 1] = offsets[vertex] + remaining[vertex];
+	}
+
+	std::vector<uint32_t> adjacency(indices.size());
+	std::vector<uint32_t> filled(vertexCount, 0);
+
+	for (size_t triangle = 0; triangle < triangleCount; triangle++) {
+		for (size_t corner = 0; corner < 3; corner++) {
+			uint32_t vertex = indices[triangle * 3 + corner];
+			adjacency[offsets[vertex] + filled[vertex]++] = static_cast<uint32_t>(triangle);
+		}
+	}
+
+	std::vector<int32_t> cachePosition(vertexCount, -1);
+	std::vector<float> scores(vertexCount);
+
+	for (size_t vertex = 0; vertex < vertexCount; vertex++) {
+		scores[vertex] = vertexScore(-1, remaining[vertex]);
+	}
+
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<bool> emitted(triangleCount, false);
+
+	int64_t best = 0;
+
+	for (size_t triangle = 0; triangle < triangleCount; triangle++) {
+		triangleScores[triangle] = scores[indices[triangle * 3]] + scores[indices[triangle * 3 + 1]] + scores[indices[triangle * 3 + 2]];
+
+		if (triangleScores[triangle] > triangleScores[best]) {
+			best = static_cast<int64_t>(triangle);
+		}
+	}
+
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> nextCache;
+	cache.reserve(optimize::forsythCacheSize + 3);
+	nextCache.reserve(optimize::forsythCacheSize + 3);
+
+	size_t cursor = 0;
+
+	while (output.size() < indices.size()) {
+		// nothing in the cache has triangles left, continue with the next triangle in input order
+		if (best < 0) {
+			while (emitted[cursor]) {
+				cursor++;
+			}
+
+			best = static_cast<int64_t>(cursor);
+		}
+
+		const uint32_t* triangle = &indices[static_cast<size_t>(best) * 3];
+
+		emitted[static_cast<size_t>(best)] = true;
+		output.insert(output.end(), triangle, triangle + 3);
+
+		nextCache.assign(triangle, triangle + 3);
+
+		for (uint32_t vertex : cache) {
+			if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2]) {
+				nextCache.push_back(vertex);
+			}
+		}
+
+		for (size_t corner = 0; corner < 3; corner++) {
+			uint32_t vertex = triangle[corner];
+			uint32_t* begin = &adjacency[offsets[vertex]];
+			uint32_t* end = begin + remaining[vertex];
+
+			*std::find(begin, end, static_cast<uint32_t>(best)) = *(end - 1);
+			remaining[vertex]--;
+		}
+
+		// rescore everything that moved in or out of the cache and the triangles around it
+		for (size_t position = 0; position < nextCache.size(); position++) {
+			uint32_t vertex = nextCache[position];
+			int32_t newPosition = position < optimize::forsythCacheSize ? static_cast<int32_t>(position) : -1;
+
+			cachePosition[vertex] = newPosition;
+
+			float score = vertexScore(newPosition, remaining[vertex]);
+			float delta = score - scores[vertex];
+			scores[vertex] = score;
+
+			for (uint32_t i = offsets[vertex]; i < offsets[vertex] + remaining[vertex]; i++) {
+				triangleScores[adjacency[i]] += delta;
+			}
+		}
+
+		nextCache.resize(std::min<size_t>(nextCache.size(), optimize::forsythCacheSize));
+		std::swap(cache, nextCache);
+
+		// only triangles touching the cache are candidates, their scores are final now
+		best = -1;
+		float bestScore = -1.0f;
+
+		for (uint32_t vertex : cache) {
+			for (uint32_t i = offsets[vertex]; i < offsets[vertex] + remaining[vertex]; i++) {
+				if (triangleScores[adjacency[i]] > bestScore) {
+					bestScore = triangleScores[adjacency[i]];
+					best = adjacency[i];
+				}
+			}
+		}
+	}
+
+	indices = std::move(output);
+}
+
+// sander, nehab and barczak, "fast triangle reordering for vertex locality and reduced overdraw", on top of the forsyth order
+void optimize::optimizeOverdraw(std::vector<uint32_t>& indices, std::span<const renderer::vertex> vertices, float threshold) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	size_t triangleCount = indices.size() / 3;
+
+	if (triangleCount < 2) {
+		return;
+	}
+
+	std::vector<uint32_t> loadedAt(vertices.size(), 0);
+	uint32_t timestamp = optimize::simulatedCacheSize + 1;
+
+	auto misses = [&](size_t triangle) {
+		uint32_t count = 0;
+
+		for (size_t corner = 0; corner < 3; corner++) {
+			uint32_t vertex = indices[triangle * 3 + corner];
+
+			if (timestamp - loadedAt[vertex] > optimize::simulatedCacheSize) {
+				loadedAt[vertex] = timestamp++;
+				count++;
+			}
+		}
+
+		return count;
+	};
+
+	// hard boundaries are triangles that miss on every vertex, the cache has no state to lose there,
+	// the first triangle is one even when it is degenerate, so nothing before the first full miss is dropped
+	std::vector<size_t> hardBoundaries = { 0 };
+
+	for (size_t triangle = 0; triangle < triangleCount; triangle++) {
+		if (misses(triangle) == 3 && triangle > 0) {
+			hardBoundaries.push_back(triangle);
+		}
+	}
+
+	hardBoundaries.push_back(triangleCount);
+
+	// soft boundaries split a hard cluster wherever the part so far is already within the threshold of the whole
+	std::vector<size_t> clusters;
+
+	for (size_t i = 0; i + 1 < hardBoundaries.size(); i++) {
+		size_t begin = hardBoundaries[i];
+		size_t end = hardBoundaries[i + 1];
+
+		timestamp += optimize::simulatedCacheSize + 1;
+
+		uint32_t clusterMisses = 0;
+
+		for (size_t triangle = begin; triangle < end; triangle++) {
+			clusterMisses += misses(triangle);
+		}
+
+		float clusterAcmr = static_cast<float>(clusterMisses) / static_cast<float>(end - begin);
+
+		timestamp += optimize::simulatedCacheSize + 1;
+
+		size_t start = begin;
+		uint32_t startMisses = 0;
+
+		clusters.push_back(begin);
+
+		for (size_t triangle = begin; triangle < end; triangle++) {
+			startMisses += misses(triangle);
+
+			if (triangle + 1 < end && static_cast<float>(startMisses) / static_cast<float>(triangle + 1 - start) <= clusterAcmr * threshold) {
+				clusters.push_back(triangle + 1);
+
+				start = triangle + 1;
+				startMisses = 0;
+				timestamp += optimize::simulatedCacheSize + 1;
+			}
+		}
+	}
+
+	clusters.push_back(triangleCount);
+
+	auto corner = [&](size_t triangle, size_t index) {
+		return vertices[indices[triangle * 3 + index]].pos;
+	};
+
+	// area weighted, so a few sliver triangles do not drag the centre around
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+
+	for (size_t triangle = 0; triangle < triangleCount; triangle++) {
+		float area = glm::length(glm::cross(corner(triangle, 1) - corner(triangle, 0), corner(triangle, 2) - corner(triangle, 0)));
+
+		meshCentroid += (corner(triangle, 0) + corner(triangle, 1) + corner(triangle, 2)) * (area / 3.0f);
+		meshArea += area;
+	}
+
+	meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : glm::vec3(0.0f);
+
+	// clusters facing away from the centre and far out in that direction occlude the rest, they go first
+	std::vector<float> sortKeys(clusters.size() - 1);
+
+	for (size_t cluster = 0; cluster + 1 < clusters.size(); cluster++) {
+		glm::vec3 centroid(0.0f);
+		glm::vec3 normal(0.0f);
+		float area = 0.0f;
+
+		for (size_t triangle = clusters[cluster]; triangle < clusters[cluster + 1]; triangle++) {
+			glm::vec3 cross = glm::cross(corner(triangle, 1) - corner(triangle, 0), corner(triangle, 2) - corner(triangle, 0));
+			float triangleArea = glm::length(cross);
+
+			centroid += (corner(triangle, 0) + corner(triangle, 1) + corner(triangle, 2)) * (triangleArea / 3.0f);
+			normal += cross;
+			area += triangleArea;
+		}
+
+		float normalLength = glm::length(normal);
+
+		sortKeys[cluster] = area > 0.0f && normalLength > 0.0f ? glm::dot(centroid / area - meshCentroid, normal / normalLength) : 0.0f;
+	}
+
+	std::vector<size_t> order(sortKeys.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+
+	for (size_t cluster : order) {
+		output.insert(output.end(), indices.begin() + clusters[cluster] * 3, indices.begin() + clusters[cluster + 1] * 3);
+	}
+
+	if (output.size() != indices.size()) {
+		throw std::runtime_error("Failed to optimize overdraw, the clusters do not cover every triangle!");
+	}
+
+	indices = std::move(output);
+}
+
+void optimize::optimizeVertexFetch(std::vector<renderer::vertex>& vertices, std::vector<uint32_t>& indices) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+	std::vector<renderer::vertex> output;
+	output.reserve(vertices.size());
+
+	for (uint32_t& index : indices) {
+		if (remap[index] == UINT32_MAX) {
+			remap[index] = static_cast<uint32_t>(output.size());
+			output.push_back(vertices[index]);
+		}
+
+		index = remap[index];
+	}
+
+	vertices = std::move(output);
+}
+
+optimize::result optimize::optimizeMesh(const std::string& name, std::span<const renderer::vertex> vertices, std::span<const uint32_t> indices) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	optimize::result result{};
+	result.verticesBefore = static_cast<uint32_t>(vertices.size());
+	result.before = optimize::analyzeVertexCache(indices, vertices.size());
+
+	optimize::weld(vertices, indices, result.vertices, result.indices);
+	optimize::optimizeVertexCache(result.indices, result.vertices.size());
+	optimize::optimizeOverdraw(result.indices, result.vertices);
+	optimize::optimizeVertexFetch(result.vertices, result.indices);
+
+	result.after = optimize::analyzeVertexCache(result.indices, result.vertices.size());
+
+	logger::log("Optimized mesh " + name + ": " + std::to_string(result.verticesBefore) + " -> " + std::to_string(result.vertices.size()) + " vertices, ACMR " + std::to_string(result.before.acmr) + " -> " + std::to_string(result.after.acmr) + ", ATVR " + std::to_string(result.before.atvr) + " -> " + std::to_string(result.after.atvr), 4);
+
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+#ifndef optimize_h
+#define optimize_h
+
+#include "../src/engine.h"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace optimize {
+	// fifo size the statistics are measured with, close to what current hardware reuses
+	const uint32_t simulatedCacheSize = 16;
+
+	// lru size forsyth's scoring assumes, larger than the fifo so the order holds up on older hardware too
+	const uint32_t forsythCacheSize = 32;
+
+	// overdraw clusters may cost this much more vertex cache than the order they were cut from
+	const float overdrawThreshold = 1.05f;
+
+	// acmr is transformed vertices per triangle (0.5 is ideal for a regular grid, 3 is no reuse), atvr per unique vertex (1 is ideal)
+	struct cacheStats {
+		float acmr;
+		float atvr;
+	};
+
+	struct result {
+		std::vector<renderer::vertex> vertices;
+		std::vector<uint32_t> indices;
+
+		uint32_t verticesBefore;
+		cacheStats before;
+		cacheStats after;
+	};
+
+	cacheStats analyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize = simulatedCacheSize);
+
+	// merges bitwise identical vertices, obj meshes come out with one vertex per corner
+	void weld(std::span<const renderer::vertex> vertices, std::span<const uint32_t> indices, std::vector<renderer::vertex>& weldedVertices, std::vector<uint32_t>& weldedIndices);
+
+	// forsyth's linear-speed vertex cache optimisation, reorders triangles only
+	void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+	// cuts the cache optimised order into clusters and draws the outward facing, outer ones first
+	void optimizeOverdraw(std::vector<uint32_t>& indices, std::span<const renderer::vertex> vertices, float threshold = overdrawThreshold);
+
+	// vertices in first use order, unused ones are dropped
+	void optimizeVertexFetch(std::vector<renderer::vertex>& vertices, std::vector<uint32_t>& indices);
+
+	// weld, vertex cache, overdraw and fetch in that order, logs acmr and atvr before and after
+	result optimizeMesh(const std::string& name, std::span<const renderer::vertex> vertices, std::span<const uint32_t> indices);
+}
+
+#endif
\ No newline at end of file
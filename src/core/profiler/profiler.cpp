@@ -0,0 +1,439 @@
+#include "./profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <unordered_map>
+
+std::atomic<bool> profiler::enabled = false;
+std::string profiler::tracePath;
+std::chrono::steady_clock::time_point profiler::epoch = std::chrono::steady_clock::now();
+
+std::vector<std::shared_ptr<profiler::threadBuffer>> profiler::buffers;
+std::mutex profiler::buffersMutex;
+
+VkQueryPool profiler::gpuQueryPool = VK_NULL_HANDLE;
+double profiler::gpuTimestampPeriod = 0.0;
+uint64_t profiler::gpuTimestampMask = 0;
+uint32_t profiler::gpuRecordingSlice = 0;
+std::array<profiler::gpuSlice, renderer::maxFramesInFlight + 1> profiler::gpuSlices;
+std::shared_ptr<profiler::threadBuffer> profiler::gpuBuffer;
+
+PFN_vkCmdBeginDebugUtilsLabelEXT profiler::beginDebugLabel = nullptr;
+PFN_vkCmdEndDebugUtilsLabelEXT profiler::endDebugLabel = nullptr;
+
+profiler::zone::zone(const char* name) {
+	if (!profiler::enabled.load(std::memory_order_relaxed)) {
+		return;
+	}
+
+	BRUTAL_MEMORY_SCOPE(memory::tag::profiler);
+
+	profiler::threadBuffer& local = profiler::localBuffer();
+
+	std::lock_guard<std::mutex> lock(local.mutex);
+
+	if (local.events.size() >= profiler::maxEventsPerThread) {
+		local.dropped++;
+		return;
+	}
+
+	buffer = &local;
+	index = local.events.size();
+
+	local.events.push_back({ name, profiler::now(), 0, local.depth++ });
+}
+
+profiler::zone::~zone() {
+	if (!buffer) {
+		return;
+	}
+
+	uint64_t end = profiler::now();
+
+	std::lock_guard<std::mutex> lock(buffer->mutex);
+
+	// the buffer may have been cleared while the zone was open
+	if (index < buffer->events.size()) {
+		buffer->events[index].end = end;
+	}
+
+	if (buffer->depth > 0) {
+		buffer->depth--;
+	}
+}
+
+void profiler::start(const std::string& tracePath) {
+	profiler::clear();
+
+	profiler::tracePath = tracePath;
+	profiler::enabled = true;
+
+#ifdef BRUTAL_PROFILING
+	logger::log("Profiler capturing" + (tracePath.empty() ? std::string("...") : " to " + tracePath + "..."), 4);
+#else
+	logger::log("Profiler zones are compiled out, define BRUTAL_PROFILER to capture in release builds!", 2);
+#endif
+}
+
+void profiler::stop() {
+	profiler::enabled = false;
+}
+
+void profiler::clear() {
+	std::lock_guard<std::mutex> lock(profiler::buffersMutex);
+
+	for (auto& buffer : profiler::buffers) {
+		std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+
+		buffer->events.clear();
+		buffer->dropped = 0;
+	}
+}
+
+uint64_t profiler::now() {
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profiler::epoch).count());
+}
+
+// the registry keeps buffers of exited threads alive until they are written
+std::shared_ptr<profiler::threadBuffer> profiler::registerBuffer(const std::string& name, bool gpu) {
+	std::shared_ptr<profiler::threadBuffer> buffer = std::make_shared<profiler::threadBuffer>();
+
+	std::lock_guard<std::mutex> lock(profiler::buffersMutex);
+
+	buffer->threadId = static_cast<uint32_t>(profiler::buffers.size() + 1);
+	buffer->threadName = name.empty() ? "thread " + std::to_string(buffer->threadId) : name;
+	buffer->gpu = gpu;
+	buffer->events.reserve(4096);
+
+	profiler::buffers.push_back(buffer);
+
+	return buffer;
+}
+
+profiler::threadBuffer& profiler::localBuffer() {
+	thread_local std::shared_ptr<profiler::threadBuffer> buffer;
+
+	if (!buffer) {
+		buffer = profiler::registerBuffer("", false);
+	}
+
+	return *buffer;
+}
+
+void profiler::setThreadName(const std::string& name) {
+	profiler::threadBuffer& local = profiler::localBuffer();
+
+	std::lock_guard<std::mutex> lock(local.mutex);
+	local.threadName = name;
+}
+
+std::vector<profiler::zoneStats> profiler::stats() {
+	BRUTAL_MEMORY_SCOPE(memory::tag::profiler);
+
+	std::unordered_map<std::string, profiler::zoneStats> zones;
+
+	std::lock_guard<std::mutex> lock(profiler::buffersMutex);
+
+	for (auto& buffer : profiler::buffers) {
+		std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+
+		for (const auto& event : buffer->events) {
+			if (event.end == 0) {
+				continue;
+			}
+
+			std::string name = buffer->gpu ? std::string("gpu/") + event.name : std::string(event.name);
+
+			profiler::zoneStats& zone = zones[name];
+			zone.name = name;
+			zone.gpu = buffer->gpu;
+
+			double milliseconds = static_cast<double>(event.end - event.start) / 1000000.0;
+
+			zone.count++;
+			zone.totalMilliseconds += milliseconds;
+			zone.maxMilliseconds = std::max(zone.maxMilliseconds, milliseconds);
+		}
+	}
+
+	std::vector<profiler::zoneStats> result;
+
+	for (auto& zone : zones) {
+		zone.second.averageMilliseconds = zone.second.totalMilliseconds / static_cast<double>(zone.second.count);
+		result.push_back(zone.second);
+	}
+
+	std::sort(result.begin(), result.end(), [](const profiler::zoneStats& a, const profiler::zoneStats& b) { return a.totalMilliseconds > b.totalMilliseconds; });
+
+	return result;
+}
+
+void profiler::report(size_t zoneCount) {
+	std::vector<profiler::zoneStats> zones = profiler::stats();
+
+	for (size_t i = 0; i < std::min(zoneCount, zones.size()); i++) {
+		logger::log(zones[i].name + ": " + std::to_string(zones[i].count) + " calls, total " + std::to_string(zones[i].totalMilliseconds) + " ms, average " + std::to_string(zones[i].averageMilliseconds) + " ms, max " + std::to_string(zones[i].maxMilliseconds) + " ms", 4);
+	}
+}
+
+static std::string escape(const std::string& text) {
+	std::string result;
+
+	for (char character : text) {
+		if (character == '"' || character == '\\') {
+			result += '\\';
+		}
+
+		if (static_cast<unsigned char>(character) >= 0x20) {
+			result += character;
+		}
+	}
+
+	return result;
+}
+
+// chrome trace event format, complete events in microseconds, opens in perfetto and chrome://tracing
+void profiler::writeTrace(const std::string& path) {
+	BRUTAL_MEMORY_SCOPE(memory::tag::profiler);
+
+	std::ofstream file(path, std::ios::trunc);
+
+	if (!file.is_open()) {
+		throw std::runtime_error("Failed to write trace: " + path);
+	}
+
+	file << std::fixed << std::setprecision(3);
+	file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+	file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"" << escape(engine::name) << "\"}}";
+
+	uint64_t eventCount = 0;
+	uint64_t dropped = 0;
+
+	std::lock_guard<std::mutex> lock(profiler::buffersMutex);
+
+	for (auto& buffer : profiler::buffers) {
+		std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+
+		file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"args\":{\"name\":\"" << escape(buffer->threadName) << "\"}}";
+
+		for (const auto& event : buffer->events) {
+			if (event.end == 0) {
+				continue;
+			}
+
+			file << ",\n{\"name\":\"" << escape(event.name) << "\",\"cat\":\"" << (buffer->gpu ? "gpu" : "cpu") << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"ts\":" << static_cast<double>(event.start) / 1000.0 << ",\"dur\":" << static_cast<double>(event.end - event.start) / 1000.0 << "}";
+
+			eventCount++;
+		}
+
+		dropped += buffer->dropped;
+	}
+
+	file << "\n]}\n";
+
+	if (dropped > 0) {
+		logger::log("Profiler dropped " + std::to_string(dropped) + " events, thread buffers were full!", 2);
+	}
+
+	logger::log("Successfully wrote trace: " + path + " (" + std::to_string(eventCount) + " events)", 1);
+}
+
+profiler::gpuZone::gpuZone(VkCommandBuffer commandBuffer, const char* name) : commandBuffer(commandBuffer) {
+	zoneIndex = profiler::beginGpuZone(commandBuffer, name);
+}
+
+profiler::gpuZone::~gpuZone() {
+	profiler::endGpuZone(commandBuffer, zoneIndex);
+}
+
+void profiler::initGpu() {
+	if (renderer::validationLayersEnabled) {
+		profiler::beginDebugLabel = (PFN_vkCmdBeginDebugUtilsLabelEXT)vkGetInstanceProcAddr(renderer::instance, "vkCmdBeginDebugUtilsLabelEXT");
+		profiler::endDebugLabel = (PFN_vkCmdEndDebugUtilsLabelEXT)vkGetInstanceProcAddr(renderer::instance, "vkCmdEndDebugUtilsLabelEXT");
+	}
+
+	// valid bits are per queue family, zero means the graphics queue cannot write timestamps at all
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(renderer::physicalDevice, &queueFamilyCount, nullptr);
+
+	std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(renderer::physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+	uint32_t validBits = queueFamilies[renderer::findQueueFamilies(renderer::physicalDevice).graphicsFamily.value()].timestampValidBits;
+
+	if (validBits == 0) {
+		logger::log("Timestamps not supported, GPU zones unavailable!", 2);
+		return;
+	}
+
+	profiler::gpuTimestampMask = validBits >= 64 ? UINT64_MAX : (1ull << validBits) - 1;
+	profiler::gpuTimestampPeriod = renderer::physicalDeviceProperties.limits.timestampPeriod;
+
+	VkQueryPoolCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	createInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	createInfo.queryCount = static_cast<uint32_t>(profiler::gpuSlices.size()) * profiler::maxGpuQueriesPerSlice;
+
+	if (vkCreateQueryPool(renderer::device, &createInfo, nullptr, &profiler::gpuQueryPool) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create timestamp query pool!");
+	}
+	else {
+		logger::log("Successfully created timestamp query pool!", 1);
+	}
+
+	if (!profiler::gpuBuffer) {
+		profiler::gpuBuffer = profiler::registerBuffer("gpu", true);
+	}
+}
+
+void profiler::shutdownGpu() {
+	if (profiler::gpuQueryPool != VK_NULL_HANDLE) {
+		vkDestroyQueryPool(renderer::device, profiler::gpuQueryPool, nullptr);
+		profiler::gpuQueryPool = VK_NULL_HANDLE;
+	}
+
+	for (auto& slice : profiler::gpuSlices) {
+		slice.zones.clear();
+		slice.openZones.clear();
+		slice.written = false;
+	}
+}
+
+void profiler::beginGpuSlice(VkCommandBuffer commandBuffer, uint32_t slice, const char* name) {
+	profiler::gpuRecordingSlice = slice;
+
+	profiler::gpuSlice& current = profiler::gpuSlices[slice];
+	current.zones.clear();
+	current.openZones.clear();
+	current.queryCount = 0;
+	current.written = false;
+
+	if (profiler::gpuQueryPool != VK_NULL_HANDLE) {
+		vkCmdResetQueryPool(commandBuffer, profiler::gpuQueryPool, slice * profiler::maxGpuQueriesPerSlice, profiler::maxGpuQueriesPerSlice);
+	}
+
+	profiler::beginGpuZone(commandBuffer, name);
+}
+
+void profiler::endGpuSlice(VkCommandBuffer commandBuffer) {
+	profiler::gpuSlice& current = profiler::gpuSlices[profiler::gpuRecordingSlice];
+
+	while (!current.openZones.empty()) {
+		profiler::endGpuZone(commandBuffer, current.openZones.back());
+	}
+
+	// the gpu track is anchored at submission, close enough to line up with the cpu zones
+	current.submitTime = profiler::now();
+	current.written = !current.zones.empty();
+}
+
+uint32_t profiler::beginGpuZone(VkCommandBuffer commandBuffer, const char* name) {
+	if (profiler::beginDebugLabel) {
+		VkDebugUtilsLabelEXT label{};
+		label.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
+		label.pLabelName = name;
+
+		profiler::beginDebugLabel(commandBuffer, &label);
+	}
+
+	profiler::gpuSlice& current = profiler::gpuSlices[profiler::gpuRecordingSlice];
+
+	uint32_t zoneIndex = static_cast<uint32_t>(current.zones.size());
+
+	profiler::gpuZoneRecord record{};
+	record.name = name;
+	record.depth = static_cast<uint32_t>(current.openZones.size());
+	record.beginQuery = UINT32_MAX;
+
+	// out of queries the zone still nests and labels, it just has no timing
+	if (profiler::gpuQueryPool != VK_NULL_HANDLE && current.queryCount + 2 <= profiler::maxGpuQueriesPerSlice) {
+		record.beginQuery = profiler::gpuRecordingSlice * profiler::maxGpuQueriesPerSlice + current.queryCount;
+		record.endQuery = record.beginQuery + 1;
+		current.queryCount += 2;
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, profiler::gpuQueryPool, record.beginQuery);
+	}
+
+	current.zones.push_back(record);
+	current.openZones.push_back(zoneIndex);
+
+	return zoneIndex;
+}
+
+void profiler::endGpuZone(VkCommandBuffer commandBuffer, uint32_t zone) {
+	profiler::gpuSlice& current = profiler::gpuSlices[profiler::gpuRecordingSlice];
+
+	if (zone == profiler::invalidGpuZone || current.openZones.empty() || current.openZones.back() != zone) {
+		return;
+	}
+
+	current.openZones.pop_back();
+
+	if (current.zones[zone].beginQuery != UINT32_MAX) {
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, profiler::gpuQueryPool, current.zones[zone].endQuery);
+	}
+
+	if (profiler::endDebugLabel) {
+		profiler::endDebugLabel(commandBuffer);
+	}
+}
+
+// returns the outermost zone in milliseconds, -1 when the slice holds nothing readable
+double profiler::collectGpuSlice(uint32_t slice, bool wait) {
+	BRUTAL_MEMORY_SCOPE(memory::tag::profiler);
+
+	profiler::gpuSlice& current = profiler::gpuSlices[slice];
+
+	if (profiler::gpuQueryPool == VK_NULL_HANDLE || !current.written || current.queryCount == 0) {
+		return -1.0;
+	}
+
+	std::array<uint64_t, profiler::maxGpuQueriesPerSlice> timestamps{};
+
+	VkQueryResultFlags flags = VK_QUERY_RESULT_64_BIT | (wait ? VK_QUERY_RESULT_WAIT_BIT : 0);
+
+	if (vkGetQueryPoolResults(renderer::device, profiler::gpuQueryPool, slice * profiler::maxGpuQueriesPerSlice, current.queryCount, current.queryCount * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t), flags) != VK_SUCCESS) {
+		return -1.0;
+	}
+
+	current.written = false;
+
+	uint32_t firstQuery = slice * profiler::maxGpuQueriesPerSlice;
+	uint64_t origin = timestamps[current.zones.front().beginQuery - firstQuery];
+
+	auto toNanoseconds = [](uint64_t ticks) {
+		return static_cast<uint64_t>(static_cast<double>(ticks & profiler::gpuTimestampMask) * profiler::gpuTimestampPeriod);
+	};
+
+	double outermost = -1.0;
+
+	bool capturing = profiler::enabled.load(std::memory_order_relaxed) && profiler::gpuBuffer;
+	std::unique_lock<std::mutex> lock;
+
+	if (capturing) {
+		lock = std::unique_lock<std::mutex>(profiler::gpuBuffer->mutex);
+	}
+
+	for (const auto& zone : current.zones) {
+		if (zone.beginQuery == UINT32_MAX) {
+			continue;
+		}
+
+		uint64_t begin = timestamps[zone.beginQuery - firstQuery];
+		uint64_t end = timestamps[zone.endQuery - firstQuery];
+		uint64_t duration = toNanoseconds(end - begin);
+
+		if (outermost < 0.0) {
+			outermost = static_cast<double>(duration) / 1000000.0;
+		}
+
+		if (capturing && profiler::gpuBuffer->events.size() < profiler::maxEventsPerThread) {
+			uint64_t start = current.submitTime + toNanoseconds(begin - origin);
+
+			profiler::gpuBuffer->events.push_back({ zone.name, start, start + std::max<uint64_t>(duration, 1), zone.depth });
+		}
+	}
+
+	return outermost;
+}
\ No newline at end of file
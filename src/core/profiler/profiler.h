@@ -0,0 +1,152 @@
+#pragma once
+#ifndef profiler_h
+#define profiler_h
+
+#include "../src/engine.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// zones compile away in release builds unless BRUTAL_PROFILER is defined
+#if !defined(NDEBUG) || defined(BRUTAL_PROFILER)
+#define BRUTAL_PROFILING
+#endif
+
+#define BRUTAL_PROFILE_CONCAT_INNER(a, b) a##b
+#define BRUTAL_PROFILE_CONCAT(a, b) BRUTAL_PROFILE_CONCAT_INNER(a, b)
+
+#ifdef BRUTAL_PROFILING
+#define BRUTAL_PROFILE_ZONE(name) profiler::zone BRUTAL_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define BRUTAL_PROFILE_FUNCTION() BRUTAL_PROFILE_ZONE(__func__)
+#else
+#define BRUTAL_PROFILE_ZONE(name)
+#define BRUTAL_PROFILE_FUNCTION()
+#endif
+
+// gpu zones stay compiled in, headless frame times are read from them
+#define BRUTAL_PROFILE_GPU_ZONE(commandBuffer, name) profiler::gpuZone BRUTAL_PROFILE_CONCAT(gpuProfileZone, __LINE__)(commandBuffer, name)
+
+namespace profiler {
+	// nanoseconds since the profiler epoch, end stays 0 while the zone is open
+	struct event {
+		const char* name;
+		uint64_t start;
+		uint64_t end;
+		uint32_t depth;
+	};
+
+	// one per thread, only its owner appends, the mutex is for readers
+	struct threadBuffer {
+		uint32_t threadId;
+		std::string threadName;
+		std::vector<event> events;
+		uint32_t depth;
+		uint64_t dropped;
+		bool gpu;
+		std::mutex mutex;
+	};
+
+	struct zoneStats {
+		std::string name;
+		bool gpu;
+		uint64_t count;
+		double totalMilliseconds;
+		double averageMilliseconds;
+		double maxMilliseconds;
+	};
+
+	// caps a thread's buffer, a long capture keeps its beginning rather than growing without bound
+	const size_t maxEventsPerThread = 1 << 20;
+
+	extern std::atomic<bool> enabled;
+	extern std::string tracePath;
+	extern std::chrono::steady_clock::time_point epoch;
+
+	extern std::vector<std::shared_ptr<threadBuffer>> buffers;
+	extern std::mutex buffersMutex;
+
+	// timestamp pairs, one slice of the pool per frame in flight and one for single time commands
+	const uint32_t maxGpuQueriesPerSlice = 64;
+	const uint32_t uploadSlice = renderer::maxFramesInFlight;
+	const uint32_t invalidGpuZone = UINT32_MAX;
+
+	struct gpuZoneRecord {
+		const char* name;
+		uint32_t beginQuery;
+		uint32_t endQuery;
+		uint32_t depth;
+	};
+
+	struct gpuSlice {
+		std::vector<gpuZoneRecord> zones;
+		std::vector<uint32_t> openZones;
+		uint32_t queryCount;
+		uint64_t submitTime;
+		bool written;
+	};
+
+	extern VkQueryPool gpuQueryPool;
+	extern double gpuTimestampPeriod;
+	extern uint64_t gpuTimestampMask;
+	extern uint32_t gpuRecordingSlice;
+	extern std::array<gpuSlice, renderer::maxFramesInFlight + 1> gpuSlices;
+	extern std::shared_ptr<threadBuffer> gpuBuffer;
+
+	// only loaded when the debug utils extension is enabled, labels show up in renderdoc and nsight
+	extern PFN_vkCmdBeginDebugUtilsLabelEXT beginDebugLabel;
+	extern PFN_vkCmdEndDebugUtilsLabelEXT endDebugLabel;
+
+	class zone {
+		public:
+			zone(const char* name);
+			~zone();
+
+			zone(const zone&) = delete;
+			zone& operator=(const zone&) = delete;
+		private:
+			threadBuffer* buffer = nullptr;
+			size_t index = 0;
+	};
+
+	class gpuZone {
+		public:
+			gpuZone(VkCommandBuffer commandBuffer, const char* name);
+			~gpuZone();
+
+			gpuZone(const gpuZone&) = delete;
+			gpuZone& operator=(const gpuZone&) = delete;
+		private:
+			VkCommandBuffer commandBuffer;
+			uint32_t zoneIndex;
+	};
+
+	void start(const std::string& tracePath = "");
+	void stop();
+	void clear();
+
+	uint64_t now();
+	threadBuffer& localBuffer();
+	void setThreadName(const std::string& name);
+
+	std::shared_ptr<threadBuffer> registerBuffer(const std::string& name, bool gpu);
+
+	void initGpu();
+	void shutdownGpu();
+
+	// a slice covers one command buffer and opens its outermost zone, results are collected after its fence
+	void beginGpuSlice(VkCommandBuffer commandBuffer, uint32_t slice, const char* name);
+	void endGpuSlice(VkCommandBuffer commandBuffer);
+	uint32_t beginGpuZone(VkCommandBuffer commandBuffer, const char* name);
+	void endGpuZone(VkCommandBuffer commandBuffer, uint32_t zone);
+	double collectGpuSlice(uint32_t slice, bool wait = false);
+
+	std::vector<zoneStats> stats();
+	void report(size_t zoneCount = 15);
+	void writeTrace(const std::string& path);
+}
+
+#endif
\ No newline at end of file
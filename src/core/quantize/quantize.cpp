@@ -0,0 +1,163 @@
+#include "./quantize.h"
+
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+uint16_t quantize::toHalf(float value) {
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	uint32_t sign = (bits >> 16) & 0x8000;
+	uint32_t exponent = (bits >> 23) & 0xFF;
+	uint32_t mantissa = bits & 0x7FFFFF;
+
+	// infinity stays infinity, nan stays a quiet nan
+	if (exponent == 0xFF) {
+		return static_cast<uint16_t>(sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0));
+	}
+
+	int32_t halfExponent = static_cast<int32_t>(exponent) - 127 + 15;
+
+	if (halfExponent >= 31) {
+		return static_cast<uint16_t>(sign | 0x7C00);
+	}
+
+	if (halfExponent <= 0) {
+		// below half of the smallest subnormal
+		if (halfExponent < -10) {
+			return static_cast<uint16_t>(sign);
+		}
+
+		mantissa |= 0x800000;
+
+		uint32_t shift = static_cast<uint32_t>(14 - halfExponent);
+		uint32_t half = mantissa >> shift;
+		uint32_t remainder = mantissa & ((1u << shift) - 1);
+		uint32_t halfway = 1u << (shift - 1);
+
+		if (remainder > halfway || (remainder == halfway && (half & 1) != 0)) {
+			half++;
+		}
+
+		return static_cast<uint16_t>(sign | half);
+	}
+
+	uint32_t half = (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+	uint32_t remainder = mantissa & 0x1FFF;
+
+	// a carry out of the mantissa moves into the exponent, which rounds correctly up to infinity
+	if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1) != 0)) {
+		half++;
+	}
+
+	return static_cast<uint16_t>(sign | half);
+}
+
+uint16_t quantize::toUnorm16(float value) {
+	return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+int16_t quantize::toSnorm16(float value) {
+	return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+uint8_t quantize::toUnorm8(float value) {
+	return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+}
+
+glm::vec2 quantize::octahedralEncode(const glm::vec3& normal) {
+	float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+
+	if (length == 0.0f) {
+		return glm::vec2(0.0f);
+	}
+
+	glm::vec3 projected = normal / length;
+
+	if (projected.z >= 0.0f) {
+		return glm::vec2(projected.x, projected.y);
+	}
+
+	return glm::vec2((1.0f - std::abs(projected.y)) * (projected.x >= 0.0f ? 1.0f : -1.0f), (1.0f - std::abs(projected.x)) * (projected.y >= 0.0f ? 1.0f : -1.0f));
+}
+
+void quantize::computeNormals(std::span<const renderer::vertex> vertices, std::span<const uint32_t> indices, std::vector<glm::vec3>& normals) {
+	normals.assign(vertices.size(), glm::vec3(0.0f));
+
+	// the unnormalized cross product is twice the area, so bigger triangles weigh more
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		uint32_t a = indices[i];
+		uint32_t b = indices[i + 1];
+		uint32_t c = indices[i + 2];
+
+		glm::vec3 faceNormal = glm::cross(vertices[b].pos - vertices[a].pos, vertices[c].pos - vertices[a].pos);
+
+		normals[a] += faceNormal;
+		normals[b] += faceNormal;
+		normals[c] += faceNormal;
+	}
+
+	for (auto& normal : normals) {
+		float length = glm::length(normal);
+		normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 0.0f, 1.0f);
+	}
+}
+
+bool quantize::hasVertexColors(std::span<const renderer::vertex> vertices) {
+	return std::any_of(vertices.begin(), vertices.end(), [](const renderer::vertex& vertex) {
+		return vertex.color != glm::vec3(1.0f);
+	});
+}
+
+// shared by both compact layouts, they only differ in the color at the end
+template<typename compactType>
+static void encodeCompact(std::span<const renderer::vertex> vertices, const std::vector<glm::vec3>& normals, const glm::vec3& minimum, const glm::vec3& extent, compactType* destination) {
+	// a flat axis has no extent, every position on it quantizes to zero
+	glm::vec3 scale(extent.x > 0.0f ? 1.0f / extent.x : 0.0f, extent.y > 0.0f ? 1.0f / extent.y : 0.0f, extent.z > 0.0f ? 1.0f / extent.z : 0.0f);
+
+	for (size_t i = 0; i < vertices.size(); i++) {
+		const renderer::vertex& source = vertices[i];
+		compactType& target = destination[i];
+
+		glm::vec3 unit = (source.pos - minimum) * scale;
+		glm::vec2 normal = quantize::octahedralEncode(normals[i]);
+
+		target.pos[0] = quantize::toUnorm16(unit.x);
+		target.pos[1] = quantize::toUnorm16(unit.y);
+		target.pos[2] = quantize::toUnorm16(unit.z);
+		target.pos[3] = 0;
+
+		target.texCoord[0] = quantize::toHalf(source.texCoord.x);
+		target.texCoord[1] = quantize::toHalf(source.texCoord.y);
+
+		target.normal[0] = quantize::toSnorm16(normal.x);
+		target.normal[1] = quantize::toSnorm16(normal.y);
+
+		if constexpr (std::is_same_v<compactType, renderer::compactColorVertex>) {
+			target.color[0] = quantize::toUnorm8(source.color.r);
+			target.color[1] = quantize::toUnorm8(source.color.g);
+			target.color[2] = quantize::toUnorm8(source.color.b);
+			target.color[3] = 255;
+		}
+	}
+}
+
+void quantize::encodeVertices(renderer::vertexFormat format, std::span<const renderer::vertex> vertices, std::span<const uint32_t> indices, const glm::vec3& minimum, const glm::vec3& extent, char* destination) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	if (format == renderer::vertexFormat::full) {
+		memcpy(destination, vertices.data(), vertices.size_bytes());
+		return;
+	}
+
+	std::vector<glm::vec3> normals;
+	quantize::computeNormals(vertices, indices, normals);
+
+	if (format == renderer::vertexFormat::compact) {
+		encodeCompact(vertices, normals, minimum, extent, reinterpret_cast<renderer::compactVertex*>(destination));
+	}
+	else {
+		encodeCompact(vertices, normals, minimum, extent, reinterpret_cast<renderer::compactColorVertex*>(destination));
+	}
+}
\ No newline at end of file
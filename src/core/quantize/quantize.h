@@ -0,0 +1,33 @@
+#pragma once
+#ifndef quantize_h
+#define quantize_h
+
+#include "../src/engine.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace quantize {
+	// ieee binary16, rounded to nearest even, values past the range become infinity
+	uint16_t toHalf(float value);
+
+	// the integers vulkan's unorm and snorm formats expand back to [0, 1] and [-1, 1]
+	uint16_t toUnorm16(float value);
+	int16_t toSnorm16(float value);
+	uint8_t toUnorm8(float value);
+
+	// unit vector onto the octahedron, the lower half folded over the upper one into the [-1, 1] square
+	glm::vec2 octahedralEncode(const glm::vec3& normal);
+
+	// area weighted, vertices no triangle references point up +z
+	void computeNormals(std::span<const renderer::vertex> vertices, std::span<const uint32_t> indices, std::vector<glm::vec3>& normals);
+
+	// true when any vertex color is not white, the only color the compact format can leave out
+	bool hasVertexColors(std::span<const renderer::vertex> vertices);
+
+	// writes vertexStride(format) bytes per vertex, compact positions are relative to minimum and extent
+	void encodeVertices(renderer::vertexFormat format, std::span<const renderer::vertex> vertices, std::span<const uint32_t> indices, const glm::vec3& minimum, const glm::vec3& extent, char* destination);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,440 @@
+#include "./raster.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// the widest vector unit the build targets, the rasterizer and the box test only see these helpers
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+typedef __m256 lanes;
+const uint32_t laneCount = 8;
+
+static inline lanes splat(float value) { return _mm256_set1_ps(value); }
+static inline lanes loadLanes(const float* source) { return _mm256_loadu_ps(source); }
+static inline void storeLanes(float* destination, lanes value) { _mm256_storeu_ps(destination, value); }
+static inline lanes addLanes(lanes a, lanes b) { return _mm256_add_ps(a, b); }
+static inline lanes multiplyLanes(lanes a, lanes b) { return _mm256_mul_ps(a, b); }
+static inline lanes minimumLanes(lanes a, lanes b) { return _mm256_min_ps(a, b); }
+static inline lanes greaterEqualLanes(lanes a, lanes b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+static inline lanes bothLanes(lanes a, lanes b) { return _mm256_and_ps(a, b); }
+static inline lanes selectLanes(lanes mask, lanes a, lanes b) { return _mm256_blendv_ps(b, a, mask); }
+static inline bool anyLane(lanes mask) { return _mm256_movemask_ps(mask) != 0; }
+static inline lanes laneIndices() { return _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f); }
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+
+typedef __m128 lanes;
+const uint32_t laneCount = 4;
+
+static inline lanes splat(float value) { return _mm_set1_ps(value); }
+static inline lanes loadLanes(const float* source) { return _mm_loadu_ps(source); }
+static inline void storeLanes(float* destination, lanes value) { _mm_storeu_ps(destination, value); }
+static inline lanes addLanes(lanes a, lanes b) { return _mm_add_ps(a, b); }
+static inline lanes multiplyLanes(lanes a, lanes b) { return _mm_mul_ps(a, b); }
+static inline lanes minimumLanes(lanes a, lanes b) { return _mm_min_ps(a, b); }
+static inline lanes greaterEqualLanes(lanes a, lanes b) { return _mm_cmpge_ps(a, b); }
+static inline lanes bothLanes(lanes a, lanes b) { return _mm_and_ps(a, b); }
+static inline lanes selectLanes(lanes mask, lanes a, lanes b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+static inline bool anyLane(lanes mask) { return _mm_movemask_ps(mask) != 0; }
+static inline lanes laneIndices() { return _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f); }
+#else
+typedef float lanes;
+const uint32_t laneCount = 1;
+
+static inline lanes splat(float value) { return value; }
+static inline lanes loadLanes(const float* source) { return *source; }
+static inline void storeLanes(float* destination, lanes value) { *destination = value; }
+static inline lanes addLanes(lanes a, lanes b) { return a + b; }
+static inline lanes multiplyLanes(lanes a, lanes b) { return a * b; }
+static inline lanes minimumLanes(lanes a, lanes b) { return std::min(a, b); }
+static inline lanes greaterEqualLanes(lanes a, lanes b) { return a >= b ? 1.0f : 0.0f; }
+static inline lanes bothLanes(lanes a, lanes b) { return a != 0.0f && b != 0.0f ? 1.0f : 0.0f; }
+static inline lanes selectLanes(lanes mask, lanes a, lanes b) { return mask != 0.0f ? a : b; }
+static inline bool anyLane(lanes mask) { return mask != 0.0f; }
+static inline lanes laneIndices() { return 0.0f; }
+#endif
+
+static_assert(raster::width % laneCount == 0, "raster::width must be a multiple of the lane count");
+static_assert(raster::height % raster::bandHeight == 0, "raster::height must be a multiple of raster::bandHeight");
+
+// anything nearer than this in w is treated as crossing the near plane
+const float minimumW = 1e-5f;
+// plane interpolation can land a hair in front of the surface it came from, an object must not hide behind itself
+const float depthBias = 1e-6f;
+
+bool raster::enabled = true;
+
+std::vector<raster::occluderMesh> raster::occluders;
+
+std::vector<float> raster::depth;
+
+std::vector<raster::selection> raster::selected;
+std::vector<glm::vec4> raster::clipVertices;
+std::vector<raster::triangle> raster::triangles;
+std::vector<uint8_t> raster::occluded;
+
+uint32_t raster::occluderTriangles = 0;
+uint32_t raster::occludedObjects = 0;
+double raster::rasterMilliseconds = 0.0;
+double raster::testMilliseconds = 0.0;
+
+const char* raster::instructionSet() {
+	return laneCount == 8 ? "avx2" : laneCount == 4 ? "sse2" : "scalar";
+}
+
+static glm::vec3 toScreen(const glm::vec4& clip) {
+	return glm::vec3((clip.x / clip.w * 0.5f + 0.5f) * raster::width, (clip.y / clip.w * 0.5f + 0.5f) * raster::height, clip.z / clip.w);
+}
+
+// a * x + b * y + c, positive on the inside of a counter clockwise edge from a to b
+static glm::vec3 edgeFunction(const glm::vec3& a, const glm::vec3& b) {
+	return glm::vec3(a.y - b.y, b.x - a.x, a.x * b.y - a.y * b.x);
+}
+
+// triangles crossing the near plane are dropped instead of clipped, that only ever lets more through
+static void setupTriangle(const glm::vec4& clip0, const glm::vec4& clip1, const glm::vec4& clip2, raster::triangle& result) {
+	result.minimumY = 1;
+	result.maximumY = 0;
+
+	if (clip0.w < minimumW || clip1.w < minimumW || clip2.w < minimumW || clip0.z < 0.0f || clip1.z < 0.0f || clip2.z < 0.0f) {
+		return;
+	}
+
+	glm::vec3 v0 = toScreen(clip0);
+	glm::vec3 v1 = toScreen(clip1);
+	glm::vec3 v2 = toScreen(clip2);
+
+	float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+
+	if (std::abs(area) < 1e-8f) {
+		return;
+	}
+
+	// both sides are drawn, occluders do not have to be closed
+	if (area < 0.0f) {
+		std::swap(v1, v2);
+		area = -area;
+	}
+
+	// pixels whose centres fall inside the bounds
+	result.minimumX = std::max(static_cast<int32_t>(std::ceil(std::min(v0.x, std::min(v1.x, v2.x)) - 0.5f)), 0);
+	result.maximumX = std::min(static_cast<int32_t>(std::floor(std::max(v0.x, std::max(v1.x, v2.x)) - 0.5f)), static_cast<int32_t>(raster::width) - 1);
+	result.minimumY = std::max(static_cast<int32_t>(std::ceil(std::min(v0.y, std::min(v1.y, v2.y)) - 0.5f)), 0);
+	result.maximumY = std::min(static_cast<int32_t>(std::floor(std::max(v0.y, std::max(v1.y, v2.y)) - 0.5f)), static_cast<int32_t>(raster::height) - 1);
+
+	if (result.minimumX > result.maximumX) {
+		result.minimumY = 1;
+		result.maximumY = 0;
+		return;
+	}
+
+	result.edges[0] = edgeFunction(v0, v1);
+	result.edges[1] = edgeFunction(v1, v2);
+	result.edges[2] = edgeFunction(v2, v0);
+
+	float depthX = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+	float depthY = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+
+	result.depth = glm::vec3(depthX, depthY, v0.z - depthX * v0.x - depthY * v0.y);
+}
+
+// a row at a time, the edge functions and the depth plane are evaluated at the centres of a lane's worth of pixels
+static void rasterizeTriangle(const raster::triangle& triangle, int32_t firstRow, int32_t lastRow) {
+	lanes zero = splat(0.0f);
+	lanes centres = addLanes(laneIndices(), splat(0.5f));
+
+	lanes edgeX0 = splat(triangle.edges[0].x);
+	lanes edgeX1 = splat(triangle.edges[1].x);
+	lanes edgeX2 = splat(triangle.edges[2].x);
+	lanes depthX = splat(triangle.depth.x);
+
+	int32_t firstColumn = triangle.minimumX - triangle.minimumX % static_cast<int32_t>(laneCount);
+
+	for (int32_t y = firstRow; y <= lastRow; y++) {
+		float centreY = static_cast<float>(y) + 0.5f;
+
+		lanes row0 = splat(triangle.edges[0].y * centreY + triangle.edges[0].z);
+		lanes row1 = splat(triangle.edges[1].y * centreY + triangle.edges[1].z);
+		lanes row2 = splat(triangle.edges[2].y * centreY + triangle.edges[2].z);
+		lanes rowDepth = splat(triangle.depth.y * centreY + triangle.depth.z);
+
+		float* depthRow = raster::depth.data() + static_cast<size_t>(y) * raster::width;
+
+		for (int32_t x = firstColumn; x <= triangle.maximumX; x += laneCount) {
+			lanes pixelX = addLanes(splat(static_cast<float>(x)), centres);
+
+			lanes inside = bothLanes(bothLanes(greaterEqualLanes(addLanes(multiplyLanes(edgeX0, pixelX), row0), zero), greaterEqualLanes(addLanes(multiplyLanes(edgeX1, pixelX), row1), zero)), greaterEqualLanes(addLanes(multiplyLanes(edgeX2, pixelX), row2), zero));
+
+			if (!anyLane(inside)) {
+				continue;
+			}
+
+			lanes current = loadLanes(depthRow + x);
+			lanes nearest = minimumLanes(current, addLanes(multiplyLanes(depthX, pixelX), rowDepth));
+
+			storeLanes(depthRow + x, selectLanes(inside, nearest, current));
+		}
+	}
+}
+
+// the finest lod that fits the budget, only the vertices it uses are kept
+raster::occluderMesh raster::buildOccluder(const engine::mesh& mesh) {
+	raster::occluderMesh occluder;
+
+	std::span<const renderer::vertex> vertices = mesh.vertices();
+	std::span<const uint32_t> indices = mesh.indices();
+
+	if (!mesh.lods.empty()) {
+		auto found = std::find_if(mesh.lods.begin(), mesh.lods.end(), [](const renderer::meshLod& lod) {
+			return lod.indexCount / 3 <= raster::maxOccluderTriangles;
+		});
+
+		if (found == mesh.lods.end()) {
+			return occluder;
+		}
+
+		indices = indices.subspan(found->firstIndex, found->indexCount);
+	}
+	else if (indices.size() / 3 > raster::maxOccluderTriangles) {
+		return occluder;
+	}
+
+	std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+
+	occluder.indices.reserve(indices.size());
+
+	for (uint32_t index : indices) {
+		if (remap[index] == UINT32_MAX) {
+			remap[index] = static_cast<uint32_t>(occluder.positions.size());
+			occluder.positions.push_back(vertices[index].pos);
+		}
+
+		occluder.indices.push_back(remap[index]);
+	}
+
+	return occluder;
+}
+
+void raster::buildOccluders(std::span<const engine::mesh> meshes) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	raster::occluders.clear();
+	raster::occluders.resize(meshes.size());
+
+	jobs::parallelFor(meshes.size(), 1, [meshes](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			raster::occluders[i] = raster::buildOccluder(meshes[i]);
+		}
+	});
+
+	size_t count = std::count_if(raster::occluders.begin(), raster::occluders.end(), [](const raster::occluderMesh& occluder) {
+		return !occluder.indices.empty();
+	});
+
+	logger::log("Software occlusion: " + std::to_string(count) + " of " + std::to_string(meshes.size()) + " meshes can occlude (" + raster::instructionSet() + ")", 4);
+}
+
+void raster::replaceOccluder(uint32_t meshIndex, const engine::mesh& mesh) {
+	if (meshIndex >= raster::occluders.size()) {
+		raster::occluders.resize(meshIndex + 1);
+	}
+
+	raster::occluders[meshIndex] = raster::buildOccluder(mesh);
+}
+
+void raster::selectOccluders(const glm::vec3& eye) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	raster::selected.clear();
+
+	for (uint32_t objectIndex : renderer::visibleObjects) {
+		const renderer::sceneObject& object = renderer::objects[objectIndex];
+
+		if (object.mesh >= raster::occluders.size() || raster::occluders[object.mesh].indices.empty()) {
+			continue;
+		}
+
+		const renderer::meshRange& mesh = renderer::meshes[object.mesh];
+
+		glm::vec3 center = glm::vec3(object.transform * glm::vec4(mesh.boundsCenter, 1.0f));
+		float scale = std::max(glm::length(glm::vec3(object.transform[0])), std::max(glm::length(glm::vec3(object.transform[1])), glm::length(glm::vec3(object.transform[2]))));
+		float radius = mesh.boundsRadius * scale;
+
+		float size = radius / std::max(glm::length(center - eye), 0.1f);
+
+		if (size >= raster::minimumOccluderSize) {
+			raster::selected.push_back({ objectIndex, size, 0, 0 });
+		}
+	}
+
+	if (raster::selected.size() > raster::maxOccluders) {
+		std::nth_element(raster::selected.begin(), raster::selected.begin() + raster::maxOccluders, raster::selected.end(), [](const raster::selection& a, const raster::selection& b) {
+			return a.size > b.size;
+		});
+
+		raster::selected.resize(raster::maxOccluders);
+	}
+}
+
+void raster::rasterize(const glm::mat4& viewProjection) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	uint32_t vertexCount = 0;
+	uint32_t triangleCount = 0;
+
+	for (auto& selection : raster::selected) {
+		const raster::occluderMesh& occluder = raster::occluders[renderer::objects[selection.object].mesh];
+
+		selection.firstVertex = vertexCount;
+		selection.firstTriangle = triangleCount;
+
+		vertexCount += static_cast<uint32_t>(occluder.positions.size());
+		triangleCount += static_cast<uint32_t>(occluder.indices.size() / 3);
+	}
+
+	raster::clipVertices.resize(vertexCount);
+	raster::triangles.resize(triangleCount);
+	raster::depth.resize(static_cast<size_t>(raster::width) * raster::height);
+
+	raster::occluderTriangles = triangleCount;
+
+	jobs::parallelFor(raster::selected.size(), 1, [&viewProjection](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			const raster::selection& selection = raster::selected[i];
+			const renderer::sceneObject& object = renderer::objects[selection.object];
+			const raster::occluderMesh& occluder = raster::occluders[object.mesh];
+
+			glm::mat4 objectToClip = viewProjection * object.transform;
+			glm::vec4* clip = raster::clipVertices.data() + selection.firstVertex;
+
+			for (size_t j = 0; j < occluder.positions.size(); j++) {
+				clip[j] = objectToClip * glm::vec4(occluder.positions[j], 1.0f);
+			}
+
+			for (size_t j = 0; j + 2 < occluder.indices.size(); j += 3) {
+				setupTriangle(clip[occluder.indices[j]], clip[occluder.indices[j + 1]], clip[occluder.indices[j + 2]], raster::triangles[selection.firstTriangle + j / 3]);
+			}
+		}
+	});
+
+	// bands own their rows, so the depth writes never race
+	jobs::parallelFor(raster::height / raster::bandHeight, 1, [](size_t begin, size_t end) {
+		for (size_t band = begin; band < end; band++) {
+			int32_t firstRow = static_cast<int32_t>(band * raster::bandHeight);
+			int32_t lastRow = firstRow + static_cast<int32_t>(raster::bandHeight) - 1;
+
+			std::fill(raster::depth.begin() + static_cast<size_t>(firstRow) * raster::width, raster::depth.begin() + static_cast<size_t>(lastRow + 1) * raster::width, 1.0f);
+
+			for (const auto& triangle : raster::triangles) {
+				int32_t first = std::max(triangle.minimumY, firstRow);
+				int32_t last = std::min(triangle.maximumY, lastRow);
+
+				if (first <= last) {
+					rasterizeTriangle(triangle, first, last);
+				}
+			}
+		}
+	});
+}
+
+// the box is hidden when its nearest corner is behind the depth of every pixel its screen rectangle touches
+bool raster::testBox(const glm::mat4& objectToClip, const glm::vec3& minimum, const glm::vec3& extent) {
+	glm::vec2 screenMinimum(FLT_MAX);
+	glm::vec2 screenMaximum(-FLT_MAX);
+	float nearest = FLT_MAX;
+
+	for (uint32_t corner = 0; corner < 8; corner++) {
+		glm::vec3 position = minimum + extent * glm::vec3(static_cast<float>(corner & 1), static_cast<float>((corner >> 1) & 1), static_cast<float>((corner >> 2) & 1));
+		glm::vec4 clip = objectToClip * glm::vec4(position, 1.0f);
+
+		if (clip.w < minimumW || clip.z < 0.0f) {
+			return false;
+		}
+
+		glm::vec3 screen = toScreen(clip);
+
+		screenMinimum = glm::min(screenMinimum, glm::vec2(screen));
+		screenMaximum = glm::max(screenMaximum, glm::vec2(screen));
+		nearest = std::min(nearest, screen.z);
+	}
+
+	int32_t firstColumn = std::max(static_cast<int32_t>(std::floor(screenMinimum.x)), 0);
+	int32_t lastColumn = std::min(static_cast<int32_t>(std::ceil(screenMaximum.x)) - 1, static_cast<int32_t>(raster::width) - 1);
+	int32_t firstRow = std::max(static_cast<int32_t>(std::floor(screenMinimum.y)), 0);
+	int32_t lastRow = std::min(static_cast<int32_t>(std::ceil(screenMaximum.y)) - 1, static_cast<int32_t>(raster::height) - 1);
+
+	// off the buffer, the frustum test already decided
+	if (firstColumn > lastColumn || firstRow > lastRow) {
+		return false;
+	}
+
+	lanes boxDepth = splat(nearest - depthBias);
+	lanes first = splat(static_cast<float>(firstColumn));
+	lanes last = splat(static_cast<float>(lastColumn));
+
+	int32_t alignedColumn = firstColumn - firstColumn % static_cast<int32_t>(laneCount);
+
+	for (int32_t y = firstRow; y <= lastRow; y++) {
+		const float* depthRow = raster::depth.data() + static_cast<size_t>(y) * raster::width;
+
+		for (int32_t x = alignedColumn; x <= lastColumn; x += laneCount) {
+			lanes pixelX = addLanes(splat(static_cast<float>(x)), laneIndices());
+			lanes covered = bothLanes(greaterEqualLanes(pixelX, first), greaterEqualLanes(last, pixelX));
+
+			if (anyLane(bothLanes(covered, greaterEqualLanes(loadLanes(depthRow + x), boxDepth)))) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+void raster::cull(const glm::mat4& viewProjection, const glm::vec3& eye) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	raster::occluderTriangles = 0;
+	raster::occludedObjects = 0;
+	raster::rasterMilliseconds = 0.0;
+	raster::testMilliseconds = 0.0;
+
+	if (!raster::enabled || raster::occluders.empty() || renderer::visibleObjects.empty()) {
+		return;
+	}
+
+	raster::selectOccluders(eye);
+
+	if (raster::selected.empty()) {
+		return;
+	}
+
+	raster::rasterMilliseconds = benchmark::measure([&viewProjection]() {
+		raster::rasterize(viewProjection);
+	});
+
+	raster::testMilliseconds = benchmark::measure([&viewProjection]() {
+		raster::occluded.assign(renderer::visibleObjects.size(), 0);
+
+		jobs::parallelFor(renderer::visibleObjects.size(), raster::testBatchSize, [&viewProjection](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				const renderer::sceneObject& object = renderer::objects[renderer::visibleObjects[i]];
+				const renderer::meshRange& mesh = renderer::meshes[object.mesh];
+
+				raster::occluded[i] = raster::testBox(viewProjection * object.transform, mesh.boundsMinimum, mesh.boundsExtent) ? 1 : 0;
+			}
+		});
+
+		size_t write = 0;
+
+		for (size_t i = 0; i < renderer::visibleObjects.size(); i++) {
+			if (!raster::occluded[i]) {
+				renderer::visibleObjects[write++] = renderer::visibleObjects[i];
+			}
+		}
+
+		raster::occludedObjects = static_cast<uint32_t>(renderer::visibleObjects.size() - write);
+		renderer::visibleObjects.resize(write);
+	});
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+#ifndef raster_h
+#define raster_h
+
+#include "../src/engine.h"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace raster {
+	// both multiples of bandHeight and of the widest simd lane count
+	const uint32_t width = 256;
+	const uint32_t height = 144;
+	// rows one job rasterizes, every band walks all triangles and keeps the ones that touch it
+	const uint32_t bandHeight = 16;
+
+	// the finest lod under this many triangles stands in for the mesh, meshes without one never occlude
+	const uint32_t maxOccluderTriangles = 1024;
+	// the largest visible objects on screen are rasterized, up to this many
+	const uint32_t maxOccluders = 64;
+	// radius over distance, smaller objects hide too little to be worth their triangles
+	const float minimumOccluderSize = 0.05f;
+
+	const size_t testBatchSize = 64;
+
+	// object space positions and triangle list of one mesh, parallel to renderer::meshes
+	struct occluderMesh {
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t> indices;
+	};
+
+	// an object picked as occluder this frame and where its vertices and triangles start in the scratch buffers
+	struct selection {
+		uint32_t object;
+		float size;
+		uint32_t firstVertex;
+		uint32_t firstTriangle;
+	};
+
+	// screen space edge functions, a pixel centre is inside when all three are positive, depth is a plane over the triangle
+	struct triangle {
+		glm::vec3 edges[3];
+		glm::vec3 depth;
+		int32_t minimumX;
+		int32_t maximumX;
+		int32_t minimumY;
+		int32_t maximumY;
+	};
+
+	extern bool enabled;
+
+	extern std::vector<occluderMesh> occluders;
+
+	// nearest ndc depth per pixel, 1 where nothing was drawn
+	extern std::vector<float> depth;
+
+	// scratch reused every frame, objects picked as occluders, their clip space vertices and the triangles set up from them
+	extern std::vector<selection> selected;
+	extern std::vector<glm::vec4> clipVertices;
+	extern std::vector<triangle> triangles;
+	extern std::vector<uint8_t> occluded;
+
+	// from the last call to cull
+	extern uint32_t occluderTriangles;
+	extern uint32_t occludedObjects;
+	extern double rasterMilliseconds;
+	extern double testMilliseconds;
+
+	// "avx2", "sse2" or "scalar", whatever the build was compiled for
+	const char* instructionSet();
+
+	occluderMesh buildOccluder(const engine::mesh& mesh);
+
+	// renderer::loadModels, while the cpu copies of the meshes are still there
+	void buildOccluders(std::span<const engine::mesh> meshes);
+	void replaceOccluder(uint32_t meshIndex, const engine::mesh& mesh);
+
+	// the visible objects that cover the most of the screen, out of renderer::visibleObjects
+	void selectOccluders(const glm::vec3& eye);
+	void rasterize(const glm::mat4& viewProjection);
+
+	// mesh space box under the object's clip transform, true when every pixel it covers has something nearer in front of it
+	bool testBox(const glm::mat4& objectToClip, const glm::vec3& minimum, const glm::vec3& extent);
+
+	// after renderer::cullObjects, drops the hidden objects from renderer::visibleObjects
+	void cull(const glm::mat4& viewProjection, const glm::vec3& eye);
+}
+
+#endif
\ No newline at end of file
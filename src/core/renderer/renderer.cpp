@@ -2,6 +2,7 @@
 
 uint32_t renderer::currentFrame = 0;
 bool renderer::framebufferResized = false;
+bool renderer::swapChainOutdated = false;
 
 VkInstance renderer::instance;
 VkSurfaceKHR renderer::surface;
@@ -10,6 +11,13 @@ VkPhysicalDevice renderer::physicalDevice;
 VkDevice renderer::device;
 VkPhysicalDeviceProperties renderer::physicalDeviceProperties;
 VkPhysicalDeviceFeatures renderer::physicalDeviceFeatures;
+bool renderer::indirectCountSupported = false;
+bool renderer::dynamicRendering = true;
+bool renderer::synchronization2 = true;
+
+PFN_vkCmdBeginRenderingKHR renderer::cmdBeginRendering = nullptr;
+PFN_vkCmdEndRenderingKHR renderer::cmdEndRendering = nullptr;
+PFN_vkCmdPipelineBarrier2KHR renderer::cmdPipelineBarrier2 = nullptr;
 
 VkQueue renderer::graphicsQueue;
 VkQueue renderer::presentQueue;
@@ -19,15 +27,13 @@ std::vector<VkImage> renderer::swapChainImages;
 VkFormat renderer::swapChainImageFormat;
 VkExtent2D renderer::swapChainExtent;
 std::vector<VkImageView> renderer::swapChainImageViews;
-std::vector<VkFramebuffer> renderer::swapChainFramebuffers;
 
-VkShaderModule renderer::vertexShaderModule;
-VkShaderModule renderer::fragmentShaderModule;
+renderer::frameResources renderer::graphResources{};
 
 VkRenderPass renderer::renderPass;
 VkDescriptorSetLayout renderer::descriptorSetLayout;
 VkPipelineLayout renderer::pipelineLayout;
-VkPipeline renderer::graphicsPipeline;
+std::array<VkPipeline, renderer::pipelineKindCount> renderer::graphicsPipelines;
 
 VkCommandPool renderer::commandPool;
 std::vector<VkCommandBuffer> renderer::commandBuffers;
@@ -40,32 +46,43 @@ VkDeviceMemory renderer::textureImageMemory;
 VkImageView renderer::textureImageView;
 VkSampler renderer::textureSampler;
 
-VkImage renderer::depthImage;
-VkDeviceMemory renderer::depthImageMemory;
-VkImageView renderer::depthImageView;
-
 std::vector<VkSemaphore> renderer::imageAvailableSemaphores;
 std::vector<VkSemaphore> renderer::renderFinishedSemaphores;
 std::vector<VkFence> renderer::inFlightFences;
 
-const std::string modelPath1 = "assets/house/groundPlane.obj";
-const std::string modelPath2 = "assets/house/house.obj";
-const std::string texturePath = "assets/house/groundPlane.png";
+std::vector<VkDeviceMemory> renderer::offscreenImagesMemory;
+
+double renderer::gpuFrameMilliseconds = -1.0;
+
+std::string renderer::scenePath = "assets/main.scene";
+
+std::vector<std::string> renderer::models;
+std::string renderer::texturePath;
+
+std::vector<renderer::meshRange> renderer::meshes;
+std::vector<renderer::sceneObject> renderer::objects;
+std::vector<uint32_t> renderer::visibleObjects;
+uint64_t renderer::sceneVersion = 0;
 
-const std::vector<std::string> models = {
-	"assets/house/groundPlane.obj"
-};
+glm::mat4 renderer::viewProjection = glm::mat4(1.0f);
+float renderer::lodErrorPixels = 1.0f;
+uint64_t renderer::drawnTriangles = 0;
+double renderer::cullMilliseconds = 0.0;
+double renderer::recordMilliseconds = 0.0;
 
-std::vector<renderer::vertex> renderer::vertices;
-std::vector<uint32_t> renderer::indices;
+std::vector<engine::mesh> renderer::meshData;
+bool renderer::retainMeshData = false;
+uint32_t renderer::totalVertices = 0;
+uint32_t renderer::totalIndices = 0;
+
+renderer::vertexFormat renderer::requestedVertexFormat = renderer::vertexFormat::full;
+renderer::vertexFormat renderer::activeVertexFormat = renderer::vertexFormat::full;
 
 VkBuffer renderer::vertexBuffer;
 VkDeviceMemory renderer::vertexBufferMemory;
 VkBuffer renderer::indexBuffer;
 VkDeviceMemory renderer::indexBufferMemory;
-std::vector<VkBuffer> renderer::uniformBuffers;
-std::vector<VkDeviceMemory> renderer::uniformBuffersMemory;
-std::vector<void*> renderer::uniformBuffersMapped;
+uint32_t renderer::uniformOffset = 0;
 
 #ifdef NDEBUG
 	const bool renderer::validationLayersEnabled = false;
@@ -74,73 +91,652 @@ std::vector<void*> renderer::uniformBuffersMapped;
 #endif
 
 void renderer::init() {
+	BRUTAL_PROFILE_FUNCTION();
+	BRUTAL_MEMORY_SCOPE(memory::tag::renderer);
+
 	logger::log("Initializing renderer...", 4);
 
+	renderer::loadScene(renderer::scenePath);
+
+	// start reading assets on the job workers while the instance and device are created
+	filesystem::prefetch({ renderer::vertexShaderPath(renderer::requestedVertexFormat), "shaders/frag.spv", assets::resolve(renderer::texturePath) });
+
+	for (const auto& model : renderer::models) {
+		filesystem::prefetch({ assets::sourcePath(assets::resolve(model)) });
+	}
+
 	renderer::createInstance();
-	renderer::createSurface();
+
+	if (!headless::enabled) {
+		renderer::createSurface();
+	}
+
 	renderer::createDebugMessenger();
 	renderer::pickPhysicalDevice();
 	renderer::createLogicalDevice();
+	profiler::initGpu();
 	renderer::createSwapChain();
 	renderer::createImageViews();
-	renderer::createRenderPass();
+	renderer::createRenderGraph();
 	renderer::createDescriptorSetLayout();
+	// the meshes decide the vertex format, so they are loaded before the pipeline is built
+	renderer::loadModels();
 	renderer::createGraphicsPipeline();
 	renderer::createCommandPool();
-	renderer::createDepthResources();
-	renderer::createFramebuffers();
 	renderer::createTextureImage();
 	renderer::createTextureImageView();
 	renderer::createTextureSampler();
-	renderer::loadModels();
 	renderer::createModelBuffers();
-	//renderer::createVertexBuffer();
-	//renderer::createIndexBuffer();
-	renderer::createUniformBuffers();
+	arena::init();
 	renderer::createDescriptorPool();
 	renderer::createDescriptorSets();
+	cluster::init();
+	occlusion::init();
+	renderer::createRenderTargets();
 	renderer::createCommandBuffers();
 	renderer::createSyncObjects();
+
+	filesystem::clearPrefetched();
 }
 
 void renderer::mainLoop() {
 	renderer::drawFrame();
 }
 
+renderer::vertexFormat renderer::parseVertexFormat(const std::string& name) {
+	if (name == "full") {
+		return renderer::vertexFormat::full;
+	}
+
+	if (name == "compact") {
+		return renderer::vertexFormat::compact;
+	}
+
+	throw std::runtime_error("Failed to parse vertex format: " + name + " (expected full or compact)");
+}
+
+uint32_t renderer::vertexStride(vertexFormat format) {
+	switch (format) {
+		case renderer::vertexFormat::compact:
+			return sizeof(renderer::compactVertex);
+		case renderer::vertexFormat::compactColor:
+			return sizeof(renderer::compactColorVertex);
+		default:
+			return sizeof(renderer::vertex);
+	}
+}
+
+std::string renderer::vertexShaderPath(vertexFormat format) {
+	return std::string("shaders/vert") + renderer::vertexShaderVariants[static_cast<size_t>(format)].suffix + ".spv";
+}
+
+// bounding sphere around the box of the positions, good enough for culling
+static void computeBounds(std::span<const renderer::vertex> meshVertices, renderer::meshRange& range) {
+	if (meshVertices.empty()) {
+		range.boundsCenter = glm::vec3(0.0f);
+		range.boundsRadius = 0.0f;
+		range.boundsMinimum = glm::vec3(0.0f);
+		range.boundsExtent = glm::vec3(0.0f);
+		range.dequantize = glm::mat4(1.0f);
+
+		return;
+	}
+
+	glm::vec3 minimum = meshVertices[0].pos;
+	glm::vec3 maximum = meshVertices[0].pos;
+
+	for (const auto& vertex : meshVertices) {
+		minimum = glm::min(minimum, vertex.pos);
+		maximum = glm::max(maximum, vertex.pos);
+	}
+
+	range.boundsCenter = (minimum + maximum) * 0.5f;
+	range.boundsRadius = 0.0f;
+	range.boundsMinimum = minimum;
+	range.boundsExtent = maximum - minimum;
+	range.dequantize = glm::scale(glm::translate(glm::mat4(1.0f), minimum), range.boundsExtent);
+
+	for (const auto& vertex : meshVertices) {
+		range.boundsRadius = std::max(range.boundsRadius, glm::length(vertex.pos - range.boundsCenter));
+	}
+}
+
+// meshes without a chain (everything that was not baked) draw all of their indices at every distance
+static void assignLods(const engine::mesh& mesh, renderer::meshRange& range) {
+	if (mesh.lods.empty()) {
+		range.lodCount = 1;
+		range.lods[0] = { 0, static_cast<uint32_t>(mesh.indices().size()), 0.0f };
+
+		return;
+	}
+
+	range.lodCount = static_cast<uint32_t>(std::min<size_t>(mesh.lods.size(), renderer::maxLods));
+	std::copy_n(mesh.lods.begin(), range.lodCount, range.lods.begin());
+}
+
+// every scene line is an object, objects that share a model share its mesh
+// a line naming a whole gltf file becomes one object per node that has a mesh, placed at the node's world transform
+void renderer::loadScene(const std::string& scenePath) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	renderer::models.clear();
+	renderer::objects.clear();
+
+	std::unordered_map<std::string, uint32_t> meshIndices;
+	std::string materialTexture;
+
+	auto addObject = [&](const std::string& model, const glm::mat4& transform) {
+		auto found = meshIndices.find(model);
+
+		if (found == meshIndices.end()) {
+			found = meshIndices.emplace(model, static_cast<uint32_t>(renderer::models.size())).first;
+			renderer::models.push_back(model);
+		}
+
+		renderer::sceneObject object{};
+		object.mesh = found->second;
+		object.transform = transform;
+
+		renderer::objects.push_back(object);
+	};
+
+	for (const auto& entry : assets::readScene(scenePath)) {
+		glm::mat4 placement = glm::translate(glm::mat4(1.0f), entry.position);
+		size_t placed = renderer::objects.size();
+
+		if (gltf::isGltf(entry.model) && entry.model.find('#') == std::string::npos) {
+			gltf::asset file = gltf::open(entry.model);
+			std::vector<gltf::material> materials = gltf::materials(file);
+			uint32_t meshes = gltf::meshCount(file);
+
+			for (const auto& node : gltf::nodes(file)) {
+				if (node.mesh < 0 || static_cast<uint32_t>(node.mesh) >= meshes) {
+					continue;
+				}
+
+				addObject(gltf::meshPath(entry.model, static_cast<uint32_t>(node.mesh)), placement * node.transform);
+
+				// the renderer binds one texture, the first node with a textured material picks it
+				if (materialTexture.empty() && node.material >= 0 && static_cast<size_t>(node.material) < materials.size()) {
+					materialTexture = materials[node.material].baseColorTexture;
+				}
+			}
+		}
+
+		// a file without nodes is still its first mesh
+		if (renderer::objects.size() == placed) {
+			addObject(entry.model, placement);
+		}
+	}
+
+	renderer::sceneVersion++;
+
+	if (!materialTexture.empty()) {
+		renderer::texturePath = materialTexture;
+	} else {
+		std::vector<std::string> textures = assets::dependenciesOf(assets::sourcePath(renderer::models.front()), assets::assetType::texture);
+
+		if (textures.empty()) {
+			throw std::runtime_error("Failed to find a texture for model: " + renderer::models.front());
+		}
+
+		renderer::texturePath = textures.front();
+	}
+
+	logger::log("Successfully loaded scene: " + scenePath + " (" + std::to_string(renderer::models.size()) + " meshes, " + std::to_string(renderer::objects.size()) + " objects)", 1);
+}
+
+// all meshes share one vertex and one index buffer, indices stay relative to the mesh
 void renderer::loadModels() {
-	for (int i = 0; i < models.size(); i++) {
-		engine::gameObject gameObject;
+	BRUTAL_PROFILE_FUNCTION();
+
+	renderer::meshData.clear();
+	renderer::meshData.resize(renderer::models.size());
+
+	jobs::parallelFor(renderer::models.size(), 1, [](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			renderer::meshData[i] = engine::model::loadMesh(renderer::models[i]);
+		}
+	});
+
+	renderer::meshes.clear();
+	renderer::totalVertices = 0;
+	renderer::totalIndices = 0;
+
+	cluster::meshlets.clear();
+
+	for (const auto& mesh : renderer::meshData) {
+		renderer::meshRange range{};
+		range.firstIndex = renderer::totalIndices;
+		range.indexCount = static_cast<uint32_t>(mesh.indices().size());
+		range.vertexOffset = static_cast<int32_t>(renderer::totalVertices);
+		range.vertexCount = static_cast<uint32_t>(mesh.vertices().size());
+
+		computeBounds(mesh.vertices(), range);
+		assignLods(mesh, range);
+
+		range.firstMeshlet = static_cast<uint32_t>(cluster::meshlets.size());
+		range.meshletCount = static_cast<uint32_t>(mesh.meshlets.size());
+		cluster::meshlets.insert(cluster::meshlets.end(), mesh.meshlets.begin(), mesh.meshlets.end());
+
+		renderer::totalVertices += range.vertexCount;
+		renderer::totalIndices += range.indexCount;
+
+		renderer::meshes.push_back(range);
+	}
+
+	raster::buildOccluders(renderer::meshData);
+
+	renderer::sceneVersion++;
+
+	renderer::activeVertexFormat = renderer::requestedVertexFormat;
+
+	if (renderer::requestedVertexFormat == renderer::vertexFormat::compact) {
+		bool colored = std::any_of(renderer::meshData.begin(), renderer::meshData.end(), [](const engine::mesh& mesh) {
+			return quantize::hasVertexColors(mesh.vertices());
+		});
+
+		if (colored) {
+			renderer::activeVertexFormat = renderer::vertexFormat::compactColor;
+		}
+	}
+
+	// the compact variants are compiled separately, a checkout without them still runs with the full format
+	if (renderer::activeVertexFormat != renderer::vertexFormat::full && !filesystem::exists(renderer::vertexShaderPath(renderer::activeVertexFormat))) {
+		logger::log("Missing " + renderer::vertexShaderPath(renderer::activeVertexFormat) + ", falling back to the full vertex format", 2);
+
+		renderer::activeVertexFormat = renderer::vertexFormat::full;
+	}
+
+	logger::log("Vertex format: " + std::to_string(renderer::vertexStride(renderer::activeVertexFormat)) + " bytes per vertex", 4);
+}
+
+// meshes are written straight into the staging memory, the cpu copies go away once they are on the gpu
+void renderer::createModelBuffers() {
+	BRUTAL_PROFILE_FUNCTION();
+
+	if (renderer::totalIndices == 0) {
+		throw std::runtime_error("Failed to create model buffers, scene is empty!");
+	}
+
+	VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	uint32_t stride = renderer::vertexStride(renderer::activeVertexFormat);
+
+	// the compact formats are encoded per mesh on the job workers
+	renderer::uploadBuffer(static_cast<VkDeviceSize>(stride) * renderer::totalVertices, usage | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, [stride](char* destination) {
+		jobs::parallelFor(renderer::meshData.size(), 1, [destination, stride](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				const renderer::meshRange& range = renderer::meshes[i];
+				quantize::encodeVertices(renderer::activeVertexFormat, renderer::meshData[i].vertices(), renderer::meshData[i].indices().first(range.lods[0].indexCount), range.boundsMinimum, range.boundsExtent, destination + static_cast<size_t>(stride) * range.vertexOffset);
+			}
+		});
+	}, renderer::vertexBuffer, renderer::vertexBufferMemory);
+
+	// the cluster culling pass reads the indices as a storage buffer
+	renderer::uploadBuffer(sizeof(uint32_t) * renderer::totalIndices, usage | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, [](char* destination) {
+		for (size_t i = 0; i < renderer::meshData.size(); i++) {
+			std::span<const uint32_t> indices = renderer::meshData[i].indices();
+			memcpy(destination + sizeof(uint32_t) * renderer::meshes[i].firstIndex, indices.data(), indices.size_bytes());
+		}
+	}, renderer::indexBuffer, renderer::indexBufferMemory);
+
+	if (!renderer::retainMeshData) {
+		for (auto& mesh : renderer::meshData) {
+			mesh.release();
+		}
+	}
+
+	logger::log("Successfully created model buffers!", 1);
+}
+
+// rebuilds the shared buffers on the gpu, the ranges around the mesh are copied from the old buffers and only the mesh itself is staged
+static std::function<void()> spliceMesh(uint32_t meshIndex, engine::mesh& mesh) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	renderer::meshRange& range = renderer::meshes[meshIndex];
+
+	uint32_t vertexCount = static_cast<uint32_t>(mesh.vertices().size());
+	uint32_t indexCount = static_cast<uint32_t>(mesh.indices().size());
+
+	uint32_t vertexEnd = static_cast<uint32_t>(range.vertexOffset) + range.vertexCount;
+	uint32_t indexEnd = range.firstIndex + range.indexCount;
+
+	uint32_t totalVertices = renderer::totalVertices - range.vertexCount + vertexCount;
+	uint32_t totalIndices = renderer::totalIndices - range.indexCount + indexCount;
+
+	VkDeviceSize vertexStride = renderer::vertexStride(renderer::activeVertexFormat);
+	VkDeviceSize indexStride = sizeof(uint32_t);
+
+	VkDeviceSize vertexSize = vertexStride * vertexCount;
+	VkDeviceSize indexSize = indexStride * indexCount;
+
+	// the pipeline's layout is fixed, colors that arrive after the scene was loaded without them are lost
+	if (renderer::activeVertexFormat == renderer::vertexFormat::compact && quantize::hasVertexColors(mesh.vertices())) {
+		logger::log("Dropping vertex colors of " + mesh.path + ", the scene was loaded without them", 2);
+	}
+
+	// the new bounds are needed to quantize the mesh
+	computeBounds(mesh.vertices(), range);
+	assignLods(mesh, range);
+
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingBufferMemory;
+
+	renderer::createBuffer(vertexSize + indexSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+
+	void* data;
+	vkMapMemory(renderer::device, stagingBufferMemory, 0, vertexSize + indexSize, 0, &data);
+	quantize::encodeVertices(renderer::activeVertexFormat, mesh.vertices(), mesh.indices().first(range.lods[0].indexCount), range.boundsMinimum, range.boundsExtent, static_cast<char*>(data));
+	memcpy(static_cast<char*>(data) + vertexSize, mesh.indices().data(), static_cast<size_t>(indexSize));
+	vkUnmapMemory(renderer::device, stagingBufferMemory);
+
+	VkBuffer vertexBuffer;
+	VkDeviceMemory vertexBufferMemory;
+	VkBuffer indexBuffer;
+	VkDeviceMemory indexBufferMemory;
+
+	renderer::createBuffer(vertexStride * totalVertices, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer, vertexBufferMemory);
+	renderer::createBuffer(indexStride * totalIndices, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, indexBufferMemory);
+
+	VkCommandBuffer commandBuffer = renderer::beginSingleTimeCommands(__func__);
+
+	// before the mesh, the mesh itself, after the mesh, empty regions are skipped
+	auto copy = [commandBuffer](VkBuffer source, VkBuffer destination, VkDeviceSize sourceOffset, VkDeviceSize destinationOffset, VkDeviceSize size) {
+		if (size == 0 || source == VK_NULL_HANDLE) {
+			return;
+		}
+
+		VkBufferCopy copyRegion{};
+		copyRegion.srcOffset = sourceOffset;
+		copyRegion.dstOffset = destinationOffset;
+		copyRegion.size = size;
+		vkCmdCopyBuffer(commandBuffer, source, destination, 1, &copyRegion);
+	};
+
+	copy(renderer::vertexBuffer, vertexBuffer, 0, 0, vertexStride * range.vertexOffset);
+	copy(stagingBuffer, vertexBuffer, 0, vertexStride * range.vertexOffset, vertexSize);
+	copy(renderer::vertexBuffer, vertexBuffer, vertexStride * vertexEnd, vertexStride * range.vertexOffset + vertexSize, vertexStride * (renderer::totalVertices - vertexEnd));
+
+	copy(renderer::indexBuffer, indexBuffer, 0, 0, indexStride * range.firstIndex);
+	copy(stagingBuffer, indexBuffer, vertexSize, indexStride * range.firstIndex, indexSize);
+	copy(renderer::indexBuffer, indexBuffer, indexStride * indexEnd, indexStride * range.firstIndex + indexSize, indexStride * (renderer::totalIndices - indexEnd));
+
+	renderer::endSingleTimeCommands(commandBuffer);
+
+	vkDestroyBuffer(renderer::device, stagingBuffer, nullptr);
+	memory::freeDevice(stagingBufferMemory);
+
+	int64_t vertexDelta = static_cast<int64_t>(vertexCount) - range.vertexCount;
+	int64_t indexDelta = static_cast<int64_t>(indexCount) - range.indexCount;
+
+	for (auto& other : renderer::meshes) {
+		if (&other != &range && other.firstIndex >= indexEnd) {
+			other.firstIndex = static_cast<uint32_t>(other.firstIndex + indexDelta);
+			other.vertexOffset = static_cast<int32_t>(other.vertexOffset + vertexDelta);
+		}
+	}
+
+	range.vertexCount = vertexCount;
+	range.indexCount = indexCount;
+
+	renderer::totalVertices = totalVertices;
+	renderer::totalIndices = totalIndices;
+
+	renderer::sceneVersion++;
+
+	std::function<void()> destroyMeshlets = cluster::replaceMeshlets(meshIndex, mesh.meshlets);
+	raster::replaceOccluder(meshIndex, mesh);
+
+	VkBuffer oldVertexBuffer = renderer::vertexBuffer;
+	VkDeviceMemory oldVertexBufferMemory = renderer::vertexBufferMemory;
+	VkBuffer oldIndexBuffer = renderer::indexBuffer;
+	VkDeviceMemory oldIndexBufferMemory = renderer::indexBufferMemory;
+
+	renderer::vertexBuffer = vertexBuffer;
+	renderer::vertexBufferMemory = vertexBufferMemory;
+	renderer::indexBuffer = indexBuffer;
+	renderer::indexBufferMemory = indexBufferMemory;
+
+	if (renderer::retainMeshData) {
+		renderer::meshData[meshIndex] = std::move(mesh);
+	}
+
+	return [oldVertexBuffer, oldVertexBufferMemory, oldIndexBuffer, oldIndexBufferMemory, destroyMeshlets]() {
+		destroyMeshlets();
+
+		if (oldVertexBuffer != VK_NULL_HANDLE) {
+			vkDestroyBuffer(renderer::device, oldVertexBuffer, nullptr);
+			memory::freeDevice(oldVertexBufferMemory);
+		}
+
+		if (oldIndexBuffer != VK_NULL_HANDLE) {
+			vkDestroyBuffer(renderer::device, oldIndexBuffer, nullptr);
+			memory::freeDevice(oldIndexBufferMemory);
+		}
+	};
+}
+
+std::function<void()> renderer::replaceMesh(const std::string& modelPath, engine::mesh&& mesh) {
+	auto found = std::find(renderer::models.begin(), renderer::models.end(), modelPath);
+
+	if (found == renderer::models.end()) {
+		throw std::runtime_error("Failed to replace mesh, not in scene: " + modelPath);
+	}
+
+	if (mesh.empty()) {
+		throw std::runtime_error("Failed to replace mesh, model is empty: " + modelPath);
+	}
+
+	return spliceMesh(static_cast<uint32_t>(found - renderer::models.begin()), mesh);
+}
+
+std::function<void()> renderer::appendMesh(engine::mesh&& mesh, uint32_t& meshIndex) {
+	if (mesh.empty()) {
+		throw std::runtime_error("Failed to append mesh, model is empty: " + mesh.path);
+	}
+
+	renderer::meshRange range{};
+	range.firstIndex = renderer::totalIndices;
+	range.vertexOffset = static_cast<int32_t>(renderer::totalVertices);
+	range.firstMeshlet = static_cast<uint32_t>(cluster::meshlets.size());
+
+	meshIndex = static_cast<uint32_t>(renderer::meshes.size());
+
+	renderer::models.push_back(mesh.path);
+	renderer::meshes.push_back(range);
+	renderer::meshData.emplace_back();
+
+	return spliceMesh(meshIndex, mesh);
+}
+
+// gribb/hartmann planes, depth is zero to one so the near plane is the third row alone
+void renderer::frustumPlanes(const glm::mat4& viewProjection, std::array<glm::vec4, 6>& planes) {
+	glm::vec4 rows[4];
+
+	for (int i = 0; i < 4; i++) {
+		rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+	}
+
+	planes = {
+		rows[3] + rows[0],
+		rows[3] - rows[0],
+		rows[3] + rows[1],
+		rows[3] - rows[1],
+		rows[2],
+		rows[3] - rows[2]
+	};
+
+	for (auto& plane : planes) {
+		plane /= glm::length(glm::vec3(plane));
+	}
+}
+
+void renderer::cullObjects(const glm::mat4& viewProjection) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	std::array<glm::vec4, 6> planes;
+	renderer::frustumPlanes(viewProjection, planes);
+
+	renderer::visibleObjects.clear();
+
+	for (uint32_t i = 0; i < static_cast<uint32_t>(renderer::objects.size()); i++) {
+		const renderer::sceneObject& object = renderer::objects[i];
+		const renderer::meshRange& mesh = renderer::meshes[object.mesh];
+
+		glm::vec3 center = glm::vec3(object.transform * glm::vec4(mesh.boundsCenter, 1.0f));
+		float scale = std::max(glm::length(glm::vec3(object.transform[0])), std::max(glm::length(glm::vec3(object.transform[1])), glm::length(glm::vec3(object.transform[2]))));
+		float radius = mesh.boundsRadius * scale;
+
+		bool visible = true;
+
+		for (const auto& plane : planes) {
+			if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+				visible = false;
+				break;
+			}
+		}
 
-		gameObject.createGameObject(models[i]);
+		if (visible) {
+			renderer::visibleObjects.push_back(i);
+		}
+	}
+}
+
+// the projected error is the lod's error over the distance to the nearest point of the bounding sphere, in pixels at the centre of the screen
+void renderer::selectLods(const glm::vec3& eye, float viewportHeight) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	float pixelsPerUnit = viewportHeight / (2.0f * std::tan(camera::getFOV() * 0.5f));
+
+	renderer::drawnTriangles = 0;
+
+	for (uint32_t objectIndex : renderer::visibleObjects) {
+		renderer::sceneObject& object = renderer::objects[objectIndex];
+		const renderer::meshRange& mesh = renderer::meshes[object.mesh];
+
+		uint32_t lod = std::min(object.lod, mesh.lodCount - 1);
+
+		if (renderer::lodErrorPixels <= 0.0f) {
+			lod = 0;
+		}
+		else if (mesh.lodCount > 1) {
+			glm::vec3 center = glm::vec3(object.transform * glm::vec4(mesh.boundsCenter, 1.0f));
+			float scale = std::max(glm::length(glm::vec3(object.transform[0])), std::max(glm::length(glm::vec3(object.transform[1])), glm::length(glm::vec3(object.transform[2]))));
+
+			// inside the sphere the distance is clamped to the near plane
+			float distance = std::max(glm::length(center - eye) - mesh.boundsRadius * scale, 0.1f);
+			float pixelsPerError = scale * pixelsPerUnit / distance;
+
+			while (lod > 0 && mesh.lods[lod].error * pixelsPerError > renderer::lodErrorPixels) {
+				lod--;
+			}
+
+			while (lod + 1 < mesh.lodCount && mesh.lods[lod + 1].error * pixelsPerError < renderer::lodErrorPixels * (1.0f - renderer::lodHysteresis)) {
+				lod++;
+			}
+		}
+
+		object.lod = lod;
+		renderer::drawnTriangles += mesh.lods[lod].indexCount / 3;
+	}
+}
+
+glm::mat4 renderer::drawTransform(const sceneObject& object, const meshRange& mesh) {
+	if (renderer::activeVertexFormat == renderer::vertexFormat::full) {
+		return object.transform;
 	}
+
+	return object.transform * mesh.dequantize;
+}
+
+glm::mat4 renderer::projectionMatrix(float aspectRatio) {
+	glm::mat4 projection = glm::perspective(camera::getFOV(), aspectRatio, renderer::nearPlane, renderer::farPlane);
+	projection[1][1] *= -1;
+
+	return projection;
 }
 
 void renderer::drawFrame() {
-	vkWaitForFences(renderer::device, 1, &renderer::inFlightFences[renderer::currentFrame], VK_TRUE, UINT64_MAX);
+	BRUTAL_PROFILE_FUNCTION();
+	BRUTAL_MEMORY_SCOPE(memory::tag::renderer);
+
+	{
+		BRUTAL_PROFILE_ZONE("waitForFence");
+
+		vkWaitForFences(renderer::device, 1, &renderer::inFlightFences[renderer::currentFrame], VK_TRUE, UINT64_MAX);
+	}
+
+	// the slot's previous frame has finished, its timestamps are read without stalling
+	renderer::gpuFrameMilliseconds = profiler::collectGpuSlice(renderer::currentFrame);
+	cluster::collect(renderer::currentFrame);
+	occlusion::collect(renderer::currentFrame);
+
+	arena::beginFrame(renderer::currentFrame);
+
+	// this frame's previous submission is done, reloaded resources can be swapped in
+	deletion::beginFrame(renderer::currentFrame);
+	hotreload::update();
 
 	uint32_t imageIndex;
-	VkResult result = vkAcquireNextImageKHR(renderer::device, renderer::swapChain, UINT64_MAX, renderer::imageAvailableSemaphores[renderer::currentFrame], VK_NULL_HANDLE, &imageIndex);
 
-	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized) {
-		renderer::recreateSwapChain();
-		return;
+	// offscreen targets belong to a frame in flight, there is nothing to acquire
+	if (headless::enabled) {
+		imageIndex = renderer::currentFrame;
 	}
-	else if (result != VK_SUCCESS) {
-		throw std::runtime_error("Failed to acquire swapchain image!");
+	else {
+		// before acquiring, so a skipped frame leaves no semaphore signaled
+		if ((renderer::framebufferResized || renderer::swapChainOutdated) && !renderer::recreateSwapChain()) {
+			SDL_WaitEventTimeout(nullptr, renderer::minimizedWaitMilliseconds);
+			return;
+		}
+
+		BRUTAL_PROFILE_ZONE("acquireNextImage");
+
+		VkResult result = vkAcquireNextImageKHR(renderer::device, renderer::swapChain, UINT64_MAX, renderer::imageAvailableSemaphores[renderer::currentFrame], VK_NULL_HANDLE, &imageIndex);
+
+		// nothing was acquired, next frame recreates it
+		if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+			renderer::swapChainOutdated = true;
+			return;
+		}
+		// the image is still presentable, this frame uses it
+		else if (result == VK_SUBOPTIMAL_KHR) {
+			renderer::swapChainOutdated = true;
+		}
+		else if (result != VK_SUCCESS) {
+			throw std::runtime_error("Failed to acquire swapchain image!");
+		}
 	}
 
 	renderer::updateUniformBuffer(renderer::currentFrame);
 
-	renderer::recordCommandBuffer(renderer::commandBuffers[renderer::currentFrame], imageIndex);
+	// the gpu culls and picks lods itself, nothing is drawn from visibleObjects then, without it the software rasterizer hides what it can
+	if (occlusion::active()) {
+		renderer::visibleObjects.clear();
+		renderer::cullMilliseconds = 0.0;
+	}
+	else {
+		renderer::cullMilliseconds = benchmark::measure([]() {
+			renderer::cullObjects(renderer::viewProjection);
+			raster::cull(renderer::viewProjection, camera::camera.eye);
+			renderer::selectLods(camera::camera.eye, static_cast<float>(renderer::swapChainExtent.height));
+		});
+	}
+
+	renderer::recordMilliseconds = benchmark::measure([imageIndex]() {
+		renderer::recordCommandBuffer(renderer::commandBuffers[renderer::currentFrame], imageIndex);
+	});
 
 	vkResetFences(renderer::device, 1, &renderer::inFlightFences[renderer::currentFrame]);
 
+	BRUTAL_PROFILE_ZONE("submitAndPresent");
+
 	VkSubmitInfo submitInfo{};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
 	VkSemaphore waitSemaphores[] = {renderer::imageAvailableSemaphores[renderer::currentFrame]};
 	VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-	submitInfo.waitSemaphoreCount = 1;
+	submitInfo.waitSemaphoreCount = headless::enabled ? 0 : 1;
 	submitInfo.pWaitSemaphores = waitSemaphores;
 
 	submitInfo.pWaitDstStageMask = waitStages;
@@ -148,13 +744,20 @@ void renderer::drawFrame() {
 	submitInfo.pCommandBuffers = &renderer::commandBuffers[renderer::currentFrame];
 
 	VkSemaphore signalSemaphores[] = {renderer::renderFinishedSemaphores[renderer::currentFrame]};
-	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.signalSemaphoreCount = headless::enabled ? 0 : 1;
 	submitInfo.pSignalSemaphores = signalSemaphores;
 	
 	if (vkQueueSubmit(renderer::graphicsQueue, 1, &submitInfo, renderer::inFlightFences[renderer::currentFrame]) != VK_SUCCESS) {
 		throw std::runtime_error("Failed to submit draw command buffer!");
 	}
 
+	deletion::endFrame(renderer::currentFrame);
+
+	if (headless::enabled) {
+		renderer::currentFrame = (renderer::currentFrame + 1) % renderer::maxFramesInFlight;
+		return;
+	}
+
 	VkPresentInfoKHR presentInfo{};
 	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 	presentInfo.waitSemaphoreCount = 1;
@@ -167,7 +770,11 @@ void renderer::drawFrame() {
 	presentInfo.pImageIndices = &imageIndex;
 	presentInfo.pResults = nullptr;
 
-	vkQueuePresentKHR(renderer::presentQueue, &presentInfo);
+	VkResult presentResult = vkQueuePresentKHR(renderer::presentQueue, &presentInfo);
+
+	if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR) {
+		renderer::swapChainOutdated = true;
+	}
 
 	renderer::currentFrame = (renderer::currentFrame + 1) % renderer::maxFramesInFlight;
 }
@@ -181,33 +788,66 @@ void renderer::updateUniformBuffer(uint32_t currentImage) {
 	uniformBufferObject ubo{};
 	ubo.model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.0f));
 	ubo.view = camera::getView();
-	ubo.proj = glm::perspective(camera::getFOV(), renderer::swapChainExtent.width / (float)renderer::swapChainExtent.height, 0.1f, 100.0f);
-	ubo.proj[1][1] *= -1;
+	ubo.proj = renderer::projectionMatrix(renderer::swapChainExtent.width / (float)renderer::swapChainExtent.height);
+
+	renderer::viewProjection = ubo.proj * ubo.view * ubo.model;
 
-	memcpy(renderer::uniformBuffersMapped[currentImage], &ubo, sizeof(ubo));
+	arena::gpuAllocation allocation = arena::allocateGpu(sizeof(ubo));
+	memcpy(allocation.mapped, &ubo, sizeof(ubo));
+
+	renderer::uniformOffset = static_cast<uint32_t>(allocation.offset);
 }
 
-void renderer::recreateSwapChain() {
-	logger::log("Recreating swapchain...", 4);
-	
-	int width = 0, height = 0;
+bool renderer::recreateSwapChain() {
+	BRUTAL_PROFILE_FUNCTION();
 
+	int width = 0, height = 0;
 	SDL_Vulkan_GetDrawableSize(engine::window, &width, &height);
-	while (width == 0 || height == 0) {
-		SDL_Vulkan_GetDrawableSize(engine::window, &width, &height);
-		SDL_WaitEvent(&engine::event);
+
+	if (width == 0 || height == 0 || (SDL_GetWindowFlags(engine::window) & SDL_WINDOW_MINIMIZED) != 0) {
+		return false;
 	}
 
-	vkDeviceWaitIdle(renderer::device);
+	VkExtent2D previousExtent = renderer::swapChainExtent;
+	bool resized = previousExtent.width != static_cast<uint32_t>(width) || previousExtent.height != static_cast<uint32_t>(height);
 
-	renderer::cleanupSwapChain();
+	// a burst of resize events settles on the size the swapchain already has
+	if (!resized && !renderer::swapChainOutdated) {
+		renderer::framebufferResized = false;
+		return true;
+	}
 
-	renderer::createSwapChain();
+	logger::log("Recreating swapchain...", 4);
+
+	// the frames in flight still present from and draw into the old images, their views and the graph's framebuffers
+	VkSwapchainKHR oldSwapChain = renderer::swapChain;
+	std::vector<VkImageView> oldImageViews = std::move(renderer::swapChainImageViews);
+
+	renderer::createSwapChain(oldSwapChain);
 	renderer::createImageViews();
-	renderer::createDepthResources();
-	renderer::createFramebuffers();
+
+	// the graph's transient depth buffer is kept when the extent stays
+	graph::retireTargets(renderer::swapChainExtent);
+
+	for (VkImageView view : oldImageViews) {
+		deletion::retireImageView(view);
+	}
+
+	deletion::retireSwapchain(oldSwapChain);
+
+	// the surface can report an extent other than the drawable size, the pyramid follows the swapchain like the depth buffer
+	if (renderer::swapChainExtent.width != previousExtent.width || renderer::swapChainExtent.height != previousExtent.height) {
+		occlusion::resize();
+	}
+
+	renderer::createRenderTargets();
+
+	renderer::framebufferResized = false;
+	renderer::swapChainOutdated = false;
 
 	logger::log("Successfully recreated swapchain!", 1);
+
+	return true;
 }
 
 void renderer::createSurface() {
@@ -220,6 +860,8 @@ void renderer::createSurface() {
 }
 
 void renderer::createInstance() {
+	BRUTAL_PROFILE_FUNCTION();
+
 	if (renderer::validationLayersEnabled && !renderer::checkValidationLayerSupport()) {
 		throw std::runtime_error("Validation layers requested, but not available");
 	}
@@ -263,6 +905,8 @@ void renderer::createInstance() {
 }
 
 void renderer::pickPhysicalDevice() {
+	BRUTAL_PROFILE_FUNCTION();
+
 	uint32_t physicalDeviceCount = 0;
 
 	vkEnumeratePhysicalDevices(renderer::instance, &physicalDeviceCount, nullptr);
@@ -278,7 +922,9 @@ void renderer::pickPhysicalDevice() {
 		if (renderer::physicalDeviceSuitable(physicalDevice)) {
 			renderer::physicalDevice = physicalDevice;
 
-			logger::log(std::string("Successfully located physical device: ") + physicalDeviceProperties.deviceName, 1);
+			vkGetPhysicalDeviceProperties(physicalDevice, &renderer::physicalDeviceProperties);
+
+			logger::log(std::string("Successfully located physical device: ") + renderer::physicalDeviceProperties.deviceName, 1);
 
 			break;
 		}
@@ -292,6 +938,14 @@ void renderer::pickPhysicalDevice() {
 bool renderer::physicalDeviceSuitable(VkPhysicalDevice physicalDevice) {
 	queueFamilyIndices indices = renderer::findQueueFamilies(physicalDevice);
 
+	VkPhysicalDeviceFeatures supportedFeatures;
+	vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
+	// no surface to present to, any graphics queue will do (lavapipe, swiftshader)
+	if (headless::enabled) {
+		return indices.isComplete() && supportedFeatures.samplerAnisotropy;
+	}
+
 	bool extensionsSupported = renderer::checkDeviceExtensionSupport(physicalDevice);
 
 	bool swapChainAdequate = false;
@@ -301,9 +955,6 @@ bool renderer::physicalDeviceSuitable(VkPhysicalDevice physicalDevice) {
 		swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
 	}
 
-	VkPhysicalDeviceFeatures supportedFeatures;
-	vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
-
 	return indices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy;
 }
 
@@ -341,7 +992,13 @@ renderer::queueFamilyIndices renderer::findQueueFamilies(VkPhysicalDevice physic
 		}
 
 		VkBool32 presentSupport = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, renderer::surface, &presentSupport);
+
+		if (headless::enabled) {
+			presentSupport = indices.graphicsFamily.has_value();
+		}
+		else {
+			vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, renderer::surface, &presentSupport);
+		}
 
 		if (presentSupport) {
 			indices.presentFamily = i;
@@ -359,7 +1016,25 @@ renderer::queueFamilyIndices renderer::findQueueFamilies(VkPhysicalDevice physic
 	return indices;
 }
 
+static bool deviceExtensionAvailable(const char* name) {
+	uint32_t extensionCount;
+	vkEnumerateDeviceExtensionProperties(renderer::physicalDevice, nullptr, &extensionCount, nullptr);
+
+	std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+	vkEnumerateDeviceExtensionProperties(renderer::physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+
+	for (const auto& extension : availableExtensions) {
+		if (strcmp(extension.extensionName, name) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 void renderer::createLogicalDevice() {
+	BRUTAL_PROFILE_FUNCTION();
+
 	renderer::queueFamilyIndices indices = renderer::findQueueFamilies(renderer::physicalDevice);
 
 	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
@@ -375,17 +1050,112 @@ void renderer::createLogicalDevice() {
 		queueCreateInfos.push_back(queueCreateInfo);
 	}
 
+	vkGetPhysicalDeviceFeatures(renderer::physicalDevice, &renderer::physicalDeviceFeatures);
+
+	bool core13 = renderer::physicalDeviceProperties.apiVersion >= VK_API_VERSION_1_3;
+
+	VkPhysicalDeviceVulkan12Features supportedFeatures12{};
+	supportedFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+	VkPhysicalDeviceVulkan13Features supportedFeatures13{};
+	supportedFeatures13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+
+	VkPhysicalDeviceDynamicRenderingFeatures supportedDynamicRendering{};
+	supportedDynamicRendering.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+
+	VkPhysicalDeviceSynchronization2Features supportedSynchronization2{};
+	supportedSynchronization2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES;
+
+	// before 1.3 both come from their khr extensions, which still need a 1.2 device to query them
+	if (renderer::physicalDeviceProperties.apiVersion >= VK_API_VERSION_1_2) {
+		VkPhysicalDeviceFeatures2 supportedFeatures{};
+		supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supportedFeatures.pNext = &supportedFeatures12;
+
+		if (core13) {
+			supportedFeatures12.pNext = &supportedFeatures13;
+		}
+		else {
+			if (deviceExtensionAvailable(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)) {
+				supportedDynamicRendering.pNext = supportedFeatures12.pNext;
+				supportedFeatures12.pNext = &supportedDynamicRendering;
+			}
+
+			if (deviceExtensionAvailable(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME)) {
+				supportedSynchronization2.pNext = supportedFeatures12.pNext;
+				supportedFeatures12.pNext = &supportedSynchronization2;
+			}
+		}
+
+		vkGetPhysicalDeviceFeatures2(renderer::physicalDevice, &supportedFeatures);
+	}
+
+	renderer::indirectCountSupported = supportedFeatures12.drawIndirectCount && renderer::physicalDeviceFeatures.multiDrawIndirect && renderer::physicalDeviceFeatures.drawIndirectFirstInstance;
+	renderer::dynamicRendering = renderer::dynamicRendering && (core13 ? supportedFeatures13.dynamicRendering : supportedDynamicRendering.dynamicRendering);
+	renderer::synchronization2 = renderer::synchronization2 && (core13 ? supportedFeatures13.synchronization2 : supportedSynchronization2.synchronization2);
+
 	VkPhysicalDeviceFeatures deviceFeatures{};
 	deviceFeatures.samplerAnisotropy = VK_TRUE;
+	deviceFeatures.multiDrawIndirect = renderer::indirectCountSupported;
+	deviceFeatures.drawIndirectFirstInstance = renderer::indirectCountSupported;
+
+	VkPhysicalDeviceVulkan12Features deviceFeatures12{};
+	deviceFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	deviceFeatures12.drawIndirectCount = renderer::indirectCountSupported;
+
+	VkPhysicalDeviceVulkan13Features deviceFeatures13{};
+	deviceFeatures13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+	deviceFeatures13.dynamicRendering = renderer::dynamicRendering;
+	deviceFeatures13.synchronization2 = renderer::synchronization2;
+
+	VkPhysicalDeviceDynamicRenderingFeatures deviceDynamicRendering{};
+	deviceDynamicRendering.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+	deviceDynamicRendering.dynamicRendering = VK_TRUE;
+
+	VkPhysicalDeviceSynchronization2Features deviceSynchronization2{};
+	deviceSynchronization2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES;
+	deviceSynchronization2.synchronization2 = VK_TRUE;
+
+	std::vector<const char*> enabledExtensions;
+
+	if (!headless::enabled) {
+		enabledExtensions.assign(renderer::deviceExtensions.begin(), renderer::deviceExtensions.end());
+	}
+
+	// every enabled feature struct is put in front of the chain
+	void* featureChain = nullptr;
+
+	if (core13 && (renderer::dynamicRendering || renderer::synchronization2)) {
+		deviceFeatures13.pNext = featureChain;
+		featureChain = &deviceFeatures13;
+	}
+
+	if (!core13 && renderer::dynamicRendering) {
+		deviceDynamicRendering.pNext = featureChain;
+		featureChain = &deviceDynamicRendering;
+		enabledExtensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+	}
+
+	if (!core13 && renderer::synchronization2) {
+		deviceSynchronization2.pNext = featureChain;
+		featureChain = &deviceSynchronization2;
+		enabledExtensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+	}
+
+	if (renderer::indirectCountSupported) {
+		deviceFeatures12.pNext = featureChain;
+		featureChain = &deviceFeatures12;
+	}
 
 	VkDeviceCreateInfo deviceCreateInfo{};
 	deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	deviceCreateInfo.pNext = featureChain;
 	deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();
 	deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 	deviceCreateInfo.pEnabledFeatures = &deviceFeatures;
 
-	deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(renderer::deviceExtensions.size());
-	deviceCreateInfo.ppEnabledExtensionNames = renderer::deviceExtensions.data();
+	deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+	deviceCreateInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
 	if (renderer::validationLayersEnabled) {
 		deviceCreateInfo.enabledLayerCount = static_cast<uint32_t>(renderer::validationLayers.size());
@@ -404,6 +1174,23 @@ void renderer::createLogicalDevice() {
 
 	vkGetDeviceQueue(renderer::device, indices.graphicsFamily.value(), 0, &renderer::graphicsQueue);
 	vkGetDeviceQueue(renderer::device, indices.presentFamily.value(), 0, &renderer::presentQueue);
+
+	if (renderer::dynamicRendering) {
+		renderer::cmdBeginRendering = (PFN_vkCmdBeginRenderingKHR)vkGetDeviceProcAddr(renderer::device, core13 ? "vkCmdBeginRendering" : "vkCmdBeginRenderingKHR");
+		renderer::cmdEndRendering = (PFN_vkCmdEndRenderingKHR)vkGetDeviceProcAddr(renderer::device, core13 ? "vkCmdEndRendering" : "vkCmdEndRenderingKHR");
+
+		renderer::dynamicRendering = renderer::cmdBeginRendering != nullptr && renderer::cmdEndRendering != nullptr;
+	}
+
+	if (renderer::synchronization2) {
+		renderer::cmdPipelineBarrier2 = (PFN_vkCmdPipelineBarrier2KHR)vkGetDeviceProcAddr(renderer::device, core13 ? "vkCmdPipelineBarrier2" : "vkCmdPipelineBarrier2KHR");
+
+		renderer::synchronization2 = renderer::cmdPipelineBarrier2 != nullptr;
+	}
+
+	std::string source = core13 ? "vulkan 1.3" : "extensions";
+
+	logger::log(std::string("Dynamic rendering ") + (renderer::dynamicRendering ? "from " + source : "off, using render passes") + ", synchronization2 " + (renderer::synchronization2 ? "from " + source : "off, using legacy barriers"), 4);
 }
 
 renderer::swapChainSupportDetails renderer::querySwapChainSupport(VkPhysicalDevice physicalDevice) {
@@ -471,7 +1258,14 @@ VkExtent2D renderer::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabiliti
 	}
 }
 
-void renderer::createSwapChain() {
+void renderer::createSwapChain(VkSwapchainKHR oldSwapChain) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	if (headless::enabled) {
+		renderer::createOffscreenTargets();
+		return;
+	}
+
 	renderer::swapChainSupportDetails swapChainSupport = renderer::querySwapChainSupport(renderer::physicalDevice);
 
 	VkSurfaceFormatKHR surfaceFormat = renderer::chooseSwapSurfaceFormat(swapChainSupport.formats);
@@ -508,103 +1302,182 @@ void renderer::createSwapChain() {
 		createInfo.pQueueFamilyIndices = nullptr;
 	}
 
-	createInfo.preTransform = swapChainSupport.capabilities.currentTransform;
-	createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-	createInfo.presentMode = presentMode;
-	createInfo.clipped = VK_TRUE;
-	createInfo.oldSwapchain = VK_NULL_HANDLE;
+	createInfo.preTransform = swapChainSupport.capabilities.currentTransform;
+	createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+	createInfo.presentMode = presentMode;
+	createInfo.clipped = VK_TRUE;
+	createInfo.oldSwapchain = oldSwapChain;
+
+	if (vkCreateSwapchainKHR(renderer::device, &createInfo, nullptr, &renderer::swapChain) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create swapchain!");
+	}
+	else {
+		logger::log("Successfully created swapchain!", 1);
+	}
+
+	vkGetSwapchainImagesKHR(renderer::device, renderer::swapChain, &imageCount, nullptr);
+	renderer::swapChainImages.resize(imageCount);
+	vkGetSwapchainImagesKHR(renderer::device, renderer::swapChain, &imageCount, renderer::swapChainImages.data());
+
+	renderer::swapChainImageFormat = surfaceFormat.format;
+	renderer::swapChainExtent = extent;
+}
+
+void renderer::createOffscreenTargets() {
+	renderer::swapChainImageFormat = VK_FORMAT_R8G8B8A8_SRGB;
+	renderer::swapChainExtent = {engine::width, engine::height};
+
+	renderer::swapChainImages.resize(renderer::maxFramesInFlight);
+	renderer::offscreenImagesMemory.resize(renderer::maxFramesInFlight);
+
+	for (size_t i = 0; i < renderer::maxFramesInFlight; i++) {
+		renderer::createImage(renderer::swapChainExtent.width, renderer::swapChainExtent.height, renderer::swapChainImageFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, renderer::swapChainImages[i], renderer::offscreenImagesMemory[i]);
+	}
+
+	logger::log("Successfully created offscreen targets!", 1);
+}
+
+void renderer::createImageViews() {
+	renderer::swapChainImageViews.resize(renderer::swapChainImages.size());
+
+	for (size_t i = 0; i < renderer::swapChainImages.size(); i++) {
+		renderer::swapChainImageViews[i] = renderer::createImageView(renderer::swapChainImages[i], renderer::swapChainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+	}
+}
+
+// inside the render pass the graph began, the culled draws are ready
+static void recordMainPass(VkCommandBuffer commandBuffer) {
+	VkBuffer vertexBuffers[] = {renderer::vertexBuffer};
+	VkDeviceSize offsets = {0};
+
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, &offsets);
+
+	vkCmdBindIndexBuffer(commandBuffer, renderer::indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+	VkViewport viewport{};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = static_cast<float>(renderer::swapChainExtent.width / 2);
+	viewport.height = static_cast<float>(renderer::swapChainExtent.height / 2);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+	VkRect2D scissor{};
+	scissor.offset = {0, 0};
+	scissor.extent = renderer::swapChainExtent;
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
-	if (vkCreateSwapchainKHR(renderer::device, &createInfo, nullptr, &renderer::swapChain) != VK_SUCCESS) {
-		throw std::runtime_error("Failed to create swapchain!");
-	}
-	else {
-		logger::log("Successfully created swapchain!", 1);
+	// the draws below only push the transform, instanced has to start out as 0
+	renderer::objectConstants constants{};
+	vkCmdPushConstants(commandBuffer, renderer::pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants), &constants);
+
+	if (drawQueue::depthPrepass) {
+		drawQueue::record(commandBuffer, drawQueue::pass::depthPrepass);
 	}
 
-	vkGetSwapchainImagesKHR(renderer::device, renderer::swapChain, &imageCount, nullptr);
-	renderer::swapChainImages.resize(imageCount);
-	vkGetSwapchainImagesKHR(renderer::device, renderer::swapChain, &imageCount, renderer::swapChainImages.data());
+	drawQueue::record(commandBuffer, drawQueue::pass::opaque);
 
-	renderer::swapChainImageFormat = surfaceFormat.format;
-	renderer::swapChainExtent = extent;
+	// the indirect draws were not in the pre-pass, they test and write depth like before
+	drawQueue::bindPipeline(commandBuffer, renderer::pipelineKind::opaque);
+	drawQueue::bindDescriptors(commandBuffer);
+
+	occlusion::recordDraws(commandBuffer);
+	cluster::recordDraws(commandBuffer);
 }
 
-void renderer::createImageViews() {
-	renderer::swapChainImageViews.resize(renderer::swapChainImages.size());
+// the frame as passes over the resources they use, the graph works out the barriers between them
+void renderer::createRenderGraph() {
+	BRUTAL_PROFILE_FUNCTION();
 
-	for (size_t i = 0; i < renderer::swapChainImages.size(); i++) {
-		renderer::swapChainImageViews[i] = renderer::createImageView(renderer::swapChainImages[i], renderer::swapChainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+	VkFormat depthFormat = renderer::findDepthFormat();
+	VkImageAspectFlags depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+
+	if (renderer::hasStencilComponent(depthFormat)) {
+		depthAspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
 	}
+
+	renderer::frameResources& resources = renderer::graphResources;
+
+	// presented, or read back by headless mode once the frame is done
+	resources.backbuffer = graph::importImage("backbuffer", renderer::swapChainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT, false, headless::enabled ? graph::usage::transferRead : graph::usage::present);
+	// only lives from the main pass to the depth pyramid, so it is the graph's and can share memory with other transient targets
+	resources.depth = graph::createImage("depth", depthFormat, depthAspect, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+	// next frame's culling tests against it
+	resources.pyramid = graph::importImage("depthPyramid", VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, true);
+
+	resources.clusterIndices = graph::importBuffer("clusterIndices", false);
+	resources.clusterDraws = graph::importBuffer("clusterDraws", false);
+	resources.occlusionDraws = graph::importBuffer("occlusionDraws", false);
+	resources.occlusionInstances = graph::importBuffer("occlusionInstances", false);
+
+	// the compute passes only run when there is something to cull this frame
+	auto clusterActive = []() { return !cluster::draws.empty(); };
+	auto occlusionActive = []() { return occlusion::frames[renderer::currentFrame].objectCount != 0; };
+
+	uint32_t clusterCulling = graph::addPass("clusterCulling", graph::passKind::compute, cluster::recordCulling);
+	graph::use(clusterCulling, resources.clusterIndices, graph::usage::computeWrite);
+	graph::use(clusterCulling, resources.clusterDraws, graph::usage::computeReadWrite);
+	graph::passes[clusterCulling].active = clusterActive;
+
+	uint32_t occlusionClear = graph::addPass("occlusionClear", graph::passKind::transfer, occlusion::recordClear);
+	graph::use(occlusionClear, resources.occlusionDraws, graph::usage::transferWrite);
+	graph::passes[occlusionClear].active = occlusionActive;
+
+	uint32_t gpuCulling = graph::addPass("gpuCulling", graph::passKind::compute, occlusion::recordCulling);
+	graph::use(gpuCulling, resources.occlusionDraws, graph::usage::computeReadWrite);
+	graph::use(gpuCulling, resources.occlusionInstances, graph::usage::computeReadWrite);
+	graph::use(gpuCulling, resources.pyramid, graph::usage::computeRead);
+	graph::passes[gpuCulling].active = occlusionActive;
+
+	VkClearValue colorClear{};
+	colorClear.color = {{1.0f, 0.0f, 0.0f, 1.0f}};
+
+	VkClearValue depthClear{};
+	depthClear.depthStencil = {1.0f, 0};
+
+	uint32_t mainPass = graph::addPass("mainPass", graph::passKind::graphics, recordMainPass);
+	graph::colorAttachment(mainPass, resources.backbuffer, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE, colorClear);
+	// kept for the depth pyramid built after the pass
+	graph::depthAttachment(mainPass, resources.depth, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE, depthClear);
+	graph::use(mainPass, resources.clusterIndices, graph::usage::indexRead);
+	graph::use(mainPass, resources.clusterDraws, graph::usage::indirectRead);
+	graph::use(mainPass, resources.occlusionDraws, graph::usage::indirectRead);
+	graph::use(mainPass, resources.occlusionInstances, graph::usage::vertexRead);
+
+	uint32_t depthPyramid = graph::addPass("depthPyramid", graph::passKind::compute, occlusion::recordPyramid);
+	graph::use(depthPyramid, resources.depth, graph::usage::depthSampled);
+	graph::use(depthPyramid, resources.pyramid, graph::usage::computeReadWrite);
+	graph::passes[depthPyramid].active = occlusionActive;
+
+	graph::compile();
+
+	// the pipelines are built against the main pass, the graph keeps it until cleanup
+	renderer::renderPass = graph::passes[mainPass].renderPass;
+
+	logger::log("Successfully created render graph!", 1);
 }
 
-void renderer::createRenderPass() {
-	VkAttachmentDescription colorAttachment{};
-	colorAttachment.format = renderer::swapChainImageFormat;
-	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-	VkAttachmentReference colorAttachmentRef{};
-	colorAttachmentRef.attachment = 0;
-	colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-	VkAttachmentDescription depthAttachment{};
-	depthAttachment.format = renderer::findDepthFormat();
-	depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-	depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-	VkAttachmentReference depthAttachmentRef{};
-	depthAttachmentRef.attachment = 1;
-	depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-	VkSubpassDependency dependency{};
-	dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-	dependency.dstSubpass = 0;
-
-	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-	dependency.srcAccessMask = 0;
-
-	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-
-	VkSubpassDescription subpass{};
-	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-	subpass.colorAttachmentCount = 1;
-	subpass.pColorAttachments = &colorAttachmentRef;
-	subpass.pDepthStencilAttachment = &depthAttachmentRef;
-
-	std::array<VkAttachmentDescription, 2> attachments = {colorAttachment, depthAttachment};
-
-	VkRenderPassCreateInfo renderPassInfo{};
-	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-	renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-	renderPassInfo.pAttachments = attachments.data();
-	renderPassInfo.subpassCount = 1;
-	renderPassInfo.pSubpasses = &subpass;
-	renderPassInfo.dependencyCount = 1;
-	renderPassInfo.pDependencies = &dependency;
-
-	if (vkCreateRenderPass(renderer::device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
-		throw std::runtime_error("Failed to create render pass!");
+void renderer::createRenderTargets() {
+	const renderer::frameResources& resources = renderer::graphResources;
+
+	graph::bindImage(resources.backbuffer, renderer::swapChainImages, renderer::swapChainImageViews);
+
+	if (occlusion::active()) {
+		graph::bindImage(resources.pyramid, { occlusion::pyramidImage }, { occlusion::pyramidImageView }, occlusion::pyramidLevels);
 	}
-	else {
-		logger::log("Successfully created render pass!", 1);
+
+	graph::createTargets(renderer::swapChainExtent);
+
+	if (occlusion::active()) {
+		occlusion::bindDepth(graph::resources[resources.depth].views[0]);
 	}
 }
 
 void renderer::createDescriptorSetLayout() {
 	VkDescriptorSetLayoutBinding uboLayoutBinding{};
 	uboLayoutBinding.binding = 0;
-	uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	uboLayoutBinding.descriptorCount = 1;
 	uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 	uboLayoutBinding.pImmutableSamplers = nullptr;
@@ -616,7 +1489,15 @@ void renderer::createDescriptorSetLayout() {
 	samplerLayoutBinding.pImmutableSamplers = nullptr;
 	samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
-	std::array<VkDescriptorSetLayoutBinding, 2> bindings = {uboLayoutBinding, samplerLayoutBinding};
+	// the instances of gpu culling, only read by indirect draws
+	VkDescriptorSetLayoutBinding instanceLayoutBinding{};
+	instanceLayoutBinding.binding = 2;
+	instanceLayoutBinding.descriptorCount = 1;
+	instanceLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	instanceLayoutBinding.pImmutableSamplers = nullptr;
+	instanceLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+	std::array<VkDescriptorSetLayoutBinding, 3> bindings = {uboLayoutBinding, samplerLayoutBinding, instanceLayoutBinding};
 
 	VkDescriptorSetLayoutCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -637,22 +1518,72 @@ void renderer::createDescriptorSetLayout() {
 }
 
 void renderer::createGraphicsPipeline() {
-	auto vertexShaderCode = filesystem::readFile("./shaders/vert.spv");
-	auto fragmentShaderCode = filesystem::readFile("./shaders/frag.spv");
+	BRUTAL_PROFILE_FUNCTION();
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &renderer::descriptorSetLayout;
+	// per object transform
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(renderer::objectConstants);
+
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	if (vkCreatePipelineLayout(renderer::device, &pipelineLayoutInfo, nullptr, &renderer::pipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create pipeline layout!");
+	}
+	else {
+		logger::log("Successfully created pipeline layout!", 1);
+	}
+
+	filesystem::fileView vertexShaderCode = filesystem::open(renderer::vertexShaderPath(renderer::activeVertexFormat));
+	filesystem::fileView fragmentShaderCode = filesystem::open("shaders/frag.spv");
+
+	renderer::graphicsPipelines = renderer::buildGraphicsPipelines(vertexShaderCode.bytes, fragmentShaderCode.bytes);
+}
+
+std::array<VkPipeline, renderer::pipelineKindCount> renderer::buildGraphicsPipelines(std::span<const char> vertexShaderCode, std::span<const char> fragmentShaderCode) {
+	std::array<VkPipeline, renderer::pipelineKindCount> pipelines{};
+
+	try {
+		for (size_t i = 0; i < renderer::pipelineKindCount; i++) {
+			pipelines[i] = renderer::buildGraphicsPipeline(vertexShaderCode, fragmentShaderCode, static_cast<renderer::pipelineKind>(i));
+		}
+	}
+	catch (...) {
+		for (VkPipeline pipeline : pipelines) {
+			if (pipeline != VK_NULL_HANDLE) {
+				vkDestroyPipeline(renderer::device, pipeline, nullptr);
+			}
+		}
+
+		throw;
+	}
+
+	return pipelines;
+}
 
-	renderer::vertexShaderModule = renderer::createShaderModule(vertexShaderCode);
-	renderer::fragmentShaderModule = renderer::createShaderModule(fragmentShaderCode);
+// only touches its own shader modules, so hot reload can call it from a job worker while frames are recorded
+VkPipeline renderer::buildGraphicsPipeline(std::span<const char> vertexShaderCode, std::span<const char> fragmentShaderCode, pipelineKind kind) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	VkShaderModule vertexShaderModule = renderer::createShaderModule(vertexShaderCode);
+	VkShaderModule fragmentShaderModule = renderer::createShaderModule(fragmentShaderCode);
 
 	VkPipelineShaderStageCreateInfo vertexShaderStageInfo{};
 	vertexShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 	vertexShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-	vertexShaderStageInfo.module = renderer::vertexShaderModule;
+	vertexShaderStageInfo.module = vertexShaderModule;
 	vertexShaderStageInfo.pName = "main";
 
 	VkPipelineShaderStageCreateInfo fragmentShaderStageInfo{};
 	fragmentShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 	fragmentShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-	fragmentShaderStageInfo.module = renderer::fragmentShaderModule;
+	fragmentShaderStageInfo.module = fragmentShaderModule;
 	fragmentShaderStageInfo.pName = "main";
 
 	VkPipelineShaderStageCreateInfo shaderStages[] = {vertexShaderStageInfo, fragmentShaderStageInfo};
@@ -660,8 +1591,27 @@ void renderer::createGraphicsPipeline() {
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
-	auto bindingDescription = renderer::vertex::getBindingDescription();
-	auto attributeDescriptions = renderer::vertex::getAttributeDescriptions();
+	VkVertexInputBindingDescription bindingDescription{};
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+
+	auto describe = [&bindingDescription, &attributeDescriptions](auto vertexType) {
+		auto attributes = decltype(vertexType)::getAttributeDescriptions();
+
+		bindingDescription = decltype(vertexType)::getBindingDescription();
+		attributeDescriptions.assign(attributes.begin(), attributes.end());
+	};
+
+	switch (renderer::activeVertexFormat) {
+		case renderer::vertexFormat::compact:
+			describe(renderer::compactVertex{});
+			break;
+		case renderer::vertexFormat::compactColor:
+			describe(renderer::compactColorVertex{});
+			break;
+		default:
+			describe(renderer::vertex{});
+			break;
+	}
 
 	vertexInputInfo.vertexBindingDescriptionCount = 1;
 	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());;
@@ -719,8 +1669,9 @@ void renderer::createGraphicsPipeline() {
 	VkPipelineDepthStencilStateCreateInfo depthStencil{};
 	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
 	depthStencil.depthTestEnable = VK_TRUE;
-	depthStencil.depthWriteEnable = VK_TRUE;
-	depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+	depthStencil.depthWriteEnable = kind != renderer::pipelineKind::opaqueAfterPrepass;
+	// the same shader writes the same depth, so what survived the pre-pass passes on equal
+	depthStencil.depthCompareOp = kind == renderer::pipelineKind::opaqueAfterPrepass ? VK_COMPARE_OP_LESS_OR_EQUAL : VK_COMPARE_OP_LESS;
 
 	depthStencil.depthBoundsTestEnable = VK_FALSE;
 	depthStencil.minDepthBounds = 0.0f;
@@ -741,7 +1692,7 @@ void renderer::createGraphicsPipeline() {
 	dynamicState.pDynamicStates = dynamicStates.data();
 
 	VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	colorBlendAttachment.colorWriteMask = kind == renderer::pipelineKind::depthPrepass ? 0 : VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
 	colorBlendAttachment.blendEnable = VK_FALSE;
 
 	colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
@@ -764,23 +1715,9 @@ void renderer::createGraphicsPipeline() {
 	colorBlending.blendConstants[2] = 0.0f;
 	colorBlending.blendConstants[3] = 0.0f;
 
-	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutInfo.setLayoutCount = 1;
-	pipelineLayoutInfo.pSetLayouts = &renderer::descriptorSetLayout;
-	pipelineLayoutInfo.pushConstantRangeCount = 0;
-	pipelineLayoutInfo.pPushConstantRanges = nullptr;
-
-	if (vkCreatePipelineLayout(renderer::device, &pipelineLayoutInfo, nullptr, &renderer::pipelineLayout) != VK_SUCCESS) {
-		throw std::runtime_error("Failed to create pipeline layout!");
-	}
-	else {
-		logger::log("Successfully created pipeline layout!", 1);
-	}
-
 	VkGraphicsPipelineCreateInfo pipelineInfo{};
 	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-	pipelineInfo.stageCount = 2;
+	pipelineInfo.stageCount = kind == renderer::pipelineKind::depthPrepass ? 1 : 2;
 
 	pipelineInfo.pStages = shaderStages;
 	pipelineInfo.pVertexInputState = &vertexInputInfo;
@@ -792,6 +1729,17 @@ void renderer::createGraphicsPipeline() {
 	pipelineInfo.pColorBlendState = &colorBlending;
 	pipelineInfo.pDynamicState = &dynamicState;
 
+	// with dynamic rendering the pipeline names the formats of the main pass instead
+	VkFormat depthFormat = renderer::findDepthFormat();
+
+	VkPipelineRenderingCreateInfo renderingInfo{};
+	renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+	renderingInfo.colorAttachmentCount = 1;
+	renderingInfo.pColorAttachmentFormats = &renderer::swapChainImageFormat;
+	renderingInfo.depthAttachmentFormat = depthFormat;
+	renderingInfo.stencilAttachmentFormat = renderer::hasStencilComponent(depthFormat) ? depthFormat : VK_FORMAT_UNDEFINED;
+
+	pipelineInfo.pNext = renderer::dynamicRendering ? &renderingInfo : nullptr;
 	pipelineInfo.layout = renderer::pipelineLayout;
 	pipelineInfo.renderPass = renderer::renderPass;
 
@@ -799,41 +1747,51 @@ void renderer::createGraphicsPipeline() {
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 	pipelineInfo.basePipelineIndex = -1;
 
-	if (vkCreateGraphicsPipelines(renderer::device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &renderer::graphicsPipeline) != VK_SUCCESS) {
+	VkPipeline pipeline;
+	VkResult result = vkCreateGraphicsPipelines(renderer::device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+
+	vkDestroyShaderModule(renderer::device, vertexShaderModule, nullptr);
+	vkDestroyShaderModule(renderer::device, fragmentShaderModule, nullptr);
+
+	if (result != VK_SUCCESS) {
 		throw std::runtime_error("Failed to create graphics pipeline!");
 	}
 
-	vkDestroyShaderModule(renderer::device, renderer::vertexShaderModule, nullptr);
-	vkDestroyShaderModule(renderer::device, renderer::fragmentShaderModule, nullptr);
+	return pipeline;
 }
 
-void renderer::createFramebuffers() {
-	renderer::swapChainFramebuffers.resize(renderer::swapChainImageViews.size());
+// cluster and gpu culling build theirs against their own layouts, hot reload swaps them the same way
+VkPipeline renderer::createComputePipeline(std::span<const char> code, VkPipelineLayout layout) {
+	BRUTAL_PROFILE_FUNCTION();
 
-	for (size_t i = 0; i < renderer::swapChainImageViews.size(); i++) {
-		std::array<VkImageView, 2> attachments = {
-			renderer::swapChainImageViews[i],
-			renderer::depthImageView
-		};
+	VkShaderModule shaderModule = renderer::createShaderModule(code);
 
-		VkFramebufferCreateInfo createInfo{};
-		createInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-		createInfo.renderPass = renderer::renderPass;
-		createInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-		createInfo.pAttachments = attachments.data();
-		createInfo.width = renderer::swapChainExtent.width;
-		createInfo.height = renderer::swapChainExtent.height;
-		createInfo.layers = 1;
-
-		if (vkCreateFramebuffer(renderer::device, &createInfo, nullptr, &renderer::swapChainFramebuffers[i]) != VK_SUCCESS) {
-			throw std::runtime_error("Failed to create framebuffer!");
-		}
-		else {
-			logger::log("Successfully created framebuffer!", 1);
-		}
+	VkPipelineShaderStageCreateInfo stageInfo{};
+	stageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	stageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	stageInfo.module = shaderModule;
+	stageInfo.pName = "main";
+
+	VkComputePipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage = stageInfo;
+	pipelineInfo.layout = layout;
+	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+	pipelineInfo.basePipelineIndex = -1;
+
+	VkPipeline pipeline;
+	VkResult result = vkCreateComputePipelines(renderer::device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+
+	vkDestroyShaderModule(renderer::device, shaderModule, nullptr);
+
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create compute pipeline!");
 	}
+
+	return pipeline;
 }
 
+
 uint32_t renderer::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
 	VkPhysicalDeviceMemoryProperties memoryProperties;
 	vkGetPhysicalDeviceMemoryProperties(renderer::physicalDevice, &memoryProperties);
@@ -872,7 +1830,7 @@ VkFormat renderer::findDepthFormat() {
 	return renderer::findSupportedFormat(
 		{VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
 		VK_IMAGE_TILING_OPTIMAL,
-		VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
+		VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT
 	);
 }
 
@@ -895,7 +1853,7 @@ void renderer::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemor
 	allocateInfo.allocationSize = memoryRequirements.size;
 	allocateInfo.memoryTypeIndex = renderer::findMemoryType(memoryRequirements.memoryTypeBits, properties);
 
-	if (vkAllocateMemory(renderer::device, &allocateInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
+	if (memory::allocateDevice(allocateInfo, bufferMemory) != VK_SUCCESS) {
 		throw std::runtime_error("Failed to allocate buffer memory!");
 	}
 
@@ -905,7 +1863,7 @@ void renderer::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemor
 }
 
 void renderer::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
-	VkCommandBuffer commandBuffer = renderer::beginSingleTimeCommands();
+	VkCommandBuffer commandBuffer = renderer::beginSingleTimeCommands(__func__);
 
 	VkBufferCopy copyRegion{};
 	copyRegion.size = size;
@@ -916,11 +1874,39 @@ void renderer::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize s
 	logger::log("Successfully copied buffer!", 1);
 }
 
-void renderer::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) {
-	VkCommandBuffer commandBuffer = renderer::beginSingleTimeCommands();
+void renderer::uploadBuffer(const void* source, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& bufferMemory) {
+	renderer::uploadBuffer(size, usage, [source, size](char* destination) {
+		memcpy(destination, source, static_cast<size_t>(size));
+	}, buffer, bufferMemory);
+}
+
+// fill writes into the mapped staging memory, so callers never need a contiguous cpu copy of the data
+void renderer::uploadBuffer(VkDeviceSize size, VkBufferUsageFlags usage, const std::function<void(char*)>& fill, VkBuffer& buffer, VkDeviceMemory& bufferMemory) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingBufferMemory;
+
+	renderer::createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+
+	void* data;
+	vkMapMemory(renderer::device, stagingBufferMemory, 0, size, 0, &data);
+	fill(static_cast<char*>(data));
+	vkUnmapMemory(renderer::device, stagingBufferMemory);
+
+	renderer::createBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, bufferMemory);
+
+	renderer::copyBuffer(stagingBuffer, buffer, size);
+
+	vkDestroyBuffer(renderer::device, stagingBuffer, nullptr);
+	memory::freeDevice(stagingBufferMemory);
+}
+
+void renderer::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, VkDeviceSize bufferOffset) {
+	VkCommandBuffer commandBuffer = renderer::beginSingleTimeCommands(__func__);
 
 	VkBufferImageCopy region{};
-	region.bufferOffset = 0;
+	region.bufferOffset = bufferOffset;
 	region.bufferRowLength = 0;
 	region.bufferImageHeight = 0;
 
@@ -957,7 +1943,7 @@ void renderer::createVertexBuffer() {
 	renderer::copyBuffer(stagingBuffer, renderer::vertexBuffer, bufferSize);
 
 	vkDestroyBuffer(renderer::device, stagingBuffer, nullptr);
-	vkFreeMemory(renderer::device, stagingBufferMemory, nullptr);
+	memory::freeDevice(stagingBufferMemory);
 
 	logger::log("Successfully created vertex buffer!", 1);
 }
@@ -980,35 +1966,24 @@ void renderer::createIndexBuffer() {
 	renderer::copyBuffer(stagingBuffer, renderer::indexBuffer, bufferSize);
 
 	vkDestroyBuffer(renderer::device, stagingBuffer, nullptr);
-	vkFreeMemory(renderer::device, stagingBufferMemory, nullptr);
+	memory::freeDevice(stagingBufferMemory);
 
 	logger::log("Successfully created index buffer!", 1);
 }
 
 */
 
-void renderer::createUniformBuffers() {
-	VkDeviceSize bufferSize = sizeof(renderer::uniformBufferObject);
-
-	renderer::uniformBuffers.resize(renderer::maxFramesInFlight);
-	renderer::uniformBuffersMemory.resize(renderer::maxFramesInFlight);
-	renderer::uniformBuffersMapped.resize(renderer::maxFramesInFlight);
-
-	for (size_t i = 0; i < renderer::maxFramesInFlight; i++) {
-		renderer::createBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, renderer::uniformBuffers[i], renderer::uniformBuffersMemory[i]);
-		
-		vkMapMemory(renderer::device, renderer::uniformBuffersMemory[i], 0, bufferSize, 0, &renderer::uniformBuffersMapped[i]);
-	}
-}
-
 void renderer::createDescriptorPool() {
-	std::array<VkDescriptorPoolSize, 2> poolSizes{};
-	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	std::array<VkDescriptorPoolSize, 3> poolSizes{};
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	poolSizes[0].descriptorCount = static_cast<uint32_t>(renderer::maxFramesInFlight);
 
 	poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	poolSizes[1].descriptorCount = static_cast<uint32_t>(renderer::maxFramesInFlight);
 
+	poolSizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSizes[2].descriptorCount = static_cast<uint32_t>(renderer::maxFramesInFlight);
+
 	VkDescriptorPoolCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 	createInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
@@ -1044,7 +2019,8 @@ void renderer::createDescriptorSets() {
 
 	for (size_t i = 0; i < renderer::maxFramesInFlight; i++) {
 		VkDescriptorBufferInfo bufferInfo{};
-		bufferInfo.buffer = renderer::uniformBuffers[i];
+		// the offset is dynamic, each frame binds wherever the gpu arena placed its uniforms
+		bufferInfo.buffer = arena::gpuBuffer;
 		bufferInfo.offset = 0;
 		bufferInfo.range = sizeof(renderer::uniformBufferObject);
 
@@ -1053,13 +2029,19 @@ void renderer::createDescriptorSets() {
 		imageInfo.imageView = renderer::textureImageView;
 		imageInfo.sampler = renderer::textureSampler;
 
-		std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
+		// a placeholder until gpu culling points it at its instances, direct draws never read it
+		VkDescriptorBufferInfo instanceInfo{};
+		instanceInfo.buffer = arena::gpuBuffer;
+		instanceInfo.offset = 0;
+		instanceInfo.range = VK_WHOLE_SIZE;
+
+		std::array<VkWriteDescriptorSet, 3> descriptorWrites{};
 
 		descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 		descriptorWrites[0].dstSet = renderer::descriptorSets[i];
 		descriptorWrites[0].dstBinding = 0;
 		descriptorWrites[0].dstArrayElement = 0;
-		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		descriptorWrites[0].descriptorCount = 1;
 		descriptorWrites[0].pBufferInfo = &bufferInfo;
 	
@@ -1070,6 +2052,14 @@ void renderer::createDescriptorSets() {
 		descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 		descriptorWrites[1].descriptorCount = 1;
 		descriptorWrites[1].pImageInfo = &imageInfo;
+
+		descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[2].dstSet = renderer::descriptorSets[i];
+		descriptorWrites[2].dstBinding = 2;
+		descriptorWrites[2].dstArrayElement = 0;
+		descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		descriptorWrites[2].descriptorCount = 1;
+		descriptorWrites[2].pBufferInfo = &instanceInfo;
 	
 		vkUpdateDescriptorSets(renderer::device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
 	}
@@ -1100,7 +2090,50 @@ void renderer::createSyncObjects() {
 	}
 }
 
-VkCommandBuffer renderer::beginSingleTimeCommands() {
+void renderer::readbackImage(uint32_t imageIndex, std::vector<uint8_t>& pixels) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	// offscreen image i is only written by frame slot i
+	vkWaitForFences(renderer::device, 1, &renderer::inFlightFences[imageIndex], VK_TRUE, UINT64_MAX);
+
+	VkDeviceSize imageSize = static_cast<VkDeviceSize>(renderer::swapChainExtent.width) * renderer::swapChainExtent.height * 4;
+
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingBufferMemory;
+
+	renderer::createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+
+	VkCommandBuffer commandBuffer = renderer::beginSingleTimeCommands(__func__);
+
+	VkBufferImageCopy region{};
+	region.bufferOffset = 0;
+	region.bufferRowLength = 0;
+	region.bufferImageHeight = 0;
+
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+
+	region.imageOffset = {0, 0, 0};
+	region.imageExtent = {renderer::swapChainExtent.width, renderer::swapChainExtent.height, 1};
+
+	vkCmdCopyImageToBuffer(commandBuffer, renderer::swapChainImages[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, stagingBuffer, 1, &region);
+
+	renderer::endSingleTimeCommands(commandBuffer);
+
+	pixels.resize(static_cast<size_t>(imageSize));
+
+	void* data;
+	vkMapMemory(renderer::device, stagingBufferMemory, 0, imageSize, 0, &data);
+	memcpy(pixels.data(), data, static_cast<size_t>(imageSize));
+	vkUnmapMemory(renderer::device, stagingBufferMemory);
+
+	vkDestroyBuffer(renderer::device, stagingBuffer, nullptr);
+	memory::freeDevice(stagingBufferMemory);
+}
+
+VkCommandBuffer renderer::beginSingleTimeCommands(const char* name) {
 	VkCommandBufferAllocateInfo allocateInfo{};
 	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
@@ -1116,10 +2149,14 @@ VkCommandBuffer renderer::beginSingleTimeCommands() {
 
 	vkBeginCommandBuffer(commandBuffer, &beginInfo);
 
+	profiler::beginGpuSlice(commandBuffer, profiler::uploadSlice, name);
+
 	return commandBuffer;
 }
 
 void renderer::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
+	profiler::endGpuSlice(commandBuffer);
+
 	vkEndCommandBuffer(commandBuffer);
 
 	VkSubmitInfo submitInfo{};
@@ -1130,17 +2167,20 @@ void renderer::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
 	vkQueueSubmit(renderer::graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
 	vkQueueWaitIdle(renderer::graphicsQueue);
 
+	// the queue is idle already, waiting on the results costs nothing
+	profiler::collectGpuSlice(profiler::uploadSlice, true);
+
 	vkFreeCommandBuffers(renderer::device, renderer::commandPool, 1, &commandBuffer);
 }
 
-void renderer::createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory) {
+void renderer::createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, uint32_t mipLevels) {
 	VkImageCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
 	createInfo.imageType = VK_IMAGE_TYPE_2D;
 	createInfo.extent.width = static_cast<uint32_t>(width);
 	createInfo.extent.height = static_cast<uint32_t>(height);
 	createInfo.extent.depth = 1;
-	createInfo.mipLevels = 1;
+	createInfo.mipLevels = mipLevels;
 	createInfo.arrayLayers = 1;
 	createInfo.format = format;
 	createInfo.tiling = tiling;
@@ -1165,7 +2205,7 @@ void renderer::createImage(uint32_t width, uint32_t height, VkFormat format, VkI
 	allocateInfo.allocationSize = memoryRequirements.size;
 	allocateInfo.memoryTypeIndex = renderer::findMemoryType(memoryRequirements.memoryTypeBits, properties);
 
-	if (vkAllocateMemory(renderer::device, &allocateInfo, nullptr, &imageMemory) != VK_SUCCESS) {
+	if (memory::allocateDevice(allocateInfo, imageMemory) != VK_SUCCESS) {
 		throw std::runtime_error("Failed to allocate texture image memory!");
 	}
 	else {
@@ -1175,7 +2215,7 @@ void renderer::createImage(uint32_t width, uint32_t height, VkFormat format, VkI
 	vkBindImageMemory(renderer::device, image, imageMemory, 0);
 }
 
-VkImageView renderer::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags) {
+VkImageView renderer::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t baseMipLevel, uint32_t levelCount) {
 	VkImageViewCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 	createInfo.image = image;
@@ -1183,8 +2223,8 @@ VkImageView renderer::createImageView(VkImage image, VkFormat format, VkImageAsp
 	createInfo.format = format;
 
 	createInfo.subresourceRange.aspectMask = aspectFlags;
-	createInfo.subresourceRange.baseMipLevel = 0;
-	createInfo.subresourceRange.levelCount = 1;
+	createInfo.subresourceRange.baseMipLevel = baseMipLevel;
+	createInfo.subresourceRange.levelCount = levelCount;
 	createInfo.subresourceRange.baseArrayLayer = 0;
 	createInfo.subresourceRange.layerCount = 1;
 
@@ -1200,31 +2240,69 @@ VkImageView renderer::createImageView(VkImage image, VkFormat format, VkImageAsp
 }
 
 void renderer::createTextureImage() {
+	BRUTAL_PROFILE_FUNCTION();
+
 	//engine::texture texture;
-	engine::texture texture = texture.createTexture(texturePath);
+	engine::texture texture = texture.createTexture(renderer::texturePath);
+
+	renderer::uploadTexture(texture, renderer::textureImage, renderer::textureImageMemory);
+}
+
+// textures are set up once outside of the render graph
+static void transitionImage(VkImage image, graph::usage from, graph::usage to) {
+	VkCommandBuffer commandBuffer = renderer::beginSingleTimeCommands(__func__);
+
+	graph::transition(commandBuffer, image, VK_IMAGE_ASPECT_COLOR_BIT, 1, from, to);
+
+	renderer::endSingleTimeCommands(commandBuffer);
+}
 
-	VkDeviceSize imageSize = texture.textureStruct.textureDimensionsX * texture.textureStruct.textureDimensionsY * 4;
+void renderer::uploadTexture(engine::texture& texture, VkImage& image, VkDeviceMemory& imageMemory) {
+	BRUTAL_PROFILE_FUNCTION();
+
+	// baked artifacts are decompressed straight into the staging buffer, header included, decoded images are copied in
+	bool baked = !texture.textureStruct.artifactPath.empty();
+	VkDeviceSize stagingSize = baked ? filesystem::fileSize(texture.textureStruct.artifactPath) : static_cast<VkDeviceSize>(texture.textureStruct.textureDimensionsX) * texture.textureStruct.textureDimensionsY * 4;
+	VkDeviceSize pixelsOffset = 0;
 
 	VkBuffer stagingBuffer;
 	VkDeviceMemory stagingBufferMemory;
 
-	renderer::createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+	renderer::createBuffer(stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
 	
 	void* data;
-	vkMapMemory(renderer::device, stagingBufferMemory, 0, imageSize, 0, &data);
-		memcpy(data, texture.textureStruct.data, static_cast<size_t>(imageSize));
-	vkUnmapMemory(renderer::device, stagingBufferMemory);
+	vkMapMemory(renderer::device, stagingBufferMemory, 0, stagingSize, 0, &data);
+
+	if (baked) {
+		std::span<char> staging(static_cast<char*>(data), static_cast<size_t>(stagingSize));
+
+		try {
+			filesystem::read(texture.textureStruct.artifactPath, staging);
+			pixelsOffset = engine::texture::readBakedHeader(texture, staging);
+		}
+		catch (...) {
+			vkUnmapMemory(renderer::device, stagingBufferMemory);
+			vkDestroyBuffer(renderer::device, stagingBuffer, nullptr);
+			memory::freeDevice(stagingBufferMemory);
 
-	texture.destroyTexture(texture.textureStruct.data);
+			throw;
+		}
+	}
+	else {
+		memcpy(data, texture.textureStruct.data, static_cast<size_t>(stagingSize));
+		texture.destroyTexture(texture.textureStruct.data);
+	}
 
-	renderer::createImage(texture.textureStruct.textureDimensionsX, texture.textureStruct.textureDimensionsY, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, renderer::textureImage, renderer::textureImageMemory);
+	vkUnmapMemory(renderer::device, stagingBufferMemory);
+
+	renderer::createImage(texture.textureStruct.textureDimensionsX, texture.textureStruct.textureDimensionsY, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageMemory);
 
-	renderer::transitionImageLayout(renderer::textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-	renderer::copyBufferToImage(stagingBuffer, renderer::textureImage, static_cast<uint32_t>(texture.textureStruct.textureDimensionsX), static_cast<uint32_t>(texture.textureStruct.textureDimensionsY));
-	renderer::transitionImageLayout(renderer::textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	transitionImage(image, graph::usage::undefined, graph::usage::transferWrite);
+	renderer::copyBufferToImage(stagingBuffer, image, static_cast<uint32_t>(texture.textureStruct.textureDimensionsX), static_cast<uint32_t>(texture.textureStruct.textureDimensionsY), pixelsOffset);
+	transitionImage(image, graph::usage::transferWrite, graph::usage::fragmentSampled);
 
 	vkDestroyBuffer(renderer::device, stagingBuffer, nullptr);
-	vkFreeMemory(renderer::device, stagingBufferMemory, nullptr);
+	memory::freeDevice(stagingBufferMemory);
 }
 
 void renderer::createTextureImageView() {
@@ -1266,69 +2344,6 @@ void renderer::createTextureSampler() {
 	}
 }
 
-void renderer::transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout) {
-	VkCommandBuffer commandBuffer = renderer::beginSingleTimeCommands();
-
-	VkImageMemoryBarrier barrier{};
-	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-
-	barrier.oldLayout = oldLayout;
-	barrier.newLayout = newLayout;
-	
-	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-
-	barrier.image = image;
-
-	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	barrier.subresourceRange.baseMipLevel = 0;
-	barrier.subresourceRange.levelCount = 1;
-	barrier.subresourceRange.baseArrayLayer = 0;
-	barrier.subresourceRange.layerCount = 1;
-
-	VkPipelineStageFlags sourceStage;
-	VkPipelineStageFlags destinationStage;
-
-	if (newLayout == VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL) {
-		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-
-		if (renderer::hasStencilComponent(format)) {
-			barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
-		}
-	}
-	else {
-		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	}
-
-	if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-		barrier.srcAccessMask = 0;
-		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-		sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-		destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-	}
-	else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-		sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-	}
-	else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
-		barrier.srcAccessMask = 0;
-		barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-
-		sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-		destinationStage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-	}
-	else {
-		throw std::invalid_argument("Unsupported layout transition!");
-	}
-
-	vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
-
-	renderer::endSingleTimeCommands(commandBuffer);
-}
 
 void renderer::createCommandPool() {
 	queueFamilyIndices queueFamilyIndices = renderer::findQueueFamilies(renderer::physicalDevice);
@@ -1346,16 +2361,6 @@ void renderer::createCommandPool() {
 	}
 }
 
-void renderer::createDepthResources() {
-	VkFormat depthFormat = renderer::findDepthFormat();
-
-	renderer::createImage(renderer::swapChainExtent.width, renderer::swapChainExtent.height, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, renderer::depthImage, renderer::depthImageMemory);
-
-	renderer::depthImageView = renderer::createImageView(renderer::depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
-
-	renderer::transitionImageLayout(renderer::depthImage, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
-}
-
 void renderer::createCommandBuffers() {
 	renderer::commandBuffers.resize(renderer::maxFramesInFlight);
 
@@ -1374,6 +2379,8 @@ void renderer::createCommandBuffers() {
 }
 
 void renderer::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+	BRUTAL_PROFILE_FUNCTION();
+
 	VkCommandBufferBeginInfo beginInfo{};
 	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
@@ -1383,58 +2390,23 @@ void renderer::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t image
 		throw std::runtime_error("Failed to begin recording command buffer!");
 	}
 
-	VkRenderPassBeginInfo renderPassInfo{};
-	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-	renderPassInfo.renderPass = renderer::renderPass;
-	renderPassInfo.framebuffer = renderer::swapChainFramebuffers[imageIndex];
-	
-	renderPassInfo.renderArea.offset = {0, 0};
-	renderPassInfo.renderArea.extent = renderer::swapChainExtent;
-
-	std::array<VkClearValue, 2> clearValues{};
-	clearValues[0].color = {{1.0f, 0.0f, 0.0f, 1.0f}};
-	clearValues[1].depthStencil = {1.0f, 0};
+	profiler::beginGpuSlice(commandBuffer, renderer::currentFrame, "frame");
 
-	renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-	renderPassInfo.pClearValues = clearValues.data();
+	// the cpu side of the passes, the render graph records them in order with the barriers between them
+	cluster::prepare();
+	occlusion::prepare();
+	drawQueue::build(camera::camera.eye);
 
-	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	graph::execute(commandBuffer, imageIndex);
 
-		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderer::graphicsPipeline);
-
-		VkBuffer vertexBuffers[] = {renderer::vertexBuffer};
-		VkDeviceSize offsets = {0};
-
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, &offsets);
-
-		vkCmdBindIndexBuffer(commandBuffer, renderer::indexBuffer, 0, VK_INDEX_TYPE_UINT32);
-
-		VkViewport viewport{};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = static_cast<float>(renderer::swapChainExtent.width / 2);
-		viewport.height = static_cast<float>(renderer::swapChainExtent.height / 2);
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-
-		VkRect2D scissor{};
-		scissor.offset = {0, 0};
-		scissor.extent = renderer::swapChainExtent;
-		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-
-		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderer::pipelineLayout, 0, 1, &renderer::descriptorSets[renderer::currentFrame], 0, nullptr);
-
-		vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
-
-	vkCmdEndRenderPass(commandBuffer);
+	profiler::endGpuSlice(commandBuffer);
 
 	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
 		throw std::runtime_error("Failed to end recording of command buffer!");
 	}
 }
 
-VkShaderModule renderer::createShaderModule(const std::vector<char>& code) {
+VkShaderModule renderer::createShaderModule(std::span<const char> code) {
 	VkShaderModuleCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
 	createInfo.codeSize = code.size();
@@ -1453,36 +2425,47 @@ VkShaderModule renderer::createShaderModule(const std::vector<char>& code) {
 }
 
 void renderer::cleanup() {
+	BRUTAL_PROFILE_FUNCTION();
+	BRUTAL_MEMORY_SCOPE(memory::tag::renderer);
+
 	logger::log("Cleaning up renderer...", 4);
 
 	vkDeviceWaitIdle(renderer::device);
 
+	hotreload::shutdown();
+
 	renderer::cleanupSwapChain();
 
+	deletion::flush();
+
 	vkDestroySampler(renderer::device, renderer::textureSampler, nullptr);
 	vkDestroyImageView(renderer::device, renderer::textureImageView, nullptr);
 
 	vkDestroyImage(renderer::device, renderer::textureImage, nullptr);
-	vkFreeMemory(renderer::device, renderer::textureImageMemory, nullptr);
+	memory::freeDevice(renderer::textureImageMemory);
 
-	for (size_t i = 0; i < renderer::maxFramesInFlight; i++) {
-		vkDestroyBuffer(renderer::device, renderer::uniformBuffers[i], nullptr);
-		vkFreeMemory(renderer::device, renderer::uniformBuffersMemory[i], nullptr);
-	}
+	arena::cleanup();
 
 	vkDestroyDescriptorPool(renderer::device, renderer::descriptorPool, nullptr);
 	vkDestroyDescriptorSetLayout(renderer::device, renderer::descriptorSetLayout, nullptr);
 
+	cluster::cleanup();
+	occlusion::cleanup();
+
 	vkDestroyBuffer(renderer::device, renderer::vertexBuffer, nullptr);
-	vkFreeMemory(renderer::device, renderer::vertexBufferMemory, nullptr);
+	memory::freeDevice(renderer::vertexBufferMemory);
 
 	vkDestroyBuffer(renderer::device, renderer::indexBuffer, nullptr);
-	vkFreeMemory(renderer::device, renderer::indexBufferMemory, nullptr);
+	memory::freeDevice(renderer::indexBufferMemory);
 
-	vkDestroyPipeline(renderer::device, renderer::graphicsPipeline, nullptr);
+	renderer::meshData.clear();
+
+	for (VkPipeline pipeline : renderer::graphicsPipelines) {
+		vkDestroyPipeline(renderer::device, pipeline, nullptr);
+	}
 	vkDestroyPipelineLayout(renderer::device, renderer::pipelineLayout, nullptr);
 
-	vkDestroyRenderPass(renderer::device, renderer::renderPass, nullptr);
+	graph::cleanup();
 
 	for (size_t i = 0; i < renderer::maxFramesInFlight; i++) {
 		vkDestroySemaphore(renderer::device, renderer::imageAvailableSemaphores[i], nullptr);
@@ -1490,6 +2473,8 @@ void renderer::cleanup() {
 		vkDestroyFence(renderer::device, renderer::inFlightFences[i], nullptr);
 	}
 
+	profiler::shutdownGpu();
+
 	vkDestroyCommandPool(renderer::device, renderer::commandPool, nullptr);
 
 	vkDestroyDevice(renderer::device, nullptr);
@@ -1511,21 +2496,24 @@ void renderer::cleanup() {
 void renderer::cleanupSwapChain() {
 	logger::log("Cleaning up swapchain...", 4);
 
-	vkDeviceWaitIdle(renderer::device);
-
-	vkDestroyImageView(renderer::device, renderer::depthImageView, nullptr);
-	vkDestroyImage(renderer::device, renderer::depthImage, nullptr);
-	vkFreeMemory(renderer::device, renderer::depthImageMemory, nullptr);
-
-	for (size_t i = 0; i < renderer::swapChainFramebuffers.size(); i++) {
-		vkDestroyFramebuffer(renderer::device, renderer::swapChainFramebuffers[i], nullptr);
-	}
+	graph::destroyTargets();
 
 	for (size_t i = 0; i < renderer::swapChainImageViews.size(); i++) {
 		vkDestroyImageView(renderer::device, renderer::swapChainImageViews[i], nullptr);
 	}
 
-	vkDestroySwapchainKHR(renderer::device, renderer::swapChain, nullptr);
+	if (headless::enabled) {
+		for (size_t i = 0; i < renderer::swapChainImages.size(); i++) {
+			vkDestroyImage(renderer::device, renderer::swapChainImages[i], nullptr);
+			memory::freeDevice(renderer::offscreenImagesMemory[i]);
+		}
+
+		renderer::swapChainImages.clear();
+		renderer::offscreenImagesMemory.clear();
+	}
+	else {
+		vkDestroySwapchainKHR(renderer::device, renderer::swapChain, nullptr);
+	}
 
 	logger::log("Cleaned up swapchain!", 1);
 }
@@ -1591,6 +2579,16 @@ bool renderer::checkValidationLayerSupport() {
 }
 
 std::vector<const char*> renderer::getRequiredExtensions() {
+	if (headless::enabled) {
+		std::vector<const char*> extensions;
+
+		if (renderer::validationLayersEnabled) {
+			extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+		}
+
+		return extensions;
+	}
+
 	uint32_t extensionCount;
 	const char** extensionNames;
 
@@ -1641,4 +2639,4 @@ void renderer::destroyDebugUtilsMessengerEXT(VkInstance instance, const VkDebugU
 	if (func != nullptr) {
 		func(instance, debugMessenger, pAllocator);
 	}
-}
+}
\ No newline at end of file
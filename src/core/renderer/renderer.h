@@ -25,6 +25,12 @@
 #include <array>
 #include <algorithm>
 #include <chrono>
+#include <functional>
+
+namespace engine {
+	class texture;
+	class mesh;
+}
 
 namespace renderer {
 	struct vertex {
@@ -62,9 +68,128 @@ namespace renderer {
 		}
 	};
 
+	// 16 bytes, the position is unorm16 inside the mesh's box and the draw's transform maps it back, the fourth component is padding
+	struct compactVertex {
+		uint16_t pos[4];
+		uint16_t texCoord[2];
+		int16_t normal[2];
+
+		static VkVertexInputBindingDescription getBindingDescription() {
+			VkVertexInputBindingDescription bindingDescription{};
+			bindingDescription.binding = 0;
+			bindingDescription.stride = sizeof(compactVertex);
+			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+			return bindingDescription;
+		}
+
+		// color has no attribute, the shader variant uses white
+		static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions() {
+			std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
+			attributeDescriptions[0].binding = 0;
+			attributeDescriptions[0].location = 0;
+			attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_UNORM;
+			attributeDescriptions[0].offset = offsetof(compactVertex, pos);
+
+			attributeDescriptions[1].binding = 0;
+			attributeDescriptions[1].location = 2;
+			attributeDescriptions[1].format = VK_FORMAT_R16G16_SFLOAT;
+			attributeDescriptions[1].offset = offsetof(compactVertex, texCoord);
+
+			attributeDescriptions[2].binding = 0;
+			attributeDescriptions[2].location = 3;
+			attributeDescriptions[2].format = VK_FORMAT_R16G16_SNORM;
+			attributeDescriptions[2].offset = offsetof(compactVertex, normal);
+
+			return attributeDescriptions;
+		}
+	};
+
+	// compactVertex plus an rgba8 color, for scenes whose colors are not white everywhere
+	struct compactColorVertex {
+		uint16_t pos[4];
+		uint16_t texCoord[2];
+		int16_t normal[2];
+		uint8_t color[4];
+
+		static VkVertexInputBindingDescription getBindingDescription() {
+			VkVertexInputBindingDescription bindingDescription{};
+			bindingDescription.binding = 0;
+			bindingDescription.stride = sizeof(compactColorVertex);
+			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+			return bindingDescription;
+		}
+
+		static std::array<VkVertexInputAttributeDescription, 4> getAttributeDescriptions() {
+			std::array<VkVertexInputAttributeDescription, 4> attributeDescriptions{};
+			attributeDescriptions[0].binding = 0;
+			attributeDescriptions[0].location = 0;
+			attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_UNORM;
+			attributeDescriptions[0].offset = offsetof(compactColorVertex, pos);
+
+			attributeDescriptions[1].binding = 0;
+			attributeDescriptions[1].location = 1;
+			attributeDescriptions[1].format = VK_FORMAT_R8G8B8A8_UNORM;
+			attributeDescriptions[1].offset = offsetof(compactColorVertex, color);
+
+			attributeDescriptions[2].binding = 0;
+			attributeDescriptions[2].location = 2;
+			attributeDescriptions[2].format = VK_FORMAT_R16G16_SFLOAT;
+			attributeDescriptions[2].offset = offsetof(compactColorVertex, texCoord);
+
+			attributeDescriptions[3].binding = 0;
+			attributeDescriptions[3].location = 3;
+			attributeDescriptions[3].format = VK_FORMAT_R16G16_SNORM;
+			attributeDescriptions[3].offset = offsetof(compactColorVertex, normal);
+
+			return attributeDescriptions;
+		}
+	};
+
+	// meshes are always loaded as renderer::vertex, the format only decides what the gpu buffer holds
+	enum class vertexFormat : uint8_t {
+		full,
+		compact,
+		compactColor
+	};
+
+	// built from shaders/shader.vert with these defines, see shaders/compile.bat, indexed by vertexFormat
+	struct vertexShaderVariant {
+		const char* suffix;
+		const char* defines;
+	};
+
+	const std::array<vertexShaderVariant, 3> vertexShaderVariants = {{
+		{ "", "" },
+		{ "_compact", "-DCOMPACT_VERTEX" },
+		{ "_compact_color", "-DCOMPACT_VERTEX -DVERTEX_COLOR" }
+	}};
+
+	// the graphics pipelines the draw queue binds, they share the layout and shaders and only differ in depth state
+	enum class pipelineKind : uint8_t {
+		opaque,
+		// vertex shader only, writes depth and no color
+		depthPrepass,
+		// after the pre-pass, tests against its depth without writing it again
+		opaqueAfterPrepass,
+		count
+	};
+
+	const size_t pipelineKindCount = static_cast<size_t>(pipelineKind::count);
+
+	const float nearPlane = 0.1f;
+	const float farPlane = 100.0f;
+
 	const int maxFramesInFlight = 2;
 	extern uint32_t currentFrame;
+	// set by window resizes, the next frame recreates the swapchain once however many arrived and only if the size changed
 	extern bool framebufferResized;
+	// set when acquire or present reports out of date or suboptimal, recreates even at the same size
+	extern bool swapChainOutdated;
+
+	// minimized windows check back this often instead of waiting for the window to come back
+	const uint32_t minimizedWaitMilliseconds = 100;
 
 	extern VkSurfaceKHR surface;
 	extern VkInstance instance;
@@ -73,6 +198,16 @@ namespace renderer {
 	extern VkDevice device;
 	extern VkPhysicalDeviceProperties physicalDeviceProperties;
 	extern VkPhysicalDeviceFeatures physicalDeviceFeatures;
+	// drawIndirectCount, multiDrawIndirect and drawIndirectFirstInstance, enabled together for gpu driven culling
+	extern bool indirectCountSupported;
+	// requested before init, cleared by createLogicalDevice when neither vulkan 1.3 nor the extension has them
+	extern bool dynamicRendering;
+	extern bool synchronization2;
+
+	// the core or khr entry points, whichever the device was created with
+	extern PFN_vkCmdBeginRenderingKHR cmdBeginRendering;
+	extern PFN_vkCmdEndRenderingKHR cmdEndRendering;
+	extern PFN_vkCmdPipelineBarrier2KHR cmdPipelineBarrier2;
 
 	extern VkQueue graphicsQueue;
 	extern VkQueue presentQueue;
@@ -98,38 +233,140 @@ namespace renderer {
 		glm::mat4 proj;
 	};
 
+	// push constants of shaders/shader.vert, direct draws only push transform and leave instanced at 0
+	struct objectConstants {
+		glm::mat4 transform;
+		// the indirect draws of occlusion::recordDraws read the transform from the instance buffer instead
+		uint32_t instanced;
+	};
+
+	const uint32_t maxLods = 4;
+
+	// one level of detail, an index range inside its mesh's, error is how far the simplifier moved the surface in mesh units
+	struct meshLod {
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		float error;
+	};
+
+	// a cluster of lod 0's triangles, contiguous in the index buffer and laid out like the std430 struct in shaders/cluster.comp
+	struct meshlet {
+		// center and radius in mesh units
+		glm::vec4 sphere;
+		// axis and the sine of the widest angle between it and a triangle's normal, 1 when the cluster can not be back-face culled
+		glm::vec4 cone;
+		// relative to the mesh like meshLod
+		uint32_t firstIndex;
+		uint32_t triangleCount;
+		uint32_t padding[2];
+	};
+
+	// a slice of the shared vertex and index buffers, indexCount covers every lod
+	struct meshRange {
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		int32_t vertexOffset;
+		uint32_t vertexCount;
+
+		glm::vec3 boundsCenter;
+		float boundsRadius;
+
+		// box the compact formats quantize positions to, dequantize maps the unit cube back onto it
+		glm::vec3 boundsMinimum;
+		glm::vec3 boundsExtent;
+		glm::mat4 dequantize;
+
+		// lod 0 is the full mesh, the errors only grow from there
+		uint32_t lodCount;
+		std::array<meshLod, maxLods> lods;
+
+		// range in cluster::meshlets, empty for meshes that were not baked
+		uint32_t firstMeshlet;
+		uint32_t meshletCount;
+	};
+
+	struct sceneObject {
+		uint32_t mesh;
+		glm::mat4 transform;
+
+		// the level drawn last frame, selectLods only moves away from it past the hysteresis
+		uint32_t lod;
+	};
+
 	//gebbs
 
-	extern std::vector<vertex> vertices;
-	extern std::vector<uint32_t> indices;
+	extern std::string scenePath;
+
+	// models holds every distinct model of the scene, meshes is parallel to it
+	extern std::vector<std::string> models;
+	extern std::string texturePath;
+
+	extern std::vector<meshRange> meshes;
+	extern std::vector<sceneObject> objects;
+	extern std::vector<uint32_t> visibleObjects;
+	// bumped whenever objects or mesh ranges change, gpu copies of them compare against it
+	extern uint64_t sceneVersion;
+
+	extern glm::mat4 viewProjection;
+
+	// largest projected lod error in pixels, 0 draws every object at full detail
+	extern float lodErrorPixels;
+	// a coarser level is only taken once its error is this much below the threshold, so objects near the switch distance do not flicker
+	const float lodHysteresis = 0.25f;
+	// triangles of the visible objects at their selected lods
+	extern uint64_t drawnTriangles;
+
+	extern double cullMilliseconds;
+	extern double recordMilliseconds;
+
+	// cpu copies parallel to meshes, empty once uploaded unless retainMeshData is set
+	extern std::vector<engine::mesh> meshData;
+	extern bool retainMeshData;
+	extern uint32_t totalVertices;
+	extern uint32_t totalIndices;
+
+	// compact turns into compactColor when loadModels finds a vertex color that is not white
+	extern vertexFormat requestedVertexFormat;
+	extern vertexFormat activeVertexFormat;
 
 	extern VkBuffer vertexBuffer;
 	extern VkDeviceMemory vertexBufferMemory;
 	extern VkBuffer indexBuffer;
 	extern VkDeviceMemory indexBufferMemory;
-	extern std::vector<VkBuffer> uniformBuffers;
-	extern std::vector<VkDeviceMemory> uniformBuffersMemory;
-	extern std::vector<void*> uniformBuffersMapped;
+	// offset of this frame's uniforms in the gpu frame arena
+	extern uint32_t uniformOffset;
 
 	extern VkSwapchainKHR swapChain;
 	extern std::vector<VkImage> swapChainImages;
 	extern VkFormat swapChainImageFormat;
 	extern VkExtent2D swapChainExtent;
 	extern std::vector<VkImageView> swapChainImageViews;
-	extern std::vector<VkFramebuffer> swapChainFramebuffers;
+
+	// the render graph's resources, declared once by createRenderGraph
+	struct frameResources {
+		uint32_t backbuffer;
+		uint32_t depth;
+		uint32_t pyramid;
+		uint32_t clusterIndices;
+		uint32_t clusterDraws;
+		uint32_t occlusionDraws;
+		uint32_t occlusionInstances;
+	};
+
+	extern frameResources graphResources;
 
 	extern VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
 	extern VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
 	extern VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
 
-	extern VkShaderModule createShaderModule(const std::vector<char>& code);
-	extern VkShaderModule vertexShaderModule;
-	extern VkShaderModule fragmentShaderModule;
+	extern VkShaderModule createShaderModule(std::span<const char> code);
 
+	// the render graph's main pass, the pipelines are built against it, null with dynamic rendering
 	extern VkRenderPass renderPass;
 	extern VkDescriptorSetLayout descriptorSetLayout;
 	extern VkPipelineLayout pipelineLayout;
-	extern VkPipeline graphicsPipeline;
+	// indexed by pipelineKind
+	extern std::array<VkPipeline, pipelineKindCount> graphicsPipelines;
 
 	extern VkCommandPool commandPool;
 	extern std::vector<VkCommandBuffer> commandBuffers;
@@ -142,10 +379,6 @@ namespace renderer {
 	extern VkImageView textureImageView;
 	extern VkSampler textureSampler;
 
-	extern VkImage depthImage;
-	extern VkDeviceMemory depthImageMemory;
-	extern VkImageView depthImageView;
-
 	const std::vector<const char*> deviceExtensions = {
 		VK_KHR_SWAPCHAIN_EXTENSION_NAME
 	};
@@ -154,53 +387,85 @@ namespace renderer {
 	extern std::vector<VkSemaphore> renderFinishedSemaphores;
 	extern std::vector<VkFence> inFlightFences;
 
+	// headless mode renders into these instead of swapchain images, one per frame in flight
+	extern std::vector<VkDeviceMemory> offscreenImagesMemory;
+
+	// outermost gpu zone of the last finished frame in this slot, -1 while unknown
+	extern double gpuFrameMilliseconds;
+
 	void init();
 	void createInstance();
 	void createSurface();
 	void pickPhysicalDevice();
 	void createLogicalDevice();
-	void createSwapChain();
+	// the old swapchain hands its images over to the new one, it is retired instead of destroyed
+	void createSwapChain(VkSwapchainKHR oldSwapChain = VK_NULL_HANDLE);
 	void createImageViews();
-	void createRenderPass();
+	void createRenderGraph();
+	// binds the swapchain, depth and pyramid images to the graph, again after the swapchain was recreated
+	void createRenderTargets();
 	void createDescriptorSetLayout();
 	void createGraphicsPipeline();
-	void createFramebuffers();
+	VkPipeline buildGraphicsPipeline(std::span<const char> vertexShaderCode, std::span<const char> fragmentShaderCode, pipelineKind kind);
+	std::array<VkPipeline, pipelineKindCount> buildGraphicsPipelines(std::span<const char> vertexShaderCode, std::span<const char> fragmentShaderCode);
+	VkPipeline createComputePipeline(std::span<const char> code, VkPipelineLayout layout);
 	void createCommandPool();
-	void createDepthResources();
 	void createTextureImage();
+	void uploadTexture(engine::texture& texture, VkImage& image, VkDeviceMemory& imageMemory);
 	void createTextureImageView();
 	void createTextureSampler();
 
 	void createVertexBuffer();
 	void createIndexBuffer();
 
-	void createUniformBuffers();
 	void createDescriptorPool();
 	void createDescriptorSets();
 	void createCommandBuffers();
 	void createSyncObjects();
+	void createOffscreenTargets();
+
+	vertexFormat parseVertexFormat(const std::string& name);
+	uint32_t vertexStride(vertexFormat format);
+	std::string vertexShaderPath(vertexFormat format);
 
+	void loadScene(const std::string& scenePath);
+	// both return the destruction of the previous buffers, the caller decides when the gpu is done with them
+	std::function<void()> replaceMesh(const std::string& modelPath, engine::mesh&& mesh);
+	std::function<void()> appendMesh(engine::mesh&& mesh, uint32_t& meshIndex);
 	void createModelBuffers();
 
+	void cullObjects(const glm::mat4& viewProjection);
+	void selectLods(const glm::vec3& eye, float viewportHeight);
+	glm::mat4 projectionMatrix(float aspectRatio);
+	// normalized gribb/hartmann planes, inside is positive
+	void frustumPlanes(const glm::mat4& viewProjection, std::array<glm::vec4, 6>& planes);
+	// what the vertex shader gets pushed, the compact formats fold their dequantization into it
+	glm::mat4 drawTransform(const sceneObject& object, const meshRange& mesh);
+
 	void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
 	void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
-	void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
+	void uploadBuffer(const void* source, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+	void uploadBuffer(VkDeviceSize size, VkBufferUsageFlags usage, const std::function<void(char*)>& fill, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+	void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, VkDeviceSize bufferOffset = 0);
 
-	void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
-	VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
+	void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, uint32_t mipLevels = 1);
+	VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t baseMipLevel = 0, uint32_t levelCount = 1);
 
 	void loadModels();
 
-	VkCommandBuffer beginSingleTimeCommands();
+	void readbackImage(uint32_t imageIndex, std::vector<uint8_t>& pixels);
+
+	VkCommandBuffer beginSingleTimeCommands(const char* name = "singleTimeCommands");
 	void endSingleTimeCommands(VkCommandBuffer commandBuffer);
-	void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
 
 	void mainLoop();
 	void drawFrame();
-	void recreateSwapChain();
+	// false while the window is minimized, the frame is skipped then
+	bool recreateSwapChain();
 	void updateUniformBuffer(uint32_t currentImage);
 
 	void cleanup();
+	// at shutdown, once the device is idle, recreation retires the old swapchain instead
 	void cleanupSwapChain();
 
 	uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -12,9 +12,17 @@ uint32_t engine::width = 1280;
 uint32_t engine::height = 960;
 
 void engine::init() {
+	BRUTAL_PROFILE_FUNCTION();
+
 	engine::running = true;
 
-	engine::initWindow();
+	jobs::init();
+	filesystem::init();
+	assets::init();
+
+	if (!headless::enabled) {
+		engine::initWindow();
+	}
 
 	camera::createCamera();
 	input::initializeInput();
@@ -24,6 +32,8 @@ void engine::init() {
 }
 
 void engine::initWindow() {
+	BRUTAL_PROFILE_FUNCTION();
+
 	if (SDL_Init(SDL_INIT_VIDEO) == 0) {
 		logger::log("Successfully initialized video!", 1);
 	}
@@ -43,14 +53,33 @@ void engine::initWindow() {
 }
 
 void engine::initRenderer() {
+	BRUTAL_PROFILE_FUNCTION();
+
 	renderer::init();
+
+	if (!headless::enabled) {
+		hotreload::init();
+	}
+
+	compression::report();
 }
 
 void engine::mainLoop() {
+	if (headless::enabled) {
+		headless::run();
+		engine::cleanUp();
+
+		return;
+	}
+
 	while (engine::running) {
+		BRUTAL_PROFILE_ZONE("frame");
+
 		renderer::drawFrame();
 
 		input::inputLoop();
+
+		memory::endFrame();
 	}
 
 	engine::cleanUp();
@@ -61,11 +90,29 @@ void engine::framebufferResizeCallback(SDL_Window* window, int width, int height
 }
 
 void engine::cleanUp() {
+	BRUTAL_PROFILE_FUNCTION();
+
 	logger::log("Quitting...", 4);
 
 	renderer::cleanup();
 
-	SDL_DestroyWindow(engine::window);
+	if (engine::window != nullptr) {
+		SDL_DestroyWindow(engine::window);
+	}
 
 	SDL_Quit();
+
+	jobs::shutdown();
+
+	// after the workers joined, so their last zones are closed
+	if (!profiler::tracePath.empty()) {
+		profiler::stop();
+		profiler::report();
+		profiler::writeTrace(profiler::tracePath);
+	}
+
+	// after renderer cleanup, device memory still charged here was leaked
+	if (memory::reportOnExit) {
+		memory::report();
+	}
 }
\ No newline at end of file
@@ -9,12 +9,32 @@
 #include <sdl2/include/SDL_vulkan.h>
 
 #include "./core/logger/logger.h"
+#include "./core/memory/memory.h"
+#include "./core/arena/arena.h"
+#include "./core/deletion/deletion.h"
+#include "./core/profiler/profiler.h"
+#include "./core/jobs/jobs.h"
 
 #include "../src/core/modules/camera.h"
 #include "../src/core/modules/texture.h"
+#include "../src/core/modules/model.h"
+#include "../src/core/obj/obj.h"
+#include "../src/core/gltf/gltf.h"
+#include "../src/core/optimize/optimize.h"
+#include "../src/core/quantize/quantize.h"
+#include "../src/core/lod/lod.h"
+#include "../src/core/cluster/cluster.h"
+#include "../src/core/occlusion/occlusion.h"
+#include "../src/core/raster/raster.h"
+#include "../src/core/drawQueue/drawQueue.h"
+#include "../src/core/graph/graph.h"
 #include "../src/core/modules/gameObject.h"
 #include "../src/core/modules/input.h"
-#include "../src/core/modules/model.h"
+
+#include "../src/core/assets/assets.h"
+#include "../src/core/hotreload/hotreload.h"
+#include "../src/core/headless/headless.h"
+#include "../src/core/benchmark/benchmark.h"
 
 namespace engine {
 	extern const char* name;